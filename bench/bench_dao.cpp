@@ -0,0 +1,307 @@
+/**
+ * DAO 并发压测: 多个线程并发调用同一 DAO 方法, 报告每个方法的延迟分布与连接池等待
+ *
+ * 参数取自库中随机抽样的用户/歌单/歌曲 (建议先用 datagen 生成数据集). 连接池大小取配置文件,
+ * 线程数大于池大小时池等待即排队时间. 池等待取 db_pool_wait_seconds 直方图在该方法运行前后的差值.
+ * 缓存与服务端一样启用, 读方法的结果包含缓存命中.
+ *
+ * 写方法 (会修改数据) 只在 filter 匹配其名字时运行, filter 为空只跑读方法.
+ * 结果以 JSON 输出到 stdout, 延迟单位为微秒.
+ *
+ * 用法: bench-dao <config.json> [threads] [seconds] [filter]
+ */
+#include "database/DBManager.h"
+#include "database/PlayHistoryDAO.h"
+#include "database/PlaylistCache.h"
+#include "database/PlaylistDAO.h"
+#include "database/SongPool.h"
+#include "database/StatsEngine.h"
+#include "database/UserCache.h"
+#include "database/UserDAO.h"
+#include "utils/Config.h"
+#include "utils/Metrics.h"
+#include "utils/PasswordUtil.h"
+
+#include <jdbc/cppconn/exception.h>
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using json = nlohmann::json;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+constexpr size_t SAMPLE_ROWS = 10000;
+constexpr const char* PASSWORD = "load-password"; // datagen 生成的用户密码
+
+struct UserSample {
+	int id = 0;
+	std::string username;
+	std::string email;
+};
+
+// 压测参数, 各线程随机选取
+struct Samples {
+	std::vector<UserSample> users;
+	std::vector<int> playlists;
+	std::vector<SongMetaPtr> songs;
+};
+
+// 每个线程一份 DAO 与随机数
+struct Worker {
+	MySqlUserDAO users;
+	MySqlPlaylistDAO playlists;
+	MySqlPlayHistoryDAO history;
+	std::mt19937_64 rng;
+
+	template <typename T>
+	const T& pick(const std::vector<T>& items) {
+		return items[std::uniform_int_distribution<size_t>(0, items.size() - 1)(rng)];
+	}
+};
+
+struct Case {
+	const char* name;
+	bool write;
+	std::function<void(Worker&, const Samples&)> run;
+};
+
+bool loadSamples(Samples& samples) {
+	SqlConnGuard guard(DBManager::getInstance()->getConnection());
+	StmtPtr stmt(guard->createStatement());
+	const std::string limit = " ORDER BY RAND() LIMIT " + std::to_string(SAMPLE_ROWS);
+
+	ResultSetPtr result(stmt->executeQuery(
+		"SELECT id, username, email FROM users WHERE deleted_at IS NULL" + limit));
+	while (result->next()) {
+		samples.users.push_back({result->getInt(1), result->getString(2), result->getString(3)});
+	}
+
+	result.reset(stmt->executeQuery("SELECT id FROM playlists" + limit));
+	while (result->next()) samples.playlists.push_back(result->getInt(1));
+
+	result.reset(
+		stmt->executeQuery("SELECT " + std::string(SongPool::COLUMNS) + " FROM songs s" + limit));
+	while (result->next()) {
+		samples.songs.push_back(SongPool::getInstance()->fromResultSet(result, 1));
+	}
+
+	if (samples.users.empty() || samples.playlists.empty() || samples.songs.empty()) {
+		std::fprintf(stderr, "database has no users/playlists/songs, run datagen first\n");
+		return false;
+	}
+	return true;
+}
+
+std::vector<Case> cases() {
+	return {
+		{"user.getUserById", false,
+		 [](Worker& w, const Samples& s) { w.users.getUserById(w.pick(s.users).id); }},
+		{"user.getUserByUsername", false,
+		 [](Worker& w, const Samples& s) { w.users.getUserByUsername(w.pick(s.users).username); }},
+		{"user.getUserByEmail", false,
+		 [](Worker& w, const Samples& s) { w.users.getUserByEmail(w.pick(s.users).email); }},
+		// 与登录相同: 按用户名查询后校验密码哈希
+		{"user.login", false,
+		 [](Worker& w, const Samples& s) {
+			 if (auto user = w.users.getUserByUsername(w.pick(s.users).username)) {
+				 PasswordUtil::verifyPassword(PASSWORD, user->passwd_hash);
+			 }
+		 }},
+		{"playlist.getPlaylistsByUserId", false,
+		 [](Worker& w, const Samples& s) { w.playlists.getPlaylistsByUserId(w.pick(s.users).id); }},
+		{"playlist.getPlaylistById", false,
+		 [](Worker& w, const Samples& s) { w.playlists.getPlaylistById(w.pick(s.playlists)); }},
+		{"playlist.getSongsInPlaylist", false,
+		 [](Worker& w, const Samples& s) { w.playlists.getSongsInPlaylist(w.pick(s.playlists)); }},
+		{"playlist.getPlaylistSnapshot", false,
+		 [](Worker& w, const Samples& s) { w.playlists.getPlaylistSnapshot(w.pick(s.playlists)); }},
+		{"playlist.countSongsInPlaylist", false,
+		 [](Worker& w, const Samples& s) {
+			 w.playlists.countSongsInPlaylist(w.pick(s.playlists));
+		 }},
+		{"history.getUserPlayHistory", false,
+		 [](Worker& w, const Samples& s) { w.history.getUserPlayHistory(w.pick(s.users).id); }},
+		{"history.getUserTotalPlayCount", false,
+		 [](Worker& w, const Samples& s) { w.history.getUserTotalPlayCount(w.pick(s.users).id); }},
+		{"history.getUserRecentPlayCount", false,
+		 [](Worker& w, const Samples& s) { w.history.getUserRecentPlayCount(w.pick(s.users).id); }},
+		{"history.getUserTopArtists", false,
+		 [](Worker& w, const Samples& s) { w.history.getUserTopArtists(w.pick(s.users).id); }},
+		{"history.getUserTopSongs", false,
+		 [](Worker& w, const Samples& s) { w.history.getUserTopSongs(w.pick(s.users).id); }},
+		{"history.getMostPlayedSongs", false,
+		 [](Worker& w, const Samples& s) { w.history.getMostPlayedSongs(w.pick(s.users).id); }},
+		{"history.addPlayHistory", true,
+		 [](Worker& w, const Samples& s) {
+			 PlayHistory history;
+			 history.user_id = w.pick(s.users).id;
+			 history.song = w.pick(s.songs);
+			 w.history.addPlayHistory(history);
+		 }},
+		// 添加后立即移除, 歌单内容不变
+		{"playlist.addRemoveSong", true,
+		 [](Worker& w, const Samples& s) {
+			 const int playlist_id = w.pick(s.playlists);
+			 Song song;
+			 song.meta = w.pick(s.songs);
+			 if (w.playlists.addSongToPlaylist(playlist_id, song) == DAOStatus::Ok) {
+				 w.playlists.removeSongFromPlaylist(playlist_id, song.meta->song_id,
+													song.meta->where);
+			 }
+		 }},
+	};
+}
+
+uint64_t percentile(const std::vector<uint32_t>& sorted, double p) {
+	if (sorted.empty()) return 0;
+	return sorted[static_cast<size_t>(p * static_cast<double>(sorted.size() - 1))];
+}
+
+json summarize(std::vector<uint32_t>& latencies) {
+	std::sort(latencies.begin(), latencies.end());
+	double sum = 0;
+	for (uint32_t v : latencies) sum += v;
+	return {{"count", latencies.size()},
+			{"mean", latencies.empty() ? 0.0 : sum / static_cast<double>(latencies.size())},
+			{"p50", percentile(latencies, 0.5)},
+			{"p90", percentile(latencies, 0.9)},
+			{"p99", percentile(latencies, 0.99)},
+			{"p999", percentile(latencies, 0.999)},
+			{"max", latencies.empty() ? 0 : latencies.back()}};
+}
+
+// 两次快照之间的池等待 (直方图桶上界, 相对误差不超过 12.5%)
+json poolWait(const MetricHistogram::Snapshot& before, const MetricHistogram::Snapshot& after) {
+	MetricHistogram::Snapshot delta;
+	delta.buckets.resize(after.buckets.size());
+	for (size_t i = 0; i < after.buckets.size(); ++i) {
+		delta.buckets[i] = after.buckets[i] - before.buckets[i];
+	}
+	delta.count = after.count - before.count;
+	delta.sum = after.sum - before.sum;
+	return {{"count", delta.count},
+			{"mean", delta.count > 0 ? static_cast<double>(delta.sum) / delta.count : 0.0},
+			{"p50", delta.quantile(0.5)},
+			{"p99", delta.quantile(0.99)},
+			{"max", delta.quantile(1.0)}};
+}
+
+json runCase(const Case& c, const Samples& samples, size_t threads,
+			 std::chrono::seconds duration) {
+	MetricHistogram& wait = MetricsRegistry::getInstance()->histogram(
+		"db_pool_wait_seconds", "Time spent waiting for a connection");
+	MetricCounter& timeouts = MetricsRegistry::getInstance()->counter(
+		"db_pool_timeouts_total", "Checkouts that timed out");
+	const auto wait_before = wait.snapshot();
+	const uint64_t timeouts_before = timeouts.value();
+
+	std::vector<std::vector<uint32_t>> latencies(threads);
+	std::vector<uint64_t> errors(threads, 0);
+	std::vector<std::thread> workers;
+	const auto start = Clock::now();
+	const auto deadline = start + duration;
+	for (size_t t = 0; t < threads; ++t) {
+		workers.emplace_back([&, t]() {
+			Worker worker;
+			worker.rng.seed(t + 1);
+			while (Clock::now() < deadline) {
+				const auto begin = Clock::now();
+				try {
+					c.run(worker, samples);
+				} catch (const std::exception&) {
+					++errors[t];
+				}
+				const auto micros =
+					std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - begin);
+				latencies[t].push_back(static_cast<uint32_t>(micros.count()));
+			}
+		});
+	}
+	for (auto& worker : workers) worker.join();
+	const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+	std::vector<uint32_t> all;
+	uint64_t error_count = 0;
+	for (size_t t = 0; t < threads; ++t) {
+		all.insert(all.end(), latencies[t].begin(), latencies[t].end());
+		error_count += errors[t];
+	}
+	const size_t ops = all.size();
+	json result = {{"name", c.name},
+				   {"ops", ops},
+				   {"ops_per_sec", seconds > 0 ? static_cast<double>(ops) / seconds : 0.0},
+				   {"errors", error_count},
+				   {"latency_us", summarize(all)},
+				   {"pool_wait_us", poolWait(wait_before, wait.snapshot())},
+				   {"pool_timeouts", timeouts.value() - timeouts_before}};
+
+	std::fprintf(stderr, "%-32s %10zu ops %10.0f ops/s  p50 %6lu us  p99 %7lu us\n", c.name, ops,
+				 result["ops_per_sec"].get<double>(),
+				 static_cast<unsigned long>(result["latency_us"]["p50"].get<uint64_t>()),
+				 static_cast<unsigned long>(result["latency_us"]["p99"].get<uint64_t>()));
+	return result;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+	if (argc < 2) {
+		std::fprintf(stderr, "usage: bench-dao <config.json> [threads] [seconds] [filter]\n");
+		return 2;
+	}
+	const size_t threads = argc > 2 ? std::max(1, std::atoi(argv[2])) : 16;
+	const std::chrono::seconds duration(argc > 3 ? std::max(1, std::atoi(argv[3])) : 10);
+	const std::string filter = argc > 4 ? argv[4] : "";
+
+	Config* config = Config::getInstance();
+	if (!config->loadFromFile(argv[1])) {
+		std::fprintf(stderr, "failed to load %s\n", argv[1]);
+		return 1;
+	}
+
+	const DatabaseConfig& db = config->getDatabaseConfig();
+	const CacheConfig& cache = config->getCacheConfig();
+	DBManager::init(db.host, db.port, db.user, db.password, db.dbname, db.connection_pool_size);
+	UserCache::init(std::chrono::seconds(cache.user_ttl),
+					std::chrono::seconds(cache.user_negative_ttl), cache.user_shards);
+	PlaylistCache::init(cache.playlist_capacity);
+	StatsEngine::init(config->getStatsConfig().max_users,
+					  std::chrono::hours(config->getStatsConfig().recompute_interval_hours));
+
+	Samples samples;
+	try {
+		if (!loadSamples(samples)) return 1;
+	} catch (const sql::SQLException& e) {
+		std::fprintf(stderr, "sql error: %s (%d)\n", e.what(), e.getErrorCode());
+		return 1;
+	}
+
+	std::fprintf(stderr, "%zu threads, pool %zu, %lds per method\n", threads,
+				 db.connection_pool_size, static_cast<long>(duration.count()));
+
+	json results = json::array();
+	for (const Case& c : cases()) {
+		const bool matched =
+			!filter.empty() && std::string(c.name).find(filter) != std::string::npos;
+		if (c.write ? !matched : !filter.empty() && !matched) continue;
+		results.push_back(runCase(c, samples, threads, duration));
+	}
+
+	StatsEngine::getInstance()->stop();
+	const json report = {{"threads", threads},
+						 {"pool_size", db.connection_pool_size},
+						 {"seconds", duration.count()},
+						 {"methods", results}};
+	std::printf("%s\n", report.dump(2).c_str());
+	return 0;
+}
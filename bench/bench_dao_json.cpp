@@ -0,0 +1,155 @@
+/**
+ * DAO → JSON 压测: 向临时歌单写入 rows 首歌, 分别计时 DAO 查询映射与 JSON 序列化
+ *
+ * 第一轮 SongPool 为冷 (逐行读取字符串列), 之后各轮为热 (已驻留歌曲跳过字符串列).
+ * 结束时删除临时用户 (级联删除歌单) 与临时歌曲.
+ *
+ * 用法: bench-dao-json [config.json] [rows] [rounds]
+ */
+#include "database/DBManager.h"
+#include "database/PlaylistCache.h"
+#include "database/PlaylistDAO.h"
+#include "database/SongPool.h"
+#include "handlers/PlaylistHandler.h"
+#include "utils/Config.h"
+#include "utils/PerfCounters.h"
+
+#include <jdbc/cppconn/exception.h>
+#include <jdbc/cppconn/prepared_statement.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+constexpr const char* BENCH_PREFIX = "bench-dao-json-";
+constexpr size_t INSERT_BATCH = 500;
+
+// 临时用户与歌单, 返回歌单 id
+int seed(size_t rows) {
+	SqlConnGuard guard(DBManager::getInstance()->getConnection());
+	SqlTransaction tx(guard);
+
+	PreStmtPtr pstmt(guard.prepareStatement(
+		"INSERT INTO users (username, passwd_hash, email) VALUES (?, '', ?)"));
+	pstmt->setString(1, std::string(BENCH_PREFIX) + "user");
+	pstmt->setString(2, std::string(BENCH_PREFIX) + "user@bench");
+	pstmt->executeUpdate();
+
+	pstmt.reset(guard.prepareStatement(
+		"INSERT INTO playlists (name, user_id) VALUES ('bench', LAST_INSERT_ID())"));
+	pstmt->executeUpdate();
+
+	StmtPtr stmt(guard->createStatement());
+	ResultSetPtr result(stmt->executeQuery("SELECT LAST_INSERT_ID()"));
+	result->next();
+	const int playlist_id = result->getInt(1);
+
+	for (size_t begin = 0; begin < rows; begin += INSERT_BATCH) {
+		const size_t end = std::min(rows, begin + INSERT_BATCH);
+		std::string sql =
+			"INSERT INTO songs (song_id, song_where, song_name, song_singer, song_pic) VALUES ";
+		for (size_t i = begin; i < end; ++i) {
+			if (i != begin) sql += ',';
+			const std::string n = std::to_string(i);
+			sql += "('" + std::string(BENCH_PREFIX) + n + "', '" + (i % 2 ? "QQ" : "NetEase") +
+				   "', 'Song Name " + n + "', 'Singer " + std::to_string(i % 97) +
+				   "', 'https://y.example.com/pic/" + n + ".jpg')";
+		}
+		stmt->executeUpdate(sql);
+	}
+
+	pstmt.reset(guard.prepareStatement(
+		"INSERT INTO playlist_songs (playlist_id, song_ref) "
+		"SELECT ?, id FROM songs WHERE song_id LIKE ?"));
+	pstmt->setInt(1, playlist_id);
+	pstmt->setString(2, std::string(BENCH_PREFIX) + "%");
+	pstmt->executeUpdate();
+
+	tx.commit();
+	return playlist_id;
+}
+
+void cleanup() {
+	SqlConnGuard guard(DBManager::getInstance()->getConnection());
+	PreStmtPtr pstmt(guard.prepareStatement("DELETE FROM users WHERE username = ?"));
+	pstmt->setString(1, std::string(BENCH_PREFIX) + "user");
+	pstmt->executeUpdate();
+
+	pstmt.reset(guard.prepareStatement("DELETE FROM songs WHERE song_id LIKE ?"));
+	pstmt->setString(1, std::string(BENCH_PREFIX) + "%");
+	pstmt->executeUpdate();
+}
+
+double elapsedMs(Clock::time_point begin) {
+	return std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+}
+
+void run(PlaylistDAO& dao, int playlist_id, size_t rounds) {
+	for (size_t round = 0; round < rounds; ++round) {
+		auto begin = Clock::now();
+		std::vector<Song> songs = dao.getSongsInPlaylist(playlist_id);
+		const double dao_ms = elapsedMs(begin);
+
+		begin = Clock::now();
+		json array = json::array();
+		for (const auto& song : songs) {
+			array.push_back(PlaylistHandler::songToJson(song));
+		}
+		std::string body = array.dump();
+		const double json_ms = elapsedMs(begin);
+
+		const double rows = static_cast<double>(std::max<size_t>(songs.size(), 1));
+		std::printf("round=%zu %-4s rows=%zu dao=%.2fms (%.0fns/row) json=%.2fms (%.0fns/row) "
+					"bytes=%zu\n",
+					round, round == 0 ? "cold" : "warm", songs.size(), dao_ms,
+					dao_ms * 1e6 / rows, json_ms, json_ms * 1e6 / rows, body.size());
+	}
+
+	SongPool::Stats stats = SongPool::getInstance()->stats();
+	std::printf("song pool: hits=%lu misses=%lu entries=%lu\n",
+				static_cast<unsigned long>(stats.hits), static_cast<unsigned long>(stats.misses),
+				static_cast<unsigned long>(stats.entries));
+
+	// 以 MUSICPLAYER_PERF_COUNTERS 构建时输出各区域的硬件计数
+	const std::string perf = PerfCounters::getInstance()->report();
+	if (!perf.empty()) std::printf("\n%s", perf.c_str());
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+	const std::string config_path = argc > 1 ? argv[1] : "config.json";
+	const size_t rows = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 10000;
+	const size_t rounds = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 5;
+
+	Config* config = Config::getInstance();
+	if (!config->loadFromFile(config_path)) {
+		std::fprintf(stderr, "failed to load %s\n", config_path.c_str());
+		return 1;
+	}
+
+	const DatabaseConfig& db = config->getDatabaseConfig();
+	DBManager::init(db.host, db.port, db.user, db.password, db.dbname, 2);
+	PlaylistCache::init(1);
+
+	try {
+		cleanup();
+		const int playlist_id = seed(rows);
+
+		MySqlPlaylistDAO dao;
+		run(dao, playlist_id, rounds);
+
+		cleanup();
+	} catch (const sql::SQLException& e) {
+		std::fprintf(stderr, "sql error: %s (%d)\n", e.what(), e.getErrorCode());
+		return 1;
+	}
+	return 0;
+}
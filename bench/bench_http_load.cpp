@@ -0,0 +1,556 @@
+/**
+ * HTTP 压测: 按权重混合请求各路由, 输出总体与各路由的吞吐、延迟分位数 (JSON)
+ *
+ * 开环 (open): 按固定到达率为每个请求排定发送时间, 延迟从排定时间算起, 服务端变慢时积压的
+ * 排队时间也计入, 不受 coordinated omission 影响. 闭环 (closed): 每个连接收到响应后
+ * (间隔 think_ms) 再发下一个请求; 除原始延迟外另给出按期望间隔补齐停顿样本的修正分位数.
+ *
+ * 压测账号需预先存在: 用户名 users.prefix + 0..users.count-1, 密码相同. 每个连接以一个账号
+ * 登录, 并创建自己的歌单供歌单读写使用.
+ *
+ * 用法: bench-http-load [load.json]
+ */
+#include "common/net.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+enum class Op {
+	Login,
+	Profile,
+	HistoryAdd,
+	HistoryList,
+	PlaylistList,
+	PlaylistRead,
+	PlaylistWrite,
+	Avatar,
+};
+
+constexpr size_t OPS = 8;
+constexpr std::array<const char*, OPS> OP_NAMES = {
+	"login",		 "profile",		  "history_add",	"history_list",
+	"playlist_list", "playlist_read", "playlist_write", "avatar"};
+
+constexpr auto IO_TIMEOUT = std::chrono::seconds(10);
+constexpr auto RECONNECT_DELAY = std::chrono::milliseconds(100);
+// 闭环修正的最小期望间隔, 避免极短间隔时补齐样本过多
+constexpr uint64_t MIN_EXPECTED_INTERVAL_US = 50;
+
+struct LoadConfig {
+	std::string host = "127.0.0.1";
+	std::string port = "8080";
+	bool open_loop = true;
+	double rate = 1000; // 开环: 所有连接合计每秒请求数
+	size_t connections = 32;
+	size_t threads = 2;
+	std::chrono::seconds warmup{5};
+	std::chrono::seconds duration{30};
+	std::chrono::milliseconds think{0}; // 闭环: 收到响应到发下一个请求的间隔
+	std::string user_prefix = "load";
+	size_t user_count = 16;
+	std::string password = "load-password";
+	size_t songs = 1000; // 写请求使用的歌曲 id 数
+	std::vector<std::pair<Op, double>> mix;
+	std::string output;
+};
+
+LoadConfig loadConfig(const std::string& path) {
+	std::ifstream file(path);
+	if (!file) throw std::runtime_error("Cannot open " + path);
+	json j = json::parse(file);
+
+	LoadConfig config;
+	config.host = j.value("host", config.host);
+	config.port = std::to_string(j.value("port", 8080));
+	const std::string mode = j.value("mode", "open");
+	if (mode != "open" && mode != "closed") throw std::runtime_error("mode must be open|closed");
+	config.open_loop = mode == "open";
+	config.rate = j.value("rate", config.rate);
+	config.connections = std::max<size_t>(1, j.value("connections", config.connections));
+	config.threads = std::clamp<size_t>(j.value("threads", config.threads), 1, config.connections);
+	config.warmup = std::chrono::seconds(j.value("warmup_s", 5));
+	config.duration = std::chrono::seconds(std::max(1, j.value("duration_s", 30)));
+	config.think = std::chrono::milliseconds(j.value("think_ms", 0));
+	if (j.contains("users")) {
+		const json& users = j["users"];
+		config.user_prefix = users.value("prefix", config.user_prefix);
+		config.user_count = std::max<size_t>(1, users.value("count", config.user_count));
+		config.password = users.value("password", config.password);
+	}
+	config.songs = std::max<size_t>(1, j.value("songs", config.songs));
+	config.output = j.value("output", "");
+
+	if (config.open_loop && config.rate <= 0) throw std::runtime_error("rate must be positive");
+
+	const json mix = j.value("mix", json::object());
+	for (const auto& [name, weight] : mix.items()) {
+		auto it = std::find(OP_NAMES.begin(), OP_NAMES.end(), name);
+		if (it == OP_NAMES.end()) throw std::runtime_error("Unknown route in mix: " + name);
+		if (weight.get<double>() > 0) {
+			config.mix.emplace_back(static_cast<Op>(it - OP_NAMES.begin()), weight.get<double>());
+		}
+	}
+	if (config.mix.empty()) throw std::runtime_error("mix is empty");
+
+	return config;
+}
+
+struct RouteResult {
+	std::vector<uint32_t> latencies; // 微秒
+	std::map<unsigned, uint64_t> status;
+	uint64_t errors = 0; // 连接错误与 5xx
+};
+
+// 一个 io 线程上所有连接的结果, 只由该线程写入
+using Results = std::array<RouteResult, OPS>;
+
+/**
+ * @brief 一个 keep-alive 连接, 按调度依次发送请求
+ */
+class Connection : public std::enable_shared_from_this<Connection> {
+public:
+	Connection(net::io_context& ioc, const LoadConfig& config,
+			   const tcp::resolver::results_type& endpoints, size_t index, Results& results,
+			   Clock::time_point measure_from, Clock::time_point end)
+		: m_stream(ioc),
+		  m_timer(ioc),
+		  m_config(config),
+		  m_endpoints(endpoints),
+		  m_index(index),
+		  m_results(results),
+		  m_measure_from(measure_from),
+		  m_end(end),
+		  m_engine(static_cast<uint32_t>(index) * 7919U + 1) {
+		double total = 0;
+		for (const auto& [op, weight] : config.mix) total += weight;
+		double acc = 0;
+		for (const auto& [op, weight] : config.mix) {
+			acc += weight / total;
+			m_cumulative.emplace_back(acc, op);
+		}
+
+		// 每个连接承担 rate / connections, 起始时间在一个间隔内错开
+		m_interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(
+			static_cast<double>(config.connections) / std::max(config.rate, 1e-9)));
+	}
+
+	void start() {
+		login([self = shared_from_this()](bool ok) {
+			if (!ok) return;
+			self->createPlaylist([self](bool ok) {
+				if (!ok) return;
+				self->m_next = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+												  self->m_interval * self->uniform());
+				self->next();
+			});
+		});
+	}
+
+private:
+	using Callback = std::function<void(beast::error_code, HttpResponse&)>;
+
+	double uniform() { return std::uniform_real_distribution<double>(0.0, 1.0)(m_engine); }
+
+	std::string username() const {
+		return m_config.user_prefix + std::to_string(m_index % m_config.user_count);
+	}
+
+	HttpRequest makeRequest(http::verb method, const std::string& target,
+							const json& body = nullptr) const {
+		HttpRequest req{method, target, 11};
+		req.set(http::field::host, m_config.host);
+		req.set(http::field::user_agent, "bench-http-load");
+		req.keep_alive(true);
+		if (!m_token.empty()) req.set(http::field::authorization, m_token);
+		if (!body.is_null()) {
+			req.set(http::field::content_type, "application/json");
+			req.body() = body.dump();
+		}
+		req.prepare_payload();
+		return req;
+	}
+
+	// 未连接时先连接; 出错后关闭连接, 下一个请求重连
+	void send(HttpRequest req, Callback callback) {
+		m_request = std::move(req);
+		if (m_connected) {
+			write(std::move(callback));
+			return;
+		}
+
+		m_stream.expires_after(IO_TIMEOUT);
+		m_stream.async_connect(m_endpoints, [self = shared_from_this(),
+											 callback = std::move(callback)](
+												beast::error_code ec, const tcp::endpoint&) {
+			if (ec) {
+				HttpResponse empty;
+				callback(ec, empty);
+				return;
+			}
+			self->m_stream.socket().set_option(tcp::no_delay(true));
+			self->m_connected = true;
+			self->write(std::move(callback));
+		});
+	}
+
+	void write(Callback callback) {
+		m_stream.expires_after(IO_TIMEOUT);
+		http::async_write(
+			m_stream, m_request,
+			[self = shared_from_this(), callback = std::move(callback)](beast::error_code ec,
+																		size_t) {
+				if (ec) {
+					self->disconnect();
+					HttpResponse empty;
+					callback(ec, empty);
+					return;
+				}
+				self->m_response = {};
+				http::async_read(
+					self->m_stream, self->m_buffer, self->m_response,
+					[self, callback](beast::error_code ec, size_t) {
+						if (ec || !self->m_response.keep_alive()) self->disconnect();
+						callback(ec, self->m_response);
+					});
+			});
+	}
+
+	void disconnect() {
+		beast::error_code ignored;
+		m_stream.socket().shutdown(tcp::socket::shutdown_both, ignored);
+		m_stream.close();
+		m_buffer.consume(m_buffer.size());
+		m_connected = false;
+	}
+
+	void login(std::function<void(bool)> done) {
+		m_token.clear();
+		send(makeRequest(http::verb::post, "/users/login",
+						 {{"username", username()}, {"password", m_config.password}}),
+			 [self = shared_from_this(), done = std::move(done)](beast::error_code ec,
+																 HttpResponse& res) {
+				 if (ec || res.result() != http::status::ok) {
+					 const std::string reason =
+						 ec ? ec.message() : "status " + std::to_string(res.result_int());
+					 std::fprintf(stderr, "connection %zu: login %s failed: %s\n", self->m_index,
+								  self->username().c_str(), reason.c_str());
+					 done(false);
+					 return;
+				 }
+				 self->m_token = std::string(res[http::field::authorization]);
+				 done(true);
+			 });
+	}
+
+	void createPlaylist(std::function<void(bool)> done) {
+		send(makeRequest(http::verb::post, "/playlists/create",
+						 {{"name", "bench-http-load-" + std::to_string(m_index)}}),
+			 [self = shared_from_this(), done = std::move(done)](beast::error_code ec,
+																 HttpResponse& res) {
+				 json body = ec ? json() : json::parse(res.body(), nullptr, false);
+				 if (ec || res.result() != http::status::ok || !body.contains("playlist_id")) {
+					 std::fprintf(stderr, "connection %zu: create playlist failed\n",
+								  self->m_index);
+					 done(false);
+					 return;
+				 }
+				 self->m_playlist_id = body["playlist_id"].get<int>();
+				 done(true);
+			 });
+	}
+
+	Op pickOp() {
+		const double r = uniform();
+		for (const auto& [acc, op] : m_cumulative) {
+			if (r < acc) return op;
+		}
+		return m_cumulative.back().second;
+	}
+
+	json song(size_t k) const {
+		return {{"song_id", "bench-" + std::to_string(k)},
+				{"where", "QQ"},
+				{"name", "Bench Song " + std::to_string(k)},
+				{"singer", "Bench Singer " + std::to_string(k % 97)},
+				{"pic", ""}};
+	}
+
+	HttpRequest requestFor(Op op) {
+		const std::string playlist = std::to_string(m_playlist_id);
+		switch (op) {
+			case Op::Login:
+				return makeRequest(http::verb::post, "/users/login",
+								   {{"username", username()}, {"password", m_config.password}});
+			case Op::Profile:
+				return makeRequest(http::verb::get, "/users/info");
+			case Op::HistoryAdd:
+				return makeRequest(http::verb::post, "/history/add",
+								   song(m_engine() % m_config.songs));
+			case Op::HistoryList:
+				return makeRequest(http::verb::post, "/history", {{"limit", 50}});
+			case Op::PlaylistList:
+				return makeRequest(http::verb::post, "/playlists");
+			case Op::PlaylistRead:
+				return makeRequest(http::verb::get, "/playlists/songs?playlist_id=" + playlist);
+			case Op::PlaylistWrite: {
+				// 交替添加与删除同一首歌, 歌单大小保持稳定
+				const bool add = (m_writes++ % 2) == 0;
+				if (add) m_write_song = m_engine() % m_config.songs;
+				json s = song(m_write_song);
+				if (add) {
+					return makeRequest(http::verb::post, "/playlists/add?playlist_id=" + playlist,
+									   {{"song", s}});
+				}
+				return makeRequest(http::verb::post, "/playlists/erase?playlist_id=" + playlist,
+								   {{"song_id", s["song_id"]}, {"where", s["where"]}});
+			}
+			case Op::Avatar:
+				return makeRequest(http::verb::get, "/users/avatar/raw");
+		}
+		return makeRequest(http::verb::get, "/");
+	}
+
+	void next() {
+		Clock::time_point intended;
+		if (m_config.open_loop) {
+			intended = m_next;
+			m_next += m_interval;
+		} else {
+			intended = Clock::now() + m_config.think;
+		}
+		if (intended >= m_end) return;
+
+		// 开环下落后于调度时立即发送, 延迟仍从排定时间算起
+		if (intended <= Clock::now()) {
+			issue(intended);
+			return;
+		}
+		m_timer.expires_at(intended);
+		m_timer.async_wait([self = shared_from_this(), intended](beast::error_code ec) {
+			if (!ec) self->issue(intended);
+		});
+	}
+
+	void issue(Clock::time_point intended) {
+		const Op op = pickOp();
+		send(requestFor(op), [self = shared_from_this(), op, intended](beast::error_code ec,
+																	   HttpResponse& res) {
+			const auto now = Clock::now();
+			if (intended >= self->m_measure_from) {
+				RouteResult& result = self->m_results[static_cast<size_t>(op)];
+				result.latencies.push_back(static_cast<uint32_t>(std::min<int64_t>(
+					std::chrono::duration_cast<std::chrono::microseconds>(now - intended).count(),
+					UINT32_MAX)));
+				if (ec) {
+					++result.errors;
+				} else {
+					++result.status[res.result_int()];
+					if (res.result_int() >= 500) ++result.errors;
+				}
+			}
+			if (op == Op::Login && !ec && res.result() == http::status::ok) {
+				self->m_token = std::string(res[http::field::authorization]);
+			}
+
+			if (ec && !self->m_connected) {
+				// 连接失败时稍后重试, 不空转
+				self->m_timer.expires_after(RECONNECT_DELAY);
+				self->m_timer.async_wait([self](beast::error_code ec) {
+					if (!ec) self->next();
+				});
+				return;
+			}
+			self->next();
+		});
+	}
+
+private:
+	beast::tcp_stream m_stream;
+	net::steady_timer m_timer;
+	beast::flat_buffer m_buffer;
+	HttpRequest m_request;
+	HttpResponse m_response;
+	bool m_connected = false;
+
+	const LoadConfig& m_config;
+	const tcp::resolver::results_type& m_endpoints;
+	const size_t m_index;
+	Results& m_results;
+	const Clock::time_point m_measure_from;
+	const Clock::time_point m_end;
+
+	std::mt19937 m_engine;
+	std::vector<std::pair<double, Op>> m_cumulative;
+	Clock::duration m_interval{};
+	Clock::time_point m_next;
+
+	std::string m_token;
+	int m_playlist_id = 0;
+	uint64_t m_writes = 0;
+	size_t m_write_song = 0;
+};
+
+uint64_t percentile(const std::vector<uint32_t>& sorted, double p) {
+	if (sorted.empty()) return 0;
+	return sorted[static_cast<size_t>(p * static_cast<double>(sorted.size() - 1))];
+}
+
+json summarize(std::vector<uint32_t>& latencies) {
+	std::sort(latencies.begin(), latencies.end());
+	double sum = 0;
+	for (uint32_t v : latencies) sum += v;
+	return {{"count", latencies.size()},
+			{"mean", latencies.empty() ? 0.0 : sum / static_cast<double>(latencies.size())},
+			{"p50", percentile(latencies, 0.5)},
+			{"p90", percentile(latencies, 0.9)},
+			{"p99", percentile(latencies, 0.99)},
+			{"p999", percentile(latencies, 0.999)},
+			{"max", latencies.empty() ? 0 : latencies.back()}};
+}
+
+// 闭环修正: 每个样本 v 按期望间隔 interval 补齐 v - interval, v - 2 * interval, ...,
+// 即停顿期间本应发出却被阻塞的请求
+std::vector<uint32_t> correct(const std::vector<uint32_t>& latencies, uint64_t interval) {
+	std::vector<uint32_t> corrected = latencies;
+	for (uint32_t v : latencies) {
+		for (uint64_t missed = v > interval ? v - interval : 0; missed >= interval;
+			 missed -= interval) {
+			corrected.push_back(static_cast<uint32_t>(missed));
+		}
+	}
+	return corrected;
+}
+
+json report(const LoadConfig& config, std::vector<Results>& all) {
+	const double seconds = static_cast<double>(config.duration.count());
+
+	json routes = json::object();
+	std::vector<uint32_t> latencies;
+	uint64_t errors = 0;
+	std::map<std::string, uint64_t> status;
+	for (size_t i = 0; i < OPS; ++i) {
+		RouteResult merged;
+		for (Results& results : all) {
+			RouteResult& part = results[i];
+			merged.latencies.insert(merged.latencies.end(), part.latencies.begin(),
+									part.latencies.end());
+			merged.errors += part.errors;
+			for (const auto& [code, count] : part.status) merged.status[code] += count;
+		}
+		if (merged.latencies.empty()) continue;
+
+		json codes = json::object();
+		for (const auto& [code, count] : merged.status) {
+			codes[std::to_string(code)] = count;
+			status[std::to_string(code)] += count;
+		}
+		latencies.insert(latencies.end(), merged.latencies.begin(), merged.latencies.end());
+		errors += merged.errors;
+
+		const size_t count = merged.latencies.size();
+		routes[OP_NAMES[i]] = {{"requests", count},
+							   {"errors", merged.errors},
+							   {"throughput_rps", static_cast<double>(count) / seconds},
+							   {"status", codes},
+							   {"latency_us", summarize(merged.latencies)}};
+	}
+
+	json out = {{"mode", config.open_loop ? "open" : "closed"},
+				{"connections", config.connections},
+				{"duration_s", config.duration.count()},
+				{"warmup_s", config.warmup.count()},
+				{"requests", latencies.size()},
+				{"errors", errors},
+				{"throughput_rps", static_cast<double>(latencies.size()) / seconds},
+				{"status", status}};
+	if (config.open_loop) {
+		out["target_rps"] = config.rate;
+	} else {
+		out["think_ms"] = config.think.count();
+	}
+
+	json summary = summarize(latencies);
+	if (!config.open_loop) {
+		// 期望间隔: 无停顿时一个连接两次请求的间隔
+		const uint64_t interval =
+			std::max<uint64_t>(MIN_EXPECTED_INTERVAL_US,
+							   static_cast<uint64_t>(config.think.count()) * 1000 +
+								   summary["p50"].get<uint64_t>());
+		std::vector<uint32_t> corrected = correct(latencies, interval);
+		out["expected_interval_us"] = interval;
+		out["latency_us_corrected"] = summarize(corrected);
+	}
+	out["latency_us"] = std::move(summary);
+	out["routes"] = std::move(routes);
+	return out;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+	const std::string config_path = argc > 1 ? argv[1] : "load.json";
+
+	LoadConfig config;
+	tcp::resolver::results_type endpoints;
+	try {
+		config = loadConfig(config_path);
+		net::io_context resolver_ioc;
+		tcp::resolver resolver(resolver_ioc);
+		endpoints = resolver.resolve(config.host, config.port);
+	} catch (const std::exception& e) {
+		std::fprintf(stderr, "%s\n", e.what());
+		return 1;
+	}
+
+	std::vector<std::unique_ptr<net::io_context>> contexts;
+	for (size_t i = 0; i < config.threads; ++i) {
+		contexts.push_back(std::make_unique<net::io_context>(1));
+	}
+	std::vector<Results> results(config.threads);
+
+	// 预热期内的请求 (含登录与建歌单) 不计入结果
+	const auto measure_from = Clock::now() + config.warmup;
+	const auto end = measure_from + config.duration;
+	for (size_t i = 0; i < config.connections; ++i) {
+		const size_t t = i % config.threads;
+		std::make_shared<Connection>(*contexts[t], config, endpoints, i, results[t], measure_from,
+									 end)
+			->start();
+	}
+
+	std::fprintf(stderr, "%s loop, %zu connections, %lds warmup + %lds\n",
+				 config.open_loop ? "open" : "closed", config.connections,
+				 static_cast<long>(config.warmup.count()),
+				 static_cast<long>(config.duration.count()));
+
+	std::vector<std::thread> threads;
+	for (auto& ioc : contexts) {
+		threads.emplace_back([&ioc]() { ioc->run(); });
+	}
+	for (auto& thread : threads) thread.join();
+
+	const std::string out = report(config, results).dump(2);
+	std::printf("%s\n", out.c_str());
+	if (!config.output.empty()) {
+		std::ofstream file(config.output, std::ios::trunc);
+		file << out << "\n";
+	}
+	return 0;
+}
@@ -0,0 +1,454 @@
+/**
+ * 微基准 (Google Benchmark): 路由分发, JWT, JSON 响应, 密码哈希, 验证码与邮箱校验,
+ * DAO 行映射 (内存结果集, 不访问数据库), 以及 memory 存储后端的 DAO 调用
+ *
+ * 用法: bench [--benchmark_filter=<regex>] [--benchmark_format=json]
+ *            [--benchmark_out=<file> --benchmark_out_format=json]
+ * JSON 结果可用 Google Benchmark 自带的 tools/compare.py 对比两个版本.
+ */
+#include "database/MemoryStore.h"
+#include "database/PlayHistoryDAO.h"
+#include "database/PlaylistDAO.h"
+#include "database/UserDAO.h"
+#include "server/Router.h"
+#include "utils/EmailUtil.h"
+#include "utils/JWTUtil.h"
+#include "utils/JsonUtil.h"
+#include "utils/PasswordUtil.h"
+
+#include <benchmark/benchmark.h>
+#include <jdbc/cppconn/resultset.h>
+
+#include <cstdlib>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief 内存结果集: 每列以文本保存 (与文本协议一致), 数值列读取时转换
+ *
+ * 只实现 DAO 行映射用到的前向游标与按序号读取, 其余接口抛 std::logic_error.
+ */
+class MemoryResultSet : public sql::ResultSet {
+public:
+	using Row = std::vector<std::optional<std::string>>;
+
+	explicit MemoryResultSet(std::vector<Row> rows) : m_rows(std::move(rows)) {}
+
+	// 回到第一行之前, 同一结果集在基准循环中重复使用
+	void rewind() { m_pos = 0; }
+
+	bool next() override { return ++m_pos <= m_rows.size(); }
+	size_t rowsCount() const override { return m_rows.size(); }
+	size_t getRow() const override { return m_pos <= m_rows.size() ? m_pos : 0; }
+
+	bool isNull(uint32_t index) const override { return !cell(index).has_value(); }
+	bool wasNull() const override { return m_was_null; }
+
+	sql::SQLString getString(uint32_t index) const override {
+		const auto& value = cell(index);
+		return value ? sql::SQLString(*value) : sql::SQLString();
+	}
+	int32_t getInt(uint32_t index) const override {
+		return static_cast<int32_t>(getInt64(index));
+	}
+	uint32_t getUInt(uint32_t index) const override {
+		return static_cast<uint32_t>(getUInt64(index));
+	}
+	int64_t getInt64(uint32_t index) const override {
+		const auto& value = cell(index);
+		return value ? std::strtoll(value->c_str(), nullptr, 10) : 0;
+	}
+	uint64_t getUInt64(uint32_t index) const override {
+		const auto& value = cell(index);
+		return value ? std::strtoull(value->c_str(), nullptr, 10) : 0;
+	}
+	long double getDouble(uint32_t index) const override {
+		const auto& value = cell(index);
+		return value ? std::strtold(value->c_str(), nullptr) : 0;
+	}
+	bool getBoolean(uint32_t index) const override { return getInt64(index) != 0; }
+
+	bool isBeforeFirst() const override { return m_pos == 0; }
+	bool isAfterLast() const override { return m_pos > m_rows.size(); }
+	bool isFirst() const override { return m_pos == 1; }
+	bool isLast() const override { return m_pos == m_rows.size(); }
+	bool isClosed() const override { return false; }
+	void close() override {}
+	enum_type getType() const override { return TYPE_FORWARD_ONLY; }
+
+	// 按列名读取与可滚动游标不在映射路径上
+	bool absolute(int) override { return unsupported<bool>(); }
+	void afterLast() override { unsupported<void>(); }
+	void beforeFirst() override { rewind(); }
+	void cancelRowUpdates() override { unsupported<void>(); }
+	void clearWarnings() override {}
+	uint32_t findColumn(const sql::SQLString&) const override { return unsupported<uint32_t>(); }
+	bool first() override { return unsupported<bool>(); }
+	std::istream* getBlob(uint32_t) const override { return unsupported<std::istream*>(); }
+	std::istream* getBlob(const sql::SQLString&) const override {
+		return unsupported<std::istream*>();
+	}
+	bool getBoolean(const sql::SQLString&) const override { return unsupported<bool>(); }
+	int getConcurrency() override { return CONCUR_READ_ONLY; }
+	sql::SQLString getCursorName() override { return unsupported<sql::SQLString>(); }
+	long double getDouble(const sql::SQLString&) const override {
+		return unsupported<long double>();
+	}
+	int getFetchDirection() override { return FETCH_FORWARD; }
+	size_t getFetchSize() override { return 0; }
+	int getHoldability() override { return unsupported<int>(); }
+	int32_t getInt(const sql::SQLString&) const override { return unsupported<int32_t>(); }
+	uint32_t getUInt(const sql::SQLString&) const override { return unsupported<uint32_t>(); }
+	int64_t getInt64(const sql::SQLString&) const override { return unsupported<int64_t>(); }
+	uint64_t getUInt64(const sql::SQLString&) const override { return unsupported<uint64_t>(); }
+	sql::ResultSetMetaData* getMetaData() const override {
+		return unsupported<sql::ResultSetMetaData*>();
+	}
+	sql::RowID* getRowId(uint32_t) override { return unsupported<sql::RowID*>(); }
+	sql::RowID* getRowId(const sql::SQLString&) override { return unsupported<sql::RowID*>(); }
+	const sql::Statement* getStatement() const override { return nullptr; }
+	sql::SQLString getString(const sql::SQLString&) const override {
+		return unsupported<sql::SQLString>();
+	}
+	void getWarnings() override {}
+	void insertRow() override { unsupported<void>(); }
+	bool isNull(const sql::SQLString&) const override { return unsupported<bool>(); }
+	bool last() override { return unsupported<bool>(); }
+	void moveToCurrentRow() override { unsupported<void>(); }
+	void moveToInsertRow() override { unsupported<void>(); }
+	bool previous() override { return unsupported<bool>(); }
+	void refreshRow() override { unsupported<void>(); }
+	bool relative(int) override { return unsupported<bool>(); }
+	bool rowDeleted() override { return false; }
+	bool rowInserted() override { return false; }
+	bool rowUpdated() override { return false; }
+	void setFetchSize(size_t) override {}
+
+private:
+	const std::optional<std::string>& cell(uint32_t index) const {
+		const auto& value = m_rows.at(m_pos - 1).at(index - 1);
+		m_was_null = !value.has_value();
+		return value;
+	}
+
+	template <typename T>
+	static T unsupported() {
+		throw std::logic_error("MemoryResultSet: not supported");
+	}
+
+private:
+	std::vector<Row> m_rows;
+	size_t m_pos = 0;
+	mutable bool m_was_null = false;
+};
+
+constexpr const char* JWT_SECRET = "bench-secret";
+
+// 歌曲列 (SongPool::COLUMNS): id, song_id, song_where + 0, name, singer, pic
+MemoryResultSet::Row songColumns(size_t i) {
+	return {std::to_string(1000 + i), "00" + std::to_string(400000 + i), std::string("1"),
+			"Song Name " + std::to_string(i), "Singer " + std::to_string(i % 97),
+			"https://y.qq.com/music/photo_new/T002R300x300M000" + std::to_string(i) + ".jpg"};
+}
+
+std::shared_ptr<MemoryResultSet> userRows(size_t n) {
+	std::vector<MemoryResultSet::Row> rows;
+	for (size_t i = 0; i < n; ++i) {
+		rows.push_back({std::to_string(i + 1), "user" + std::to_string(i),
+						PasswordUtil::hashPassword("password" + std::to_string(i)),
+						"user" + std::to_string(i) + "@example.com",
+						i % 2 == 0 ? std::optional<std::string>("12345678") : std::nullopt,
+						std::nullopt, std::string("1700000000"), std::string("1700000000")});
+	}
+	return std::make_shared<MemoryResultSet>(std::move(rows));
+}
+
+std::shared_ptr<MemoryResultSet> playlistSongRows(size_t n) {
+	std::vector<MemoryResultSet::Row> rows;
+	for (size_t i = 0; i < n; ++i) {
+		MemoryResultSet::Row row = {std::to_string(i + 1), std::string("1700000000")};
+		for (auto& column : songColumns(i)) row.push_back(std::move(column));
+		rows.push_back(std::move(row));
+	}
+	return std::make_shared<MemoryResultSet>(std::move(rows));
+}
+
+std::shared_ptr<MemoryResultSet> historyRows(size_t n) {
+	std::vector<MemoryResultSet::Row> rows;
+	for (size_t i = 0; i < n; ++i) {
+		MemoryResultSet::Row row = {std::to_string(i + 1), std::string("1"),
+									std::to_string(i % 13), std::to_string(1700000000 + i)};
+		for (auto& column : songColumns(i)) row.push_back(std::move(column));
+		rows.push_back(std::move(row));
+	}
+	return std::make_shared<MemoryResultSet>(std::move(rows));
+}
+
+SongMetaPtr memorySong(size_t i) {
+	auto song = std::make_shared<SongMeta>();
+	song->song_id = "00" + std::to_string(400000 + i);
+	song->name = "Song Name " + std::to_string(i);
+	song->singer = "Singer " + std::to_string(i % 97);
+	return song;
+}
+
+// memory 后端: 一个用户, 一个含 songs 首歌的歌单, 并按歌曲轮流写入 plays 次播放
+struct MemoryFixture {
+	MemoryStore store;
+	MemoryUserDAO users{&store};
+	MemoryPlaylistDAO playlists{&store};
+	MemoryPlayHistoryDAO history{&store};
+	int user_id = 0;
+	int playlist_id = 0;
+
+	MemoryFixture(size_t songs, size_t plays) {
+		User user;
+		user.username = "bench";
+		user.passwd_hash = "bench-password";
+		user.email = "bench@example.com";
+		users.createUser(user);
+		user_id = user.id;
+
+		Playlist playlist;
+		playlist.user_id = user_id;
+		playlist.name = "bench";
+		playlists.createPlaylist(playlist);
+		playlist_id = playlist.id;
+
+		for (size_t i = 0; i < songs; ++i) {
+			playlists.addSongToPlaylist(playlist_id, Song{0, 0, memorySong(i)});
+		}
+		for (size_t i = 0; i < plays; ++i) {
+			history.addPlayHistory(PlayHistory{0, user_id, 0, 0, memorySong(i % songs)});
+		}
+	}
+};
+
+HttpRequest makeRequest(http::verb method, const std::string& target) {
+	HttpRequest req{method, target, 11};
+	req.set(http::field::host, "localhost");
+	return req;
+}
+
+// 与 setupRoutes 相同的路由表, 处理函数只返回固定响应
+const Router& benchRouter() {
+	static const std::unique_ptr<Router> router = []() {
+		auto r = std::make_unique<Router>();
+		const std::pair<http::verb, const char*> routes[] = {
+			{http::verb::get, "/"},
+			{http::verb::post, "/users/register"},
+			{http::verb::post, "/users/verify_code"},
+			{http::verb::post, "/users/login"},
+			{http::verb::get, "/users/info"},
+			{http::verb::get, "/users/avatar"},
+			{http::verb::post, "/users/password"},
+			{http::verb::post, "/users/bind"},
+			{http::verb::post, "/playlists"},
+			{http::verb::get, "/playlists/songs"},
+			{http::verb::post, "/playlists/songs"},
+			{http::verb::post, "/playlists/add"},
+			{http::verb::post, "/playlists/erase"},
+			{http::verb::post, "/playlists/add/batch"},
+			{http::verb::post, "/playlists/erase/batch"},
+			{http::verb::post, "/playlists/create"},
+			{http::verb::post, "/playlists/delete"},
+			{http::verb::post, "/playlists/update"},
+			{http::verb::get, "/playlists/info"},
+			{http::verb::post, "/history"},
+			{http::verb::post, "/history/add"},
+			{http::verb::post, "/history/erase"},
+			{http::verb::post, "/history/clear"},
+			{http::verb::get, "/history/clear/status"},
+			{http::verb::post, "/history/like"},
+			{http::verb::get, "/history/stats"},
+			{http::verb::get, "/metrics"},
+		};
+		for (const auto& [method, path] : routes) {
+			r->addRouter(method, path, [](const HttpRequest& request) {
+				return JsonUtil::buildSuccessResponse(request.version(), R"({"code":200})");
+			});
+		}
+		return r;
+	}();
+	return *router;
+}
+
+void BM_RouterHandleRouter(benchmark::State& state) {
+	const Router& router = benchRouter();
+	const HttpRequest req = makeRequest(http::verb::get, "/playlists/songs?playlist_id=42");
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(router.handleRouter(req));
+	}
+}
+BENCHMARK(BM_RouterHandleRouter);
+
+void BM_RouterNotFound(benchmark::State& state) {
+	const Router& router = benchRouter();
+	const HttpRequest req = makeRequest(http::verb::get, "/no/such/route");
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(router.handleRouter(req));
+	}
+}
+BENCHMARK(BM_RouterNotFound);
+
+void BM_JwtGenerateToken(benchmark::State& state) {
+	const JWTUtil jwt(JWT_SECRET);
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(jwt.generateToken(
+			"user42", {{"id", "42"}, {"email", "user42@example.com"}}, std::chrono::hours{24}));
+	}
+}
+BENCHMARK(BM_JwtGenerateToken);
+
+void BM_JwtVerifyToken(benchmark::State& state) {
+	const JWTUtil jwt(JWT_SECRET);
+	const std::string token =
+		jwt.generateToken("user42", {{"id", "42"}, {"email", "user42@example.com"}});
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(jwt.verifyToken(token));
+	}
+}
+BENCHMARK(BM_JwtVerifyToken);
+
+void BM_JwtGetClaim(benchmark::State& state) {
+	const JWTUtil jwt(JWT_SECRET);
+	const std::string token =
+		jwt.generateToken("user42", {{"id", "42"}, {"email", "user42@example.com"}});
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(JWTUtil::getClaim(token, "id"));
+	}
+}
+BENCHMARK(BM_JwtGetClaim);
+
+void BM_JsonBuildSuccessResponse(benchmark::State& state) {
+	json songs = json::array();
+	for (int64_t i = 0; i < state.range(0); ++i) {
+		songs.push_back({{"song_id", "00" + std::to_string(400000 + i)},
+						 {"name", "Song Name " + std::to_string(i)},
+						 {"singer", "Singer " + std::to_string(i % 97)},
+						 {"where", "QQ"}});
+	}
+	const json body = {{"code", 200}, {"message", "ok"}, {"songs", songs}};
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(JsonUtil::buildSuccessResponse(11, JsonUtil::dump(body)));
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_JsonBuildSuccessResponse)->Arg(1)->Arg(100)->Arg(1000);
+
+void BM_JsonBuildErrorResponse(benchmark::State& state) {
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(
+			JsonUtil::buildErrorResponse(http::status::not_found, 11, "Playlist not found"));
+	}
+}
+BENCHMARK(BM_JsonBuildErrorResponse);
+
+void BM_PasswordHash(benchmark::State& state) {
+	const std::string password = "correct horse battery staple";
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(PasswordUtil::hashPassword(password));
+	}
+}
+BENCHMARK(BM_PasswordHash);
+
+void BM_EmailGenerateVerificationCode(benchmark::State& state) {
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(EmailUtil::generateVerificationCode());
+	}
+}
+BENCHMARK(BM_EmailGenerateVerificationCode);
+
+void BM_EmailIsValid(benchmark::State& state) {
+	const std::string email = "someone.long_name+tag@mail.example.com";
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(EmailUtil::isValidEmail(email));
+	}
+}
+BENCHMARK(BM_EmailIsValid);
+
+void BM_UserFromResultSet(benchmark::State& state) {
+	auto result = userRows(static_cast<size_t>(state.range(0)));
+	const ResultSetPtr ptr = result;
+	for (auto _ : state) {
+		result->rewind();
+		while (result->next()) benchmark::DoNotOptimize(MySqlUserDAO::buildFromResultSet(ptr));
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_UserFromResultSet)->Arg(100);
+
+// 歌曲已驻留在 SongPool 中 (热): 只读 id 列
+void BM_PlaylistSongFromResultSet(benchmark::State& state) {
+	auto result = playlistSongRows(static_cast<size_t>(state.range(0)));
+	const ResultSetPtr ptr = result;
+	std::vector<Song> songs;
+	while (result->next()) songs.push_back(MySqlPlaylistDAO::buildSongFromResultSet(ptr));
+
+	for (auto _ : state) {
+		result->rewind();
+		while (result->next())
+			benchmark::DoNotOptimize(MySqlPlaylistDAO::buildSongFromResultSet(ptr));
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_PlaylistSongFromResultSet)->Arg(100)->Arg(1000);
+
+// 歌曲未驻留 (冷): 每行读取全部字符串列并驻留, 映射结果随即释放
+void BM_HistoryFromResultSetCold(benchmark::State& state) {
+	auto result = historyRows(static_cast<size_t>(state.range(0)));
+	const ResultSetPtr ptr = result;
+	for (auto _ : state) {
+		result->rewind();
+		while (result->next())
+			benchmark::DoNotOptimize(MySqlPlayHistoryDAO::buildFromResultSet(ptr));
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_HistoryFromResultSetCold)->Arg(100);
+
+// memory 后端读取歌单全部歌曲 (不经过快照缓存)
+void BM_MemoryPlaylistSongs(benchmark::State& state) {
+	PlaylistCache::init(1024);
+	MemoryFixture fixture(static_cast<size_t>(state.range(0)), 0);
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(fixture.playlists.getSongsInPlaylist(fixture.playlist_id));
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_MemoryPlaylistSongs)->Arg(100)->Arg(1000);
+
+// memory 后端写入一次播放 (含汇总计数)
+void BM_MemoryAddPlayHistory(benchmark::State& state) {
+	PlaylistCache::init(1024);
+	MemoryFixture fixture(1000, 0);
+	std::vector<SongMetaPtr> songs;
+	for (size_t i = 0; i < 1000; ++i) songs.push_back(memorySong(i));
+
+	size_t i = 0;
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(fixture.history.addPlayHistory(
+			PlayHistory{0, fixture.user_id, 0, 0, songs[i++ % songs.size()]}));
+	}
+}
+BENCHMARK(BM_MemoryAddPlayHistory);
+
+// memory 后端用户统计: 对汇总计数部分排序取 top-10
+void BM_MemoryUserStats(benchmark::State& state) {
+	PlaylistCache::init(1024);
+	MemoryFixture fixture(static_cast<size_t>(state.range(0)), 10000);
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(fixture.history.getUserStats(fixture.user_id, 10));
+	}
+}
+BENCHMARK(BM_MemoryUserStats)->Arg(100)->Arg(1000);
+
+} // namespace
+
+BENCHMARK_MAIN();
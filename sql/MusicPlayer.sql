@@ -1,9 +1,18 @@
 USE HW_MusicPlayer;
 
+# 建表后执行 procedures.sql 创建存储过程
+
 # 删除所有表
+DROP TABLE IF EXISTS deletion_jobs;
+DROP TABLE IF EXISTS play_history_compactions;
+DROP TABLE IF EXISTS play_history_daily;
+DROP TABLE IF EXISTS user_play_stats;
+DROP TABLE IF EXISTS user_artist_stats;
+DROP TABLE IF EXISTS user_song_stats;
 DROP TABLE IF EXISTS playlist_songs;
 DROP TABLE IF EXISTS play_history;
 DROP TABLE IF EXISTS playlists;
+DROP TABLE IF EXISTS songs;
 DROP TABLE IF EXISTS users;
 
 
@@ -16,7 +25,23 @@ CREATE TABLE users (
 	qq_id VARCHAR(50),
 	netease_id VARCHAR(50),
 	create_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,
-	update_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP ON UPDATE CURRENT_TIMESTAMP
+	update_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP ON UPDATE CURRENT_TIMESTAMP,
+	deleted_at TIMESTAMP NULL, -- 已注销, 数据由 deletion_jobs 分批删除
+	-- 清空历史时的水位线, id 不超过它的播放历史/按日汇总不可见
+	history_cleared_id BIGINT NOT NULL DEFAULT 0,
+	daily_cleared_id BIGINT NOT NULL DEFAULT 0
+);
+
+-- 歌曲维表, 歌曲元数据只存一份, 歌单/历史/统计按 id 引用
+CREATE TABLE songs (
+	id INT AUTO_INCREMENT PRIMARY KEY,
+	song_id VARCHAR(50) CHARACTER SET utf8mb4 COLLATE utf8mb4_bin NOT NULL, -- 平台歌曲 id 区分大小写
+	song_where ENUM('QQ','NetEase') NOT NULL,
+	song_name VARCHAR(255) NOT NULL,
+	song_singer VARCHAR(255) NOT NULL,
+	song_pic VARCHAR(255),
+
+	UNIQUE KEY(song_id, song_where)
 );
 
 -- 歌单表
@@ -36,32 +61,102 @@ CREATE TABLE playlist_songs (
 	id INT AUTO_INCREMENT PRIMARY KEY,
 	
 	playlist_id INT NOT NULL,
-	song_id VARCHAR(50) NOT NULL,
-	song_name VARCHAR(255) NOT NULL,
-	song_singer VARCHAR(255) NOT NULL,
-	song_pic VARCHAR(255),
-	song_where ENUM('QQ','NetEase') NOT NULL,
+	song_ref INT NOT NULL, -- songs.id
 	
 	added_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,
 	
 	FOREIGN KEY (playlist_id) REFERENCES playlists(id) ON DELETE CASCADE,
-	UNIQUE KEY(playlist_id, song_id, song_where)
+	FOREIGN KEY (song_ref) REFERENCES songs(id),
+	UNIQUE KEY(playlist_id, song_ref),
+	KEY idx_playlist_id (playlist_id, id) -- 按主键分页导出
 );
 
--- 播放历史表
+-- 播放历史表, 每次播放一行, 只追加
+-- 按月 RANGE 分区, 分区由服务端维护 (HistoryPartitions): 提前创建未来的分区, 超过保留期的
+-- 分区先按日汇总到 play_history_daily 再整体删除. 分区表不支持外键, 且唯一键须包含分区列
 CREATE TABLE play_history(
-	id INT AUTO_INCREMENT PRIMARY KEY,
-	user_id INT  NOT NULL,
-	
-	song_id VARCHAR(50) NOT NULL,
-	song_name VARCHAR(255) NOT NULL,
+	id BIGINT AUTO_INCREMENT,
+	user_id INT NOT NULL,
+	song_ref INT NOT NULL, -- songs.id
+	played_at TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP,
+
+	PRIMARY KEY (id, played_at),
+	KEY idx_user_id (user_id, id), -- 按主键分页导出/分批删除
+	KEY idx_user_played (user_id, played_at),
+	KEY idx_played_at (played_at) -- 按日汇总
+)
+PARTITION BY RANGE (UNIX_TIMESTAMP(played_at)) (
+	PARTITION p_initial VALUES LESS THAN (UNIX_TIMESTAMP('2025-01-01 00:00:00'))
+);
+
+-- 超过保留期的播放历史, 按 (用户, 日, 歌曲) 汇总
+CREATE TABLE play_history_daily (
+	id BIGINT AUTO_INCREMENT PRIMARY KEY,
+	user_id INT NOT NULL,
+	song_ref INT NOT NULL, -- songs.id
+	day DATE NOT NULL,
+	play_count INT NOT NULL,
+
+	UNIQUE KEY uk_user_day_song (user_id, day, song_ref),
+	KEY idx_user_id (user_id, id),
+	FOREIGN KEY (user_id) REFERENCES users(id) ON DELETE CASCADE,
+	FOREIGN KEY (song_ref) REFERENCES songs(id)
+);
+
+-- 过期分区的汇总进度, 每个分区一行, 中断后从 compacted_until 的下一天继续
+CREATE TABLE play_history_compactions (
+	partition_name VARCHAR(16) PRIMARY KEY,
+	bound BIGINT NOT NULL, -- 分区上界 (Unix 秒), 登记后早于它的导入直接写入按日汇总
+	compacted_until DATE NULL, -- 已汇总到的日期, 与该日的汇总在同一事务中更新
+	started_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,
+	finished_at TIMESTAMP NULL -- 分区已删除
+);
+
+-- 播放统计汇总表, 随播放事件增量维护, 可由 play_history 重算
+-- 用户每首歌的播放次数
+CREATE TABLE user_song_stats (
+	user_id INT NOT NULL,
+	song_ref INT NOT NULL, -- songs.id
+	play_count INT NOT NULL DEFAULT 0,
+
+	PRIMARY KEY (user_id, song_ref),
+	KEY idx_user_count (user_id, play_count),
+	FOREIGN KEY (user_id) REFERENCES users(id) ON DELETE CASCADE,
+	FOREIGN KEY (song_ref) REFERENCES songs(id)
+);
+
+-- 用户每位歌手的播放次数
+CREATE TABLE user_artist_stats (
+	user_id INT NOT NULL,
 	song_singer VARCHAR(255) NOT NULL,
-	song_pic VARCHAR(255),
-	song_where ENUM('QQ','NetEase') NOT NULL,
-	song_count INT DEFAULT 0, -- 播放次数
-	
-	played_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,
-	
+	play_count INT NOT NULL DEFAULT 0,
+
+	PRIMARY KEY (user_id, song_singer),
+	KEY idx_user_count (user_id, play_count),
 	FOREIGN KEY (user_id) REFERENCES users(id) ON DELETE CASCADE
 );
 
+-- 用户总播放次数
+CREATE TABLE user_play_stats (
+	user_id INT PRIMARY KEY,
+	total_plays BIGINT NOT NULL DEFAULT 0,
+
+	FOREIGN KEY (user_id) REFERENCES users(id) ON DELETE CASCADE
+);
+
+-- 后台删除任务: 清空播放历史 / 注销账号, 按批删除并记录进度
+CREATE TABLE deletion_jobs (
+	id INT AUTO_INCREMENT PRIMARY KEY,
+	kind ENUM('history','user') NOT NULL,
+	user_id INT NOT NULL, -- 不建外键, 注销任务最后删除用户行
+	cutoff_id BIGINT NOT NULL DEFAULT 0, -- history: 删除 id 不超过它的播放历史
+	state ENUM('pending','running','done','failed') NOT NULL DEFAULT 'pending',
+	deleted_rows BIGINT NOT NULL DEFAULT 0,
+	attempts INT NOT NULL DEFAULT 0,
+	error VARCHAR(255),
+	created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,
+	updated_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP ON UPDATE CURRENT_TIMESTAMP,
+
+	KEY idx_state (state, id),
+	KEY idx_user (user_id, kind)
+);
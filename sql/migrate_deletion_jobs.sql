@@ -0,0 +1,28 @@
+USE HW_MusicPlayer;
+
+# 清空历史/注销账号改为后台分批删除
+# 执行后重新执行 procedures.sql (record_play 需跳过已清空的记录)
+
+ALTER TABLE users
+	ADD COLUMN deleted_at TIMESTAMP NULL,
+	ADD COLUMN history_cleared_id INT NOT NULL DEFAULT 0;
+
+CREATE TABLE IF NOT EXISTS deletion_jobs (
+	id INT AUTO_INCREMENT PRIMARY KEY,
+	kind ENUM('history','user') NOT NULL,
+	user_id INT NOT NULL,
+	cutoff_id INT NOT NULL DEFAULT 0,
+	state ENUM('pending','running','done','failed') NOT NULL DEFAULT 'pending',
+	deleted_rows BIGINT NOT NULL DEFAULT 0,
+	attempts INT NOT NULL DEFAULT 0,
+	error VARCHAR(255),
+	created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,
+	updated_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP ON UPDATE CURRENT_TIMESTAMP,
+
+	KEY idx_state (state, id),
+	KEY idx_user (user_id, kind)
+);
+
+-- 观察: 删除期间的 undo 积压 (History list length) 与行锁等待
+SHOW ENGINE INNODB STATUS;
+SELECT kind, state, COUNT(*), SUM(deleted_rows) FROM deletion_jobs GROUP BY kind, state;
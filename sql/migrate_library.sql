@@ -0,0 +1,11 @@
+USE HW_MusicPlayer;
+
+# 曲库导出按主键分页 (WHERE ... AND id > ? ORDER BY id LIMIT ?)
+# 已有唯一键以 song_ref 为第二列, 无法按 id 顺序扫描, 补充 (外键列, id) 索引
+
+ALTER TABLE playlist_songs ADD KEY idx_playlist_id (playlist_id, id);
+ALTER TABLE play_history ADD KEY idx_user_id (user_id, id);
+
+-- 验证: 应使用新索引且 Extra 中没有 Using filesort
+EXPLAIN SELECT id FROM play_history WHERE user_id = 1 AND id > 0 ORDER BY id LIMIT 1000;
+EXPLAIN SELECT id FROM playlist_songs WHERE playlist_id = 1 AND id > 0 ORDER BY id LIMIT 1000;
@@ -0,0 +1,85 @@
+USE HW_MusicPlayer;
+
+# play_history 改为每次播放一行并按月分区, 旧数据按 (用户, 歌曲) 汇总, 无法还原逐次明细:
+# 每行保留最后一次播放为明细, 其余次数记入 play_history_daily (最后播放当日)
+# 执行前停止服务, 执行后重新执行 procedures.sql; 汇总表总数不变, 无需重算
+
+ALTER TABLE users
+	MODIFY history_cleared_id BIGINT NOT NULL DEFAULT 0,
+	ADD COLUMN daily_cleared_id BIGINT NOT NULL DEFAULT 0;
+
+ALTER TABLE deletion_jobs MODIFY cutoff_id BIGINT NOT NULL DEFAULT 0;
+
+CREATE TABLE play_history_new (
+	id BIGINT AUTO_INCREMENT,
+	user_id INT NOT NULL,
+	song_ref INT NOT NULL,
+	played_at TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP,
+
+	PRIMARY KEY (id, played_at),
+	KEY idx_user_id (user_id, id),
+	KEY idx_user_played (user_id, played_at),
+	KEY idx_played_at (played_at) -- 按日汇总
+)
+PARTITION BY RANGE (UNIX_TIMESTAMP(played_at)) (
+	PARTITION p_initial VALUES LESS THAN (UNIX_TIMESTAMP('2025-01-01 00:00:00'))
+);
+
+CREATE TABLE IF NOT EXISTS play_history_daily (
+	id BIGINT AUTO_INCREMENT PRIMARY KEY,
+	user_id INT NOT NULL,
+	song_ref INT NOT NULL,
+	day DATE NOT NULL,
+	play_count INT NOT NULL,
+
+	UNIQUE KEY uk_user_day_song (user_id, day, song_ref),
+	KEY idx_user_id (user_id, id),
+	FOREIGN KEY (user_id) REFERENCES users(id) ON DELETE CASCADE,
+	FOREIGN KEY (song_ref) REFERENCES songs(id)
+);
+
+CREATE TABLE IF NOT EXISTS play_history_compactions (
+	partition_name VARCHAR(16) PRIMARY KEY,
+	bound BIGINT NOT NULL, -- 分区上界 (Unix 秒), 登记后早于它的导入直接写入按日汇总
+	compacted_until DATE NULL, -- 已汇总到的日期, 与该日的汇总在同一事务中更新
+	started_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,
+	finished_at TIMESTAMP NULL -- 分区已删除
+);
+
+-- 新分区须在写入前创建, 覆盖到当前月之后 (服务启动时也会补齐)
+ALTER TABLE play_history_new ADD PARTITION (
+	PARTITION p_migrated VALUES LESS THAN (UNIX_TIMESTAMP(
+		DATE_FORMAT(CURRENT_DATE + INTERVAL 1 MONTH, '%Y-%m-01')))
+);
+
+-- 只迁移可见记录 (已清空待删除的不迁移)
+INSERT INTO play_history_new (user_id, song_ref, played_at)
+SELECT h.user_id, h.song_ref, h.played_at FROM play_history h
+JOIN users u ON u.id = h.user_id
+WHERE h.id > u.history_cleared_id AND u.deleted_at IS NULL AND h.song_count > 0;
+
+INSERT INTO play_history_daily (user_id, song_ref, day, play_count)
+SELECT h.user_id, h.song_ref, DATE(h.played_at), h.song_count - 1 FROM play_history h
+JOIN users u ON u.id = h.user_id
+WHERE h.id > u.history_cleared_id AND u.deleted_at IS NULL AND h.song_count > 1;
+
+-- 旧表的 id 与新表无关, 水位线清零; 已清空的记录未迁移, 未完成的清空任务直接完成
+UPDATE users SET history_cleared_id = 0 WHERE history_cleared_id > 0;
+UPDATE deletion_jobs SET state = 'done' WHERE kind = 'history' AND state IN ('pending', 'running');
+
+RENAME TABLE play_history TO play_history_old, play_history_new TO play_history;
+
+-- 核对后删除旧表: 两边总次数应一致
+SELECT
+	(SELECT COALESCE(SUM(total_plays), 0) FROM user_play_stats) AS stats_total,
+	(SELECT COUNT(*) FROM play_history) + (SELECT COALESCE(SUM(play_count), 0)
+		FROM play_history_daily) AS history_total;
+-- DROP TABLE play_history_old;
+
+-- 观察: 各分区行数与大小
+SELECT PARTITION_NAME, PARTITION_DESCRIPTION, TABLE_ROWS,
+	ROUND(DATA_LENGTH / 1024 / 1024, 2) AS data_mb,
+	ROUND(INDEX_LENGTH / 1024 / 1024, 2) AS index_mb
+FROM information_schema.PARTITIONS
+WHERE TABLE_SCHEMA = DATABASE() AND TABLE_NAME = 'play_history'
+ORDER BY PARTITION_ORDINAL_POSITION;
@@ -0,0 +1,8 @@
+USE HW_MusicPlayer;
+
+# songs.song_id 改为区分大小写 (utf8mb4_bin)
+# 平台歌曲 id 区分大小写; 原排序规则下大小写不同的 id 会落到同一行, 而 SongPool 按原字符串
+# 取回 id, 导致批量解析失败. 原唯一键已保证不存在仅大小写不同的行, 修改不会冲突.
+
+ALTER TABLE songs
+	MODIFY song_id VARCHAR(50) CHARACTER SET utf8mb4 COLLATE utf8mb4_bin NOT NULL;
@@ -0,0 +1,87 @@
+USE HW_MusicPlayer;
+
+# 将歌单/历史/统计中重复存放的歌曲元数据迁移到 songs 维表
+# 执行前后分别运行末尾的测量语句, 对比表空间与缓冲池命中率
+
+-- 1. 建维表
+CREATE TABLE IF NOT EXISTS songs (
+	id INT AUTO_INCREMENT PRIMARY KEY,
+	song_id VARCHAR(50) CHARACTER SET utf8mb4 COLLATE utf8mb4_bin NOT NULL,
+	song_where ENUM('QQ','NetEase') NOT NULL,
+	song_name VARCHAR(255) NOT NULL,
+	song_singer VARCHAR(255) NOT NULL,
+	song_pic VARCHAR(255),
+
+	UNIQUE KEY(song_id, song_where)
+);
+
+-- 2. 收集已有歌曲, 同一首歌保留最后写入的元数据
+INSERT INTO songs (song_id, song_where, song_name, song_singer, song_pic)
+SELECT song_id, song_where, song_name, song_singer, song_pic FROM play_history
+ON DUPLICATE KEY UPDATE song_name = VALUES(song_name), song_singer = VALUES(song_singer),
+	song_pic = VALUES(song_pic);
+
+INSERT INTO songs (song_id, song_where, song_name, song_singer, song_pic)
+SELECT song_id, song_where, song_name, song_singer, song_pic FROM playlist_songs
+ON DUPLICATE KEY UPDATE song_name = VALUES(song_name), song_singer = VALUES(song_singer),
+	song_pic = VALUES(song_pic);
+
+-- 3. 歌单歌曲
+ALTER TABLE playlist_songs ADD COLUMN song_ref INT NULL AFTER playlist_id;
+UPDATE playlist_songs ps JOIN songs s ON s.song_id = ps.song_id AND s.song_where = ps.song_where
+SET ps.song_ref = s.id;
+ALTER TABLE playlist_songs
+	DROP INDEX playlist_id,
+	DROP COLUMN song_id,
+	DROP COLUMN song_name,
+	DROP COLUMN song_singer,
+	DROP COLUMN song_pic,
+	DROP COLUMN song_where,
+	MODIFY song_ref INT NOT NULL,
+	ADD UNIQUE KEY(playlist_id, song_ref),
+	ADD FOREIGN KEY (song_ref) REFERENCES songs(id);
+
+-- 4. 播放历史
+ALTER TABLE play_history ADD COLUMN song_ref INT NULL AFTER user_id;
+UPDATE play_history h JOIN songs s ON s.song_id = h.song_id AND s.song_where = h.song_where
+SET h.song_ref = s.id;
+ALTER TABLE play_history
+	DROP COLUMN song_id,
+	DROP COLUMN song_name,
+	DROP COLUMN song_singer,
+	DROP COLUMN song_pic,
+	DROP COLUMN song_where,
+	MODIFY song_ref INT NOT NULL,
+	ADD UNIQUE KEY uk_user_song (user_id, song_ref),
+	ADD FOREIGN KEY (song_ref) REFERENCES songs(id);
+
+-- 5. 统计汇总表可由 play_history 重算, 直接重建
+DROP TABLE IF EXISTS user_song_stats;
+CREATE TABLE user_song_stats (
+	user_id INT NOT NULL,
+	song_ref INT NOT NULL, -- songs.id
+	play_count INT NOT NULL DEFAULT 0,
+
+	PRIMARY KEY (user_id, song_ref),
+	KEY idx_user_count (user_id, play_count),
+	FOREIGN KEY (user_id) REFERENCES users(id) ON DELETE CASCADE,
+	FOREIGN KEY (song_ref) REFERENCES songs(id)
+);
+
+INSERT INTO user_song_stats (user_id, song_ref, play_count)
+SELECT user_id, song_ref, SUM(song_count) FROM play_history GROUP BY user_id, song_ref;
+
+-- 测量: 各表数据与索引大小 (先 ANALYZE 刷新统计)
+ANALYZE TABLE songs, playlist_songs, play_history, user_song_stats;
+SELECT TABLE_NAME, TABLE_ROWS,
+	ROUND(DATA_LENGTH / 1024 / 1024, 2) AS data_mb,
+	ROUND(INDEX_LENGTH / 1024 / 1024, 2) AS index_mb
+FROM information_schema.TABLES
+WHERE TABLE_SCHEMA = DATABASE()
+	AND TABLE_NAME IN ('songs', 'playlist_songs', 'play_history', 'user_song_stats');
+
+-- 测量: 缓冲池命中率, 在相同负载运行一段时间后取两次差值计算
+-- hit_rate = 1 - Δreads / Δread_requests
+SHOW GLOBAL STATUS WHERE Variable_name IN
+	('Innodb_buffer_pool_read_requests', 'Innodb_buffer_pool_reads',
+	 'Innodb_buffer_pool_pages_data', 'Innodb_buffer_pool_pages_total');
@@ -0,0 +1,99 @@
+USE HW_MusicPlayer;
+
+# 存储过程: 把 "写入 + 取回 id/计数" 合并为一次往返
+# 在 MusicPlayer.sql 之后执行, 可重复执行
+
+DELIMITER //
+
+-- 注册用户, 用户名/邮箱重复时报 1062
+DROP PROCEDURE IF EXISTS create_user //
+CREATE PROCEDURE create_user(
+	IN p_username VARCHAR(50),
+	IN p_passwd_hash VARCHAR(255),
+	IN p_email VARCHAR(50))
+BEGIN
+	INSERT INTO users (username, passwd_hash, email) VALUES (p_username, p_passwd_hash, p_email);
+	SELECT LAST_INSERT_ID() AS id;
+END //
+
+-- 创建歌单, 用户不存在或已注销时报 1452
+-- 共享锁住用户行, 与注销 (FOR UPDATE) 互斥, 注销提交后不会再写入
+DROP PROCEDURE IF EXISTS create_playlist //
+CREATE PROCEDURE create_playlist(
+	IN p_user_id INT,
+	IN p_name VARCHAR(50),
+	IN p_cover VARCHAR(255))
+BEGIN
+	INSERT INTO playlists (user_id, name, cover)
+	SELECT id, p_name, p_cover FROM users
+	WHERE id = p_user_id AND deleted_at IS NULL FOR SHARE;
+	IF ROW_COUNT() = 0 THEN
+		SIGNAL SQLSTATE '23000' SET MYSQL_ERRNO = 1452, MESSAGE_TEXT = 'User not found';
+	END IF;
+	SELECT LAST_INSERT_ID() AS id;
+END //
+
+-- 写入/更新歌曲维表, 返回 songs.id
+DROP PROCEDURE IF EXISTS resolve_song //
+CREATE PROCEDURE resolve_song(
+	IN p_song_id VARCHAR(50),
+	IN p_song_where VARCHAR(10),
+	IN p_song_name VARCHAR(255),
+	IN p_song_singer VARCHAR(255),
+	IN p_song_pic VARCHAR(255))
+BEGIN
+	INSERT INTO songs (song_id, song_where, song_name, song_singer, song_pic)
+	VALUES (p_song_id, p_song_where, p_song_name, p_song_singer, p_song_pic)
+	ON DUPLICATE KEY UPDATE id = LAST_INSERT_ID(id), song_name = VALUES(song_name),
+		song_singer = VALUES(song_singer), song_pic = VALUES(song_pic);
+	SELECT LAST_INSERT_ID() AS id;
+END //
+
+-- 记录一次播放: 播放历史与三张汇总表, 返回更新后的计数
+-- 不自行开启事务, 由调用方在事务中执行; 用户不存在或已注销时报 1452
+-- (play_history 没有外键, 共享锁住用户行到事务结束, 与注销互斥)
+DROP PROCEDURE IF EXISTS record_play //
+CREATE PROCEDURE record_play(
+	IN p_user_id INT,
+	IN p_song_ref INT,
+	IN p_song_singer VARCHAR(255))
+BEGIN
+	DECLARE v_live INT DEFAULT 0;
+	SELECT COUNT(*) INTO v_live FROM users
+	WHERE id = p_user_id AND deleted_at IS NULL FOR SHARE;
+	IF v_live = 0 THEN
+		SIGNAL SQLSTATE '23000' SET MYSQL_ERRNO = 1452, MESSAGE_TEXT = 'User not found';
+	END IF;
+
+	INSERT INTO play_history (user_id, song_ref) VALUES (p_user_id, p_song_ref);
+
+	INSERT INTO user_song_stats (user_id, song_ref, play_count) VALUES (p_user_id, p_song_ref, 1)
+	ON DUPLICATE KEY UPDATE play_count = play_count + 1;
+
+	INSERT INTO user_artist_stats (user_id, song_singer, play_count)
+	VALUES (p_user_id, p_song_singer, 1)
+	ON DUPLICATE KEY UPDATE play_count = play_count + 1;
+
+	INSERT INTO user_play_stats (user_id, total_plays) VALUES (p_user_id, 1)
+	ON DUPLICATE KEY UPDATE total_plays = total_plays + 1;
+
+	SELECT
+		(SELECT play_count FROM user_song_stats
+		 WHERE user_id = p_user_id AND song_ref = p_song_ref) AS song_count,
+		(SELECT play_count FROM user_artist_stats
+		 WHERE user_id = p_user_id AND song_singer = p_song_singer) AS artist_count,
+		(SELECT total_plays FROM user_play_stats WHERE user_id = p_user_id) AS total;
+END //
+
+-- 登记删除任务, 返回任务 id; p_kind 为 ENUM 下标 (1 history, 2 user)
+DROP PROCEDURE IF EXISTS create_deletion_job //
+CREATE PROCEDURE create_deletion_job(
+	IN p_kind TINYINT,
+	IN p_user_id INT,
+	IN p_cutoff_id BIGINT)
+BEGIN
+	INSERT INTO deletion_jobs (kind, user_id, cutoff_id) VALUES (p_kind, p_user_id, p_cutoff_id);
+	SELECT LAST_INSERT_ID() AS id;
+END //
+
+DELIMITER ;
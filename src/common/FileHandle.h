@@ -0,0 +1,34 @@
+#pragma once
+
+#include <unistd.h>
+
+#include <utility>
+
+/**
+ * @brief 文件描述符 RAII 封装
+ */
+class FileHandle {
+public:
+	explicit FileHandle(int fd = -1) noexcept : m_fd(fd) {}
+	~FileHandle() {
+		if (m_fd >= 0) ::close(m_fd);
+	}
+
+	FileHandle(const FileHandle&) = delete;
+	FileHandle& operator=(const FileHandle&) = delete;
+	FileHandle(FileHandle&& other) noexcept : m_fd(std::exchange(other.m_fd, -1)) {}
+	FileHandle& operator=(FileHandle&& other) noexcept {
+		if (this != &other) {
+			if (m_fd >= 0) ::close(m_fd);
+			m_fd = std::exchange(other.m_fd, -1);
+		}
+		return *this;
+	}
+
+	int get() const noexcept { return m_fd; }
+
+	explicit operator bool() const noexcept { return m_fd >= 0; }
+
+private:
+	int m_fd;
+};
@@ -0,0 +1,23 @@
+#pragma once
+#include <jdbc/cppconn/exception.h>
+
+/**
+ * @brief DAO 写操作结果, 由数据库约束判定冲突, 不再先查后写
+ */
+enum class DAOStatus {
+	Ok,
+	Conflict, // 唯一键冲突
+	NotFound, // 引用的行不存在 (外键约束)
+	Error,
+};
+
+inline DAOStatus toDAOStatus(const sql::SQLException& e) {
+	switch (e.getErrorCode()) {
+	case 1062: // ER_DUP_ENTRY
+		return DAOStatus::Conflict;
+	case 1452: // ER_NO_REFERENCED_ROW_2
+		return DAOStatus::NotFound;
+	default:
+		return DAOStatus::Error;
+	}
+}
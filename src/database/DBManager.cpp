@@ -8,6 +8,8 @@
 #include <jdbc/cppconn/prepared_statement.h>
 #include <spdlog/spdlog.h>
 
+#include "../utils/Metrics.h"
+
 #include <memory>
 #include <mutex>
 #include <string>
@@ -17,6 +19,36 @@ constexpr const char* TAG = "[DBManager]";
 
 std::unique_ptr<DBManager> DBManager::m_instance = nullptr;
 
+namespace {
+
+struct PoolMetrics {
+	MetricHistogram& wait;
+	MetricCounter& checkouts;
+	MetricCounter& timeouts;
+	MetricCounter& reconnects;
+	MetricCounter& reconnect_failures;
+	MetricGauge& size;
+	MetricGauge& available;
+};
+
+PoolMetrics& poolMetrics() {
+	static PoolMetrics metrics = []() {
+		auto* registry = MetricsRegistry::getInstance();
+		const std::string reconnects_help = "Invalid connections reconnected on checkout";
+		return PoolMetrics{
+			registry->histogram("db_pool_wait_seconds", "Time spent waiting for a connection"),
+			registry->counter("db_pool_checkouts_total", "Connections taken from the pool"),
+			registry->counter("db_pool_timeouts_total", "Checkouts that timed out"),
+			registry->counter("db_reconnects_total", reconnects_help, {{"result", "ok"}}),
+			registry->counter("db_reconnects_total", reconnects_help, {{"result", "failed"}}),
+			registry->gauge("db_pool_size", "Connections created at startup"),
+			registry->gauge("db_pool_available", "Idle connections in the pool")};
+	}();
+	return metrics;
+}
+
+} // namespace
+
 DBManager::~DBManager() {
 	for (auto& conn : m_connections) {
 		try {
@@ -50,6 +82,8 @@ DBManager::DBManager(std::string host, uint16_t port, std::string user, std::str
 			this->m_connections.push_back(SqlConnPtr{conn});
 		}
 
+		poolMetrics().size.set(static_cast<int64_t>(m_connections.size()));
+		poolMetrics().available.set(static_cast<int64_t>(m_connections.size()));
 		spdlog::info("{} Create connection pool success, size: {}", TAG, pool_size);
 	} catch (sql::SQLException& e) {
 		spdlog::critical(
@@ -75,21 +109,27 @@ DBManager* DBManager::getInstance() {
 }
 
 SqlConnPtr DBManager::getConnection(std::chrono::seconds timeout) {
+	PoolMetrics& metrics = poolMetrics();
 	SqlConnPtr conn;
 	{
+		MetricTimer timer(metrics.wait);
+		TraceSpan span("db.pool_wait");
 		std::unique_lock<std::mutex> lock(m_mtx);
 		if (m_connections.empty()) {
 			m_cv.wait_for(lock, timeout, [this]() { return !m_connections.empty(); });
 		}
 
 		if (m_connections.empty()) {
+			metrics.timeouts.inc();
 			spdlog::error("{} No available connection", TAG);
 			return nullptr;
 		}
 
 		conn = m_connections.front();
 		m_connections.pop_front();
+		metrics.available.set(static_cast<int64_t>(m_connections.size()));
 	}
+	metrics.checkouts.inc();
 
 	try {
 		// 无效重新连接
@@ -100,9 +140,11 @@ SqlConnPtr DBManager::getConnection(std::chrono::seconds timeout) {
 			// conn.reset(m_driver->connect("tcp://" + m_host + ":" + std::to_string(m_port),
 			// m_user, m_passwd));
 			conn->setSchema(m_db_name);
+			metrics.reconnects.inc();
 		}
 
 	} catch (sql::SQLException& e) {
+		metrics.reconnect_failures.inc();
 		spdlog::error("{} Reconnect failed: {}, Error Code:{}, SQLState:{}", TAG, e.what(),
 					  e.getErrorCode(), e.getSQLStateCStr());
 	}
@@ -113,5 +155,6 @@ SqlConnPtr DBManager::getConnection(std::chrono::seconds timeout) {
 void DBManager::releaseConnection(const SqlConnPtr& conn) {
 	std::lock_guard<std::mutex> lock(m_mtx);
 	m_connections.push_back(conn);
+	poolMetrics().available.set(static_cast<int64_t>(m_connections.size()));
 	m_cv.notify_one();
 }
@@ -10,10 +10,14 @@
 
 #include <jdbc/mysql_driver.h>
 #include <jdbc/cppconn/connection.h>
+#include <jdbc/cppconn/prepared_statement.h>
 #include <jdbc/cppconn/resultset.h>
 
+#include "SqlStatement.h"
+#include "../utils/Tracing.h"
+
 using SqlConnPtr = std::shared_ptr<sql::Connection>;
-using PreStmtPtr = std::unique_ptr<sql::PreparedStatement>;
+using PreStmtPtr = std::unique_ptr<SqlStatement>;
 using StmtPtr = std::unique_ptr<sql::Statement>;
 using ResultSetPtr = std::shared_ptr<sql::ResultSet>;
 
@@ -57,6 +61,8 @@ private:
 
 /**
  * @brief 数据库连接 连接 RAII 封装
+ *
+ * 持有连接期间记为一个 "db" span (请求启用追踪时).
  */
 struct SqlConnGuard {
 	explicit SqlConnGuard(SqlConnPtr conn) : m_conn(std::move(conn)) {}
@@ -74,8 +80,73 @@ struct SqlConnGuard {
 	// 获取原始连接
 	SqlConnPtr get() const { return m_conn; }
 
+	// 预处理语句, 执行计入语句统计; 与 sql::Connection::prepareStatement 一样由调用方接管
+	SqlStatement* prepareStatement(const std::string& sql) const {
+		return prepareStatement(sql, sql);
+	}
+
+	// 语句含随调用变化的标识符 (如分区名) 时按 stats_sql 归并统计
+	SqlStatement* prepareStatement(const std::string& sql, const std::string& stats_sql) const {
+		SqlStats::Statement& stats = SqlStats::getInstance()->statement(stats_sql);
+		return new SqlStatement(m_conn.get(), m_conn->prepareStatement(sql), stats, sql);
+	}
+
 	sql::Connection* operator->() const { return m_conn.get(); }
 
 private:
 	SqlConnPtr m_conn;
-};
\ No newline at end of file
+	TraceSpan m_span{"db"};
+};
+/**
+ * @brief 事务 RAII 封装, 未 commit 时析构回滚; 结束后恢复自动提交再归还连接
+ */
+class SqlTransaction {
+public:
+	explicit SqlTransaction(const SqlConnGuard& guard) : m_conn(guard.get()) {
+		m_conn->setAutoCommit(false);
+	}
+	~SqlTransaction() {
+		try {
+			if (!m_committed) m_conn->rollback();
+			m_conn->setAutoCommit(true);
+		} catch (...) {
+		}
+	}
+
+	SqlTransaction(const SqlTransaction&) = delete;
+	SqlTransaction(SqlTransaction&&) = delete;
+	SqlTransaction& operator=(const SqlTransaction&) = delete;
+	SqlTransaction& operator=(SqlTransaction&&) = delete;
+
+	void commit() {
+		m_conn->commit();
+		m_committed = true;
+	}
+
+private:
+	SqlConnPtr m_conn;
+	bool m_committed = false;
+};
+
+/**
+ * @brief 读完 CALL 返回的剩余结果 (含末尾的状态结果), 否则连接上的下一条语句会失败
+ */
+inline void finishCall(const PreStmtPtr& pstmt) {
+	while (pstmt->getMoreResults()) {
+	}
+}
+
+// 多行语句的占位符, 如 rows=2, columns=2 得 "(?, ?), (?, ?)"
+inline std::string sqlPlaceholders(size_t rows, size_t columns) {
+	std::string row = "(";
+	for (size_t i = 0; i < columns; ++i) row += i == 0 ? "?" : ", ?";
+	row += ')';
+
+	std::string out;
+	out.reserve(rows * (row.size() + 2));
+	for (size_t i = 0; i < rows; ++i) {
+		if (i != 0) out += ", ";
+		out += row;
+	}
+	return out;
+}
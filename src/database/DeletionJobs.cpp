@@ -0,0 +1,337 @@
+#include "DeletionJobs.h"
+#include "PlaylistCache.h"
+
+#include <jdbc/cppconn/exception.h>
+#include <jdbc/cppconn/prepared_statement.h>
+#include <spdlog/spdlog.h>
+
+#include <stdexcept>
+
+constexpr const char* TAG = "[DeletionJobs]";
+
+std::unique_ptr<DeletionJobs> DeletionJobs::m_instance = nullptr;
+
+namespace {
+
+constexpr const char* SELECT_JOBS =
+	"SELECT id, kind + 0, user_id, cutoff_id, state + 0, deleted_rows, attempts, error, "
+	"UNIX_TIMESTAMP(created_at), UNIX_TIMESTAMP(updated_at) FROM deletion_jobs ";
+
+DeletionJobs::Job buildJob(const ResultSetPtr& result) {
+	DeletionJobs::Job job;
+	job.id = result->getInt(1);
+	job.kind = static_cast<DeletionJobs::Kind>(result->getInt(2));
+	job.user_id = result->getInt(3);
+	job.cutoff_id = result->getInt64(4);
+	job.state = static_cast<DeletionJobs::State>(result->getInt(5));
+	job.deleted_rows = result->getInt64(6);
+	job.attempts = result->getInt(7);
+	job.error = result->isNull(8) ? "" : std::string(result->getString(8));
+	job.created_at = result->getInt64(9);
+	job.updated_at = result->getInt64(10);
+	return job;
+}
+
+// 按 sql 删除一批 (参数: user_id, batch_size), 返回删除行数
+size_t deleteLimited(const SqlConnGuard& guard, const char* sql, int user_id, size_t batch_size) {
+	PreStmtPtr pstmt(guard.prepareStatement(sql));
+	pstmt->setInt(1, user_id);
+	pstmt->setInt(2, static_cast<int>(batch_size));
+	return static_cast<size_t>(pstmt->executeUpdate());
+}
+
+} // namespace
+
+DeletionJobs::DeletionJobs(size_t batch_size, std::chrono::milliseconds batch_interval,
+						   std::chrono::seconds poll_interval, uint32_t max_attempts)
+	: m_batch_size(batch_size > 0 ? batch_size : 1), m_batch_interval(batch_interval),
+	  m_poll_interval(poll_interval), m_max_attempts(max_attempts > 0 ? max_attempts : 1) {
+	m_thread = std::thread([this]() { runLoop(); });
+}
+
+DeletionJobs::~DeletionJobs() { stop(); }
+
+void DeletionJobs::init(size_t batch_size, std::chrono::milliseconds batch_interval,
+						std::chrono::seconds poll_interval, uint32_t max_attempts) {
+	if (!m_instance) {
+		m_instance.reset(
+			new DeletionJobs(batch_size, batch_interval, poll_interval, max_attempts));
+	}
+}
+
+DeletionJobs* DeletionJobs::getInstance() {
+	if (!m_instance) {
+		throw std::runtime_error("DeletionJobs not initialized");
+	}
+
+	return m_instance.get();
+}
+
+void DeletionJobs::stop() {
+	{
+		std::lock_guard<std::mutex> lock(m_mtx);
+		m_stop = true;
+	}
+	m_cv.notify_all();
+	if (m_thread.joinable()) m_thread.join();
+}
+
+void DeletionJobs::notify() {
+	{
+		std::lock_guard<std::mutex> lock(m_mtx);
+		m_notified = true;
+	}
+	m_cv.notify_all();
+}
+
+int64_t DeletionJobs::hideHistory(const SqlConnGuard& guard, int user_id) {
+	PreStmtPtr pstmt(guard.prepareStatement(
+		"UPDATE users SET history_cleared_id = GREATEST(history_cleared_id, "
+		"(SELECT COALESCE(MAX(id), 0) FROM play_history WHERE user_id = ?)), "
+		"daily_cleared_id = GREATEST(daily_cleared_id, "
+		"(SELECT COALESCE(MAX(id), 0) FROM play_history_daily WHERE user_id = ?)) WHERE id = ?"));
+	pstmt->setInt(1, user_id);
+	pstmt->setInt(2, user_id);
+	pstmt->setInt(3, user_id);
+	pstmt->executeUpdate();
+
+	pstmt.reset(guard.prepareStatement("SELECT history_cleared_id FROM users WHERE id = ?"));
+	pstmt->setInt(1, user_id);
+	ResultSetPtr result(pstmt->executeQuery());
+	return result->next() ? result->getInt64(1) : 0;
+}
+
+int DeletionJobs::enqueue(const SqlConnGuard& guard, Kind kind, int user_id, int64_t cutoff_id) {
+	// 插入与取回 id 一次往返
+	PreStmtPtr pstmt(guard.prepareStatement("CALL create_deletion_job(?, ?, ?)"));
+	pstmt->setInt(1, static_cast<int>(kind));
+	pstmt->setInt(2, user_id);
+	pstmt->setInt64(3, cutoff_id);
+
+	ResultSetPtr result(pstmt->executeQuery());
+	const int job_id = result->next() ? result->getInt(1) : 0;
+	result.reset();
+	finishCall(pstmt);
+	return job_id;
+}
+
+std::optional<DeletionJobs::Job> DeletionJobs::getJob(int job_id, int user_id) {
+	try {
+		SqlConnGuard guard(DBManager::getInstance()->getConnection());
+		PreStmtPtr pstmt(guard.prepareStatement(std::string(SELECT_JOBS) +
+												 "WHERE id = ? AND user_id = ?"));
+		pstmt->setInt(1, job_id);
+		pstmt->setInt(2, user_id);
+		ResultSetPtr result(pstmt->executeQuery());
+		if (!result->next()) return std::nullopt;
+
+		return buildJob(result);
+	} catch (sql::SQLException& e) {
+		spdlog::error("{} Get job {} failed: {}, Code: {}", TAG, job_id, e.what(),
+					  e.getErrorCode());
+		return std::nullopt;
+	}
+}
+
+bool DeletionJobs::hasPending(int user_id) {
+	try {
+		SqlConnGuard guard(DBManager::getInstance()->getConnection());
+		PreStmtPtr pstmt(guard.prepareStatement(
+			"SELECT 1 FROM deletion_jobs WHERE user_id = ? AND state IN ('pending', 'running') "
+			"LIMIT 1"));
+		pstmt->setInt(1, user_id);
+		ResultSetPtr result(pstmt->executeQuery());
+		return result->next();
+	} catch (sql::SQLException& e) {
+		spdlog::error("{} Check pending jobs of user {} failed: {}, Code: {}", TAG, user_id,
+					  e.what(), e.getErrorCode());
+		return true;
+	}
+}
+
+const char* DeletionJobs::toString(State state) {
+	switch (state) {
+	case State::Pending:
+		return "pending";
+	case State::Running:
+		return "running";
+	case State::Done:
+		return "done";
+	case State::Failed:
+		return "failed";
+	}
+	return "unknown";
+}
+
+void DeletionJobs::runLoop() {
+	while (true) {
+		std::optional<Job> job;
+		try {
+			job = nextJob();
+		} catch (sql::SQLException& e) {
+			spdlog::error("{} Fetch next job failed: {}, Code: {}", TAG, e.what(),
+						  e.getErrorCode());
+		}
+
+		if (!job) {
+			if (!waitFor(m_poll_interval, true)) return;
+			continue;
+		}
+
+		runJob(*job);
+
+		std::lock_guard<std::mutex> lock(m_mtx);
+		if (m_stop) return;
+	}
+}
+
+void DeletionJobs::runJob(const Job& job) {
+	spdlog::info("{} Job {} ({} of user {}) started, {} rows deleted so far", TAG, job.id,
+				 job.kind == Kind::History ? "history" : "user", job.user_id, job.deleted_rows);
+	try {
+		int64_t deleted = 0;
+		while (size_t rows = runBatch(job)) {
+			deleted += static_cast<int64_t>(rows);
+			if (!waitFor(m_batch_interval, false)) {
+				spdlog::info("{} Job {} paused after {} rows", TAG, job.id, deleted);
+				return;
+			}
+		}
+
+		finish(job);
+		spdlog::info("{} Job {} done, {} rows deleted", TAG, job.id, job.deleted_rows + deleted);
+	} catch (sql::SQLException& e) {
+		spdlog::error("{} Job {} failed: {}, Code: {}", TAG, job.id, e.what(), e.getErrorCode());
+		recordFailure(job, e.what());
+		waitFor(m_poll_interval, false);
+	}
+}
+
+size_t DeletionJobs::runBatch(const Job& job) {
+	SqlConnGuard guard(DBManager::getInstance()->getConnection());
+	SqlTransaction tx(guard);
+
+	const size_t rows = job.kind == Kind::History ? deleteHistoryBatch(guard, job)
+												   : deleteUserBatch(guard, job);
+	if (rows == 0) return 0;
+
+	PreStmtPtr pstmt(guard.prepareStatement(
+		"UPDATE deletion_jobs SET state = 'running', deleted_rows = deleted_rows + ? "
+		"WHERE id = ?"));
+	pstmt->setInt64(1, static_cast<int64_t>(rows));
+	pstmt->setInt(2, job.id);
+	pstmt->executeUpdate();
+
+	tx.commit();
+	return rows;
+}
+
+size_t DeletionJobs::deleteHistoryBatch(const SqlConnGuard& guard, const Job& job) {
+	// 走 (user_id, id) 索引, 每批只锁 batch_size 行
+	PreStmtPtr pstmt(guard.prepareStatement(
+		"DELETE FROM play_history WHERE user_id = ? AND id <= ? ORDER BY id LIMIT ?"));
+	pstmt->setInt(1, job.user_id);
+	pstmt->setInt64(2, job.cutoff_id);
+	pstmt->setInt(3, static_cast<int>(m_batch_size));
+	size_t rows = static_cast<size_t>(pstmt->executeUpdate());
+	if (rows > 0) return rows;
+
+	// 按日汇总的水位线只增不减, 按当前值删除即可
+	pstmt.reset(guard.prepareStatement(
+		"DELETE FROM play_history_daily WHERE user_id = ? AND id <= "
+		"(SELECT daily_cleared_id FROM users WHERE id = ?) ORDER BY id LIMIT ?"));
+	pstmt->setInt(1, job.user_id);
+	pstmt->setInt(2, job.user_id);
+	pstmt->setInt(3, static_cast<int>(m_batch_size));
+	return static_cast<size_t>(pstmt->executeUpdate());
+}
+
+size_t DeletionJobs::deleteUserBatch(const SqlConnGuard& guard, const Job& job) {
+	// 依次删除播放历史与按日汇总、各歌单的歌曲与歌单、汇总表,
+	// 最后删除用户行 (此时级联已无数据)
+	size_t rows = 0;
+	for (const char* sql :
+		 {"DELETE FROM play_history WHERE user_id = ? ORDER BY id LIMIT ?",
+		  "DELETE FROM play_history_daily WHERE user_id = ? ORDER BY id LIMIT ?"}) {
+		rows = deleteLimited(guard, sql, job.user_id, m_batch_size);
+		if (rows > 0) return rows;
+	}
+
+	PreStmtPtr pstmt(guard.prepareStatement(
+		"SELECT id FROM playlists WHERE user_id = ? ORDER BY id LIMIT 1"));
+	pstmt->setInt(1, job.user_id);
+	ResultSetPtr result(pstmt->executeQuery());
+	if (result->next()) {
+		const int playlist_id = result->getInt(1);
+		rows = deleteLimited(
+			guard, "DELETE FROM playlist_songs WHERE playlist_id = ? ORDER BY id LIMIT ?",
+			playlist_id, m_batch_size);
+		if (rows > 0) return rows;
+
+		pstmt.reset(guard.prepareStatement("DELETE FROM playlists WHERE id = ?"));
+		pstmt->setInt(1, playlist_id);
+		rows = static_cast<size_t>(pstmt->executeUpdate());
+		PlaylistCache::getInstance()->erase(playlist_id);
+		return rows;
+	}
+
+	for (const char* sql : {"DELETE FROM user_song_stats WHERE user_id = ? LIMIT ?",
+							"DELETE FROM user_artist_stats WHERE user_id = ? LIMIT ?",
+							"DELETE FROM user_play_stats WHERE user_id = ? LIMIT ?"}) {
+		rows = deleteLimited(guard, sql, job.user_id, m_batch_size);
+		if (rows > 0) return rows;
+	}
+
+	// 注销后的写入已被拒绝, 只可能剩下注销提交前已开始的播放; play_history 没有外键,
+	// 与用户行在同一事务中清除, 不留孤儿
+	pstmt.reset(guard.prepareStatement("DELETE FROM play_history WHERE user_id = ?"));
+	pstmt->setInt(1, job.user_id);
+	rows = static_cast<size_t>(pstmt->executeUpdate());
+
+	pstmt.reset(
+		guard.prepareStatement("DELETE FROM users WHERE id = ? AND deleted_at IS NOT NULL"));
+	pstmt->setInt(1, job.user_id);
+	return rows + static_cast<size_t>(pstmt->executeUpdate());
+}
+
+void DeletionJobs::finish(const Job& job) {
+	SqlConnGuard guard(DBManager::getInstance()->getConnection());
+	PreStmtPtr pstmt(guard.prepareStatement(
+		"UPDATE deletion_jobs SET state = 'done', error = NULL WHERE id = ?"));
+	pstmt->setInt(1, job.id);
+	pstmt->executeUpdate();
+}
+
+void DeletionJobs::recordFailure(const Job& job, const std::string& error) {
+	try {
+		SqlConnGuard guard(DBManager::getInstance()->getConnection());
+		PreStmtPtr pstmt(guard.prepareStatement(
+			"UPDATE deletion_jobs SET attempts = attempts + 1, error = LEFT(?, 255), "
+			"state = IF(attempts >= ?, 'failed', 'pending') WHERE id = ?"));
+		pstmt->setString(1, error);
+		pstmt->setInt(2, static_cast<int>(m_max_attempts));
+		pstmt->setInt(3, job.id);
+		pstmt->executeUpdate();
+	} catch (sql::SQLException& e) {
+		spdlog::error("{} Record failure of job {} failed: {}, Code: {}", TAG, job.id, e.what(),
+					  e.getErrorCode());
+	}
+}
+
+std::optional<DeletionJobs::Job> DeletionJobs::nextJob() {
+	// running 为上次进程退出时未完成的任务, 删除步骤可重复执行, 直接继续
+	SqlConnGuard guard(DBManager::getInstance()->getConnection());
+	PreStmtPtr pstmt(guard.prepareStatement(
+		std::string(SELECT_JOBS) + "WHERE state IN ('pending', 'running') ORDER BY id LIMIT 1"));
+	ResultSetPtr result(pstmt->executeQuery());
+	if (!result->next()) return std::nullopt;
+
+	return buildJob(result);
+}
+
+bool DeletionJobs::waitFor(std::chrono::milliseconds timeout, bool wake_on_notify) {
+	std::unique_lock<std::mutex> lock(m_mtx);
+	m_cv.wait_for(lock, timeout, [&]() { return m_stop || (wake_on_notify && m_notified); });
+	if (wake_on_notify) m_notified = false;
+	return !m_stop;
+}
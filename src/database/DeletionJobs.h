@@ -0,0 +1,121 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+
+#include "DBManager.h"
+
+/**
+ * @brief 后台删除任务 单例
+ *
+ * 清空播放历史与注销账号只在请求事务中登记任务并使数据逻辑不可见 (水位线 / deleted_at),
+ * 立即返回; 后台线程按 batch_size 分批删除, 每批一个短事务并累加进度, 批之间休眠,
+ * 避免一条大 DELETE 长时间持有行锁、堆积 undo. 任务持久化在 deletion_jobs, 每一步都可
+ * 重复执行, 进程重启后从未完成的任务继续.
+ */
+class DeletionJobs {
+public:
+	// 与 deletion_jobs 中 ENUM 的序号一致
+	enum class Kind : uint8_t { History = 1, User = 2 };
+	enum class State : uint8_t { Pending = 1, Running = 2, Done = 3, Failed = 4 };
+
+	struct Job {
+		int id = 0;
+		Kind kind = Kind::History;
+		int user_id = 0;
+		int64_t cutoff_id = 0;
+		State state = State::Pending;
+		int64_t deleted_rows = 0;
+		int attempts = 0;
+		std::string error;
+		int64_t created_at = 0;
+		int64_t updated_at = 0;
+	};
+
+	// 播放历史可见条件 (表别名 h), 需再绑定一次 user_id
+	static constexpr const char* HISTORY_VISIBLE =
+		"h.id > (SELECT history_cleared_id FROM users WHERE id = ?)";
+
+	// 按日汇总可见条件 (表别名 d), 需再绑定一次 user_id
+	static constexpr const char* DAILY_VISIBLE =
+		"d.id > (SELECT daily_cleared_id FROM users WHERE id = ?)";
+
+	static void init(size_t batch_size, std::chrono::milliseconds batch_interval,
+					 std::chrono::seconds poll_interval, uint32_t max_attempts);
+	static DeletionJobs* getInstance();
+
+	// 停止后台线程 (当前批次完成后), 需在 DBManager 析构前调用
+	void stop();
+
+	// 有新任务提交, 唤醒空闲的后台线程
+	void notify();
+
+	/**
+	 * @brief 把用户当前的播放历史与按日汇总标记为不可见, 在调用方事务中执行
+	 * @return 播放历史新的水位线 (id 不超过它的记录不可见)
+	 */
+	static int64_t hideHistory(const SqlConnGuard& guard, int user_id);
+
+	/**
+	 * @brief 在调用方事务中登记任务, 提交后调用 notify
+	 * @return 任务 id
+	 */
+	static int enqueue(const SqlConnGuard& guard, Kind kind, int user_id, int64_t cutoff_id = 0);
+
+	// 查询用户自己的任务, 不存在或失败返回 nullopt
+	static std::optional<Job> getJob(int job_id, int user_id);
+
+	// 用户是否有未完成的任务; 查询失败按有处理
+	static bool hasPending(int user_id);
+
+	static const char* toString(State state);
+
+	~DeletionJobs();
+	DeletionJobs(const DeletionJobs&) = delete;
+	DeletionJobs(DeletionJobs&&) = delete;
+	DeletionJobs& operator=(const DeletionJobs&) = delete;
+	DeletionJobs& operator=(DeletionJobs&&) = delete;
+
+private:
+	DeletionJobs(size_t batch_size, std::chrono::milliseconds batch_interval,
+				 std::chrono::seconds poll_interval, uint32_t max_attempts);
+
+	void runLoop();
+
+	// 执行任务直到完成或停止
+	void runJob(const Job& job);
+
+	// 删除一批并记录进度, 返回删除行数, 0 表示任务已完成
+	size_t runBatch(const Job& job);
+
+	size_t deleteHistoryBatch(const SqlConnGuard& guard, const Job& job);
+	size_t deleteUserBatch(const SqlConnGuard& guard, const Job& job);
+
+	void finish(const Job& job);
+	void recordFailure(const Job& job, const std::string& error);
+
+	static std::optional<Job> nextJob();
+
+	// 等待 timeout 或被 stop (wake_on_notify 时也被 notify) 唤醒, 返回是否仍在运行
+	bool waitFor(std::chrono::milliseconds timeout, bool wake_on_notify);
+
+private:
+	size_t m_batch_size;
+	std::chrono::milliseconds m_batch_interval;
+	std::chrono::milliseconds m_poll_interval;
+	uint32_t m_max_attempts;
+
+	std::thread m_thread;
+	std::mutex m_mtx;
+	std::condition_variable m_cv;
+	bool m_stop = false;
+	bool m_notified = false;
+
+	static std::unique_ptr<DeletionJobs> m_instance;
+};
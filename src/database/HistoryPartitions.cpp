@@ -0,0 +1,251 @@
+#include "HistoryPartitions.h"
+
+#include <jdbc/cppconn/exception.h>
+#include <jdbc/cppconn/prepared_statement.h>
+#include <spdlog/spdlog.h>
+
+#include <cctype>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+constexpr const char* TAG = "[HistoryPartitions]";
+
+std::unique_ptr<HistoryPartitions> HistoryPartitions::m_instance = nullptr;
+
+HistoryPartitions::HistoryPartitions(uint32_t months_ahead, uint32_t retention_days,
+									 std::chrono::hours interval,
+									 std::chrono::milliseconds compact_interval)
+	: m_months_ahead(months_ahead), m_retention_days(retention_days), m_interval(interval),
+	  m_compact_interval(compact_interval) {
+	// 在接受请求前补齐分区, 汇总在后台进行
+	ensurePartitions();
+	m_thread = std::thread([this]() { runLoop(); });
+}
+
+HistoryPartitions::~HistoryPartitions() { stop(); }
+
+void HistoryPartitions::init(uint32_t months_ahead, uint32_t retention_days,
+							 std::chrono::hours interval,
+							 std::chrono::milliseconds compact_interval) {
+	if (!m_instance) {
+		m_instance.reset(
+			new HistoryPartitions(months_ahead, retention_days, interval, compact_interval));
+	}
+}
+
+HistoryPartitions* HistoryPartitions::getInstance() {
+	if (!m_instance) {
+		throw std::runtime_error("HistoryPartitions not initialized");
+	}
+
+	return m_instance.get();
+}
+
+void HistoryPartitions::stop() {
+	{
+		std::lock_guard<std::mutex> lock(m_mtx);
+		m_stop = true;
+	}
+	m_cv.notify_all();
+	if (m_thread.joinable()) m_thread.join();
+}
+
+void HistoryPartitions::runLoop() {
+	compactExpired();
+	if (m_interval.count() == 0) return;
+
+	while (waitFor(m_interval)) {
+		ensurePartitions();
+		compactExpired();
+	}
+}
+
+bool HistoryPartitions::ensurePartitions() {
+	try {
+		SqlConnGuard guard(DBManager::getInstance()->getConnection());
+		auto partitions = listPartitions(guard);
+		if (partitions.empty()) {
+			spdlog::error("{} play_history is not partitioned", TAG);
+			return false;
+		}
+
+		// 第 n 个月的分区名与上界 (下月 1 日零点)
+		PreStmtPtr pstmt(guard.prepareStatement(
+			"SELECT DATE_FORMAT(CURRENT_DATE + INTERVAL ? MONTH, 'p%Y%m'), "
+			"UNIX_TIMESTAMP(DATE_FORMAT(CURRENT_DATE + INTERVAL ? MONTH, '%Y-%m-01'))"));
+		int64_t last_bound = partitions.back().bound;
+		for (uint32_t n = 0; n <= m_months_ahead; ++n) {
+			pstmt->setInt(1, static_cast<int>(n));
+			pstmt->setInt(2, static_cast<int>(n + 1));
+			ResultSetPtr result(pstmt->executeQuery());
+			if (!result->next()) continue;
+
+			const int64_t bound = result->getInt64(2);
+			if (bound <= last_bound) continue;
+
+			// 服务长期停止时缺失的月份并入第一个新分区
+			const std::string name = result->getString(1);
+			PreStmtPtr alter(guard.prepareStatement(
+				"ALTER TABLE play_history ADD PARTITION (PARTITION " + name +
+					" VALUES LESS THAN (" + std::to_string(bound) + "))",
+				"ALTER TABLE play_history ADD PARTITION"));
+			alter->execute();
+			last_bound = bound;
+			spdlog::info("{} Partition {} added", TAG, name);
+		}
+		return true;
+	} catch (sql::SQLException& e) {
+		spdlog::error("{} Add partitions failed: {}, Code: {}", TAG, e.what(), e.getErrorCode());
+		return false;
+	}
+}
+
+void HistoryPartitions::compactExpired() {
+	std::vector<Partition> expired;
+	try {
+		SqlConnGuard guard(DBManager::getInstance()->getConnection());
+		PreStmtPtr pstmt(guard.prepareStatement(
+			"SELECT UNIX_TIMESTAMP(CURRENT_DATE - INTERVAL ? DAY)"));
+		pstmt->setInt(1, static_cast<int>(m_retention_days));
+		ResultSetPtr result(pstmt->executeQuery());
+		if (!result->next()) return;
+		const int64_t horizon = result->getInt64(1);
+
+		// 最后一个分区不能删除
+		auto partitions = listPartitions(guard);
+		for (size_t i = 0; i + 1 < partitions.size(); ++i) {
+			if (partitions[i].bound <= horizon) expired.push_back(partitions[i]);
+		}
+	} catch (sql::SQLException& e) {
+		spdlog::error("{} List expired partitions failed: {}, Code: {}", TAG, e.what(),
+					  e.getErrorCode());
+		return;
+	}
+
+	for (const auto& partition : expired) {
+		try {
+			if (!compactPartition(partition)) return;
+		} catch (sql::SQLException& e) {
+			spdlog::error("{} Compact partition {} failed: {}, Code: {}", TAG, partition.name,
+						  e.what(), e.getErrorCode());
+			return;
+		}
+	}
+}
+
+bool HistoryPartitions::compactPartition(const Partition& partition) {
+	// 登记分区 (单独提交), 已登记时取上次的进度
+	std::string after;
+	{
+		SqlConnGuard guard(DBManager::getInstance()->getConnection());
+		PreStmtPtr pstmt(guard.prepareStatement(
+			"INSERT INTO play_history_compactions (partition_name, bound) VALUES (?, ?) "
+			"ON DUPLICATE KEY UPDATE bound = VALUES(bound)"));
+		pstmt->setString(1, partition.name);
+		pstmt->setInt64(2, partition.bound);
+		pstmt->executeUpdate();
+
+		pstmt.reset(guard.prepareStatement(
+			"SELECT COALESCE(compacted_until, '1000-01-01') FROM play_history_compactions "
+			"WHERE partition_name = ?"));
+		pstmt->setString(1, partition.name);
+		ResultSetPtr result(pstmt->executeQuery());
+		if (!result->next()) return true;
+		after = result->getString(1);
+	}
+
+	spdlog::info("{} Compacting partition {} after {}", TAG, partition.name, after);
+	size_t days = 0;
+	while (auto day = compactNextDay(partition, after)) {
+		after = std::move(*day);
+		++days;
+		if (!waitFor(m_compact_interval)) {
+			spdlog::info("{} Compaction of {} paused at {}", TAG, partition.name, after);
+			return false;
+		}
+	}
+
+	SqlConnGuard guard(DBManager::getInstance()->getConnection());
+	PreStmtPtr pstmt(guard.prepareStatement("ALTER TABLE play_history DROP PARTITION " +
+												partition.name,
+											"ALTER TABLE play_history DROP PARTITION"));
+	pstmt->execute();
+
+	pstmt.reset(guard.prepareStatement(
+		"UPDATE play_history_compactions SET finished_at = CURRENT_TIMESTAMP "
+		"WHERE partition_name = ?"));
+	pstmt->setString(1, partition.name);
+	pstmt->executeUpdate();
+
+	spdlog::info("{} Partition {} dropped, {} days compacted", TAG, partition.name, days);
+	return true;
+}
+
+std::optional<std::string> HistoryPartitions::compactNextDay(const Partition& partition,
+															 const std::string& after) {
+	SqlConnGuard guard(DBManager::getInstance()->getConnection());
+	SqlTransaction tx(guard);
+
+	const std::string table = "play_history PARTITION (" + partition.name + ") h";
+	PreStmtPtr pstmt(guard.prepareStatement(
+		"SELECT DATE(MIN(h.played_at)) FROM " + table +
+		" WHERE h.played_at >= DATE(?) + INTERVAL 1 DAY"));
+	pstmt->setString(1, after);
+	ResultSetPtr result(pstmt->executeQuery());
+	if (!result->next() || result->isNull(1)) return std::nullopt;
+	const std::string day = result->getString(1);
+
+	// 已清空 (待后台删除) 与已注销用户的播放不汇总
+	pstmt.reset(guard.prepareStatement(
+		"INSERT INTO play_history_daily (user_id, song_ref, day, play_count) "
+		"SELECT h.user_id, h.song_ref, DATE(?), COUNT(*) FROM " +
+		table +
+		" JOIN users u ON u.id = h.user_id "
+		"WHERE h.played_at >= DATE(?) AND h.played_at < DATE(?) + INTERVAL 1 DAY "
+		"AND h.id > u.history_cleared_id AND u.deleted_at IS NULL "
+		"GROUP BY h.user_id, h.song_ref "
+		"ON DUPLICATE KEY UPDATE play_count = play_count + VALUES(play_count)"));
+	pstmt->setString(1, day);
+	pstmt->setString(2, day);
+	pstmt->setString(3, day);
+	pstmt->executeUpdate();
+
+	// 明细保留到 DROP PARTITION, 读取方按 compacted_until 排除已汇总的日期 (NOT_COMPACTED)
+	pstmt.reset(guard.prepareStatement(
+		"UPDATE play_history_compactions SET compacted_until = ? WHERE partition_name = ?"));
+	pstmt->setString(1, day);
+	pstmt->setString(2, partition.name);
+	pstmt->executeUpdate();
+
+	tx.commit();
+	return day;
+}
+
+std::vector<HistoryPartitions::Partition> HistoryPartitions::listPartitions(
+	const SqlConnGuard& guard) {
+	PreStmtPtr pstmt(guard.prepareStatement(
+		"SELECT PARTITION_NAME, PARTITION_DESCRIPTION FROM information_schema.PARTITIONS "
+		"WHERE TABLE_SCHEMA = DATABASE() AND TABLE_NAME = 'play_history' "
+		"AND PARTITION_NAME IS NOT NULL ORDER BY PARTITION_ORDINAL_POSITION"));
+	ResultSetPtr result(pstmt->executeQuery());
+
+	std::vector<Partition> partitions;
+	while (result->next()) {
+		Partition partition;
+		partition.name = result->getString(1);
+		const std::string description = result->getString(2);
+		const bool maxvalue =
+			description.empty() || !std::isdigit(static_cast<unsigned char>(description[0]));
+		partition.bound =
+			maxvalue ? std::numeric_limits<int64_t>::max() : std::stoll(description);
+		partitions.push_back(std::move(partition));
+	}
+	return partitions;
+}
+
+bool HistoryPartitions::waitFor(std::chrono::milliseconds timeout) {
+	std::unique_lock<std::mutex> lock(m_mtx);
+	m_cv.wait_for(lock, timeout, [this]() { return m_stop; });
+	return !m_stop;
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "DBManager.h"
+
+/**
+ * @brief play_history 分区维护 单例
+ *
+ * play_history 按月 RANGE 分区, 每次播放一行. 启动时与之后每隔 interval:
+ * 1. 补齐到当前月之后 months_ahead 个月的分区, 写入不会落到不存在的分区;
+ * 2. 上界早于 retention_days 之前的分区 (最后一个分区除外) 逐日汇总到 play_history_daily,
+ *    每日一个事务并记录进度 (compacted_until), 日与日之间休眠; 全部汇总后 DROP PARTITION,
+ *    不逐行删除. 删除前已汇总日期的明细仍在表中, 合并明细与汇总的读取方以 NOT_COMPACTED
+ *    排除它们.
+ *
+ * 分区开始汇总前先登记到 play_history_compactions, 之后导入的早于其上界的播放直接写入按日
+ * 汇总 (见 LibraryImport), 汇总期间不会有新明细写入该分区.
+ */
+class HistoryPartitions {
+public:
+	// 明细未汇总条件 (表别名 h), 不需绑定参数. 分区按顺序逐日汇总, 早于最近汇总日次日零点的
+	// 明细都已计入 play_history_daily; 标量子查询只计算一次
+	static constexpr const char* NOT_COMPACTED =
+		"h.played_at >= (SELECT COALESCE(MAX(compacted_until), '1000-01-01') + INTERVAL 1 DAY "
+		"FROM play_history_compactions)";
+
+	static void init(uint32_t months_ahead, uint32_t retention_days,
+					 std::chrono::hours interval, std::chrono::milliseconds compact_interval);
+	static HistoryPartitions* getInstance();
+
+	// 停止后台线程 (当前一日汇总完成后), 需在 DBManager 析构前调用
+	void stop();
+
+	~HistoryPartitions();
+	HistoryPartitions(const HistoryPartitions&) = delete;
+	HistoryPartitions(HistoryPartitions&&) = delete;
+	HistoryPartitions& operator=(const HistoryPartitions&) = delete;
+	HistoryPartitions& operator=(HistoryPartitions&&) = delete;
+
+private:
+	struct Partition {
+		std::string name;
+		int64_t bound = 0; // VALUES LESS THAN (Unix 秒), MAXVALUE 为 INT64_MAX
+	};
+
+	HistoryPartitions(uint32_t months_ahead, uint32_t retention_days,
+					  std::chrono::hours interval, std::chrono::milliseconds compact_interval);
+
+	void runLoop();
+
+	// 补齐未来的月分区, 失败返回 false
+	bool ensurePartitions();
+
+	// 汇总并删除过期分区
+	void compactExpired();
+
+	// 汇总一个分区并删除, 被 stop 中断返回 false
+	bool compactPartition(const Partition& partition);
+
+	// 汇总分区中 after 之后最早有播放的一天, 没有剩余日期返回 nullopt
+	static std::optional<std::string> compactNextDay(const Partition& partition,
+													 const std::string& after);
+
+	static std::vector<Partition> listPartitions(const SqlConnGuard& guard);
+
+	// 等待 timeout 或被 stop 唤醒, 返回是否仍在运行
+	bool waitFor(std::chrono::milliseconds timeout);
+
+private:
+	uint32_t m_months_ahead;
+	uint32_t m_retention_days;
+	std::chrono::hours m_interval;
+	std::chrono::milliseconds m_compact_interval;
+
+	std::thread m_thread;
+	std::mutex m_mtx;
+	std::condition_variable m_cv;
+	bool m_stop = false;
+
+	static std::unique_ptr<HistoryPartitions> m_instance;
+};
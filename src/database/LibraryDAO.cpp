@@ -0,0 +1,436 @@
+#include "LibraryDAO.h"
+#include "DeletionJobs.h"
+#include "HistoryPartitions.h"
+#include "PlaylistCache.h"
+#include "PlaylistDAO.h"
+#include "SongPool.h"
+#include "StatsEngine.h"
+#include "UserDAO.h"
+
+#include <jdbc/cppconn/exception.h>
+#include <jdbc/cppconn/prepared_statement.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <ctime>
+#include <unordered_set>
+#include <utility>
+
+using json = nlohmann::json;
+
+constexpr const char* TAG = "[LibraryDAO]";
+
+namespace {
+
+// 从 first 列起读取 song_id, song_where + 0, song_name, song_singer, song_pic
+void readSong(const ResultSetPtr& result, uint32_t first, json& line) {
+	line["song_id"] = std::string(result->getString(first));
+	line["where"] = toString(static_cast<SongSource>(result->getInt(first + 1)));
+	line["name"] = std::string(result->getString(first + 2));
+	line["singer"] = std::string(result->getString(first + 3));
+	line["pic"] = result->isNull(first + 4) ? "" : std::string(result->getString(first + 4));
+}
+
+void appendLine(const json& line, std::string& out) {
+	out += line.dump();
+	out += '\n';
+}
+
+// rows 个 row, 逗号分隔
+std::string repeatRow(size_t rows, const std::string& row) {
+	std::string out;
+	out.reserve(rows * (row.size() + 2));
+	for (size_t i = 0; i < rows; ++i) {
+		if (i != 0) out += ", ";
+		out += row;
+	}
+	return out;
+}
+
+// 缺少时间戳时绑定 NULL, 由 COALESCE 取当前时间
+void setTimestamp(const PreStmtPtr& pstmt, uint32_t index, int64_t timestamp) {
+	if (timestamp > 0)
+		pstmt->setInt64(index, timestamp);
+	else
+		pstmt->setNull(index, sql::DataType::BIGINT);
+}
+
+} // namespace
+
+LibraryExport::LibraryExport(int user_id) : m_user_id{user_id} {}
+
+bool LibraryExport::next(std::string& out) {
+	if (m_phase == Phase::Profile) {
+		exportProfile(out);
+		m_phase = Phase::Playlists;
+		return true;
+	}
+	if (m_phase == Phase::Done) return false;
+
+	SqlConnGuard guard(DBManager::getInstance()->getConnection());
+	switch (m_phase) {
+	case Phase::Playlists:
+		exportPlaylists(guard, out);
+		break;
+	case Phase::PlaylistSongs:
+		exportPlaylistSongs(guard, out);
+		break;
+	case Phase::History:
+		exportHistory(guard, out);
+		break;
+	case Phase::Daily:
+		exportDaily(guard, out);
+		break;
+	default:
+		break;
+	}
+	return m_phase != Phase::Done;
+}
+
+void LibraryExport::exportProfile(std::string& out) {
+	MySqlUserDAO user_dao;
+	auto user = user_dao.getUserById(m_user_id);
+	if (!user) return;
+
+	appendLine(json{{"type", "profile"},
+					{"username", user->username},
+					{"email", user->email},
+					{"qq_id", user->qq_id},
+					{"netease_id", user->netease_id},
+					{"create_at", user->create_at}},
+			   out);
+}
+
+void LibraryExport::exportPlaylists(const SqlConnGuard& guard, std::string& out) {
+	PreStmtPtr pstmt(guard.prepareStatement(
+		"SELECT id, name, cover, UNIX_TIMESTAMP(create_at) FROM playlists "
+		"WHERE user_id = ? AND id > ? ORDER BY id LIMIT ?"));
+	pstmt->setInt(1, m_user_id);
+	pstmt->setInt64(2, m_last_id);
+	pstmt->setInt(3, static_cast<int>(PAGE_SIZE));
+
+	size_t rows = 0;
+	ResultSetPtr result(pstmt->executeQuery());
+	while (result->next()) {
+		++rows;
+		const int id = result->getInt(1);
+		m_last_id = id;
+		m_playlists.push_back(id);
+		appendLine(json{{"type", "playlist"},
+						{"id", id},
+						{"name", std::string(result->getString(2))},
+						{"cover", result->isNull(3) ? "" : std::string(result->getString(3))},
+						{"create_at", result->getInt64(4)}},
+				   out);
+	}
+
+	if (rows < PAGE_SIZE) {
+		m_phase = Phase::PlaylistSongs;
+		m_last_id = 0;
+	}
+}
+
+void LibraryExport::exportPlaylistSongs(const SqlConnGuard& guard, std::string& out) {
+	if (m_playlist_index >= m_playlists.size()) {
+		m_phase = Phase::History;
+		m_last_id = 0;
+		return;
+	}
+
+	const int playlist_id = m_playlists[m_playlist_index];
+	PreStmtPtr pstmt(guard.prepareStatement(
+		"SELECT ps.id, UNIX_TIMESTAMP(ps.added_at), s.song_id, s.song_where + 0, s.song_name, "
+		"s.song_singer, s.song_pic FROM playlist_songs ps JOIN songs s ON s.id = ps.song_ref "
+		"WHERE ps.playlist_id = ? AND ps.id > ? ORDER BY ps.id LIMIT ?"));
+	pstmt->setInt(1, playlist_id);
+	pstmt->setInt64(2, m_last_id);
+	pstmt->setInt(3, static_cast<int>(PAGE_SIZE));
+
+	size_t rows = 0;
+	ResultSetPtr result(pstmt->executeQuery());
+	while (result->next()) {
+		++rows;
+		m_last_id = result->getInt(1);
+		json line = {{"type", "playlist_song"},
+					 {"playlist", playlist_id},
+					 {"added_at", result->getInt64(2)}};
+		readSong(result, 3, line);
+		appendLine(line, out);
+	}
+
+	if (rows < PAGE_SIZE) {
+		++m_playlist_index;
+		m_last_id = 0;
+	}
+}
+
+void LibraryExport::exportHistory(const SqlConnGuard& guard, std::string& out) {
+	PreStmtPtr pstmt(guard.prepareStatement(
+		std::string("SELECT h.id, UNIX_TIMESTAMP(h.played_at), s.song_id, s.song_where + 0, "
+					"s.song_name, s.song_singer, s.song_pic FROM play_history h "
+					"JOIN songs s ON s.id = h.song_ref WHERE h.user_id = ? AND h.id > ? AND ") +
+		DeletionJobs::HISTORY_VISIBLE + " AND " + HistoryPartitions::NOT_COMPACTED +
+		" ORDER BY h.id LIMIT ?"));
+	pstmt->setInt(1, m_user_id);
+	pstmt->setInt64(2, m_last_id);
+	pstmt->setInt(3, m_user_id);
+	pstmt->setInt(4, static_cast<int>(PAGE_SIZE));
+
+	size_t rows = 0;
+	ResultSetPtr result(pstmt->executeQuery());
+	while (result->next()) {
+		++rows;
+		m_last_id = result->getInt64(1);
+		json line = {{"type", "history"}, {"count", 1}, {"played_at", result->getInt64(2)}};
+		readSong(result, 3, line);
+		appendLine(line, out);
+	}
+
+	if (rows < PAGE_SIZE) {
+		m_phase = Phase::Daily;
+		m_last_id = 0;
+	}
+}
+
+void LibraryExport::exportDaily(const SqlConnGuard& guard, std::string& out) {
+	PreStmtPtr pstmt(guard.prepareStatement(
+		std::string("SELECT d.id, d.play_count, UNIX_TIMESTAMP(d.day), s.song_id, "
+					"s.song_where + 0, s.song_name, s.song_singer, s.song_pic "
+					"FROM play_history_daily d JOIN songs s ON s.id = d.song_ref "
+					"WHERE d.user_id = ? AND d.id > ? AND ") +
+		DeletionJobs::DAILY_VISIBLE + " ORDER BY d.id LIMIT ?"));
+	pstmt->setInt(1, m_user_id);
+	pstmt->setInt64(2, m_last_id);
+	pstmt->setInt(3, m_user_id);
+	pstmt->setInt(4, static_cast<int>(PAGE_SIZE));
+
+	size_t rows = 0;
+	ResultSetPtr result(pstmt->executeQuery());
+	while (result->next()) {
+		++rows;
+		m_last_id = result->getInt64(1);
+		json line = {{"type", "history"},
+					 {"count", result->getInt(2)},
+					 {"played_at", result->getInt64(3)}};
+		readSong(result, 4, line);
+		appendLine(line, out);
+	}
+
+	if (rows < PAGE_SIZE) m_phase = Phase::Done;
+}
+
+LibraryImport::LibraryImport(int user_id) : m_user_id{user_id} {}
+
+void LibraryImport::add(const json& line) {
+	try {
+		const std::string type = line.value("type", "");
+		if (type == "profile") {
+			importProfile(line);
+			return;
+		}
+
+		if (type == "playlist") {
+			importPlaylist(line);
+			return;
+		}
+
+		if (type == "playlist_song") {
+			PendingSong song;
+			auto it = m_playlist_ids.find(line.value("playlist", 0));
+			if (it == m_playlist_ids.end() || !parseSong(line, song.meta)) {
+				++m_summary.skipped;
+				return;
+			}
+			song.playlist_id = it->second;
+			song.added_at = line.value("added_at", int64_t{0});
+			m_songs.push_back(std::move(song));
+			if (m_songs.size() >= CHUNK) flushSongs();
+			return;
+		}
+
+		if (type == "history") {
+			PendingPlay play;
+			play.count = line.value("count", 1);
+			play.played_at = line.value("played_at", int64_t{0});
+			if (play.count <= 0 || !parseSong(line, play.meta)) {
+				++m_summary.skipped;
+				return;
+			}
+			m_plays.push_back(std::move(play));
+			if (m_plays.size() >= CHUNK) flushHistory();
+			return;
+		}
+	} catch (const json::exception& e) {
+		// 字段类型不符
+	}
+	++m_summary.skipped;
+}
+
+void LibraryImport::finish() {
+	flushSongs();
+	flushHistory();
+
+	if (m_summary.history > 0 && !StatsEngine::getInstance()->recompute(m_user_id).has_value()) {
+		spdlog::warn("{} Recompute stats of user {} failed after import", TAG, m_user_id);
+	}
+}
+
+void LibraryImport::importProfile(const json& line) {
+	// 用户名/邮箱不导入, 只恢复平台绑定
+	MySqlUserDAO user_dao;
+	const std::string qq_id = line.value("qq_id", "");
+	const std::string netease_id = line.value("netease_id", "");
+	if (!qq_id.empty()) user_dao.updateQQId(m_user_id, qq_id);
+	if (!netease_id.empty()) user_dao.updateNetEaseId(m_user_id, netease_id);
+}
+
+void LibraryImport::importPlaylist(const json& line) {
+	// 之前歌单的歌曲先写入
+	flushSongs();
+
+	Playlist playlist;
+	playlist.user_id = m_user_id;
+	playlist.name = line.value("name", "");
+	playlist.cover = line.value("cover", "");
+	if (playlist.name.empty()) {
+		++m_summary.skipped;
+		return;
+	}
+
+	MySqlPlaylistDAO playlist_dao;
+	if (playlist_dao.createPlaylist(playlist) != DAOStatus::Ok) {
+		throw sql::SQLException("Create playlist failed");
+	}
+	m_playlist_ids[line.value("id", 0)] = playlist.id;
+	++m_summary.playlists;
+}
+
+void LibraryImport::flushSongs() {
+	if (m_songs.empty()) return;
+
+	SqlConnGuard guard(DBManager::getInstance()->getConnection());
+	std::vector<SongMeta> metas;
+	metas.reserve(m_songs.size());
+	for (const auto& song : m_songs) metas.push_back(song.meta);
+	auto resolved = SongPool::getInstance()->resolveBatch(guard, metas);
+
+	PreStmtPtr pstmt(guard.prepareStatement(
+		"INSERT INTO playlist_songs (playlist_id, song_ref, added_at) VALUES " +
+		repeatRow(m_songs.size(), "(?, ?, COALESCE(FROM_UNIXTIME(?), CURRENT_TIMESTAMP))") +
+		" ON DUPLICATE KEY UPDATE song_ref = song_ref"));
+	uint32_t param = 1;
+	for (size_t i = 0; i < m_songs.size(); ++i) {
+		if (!resolved[i]) throw sql::SQLException("Resolve song failed");
+		pstmt->setInt(param++, m_songs[i].playlist_id);
+		pstmt->setInt(param++, resolved[i]->ref);
+		setTimestamp(pstmt, param++, m_songs[i].added_at);
+	}
+	pstmt->executeUpdate();
+
+	std::unordered_set<int> touched;
+	for (const auto& song : m_songs) {
+		if (touched.insert(song.playlist_id).second) {
+			PlaylistCache::getInstance()->bump(song.playlist_id);
+		}
+	}
+	m_summary.playlist_songs += m_songs.size();
+	m_songs.clear();
+}
+
+void LibraryImport::flushHistory() {
+	if (m_plays.empty()) return;
+
+	SqlConnGuard guard(DBManager::getInstance()->getConnection());
+	std::vector<SongMeta> metas;
+	metas.reserve(m_plays.size());
+	for (const auto& play : m_plays) metas.push_back(play.meta);
+	auto resolved = SongPool::getInstance()->resolveBatch(guard, metas);
+
+	SqlTransaction tx(guard);
+
+	// play_history 没有外键: 用户行加共享锁到提交, 与注销互斥, 已注销时不写入
+	{
+		PreStmtPtr pstmt(guard.prepareStatement(
+			"SELECT id FROM users WHERE id = ? AND deleted_at IS NULL FOR SHARE"));
+		pstmt->setInt(1, m_user_id);
+		ResultSetPtr result(pstmt->executeQuery());
+		if (!result->next()) throw sql::SQLException("User not found");
+	}
+
+	// 已登记汇总的分区上界 (Unix 秒), 早于它的明细所在分区已删除或即将删除.
+	// 整表共享锁 (含末尾间隙) 与 HistoryPartitions 登记分区互斥, 明细不会写入汇总中的分区
+	int64_t horizon = 0;
+	{
+		PreStmtPtr pstmt(
+			guard.prepareStatement("SELECT bound FROM play_history_compactions FOR SHARE"));
+		ResultSetPtr result(pstmt->executeQuery());
+		while (result->next()) horizon = std::max(horizon, result->getInt64(1));
+	}
+
+	const int64_t now = static_cast<int64_t>(std::time(nullptr));
+	std::vector<size_t> daily;
+	std::vector<std::pair<int, int64_t>> plays;
+	for (size_t i = 0; i < m_plays.size(); ++i) {
+		if (!resolved[i]) throw sql::SQLException("Resolve song failed");
+
+		// 缺少或晚于当前的播放时间按当前时间
+		int64_t played_at = m_plays[i].played_at;
+		if (played_at <= 0 || played_at > now) played_at = now;
+		m_plays[i].played_at = played_at;
+
+		// 多次播放来自导出的按日汇总, 原样写回汇总而不展开, 每行只写一条
+		if (played_at < horizon || m_plays[i].count > 1) {
+			daily.push_back(i);
+			continue;
+		}
+		plays.emplace_back(resolved[i]->ref, played_at);
+	}
+	insertPlays(guard, m_user_id, plays);
+
+	if (!daily.empty()) {
+		PreStmtPtr pstmt(guard.prepareStatement(
+			"INSERT INTO play_history_daily (user_id, song_ref, day, play_count) VALUES " +
+			repeatRow(daily.size(), "(?, ?, DATE(FROM_UNIXTIME(?)), ?)") +
+			" ON DUPLICATE KEY UPDATE play_count = play_count + VALUES(play_count)"));
+		uint32_t param = 1;
+		for (size_t i : daily) {
+			pstmt->setInt(param++, m_user_id);
+			pstmt->setInt(param++, resolved[i]->ref);
+			pstmt->setInt64(param++, m_plays[i].played_at);
+			pstmt->setInt(param++, m_plays[i].count);
+		}
+		pstmt->executeUpdate();
+	}
+
+	tx.commit();
+	m_summary.history += m_plays.size();
+	m_plays.clear();
+}
+
+void LibraryImport::insertPlays(const SqlConnGuard& guard, int user_id,
+								const std::vector<std::pair<int, int64_t>>& plays) {
+	if (plays.empty()) return;
+
+	PreStmtPtr pstmt(guard.prepareStatement(
+		"INSERT INTO play_history (user_id, song_ref, played_at) VALUES " +
+		repeatRow(plays.size(), "(?, ?, FROM_UNIXTIME(?))")));
+	uint32_t param = 1;
+	for (const auto& [song_ref, played_at] : plays) {
+		pstmt->setInt(param++, user_id);
+		pstmt->setInt(param++, song_ref);
+		pstmt->setInt64(param++, played_at);
+	}
+	pstmt->executeUpdate();
+}
+
+bool LibraryImport::parseSong(const json& line, SongMeta& meta) {
+	auto where = parseSongSource(line.value("where", ""));
+	meta.song_id = line.value("song_id", "");
+	if (!where || meta.song_id.empty()) return false;
+
+	meta.where = *where;
+	meta.name = line.value("name", "");
+	meta.singer = line.value("singer", "");
+	meta.pic = line.value("pic", "");
+	return true;
+}
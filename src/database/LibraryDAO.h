@@ -0,0 +1,115 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "DBManager.h"
+#include "../models/song.h"
+
+/**
+ * @brief 用户曲库 NDJSON 导出
+ *
+ * 每行一个 JSON 对象, type 依次为 profile / playlist / playlist_song / history, 时间戳为
+ * Unix 秒. 播放明细每次一行 (count 为 1), 已按日汇总的历史每 (日, 歌曲) 一行.
+ * 按主键分页 (keyset), 每次只查询一页并立即归还连接, 内存占用与总行数无关,
+ * 导出期间也不长期占用连接池.
+ */
+class LibraryExport {
+public:
+	static constexpr size_t PAGE_SIZE = 1000;
+
+	explicit LibraryExport(int user_id);
+
+	/**
+	 * @brief 向 out 追加下一页的 NDJSON 行
+	 * @return 之后是否还有数据; 查询失败抛出 sql::SQLException
+	 */
+	bool next(std::string& out);
+
+private:
+	enum class Phase { Profile, Playlists, PlaylistSongs, History, Daily, Done };
+
+	void exportProfile(std::string& out);
+	void exportPlaylists(const SqlConnGuard& guard, std::string& out);
+	void exportPlaylistSongs(const SqlConnGuard& guard, std::string& out);
+	void exportHistory(const SqlConnGuard& guard, std::string& out);
+	void exportDaily(const SqlConnGuard& guard, std::string& out);
+
+private:
+	int m_user_id;
+	Phase m_phase = Phase::Profile;
+	int64_t m_last_id = 0; // 当前阶段已导出的最大主键
+
+	std::vector<int> m_playlists; // 用户的歌单 id, 逐个导出歌曲
+	size_t m_playlist_index = 0;
+};
+
+/**
+ * @brief 用户曲库 NDJSON 导入 (格式同 LibraryExport)
+ *
+ * 歌单按文件中的顺序新建, playlist_song 行通过导出时的歌单 id 关联到新歌单; 歌曲与播放
+ * 历史按 CHUNK 行缓冲, 以多行语句写入. 每块单独提交, 中途失败时已写入的块保留.
+ * count 大于 1 或播放时间落在已过期分区 (见 HistoryPartitions) 的历史写入按日汇总, 其余
+ * 写入明细, 每个输入行至多写一行.
+ * 结束后由 play_history 重算该用户的统计汇总表.
+ */
+class LibraryImport {
+public:
+	static constexpr size_t CHUNK = 500;
+
+	struct Summary {
+		size_t playlists = 0;
+		size_t playlist_songs = 0;
+		size_t history = 0;
+		size_t skipped = 0; // 无法识别或缺少字段的行
+	};
+
+	explicit LibraryImport(int user_id);
+
+	// 处理一行; 写入失败抛出 sql::SQLException
+	void add(const nlohmann::json& line);
+
+	// 写入剩余缓冲并重算统计
+	void finish();
+
+	const Summary& summary() const { return m_summary; }
+
+private:
+	struct PendingSong {
+		int playlist_id = 0;
+		int64_t added_at = 0;
+		SongMeta meta;
+	};
+
+	struct PendingPlay {
+		int count = 0;
+		int64_t played_at = 0;
+		SongMeta meta;
+	};
+
+	void importProfile(const nlohmann::json& line);
+	void importPlaylist(const nlohmann::json& line);
+
+	void flushSongs();
+	void flushHistory();
+
+	// 写入播放明细, 每个 (song_ref, played_at) 一行
+	static void insertPlays(const SqlConnGuard& guard, int user_id,
+							const std::vector<std::pair<int, int64_t>>& plays);
+
+	// 解析歌曲字段, 缺少 song_id/where 时返回 false
+	static bool parseSong(const nlohmann::json& line, SongMeta& meta);
+
+private:
+	int m_user_id;
+	Summary m_summary;
+
+	std::unordered_map<int, int> m_playlist_ids; // 导出时的歌单 id → 新歌单 id
+	std::vector<PendingSong> m_songs;
+	std::vector<PendingPlay> m_plays;
+};
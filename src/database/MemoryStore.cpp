@@ -0,0 +1,523 @@
+#include "MemoryStore.h"
+#include "../utils/PasswordUtil.h"
+
+#include <algorithm>
+#include <ctime>
+#include <mutex>
+
+namespace {
+
+int64_t now() {
+	return static_cast<int64_t>(std::time(nullptr));
+}
+
+} // namespace
+
+SongMetaPtr MemoryStore::resolveSong(const SongMeta& meta) {
+	const std::string key = songKey(meta.song_id, meta.where);
+	auto it = m_songs_by_key.find(key);
+	const int ref = it != m_songs_by_key.end() ? it->second : static_cast<int>(m_songs.size()) + 1;
+
+	// 与 upsert 一致: 已存在的歌曲以最新的元数据为准
+	auto song = std::make_shared<SongMeta>(meta);
+	song->ref = ref;
+	if (it == m_songs_by_key.end()) {
+		m_songs.push_back(song);
+		m_songs_by_key.emplace(key, ref);
+	} else {
+		m_songs[ref - 1] = song;
+	}
+	return song;
+}
+
+SongMetaPtr MemoryStore::findSong(int ref) const {
+	if (ref <= 0 || static_cast<size_t>(ref) > m_songs.size()) return nullptr;
+	return m_songs[ref - 1];
+}
+
+std::optional<int> MemoryStore::findSongRef(const std::string& song_id, SongSource where) const {
+	auto it = m_songs_by_key.find(songKey(song_id, where));
+	if (it == m_songs_by_key.end()) return std::nullopt;
+	return it->second;
+}
+
+size_t MemoryStore::erasePlaylist(int playlist_id) {
+	auto it = m_playlists.find(playlist_id);
+	if (it == m_playlists.end()) return 0;
+
+	const size_t rows = it->second.songs.size() + 1;
+	auto owner = m_playlists_by_user.find(it->second.playlist.user_id);
+	if (owner != m_playlists_by_user.end()) {
+		owner->second.erase(playlist_id);
+		if (owner->second.empty()) m_playlists_by_user.erase(owner);
+	}
+	m_playlists.erase(it);
+	return rows;
+}
+
+int MemoryStore::addJob(DeletionJobs::Kind kind, int user_id, int64_t deleted_rows) {
+	DeletionJobs::Job job;
+	job.id = m_next_job_id++;
+	job.kind = kind;
+	job.user_id = user_id;
+	job.state = DeletionJobs::State::Done;
+	job.deleted_rows = deleted_rows;
+	job.created_at = job.updated_at = now();
+	m_jobs.emplace(job.id, job);
+	return job.id;
+}
+
+MemoryUserDAO::MemoryUserDAO(MemoryStore* store)
+	: store{store}, playlist_cache{PlaylistCache::getInstance()} {}
+
+DAOStatus MemoryUserDAO::createUser(User& user) {
+	// 哈希较慢, 在锁外完成
+	const std::string hashed_passwd = PasswordUtil::hashPassword(user.passwd_hash);
+
+	std::unique_lock<std::shared_mutex> lock(store->m_mtx);
+	if (store->m_users_by_name.count(user.username) > 0 ||
+		store->m_users_by_email.count(user.email) > 0) {
+		return DAOStatus::Conflict;
+	}
+
+	User row;
+	row.id = store->m_next_user_id++;
+	row.create_at = row.update_at = now();
+	row.username = user.username;
+	row.passwd_hash = hashed_passwd;
+	row.email = user.email;
+
+	user.id = row.id;
+	store->m_users_by_name.emplace(row.username, row.id);
+	store->m_users_by_email.emplace(row.email, row.id);
+	store->m_users.emplace(row.id, std::move(row));
+	return DAOStatus::Ok;
+}
+
+std::optional<User> MemoryUserDAO::getUserById(int id) {
+	std::shared_lock<std::shared_mutex> lock(store->m_mtx);
+	auto it = store->m_users.find(id);
+	if (it == store->m_users.end()) return std::nullopt;
+	return it->second;
+}
+
+std::optional<User> MemoryUserDAO::getUserByUsername(const std::string& username) {
+	std::shared_lock<std::shared_mutex> lock(store->m_mtx);
+	auto it = store->m_users_by_name.find(username);
+	if (it == store->m_users_by_name.end()) return std::nullopt;
+	return store->m_users.at(it->second);
+}
+
+std::optional<User> MemoryUserDAO::getUserByEmail(const std::string& email) {
+	std::shared_lock<std::shared_mutex> lock(store->m_mtx);
+	auto it = store->m_users_by_email.find(email);
+	if (it == store->m_users_by_email.end()) return std::nullopt;
+	return store->m_users.at(it->second);
+}
+
+bool MemoryUserDAO::updateUser(const User& user) {
+	std::unique_lock<std::shared_mutex> lock(store->m_mtx);
+	auto it = store->m_users.find(user.id);
+	if (it == store->m_users.end()) return false;
+
+	// 用户名/邮箱被其他用户占用时违反唯一键
+	auto name = store->m_users_by_name.find(user.username);
+	if (name != store->m_users_by_name.end() && name->second != user.id) return false;
+	auto email = store->m_users_by_email.find(user.email);
+	if (email != store->m_users_by_email.end() && email->second != user.id) return false;
+
+	User& row = it->second;
+	store->m_users_by_name.erase(row.username);
+	store->m_users_by_email.erase(row.email);
+	row.username = user.username;
+	row.email = user.email;
+	row.qq_id = user.qq_id;
+	row.netease_id = user.netease_id;
+	row.update_at = now();
+	store->m_users_by_name.emplace(row.username, row.id);
+	store->m_users_by_email.emplace(row.email, row.id);
+	return true;
+}
+
+std::optional<int> MemoryUserDAO::deleteUser(int id) {
+	std::vector<int> playlist_ids;
+	int job_id = 0;
+	{
+		std::unique_lock<std::shared_mutex> lock(store->m_mtx);
+		auto it = store->m_users.find(id);
+		if (it == store->m_users.end()) return std::nullopt;
+
+		int64_t rows = 1;
+		auto owned = store->m_playlists_by_user.find(id);
+		if (owned != store->m_playlists_by_user.end()) {
+			playlist_ids.assign(owned->second.begin(), owned->second.end());
+		}
+		for (int playlist_id : playlist_ids) rows += store->erasePlaylist(playlist_id);
+
+		auto history = store->m_history.find(id);
+		if (history != store->m_history.end()) {
+			rows += history->second.plays.size();
+			store->m_history.erase(history);
+		}
+
+		store->m_users_by_name.erase(it->second.username);
+		store->m_users_by_email.erase(it->second.email);
+		store->m_users.erase(it);
+		job_id = store->addJob(DeletionJobs::Kind::User, id, rows);
+	}
+
+	for (int playlist_id : playlist_ids) playlist_cache->erase(playlist_id);
+	return job_id;
+}
+
+template <typename Fn>
+void MemoryUserDAO::modifyUser(int user_id, Fn&& fn) {
+	std::unique_lock<std::shared_mutex> lock(store->m_mtx);
+	auto it = store->m_users.find(user_id);
+	if (it == store->m_users.end()) return;
+	fn(it->second);
+	it->second.update_at = now();
+}
+
+// 与 MySQL 实现一致, 用户不存在时 UPDATE 不影响任何行, 仍视为成功
+bool MemoryUserDAO::updatePassword(int user_id, const std::string& new_password) {
+	const std::string hashed_passwd = PasswordUtil::hashPassword(new_password);
+	modifyUser(user_id, [&](User& user) { user.passwd_hash = hashed_passwd; });
+	return true;
+}
+
+bool MemoryUserDAO::updateQQId(int user_id, const std::string& qq_id) {
+	modifyUser(user_id, [&](User& user) { user.qq_id = qq_id; });
+	return true;
+}
+
+bool MemoryUserDAO::updateNetEaseId(int user_id, const std::string& netease_id) {
+	modifyUser(user_id, [&](User& user) { user.netease_id = netease_id; });
+	return true;
+}
+
+MemoryPlaylistDAO::MemoryPlaylistDAO(MemoryStore* store)
+	: store{store}, playlist_cache{PlaylistCache::getInstance()} {}
+
+DAOStatus MemoryPlaylistDAO::createPlaylist(Playlist& playlist) {
+	std::unique_lock<std::shared_mutex> lock(store->m_mtx);
+	if (store->m_users.count(playlist.user_id) == 0) return DAOStatus::NotFound;
+
+	MemoryStore::PlaylistRow row;
+	row.playlist = playlist;
+	row.playlist.id = store->m_next_playlist_id++;
+	row.playlist.create_at = row.playlist.update_at = now();
+
+	playlist.id = row.playlist.id;
+	store->m_playlists_by_user[playlist.user_id].insert(playlist.id);
+	store->m_playlists.emplace(playlist.id, std::move(row));
+	return DAOStatus::Ok;
+}
+
+std::optional<Playlist> MemoryPlaylistDAO::getPlaylistById(int playlist_id) {
+	std::shared_lock<std::shared_mutex> lock(store->m_mtx);
+	auto it = store->m_playlists.find(playlist_id);
+	if (it == store->m_playlists.end()) return std::nullopt;
+	return it->second.playlist;
+}
+
+std::vector<Playlist> MemoryPlaylistDAO::getPlaylistsByUserId(int user_id) {
+	std::vector<Playlist> playlists;
+	std::shared_lock<std::shared_mutex> lock(store->m_mtx);
+	auto owned = store->m_playlists_by_user.find(user_id);
+	if (owned == store->m_playlists_by_user.end()) return playlists;
+
+	playlists.reserve(owned->second.size());
+	for (int playlist_id : owned->second) {
+		playlists.push_back(store->m_playlists.at(playlist_id).playlist);
+	}
+	return playlists;
+}
+
+bool MemoryPlaylistDAO::updatePlaylist(const Playlist& playlist) {
+	{
+		std::unique_lock<std::shared_mutex> lock(store->m_mtx);
+		auto it = store->m_playlists.find(playlist.id);
+		if (it == store->m_playlists.end()) return false;
+
+		it->second.playlist.name = playlist.name;
+		it->second.playlist.cover = playlist.cover;
+		it->second.playlist.update_at = now();
+	}
+	playlist_cache->bump(playlist.id);
+	return true;
+}
+
+bool MemoryPlaylistDAO::deletePlaylist(int id) {
+	{
+		std::unique_lock<std::shared_mutex> lock(store->m_mtx);
+		if (store->erasePlaylist(id) == 0) return false;
+	}
+	playlist_cache->erase(id);
+	return true;
+}
+
+DAOStatus MemoryPlaylistDAO::addSongToPlaylist(int playlist_id, const Song& song) {
+	{
+		std::unique_lock<std::shared_mutex> lock(store->m_mtx);
+		auto it = store->m_playlists.find(playlist_id);
+		if (it == store->m_playlists.end()) return DAOStatus::NotFound;
+
+		const int ref = store->resolveSong(*song.meta)->ref;
+		if (!it->second.refs.insert(ref).second) return DAOStatus::Conflict;
+		it->second.songs.push_back({store->m_next_entry_id++, now(), ref});
+	}
+	playlist_cache->bump(playlist_id);
+	return DAOStatus::Ok;
+}
+
+bool MemoryPlaylistDAO::removeSongFromPlaylist(int playlist_id, const std::string& song_id,
+											   SongSource song_source) {
+	{
+		std::unique_lock<std::shared_mutex> lock(store->m_mtx);
+		auto it = store->m_playlists.find(playlist_id);
+		if (it == store->m_playlists.end()) return false;
+
+		auto ref = store->findSongRef(song_id, song_source);
+		if (!ref || it->second.refs.erase(*ref) == 0) return false;
+
+		auto& songs = it->second.songs;
+		auto entry = std::find_if(songs.begin(), songs.end(), [&](const auto& e) {
+			return e.song_ref == *ref;
+		});
+		songs.erase(entry);
+	}
+	playlist_cache->bump(playlist_id);
+	return true;
+}
+
+DAOStatus MemoryPlaylistDAO::addSongsToPlaylist(int playlist_id, const std::vector<Song>& songs,
+												std::vector<DAOStatus>& results) {
+	results.assign(songs.size(), DAOStatus::Error);
+	size_t added = 0;
+	{
+		std::unique_lock<std::shared_mutex> lock(store->m_mtx);
+		auto it = store->m_playlists.find(playlist_id);
+		if (it == store->m_playlists.end()) return DAOStatus::NotFound;
+
+		// 本批内重复与已在歌单中的歌曲都违反唯一键
+		const int64_t added_at = now();
+		for (size_t i = 0; i < songs.size(); ++i) {
+			const int ref = store->resolveSong(*songs[i].meta)->ref;
+			if (!it->second.refs.insert(ref).second) {
+				results[i] = DAOStatus::Conflict;
+				continue;
+			}
+			it->second.songs.push_back({store->m_next_entry_id++, added_at, ref});
+			results[i] = DAOStatus::Ok;
+			++added;
+		}
+	}
+	if (added > 0) playlist_cache->bump(playlist_id);
+	return DAOStatus::Ok;
+}
+
+DAOStatus MemoryPlaylistDAO::removeSongsFromPlaylist(
+	int playlist_id, const std::vector<std::pair<std::string, SongSource>>& keys,
+	std::vector<DAOStatus>& results) {
+	results.assign(keys.size(), DAOStatus::NotFound);
+	std::unordered_set<int> removed;
+	{
+		std::unique_lock<std::shared_mutex> lock(store->m_mtx);
+		auto it = store->m_playlists.find(playlist_id);
+		if (it == store->m_playlists.end()) return DAOStatus::NotFound;
+
+		for (size_t i = 0; i < keys.size(); ++i) {
+			auto ref = store->findSongRef(keys[i].first, keys[i].second);
+			if (!ref || it->second.refs.erase(*ref) == 0) continue;
+			removed.insert(*ref);
+			results[i] = DAOStatus::Ok;
+		}
+
+		auto& songs = it->second.songs;
+		songs.erase(std::remove_if(songs.begin(), songs.end(),
+								   [&](const MemoryStore::PlaylistEntry& e) {
+									   return removed.count(e.song_ref) > 0;
+								   }),
+					songs.end());
+	}
+	if (!removed.empty()) playlist_cache->bump(playlist_id);
+	return DAOStatus::Ok;
+}
+
+std::vector<Song> MemoryPlaylistDAO::buildSongs(const MemoryStore::PlaylistRow& row) const {
+	std::vector<Song> songs;
+	songs.reserve(row.songs.size());
+	for (const auto& entry : row.songs) {
+		songs.push_back({entry.id, entry.added_at, store->findSong(entry.song_ref)});
+	}
+	return songs;
+}
+
+std::vector<Song> MemoryPlaylistDAO::getSongsInPlaylist(int playlist_id) {
+	std::shared_lock<std::shared_mutex> lock(store->m_mtx);
+	auto it = store->m_playlists.find(playlist_id);
+	if (it == store->m_playlists.end()) return {};
+	return buildSongs(it->second);
+}
+
+std::optional<PlaylistCache::Snapshot> MemoryPlaylistDAO::getPlaylistSnapshot(int playlist_id) {
+	if (auto snapshot = playlist_cache->get(playlist_id)) return snapshot;
+
+	// 与 MySQL 实现相同, 先取版本再读取, 期间有修改时不回填
+	PlaylistCache::Snapshot snapshot;
+	snapshot.version = playlist_cache->version(playlist_id);
+	{
+		std::shared_lock<std::shared_mutex> lock(store->m_mtx);
+		auto it = store->m_playlists.find(playlist_id);
+		if (it == store->m_playlists.end()) return std::nullopt;
+
+		snapshot.playlist = std::make_shared<const Playlist>(it->second.playlist);
+		snapshot.songs = std::make_shared<const std::vector<Song>>(buildSongs(it->second));
+	}
+	playlist_cache->put(playlist_id, snapshot);
+	return snapshot;
+}
+
+int MemoryPlaylistDAO::countSongsInPlaylist(int playlist_id) {
+	std::shared_lock<std::shared_mutex> lock(store->m_mtx);
+	auto it = store->m_playlists.find(playlist_id);
+	if (it == store->m_playlists.end()) return 0;
+	return static_cast<int>(it->second.songs.size());
+}
+
+MemoryPlayHistoryDAO::MemoryPlayHistoryDAO(MemoryStore* store) : store{store} {}
+
+bool MemoryPlayHistoryDAO::addPlayHistory(const PlayHistory& history) {
+	if (!history.song) return false;
+
+	std::unique_lock<std::shared_mutex> lock(store->m_mtx);
+	if (store->m_users.count(history.user_id) == 0) return false;
+
+	SongMetaPtr song = store->resolveSong(*history.song);
+	auto& user = store->m_history[history.user_id];
+	user.plays.push_back({store->m_next_play_id++, song->ref, now()});
+	++user.song_counts[song->ref];
+	++user.artist_counts[song->singer];
+	++user.total_plays;
+	return true;
+}
+
+std::vector<PlayHistory> MemoryPlayHistoryDAO::getUserPlayHistory(int user_id, int limit,
+																  int offset) {
+	std::vector<PlayHistory> histories;
+	if (limit <= 0 || offset < 0) return histories;
+
+	std::shared_lock<std::shared_mutex> lock(store->m_mtx);
+	auto it = store->m_history.find(user_id);
+	if (it == store->m_history.end()) return histories;
+
+	const auto& plays = it->second.plays;
+	const auto& song_counts = it->second.song_counts;
+	if (static_cast<size_t>(offset) >= plays.size()) return histories;
+
+	const size_t count = std::min(plays.size() - offset, static_cast<size_t>(limit));
+	histories.reserve(count);
+	for (auto play = plays.rbegin() + offset; histories.size() < count; ++play) {
+		PlayHistory history;
+		history.id = play->id;
+		history.user_id = user_id;
+		auto count = song_counts.find(play->song_ref);
+		history.song_count = count != song_counts.end() ? count->second : 0;
+		history.played_at = play->played_at;
+		history.song = store->findSong(play->song_ref);
+		histories.push_back(std::move(history));
+	}
+	return histories;
+}
+
+std::optional<int> MemoryPlayHistoryDAO::clearUserPlayHistory(int user_id) {
+	std::unique_lock<std::shared_mutex> lock(store->m_mtx);
+	if (store->m_users.count(user_id) == 0) return std::nullopt;
+
+	int64_t rows = 0;
+	auto it = store->m_history.find(user_id);
+	if (it != store->m_history.end()) {
+		rows = static_cast<int64_t>(it->second.plays.size());
+		store->m_history.erase(it);
+	}
+	return store->addJob(DeletionJobs::Kind::History, user_id, rows);
+}
+
+std::optional<DeletionJobs::Job> MemoryPlayHistoryDAO::getClearJob(int job_id, int user_id) {
+	std::shared_lock<std::shared_mutex> lock(store->m_mtx);
+	auto it = store->m_jobs.find(job_id);
+	if (it == store->m_jobs.end() || it->second.user_id != user_id) return std::nullopt;
+	return it->second;
+}
+
+bool MemoryPlayHistoryDAO::deletePlayHistory(int64_t history_id, int user_id) {
+	std::unique_lock<std::shared_mutex> lock(store->m_mtx);
+	auto it = store->m_history.find(user_id);
+	if (it == store->m_history.end()) return false;
+
+	auto& user = it->second;
+	auto play = std::lower_bound(
+		user.plays.begin(), user.plays.end(), history_id,
+		[](const MemoryStore::Play& p, int64_t id) { return p.id < id; });
+	if (play == user.plays.end() || play->id != history_id) return false;
+
+	// 与汇总表一致, 计数减到 0 时删除该项
+	auto decrement = [](auto& counts, const auto& key) {
+		auto it = counts.find(key);
+		if (it != counts.end() && --it->second <= 0) counts.erase(it);
+	};
+	decrement(user.song_counts, play->song_ref);
+	decrement(user.artist_counts, store->findSong(play->song_ref)->singer);
+	if (user.total_plays > 0) --user.total_plays;
+	user.plays.erase(play);
+	return true;
+}
+
+int MemoryPlayHistoryDAO::getUserRecentPlayCount(int user_id, int days) {
+	std::shared_lock<std::shared_mutex> lock(store->m_mtx);
+	auto it = store->m_history.find(user_id);
+	if (it == store->m_history.end()) return 0;
+
+	const int64_t since = now() - static_cast<int64_t>(days) * 24 * 3600;
+	const auto& plays = it->second.plays;
+	auto first = std::find_if(plays.rbegin(), plays.rend(),
+							  [&](const MemoryStore::Play& p) { return p.played_at < since; });
+	return static_cast<int>(first - plays.rbegin());
+}
+
+std::optional<StatsEngine::UserStats> MemoryPlayHistoryDAO::getUserStats(int user_id, size_t k) {
+	k = std::min(k, StatsEngine::TOP_K_MAX);
+
+	StatsEngine::UserStats stats;
+	std::shared_lock<std::shared_mutex> lock(store->m_mtx);
+	auto it = store->m_history.find(user_id);
+	if (it == store->m_history.end()) return stats;
+
+	const auto& user = it->second;
+	stats.total_plays = user.total_plays;
+
+	std::vector<std::pair<int, int>> songs(user.song_counts.begin(), user.song_counts.end());
+	const size_t song_k = std::min(k, songs.size());
+	std::partial_sort(songs.begin(), songs.begin() + song_k, songs.end(),
+					  [](const auto& a, const auto& b) {
+						  return a.second != b.second ? a.second > b.second : a.first < b.first;
+					  });
+	stats.top_songs.reserve(song_k);
+	for (size_t i = 0; i < song_k; ++i) {
+		stats.top_songs.push_back({store->findSong(songs[i].first), songs[i].second});
+	}
+
+	std::vector<std::pair<std::string, int>> artists(user.artist_counts.begin(),
+													 user.artist_counts.end());
+	const size_t artist_k = std::min(k, artists.size());
+	std::partial_sort(artists.begin(), artists.begin() + artist_k, artists.end(),
+					  [](const auto& a, const auto& b) {
+						  return a.second != b.second ? a.second > b.second : a.first < b.first;
+					  });
+	stats.top_artists.reserve(artist_k);
+	for (size_t i = 0; i < artist_k; ++i) {
+		stats.top_artists.push_back({artists[i].first, artists[i].second});
+	}
+	return stats;
+}
@@ -0,0 +1,192 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "PlayHistoryDAO.h"
+#include "PlaylistCache.h"
+#include "PlaylistDAO.h"
+#include "UserDAO.h"
+
+/**
+ * @brief 内存存储引擎, memory 后端的全部数据
+ *
+ * 各表与 MySQL 模式对应, 由一把读写锁保护: 查询共享, 修改互斥, 每个 DAO 方法在一次加锁内
+ * 完成, 相当于一个事务. 与 MySQL 实现保持相同的语义:
+ *   唯一键	用户名, 邮箱, 歌曲 (song_id, song_where), 歌单歌曲 (playlist_id, song_ref)
+ *   外键	歌单与播放历史引用的用户须存在, 删除歌单时级联删除其歌曲
+ *   排序	歌单按 id, 歌单歌曲按加入顺序, 播放历史按时间倒序, 统计按次数降序
+ *			(次数相同时按歌曲 id / 歌手名, 结果确定)
+ * 注销用户与清空历史在 MySQL 后端由后台任务分批删除, 这里在请求内同步删除, 任务直接登记为
+ * 已完成; 播放历史没有保留期. 数据只在进程内, 重启后清空.
+ */
+class MemoryStore {
+public:
+	MemoryStore() = default;
+	~MemoryStore() = default;
+	MemoryStore(const MemoryStore&) = delete;
+	MemoryStore(MemoryStore&&) = delete;
+	MemoryStore& operator=(const MemoryStore&) = delete;
+	MemoryStore& operator=(MemoryStore&&) = delete;
+
+private:
+	friend class MemoryUserDAO;
+	friend class MemoryPlaylistDAO;
+	friend class MemoryPlayHistoryDAO;
+
+	// playlist_songs 的一行
+	struct PlaylistEntry {
+		int id = 0;
+		int64_t added_at = 0;
+		int song_ref = 0;
+	};
+
+	struct PlaylistRow {
+		Playlist playlist;
+		std::vector<PlaylistEntry> songs; // 按加入顺序 (id 递增)
+		std::unordered_set<int> refs;	  // 唯一键 (playlist_id, song_ref)
+	};
+
+	// play_history 的一行
+	struct Play {
+		int64_t id = 0;
+		int song_ref = 0;
+		int64_t played_at = 0;
+	};
+
+	// 用户的播放历史与汇总 (user_song_stats / user_artist_stats / user_play_stats)
+	struct UserHistory {
+		std::vector<Play> plays; // id 与时间递增
+		std::unordered_map<int, int> song_counts;
+		std::unordered_map<std::string, int> artist_counts;
+		int64_t total_plays = 0;
+	};
+
+	// 以下调用方持有锁, 修改类需持有写锁
+
+	// 写入歌曲 (已存在则更新元数据), 返回带 ref 的元数据
+	SongMetaPtr resolveSong(const SongMeta& meta);
+	SongMetaPtr findSong(int ref) const;
+	std::optional<int> findSongRef(const std::string& song_id, SongSource where) const;
+
+	// 删除歌单及其歌曲, 返回删除的行数
+	size_t erasePlaylist(int playlist_id);
+
+	// 登记一个已完成的删除任务
+	int addJob(DeletionJobs::Kind kind, int user_id, int64_t deleted_rows);
+
+	static std::string songKey(const std::string& song_id, SongSource where) {
+		return static_cast<char>(where) + song_id;
+	}
+
+private:
+	std::map<int, User> m_users;
+	std::unordered_map<std::string, int> m_users_by_name;
+	std::unordered_map<std::string, int> m_users_by_email;
+	int m_next_user_id = 1;
+
+	std::vector<SongMetaPtr> m_songs; // 下标为 ref - 1
+	std::unordered_map<std::string, int> m_songs_by_key;
+
+	std::map<int, PlaylistRow> m_playlists;
+	std::unordered_map<int, std::set<int>> m_playlists_by_user;
+	int m_next_playlist_id = 1;
+	int m_next_entry_id = 1;
+
+	std::unordered_map<int, UserHistory> m_history;
+	int64_t m_next_play_id = 1;
+
+	std::map<int, DeletionJobs::Job> m_jobs;
+	int m_next_job_id = 1;
+
+	mutable std::shared_mutex m_mtx;
+};
+
+/**
+ * @brief 用户 内存实现, 不经过 UserCache
+ */
+class MemoryUserDAO : public UserDAO {
+public:
+	explicit MemoryUserDAO(MemoryStore* store);
+
+	DAOStatus createUser(User& user) override;
+	std::optional<User> getUserById(int id) override;
+	std::optional<User> getUserByUsername(const std::string& username) override;
+	std::optional<User> getUserByEmail(const std::string& email) override;
+	bool updateUser(const User& user) override;
+	std::optional<int> deleteUser(int id) override;
+	bool updatePassword(int user_id, const std::string& new_password) override;
+	bool updateQQId(int user_id, const std::string& qq_id) override;
+	bool updateNetEaseId(int user_id, const std::string& netease_id) override;
+
+private:
+	// 修改一个用户, 用户不存在时什么也不做
+	template <typename Fn>
+	void modifyUser(int user_id, Fn&& fn);
+
+private:
+	MemoryStore* store;
+	PlaylistCache* playlist_cache;
+};
+
+/**
+ * @brief 歌单 内存实现, 版本号与快照缓存仍由 PlaylistCache 维护
+ */
+class MemoryPlaylistDAO : public PlaylistDAO {
+public:
+	explicit MemoryPlaylistDAO(MemoryStore* store);
+
+	DAOStatus createPlaylist(Playlist& playlist) override;
+	std::optional<Playlist> getPlaylistById(int playlist_id) override;
+	std::vector<Playlist> getPlaylistsByUserId(int user_id) override;
+	bool updatePlaylist(const Playlist& playlist) override;
+	bool deletePlaylist(int id) override;
+
+	DAOStatus addSongToPlaylist(int playlist_id, const Song& song) override;
+	bool removeSongFromPlaylist(int playlist_id, const std::string& song_id,
+								SongSource song_source) override;
+	DAOStatus addSongsToPlaylist(int playlist_id, const std::vector<Song>& songs,
+								 std::vector<DAOStatus>& results) override;
+	DAOStatus removeSongsFromPlaylist(int playlist_id,
+									  const std::vector<std::pair<std::string, SongSource>>& keys,
+									  std::vector<DAOStatus>& results) override;
+
+	std::vector<Song> getSongsInPlaylist(int playlist_id) override;
+	std::optional<PlaylistCache::Snapshot> getPlaylistSnapshot(int playlist_id) override;
+	int countSongsInPlaylist(int playlist_id) override;
+
+private:
+	// 调用方持有锁
+	std::vector<Song> buildSongs(const MemoryStore::PlaylistRow& row) const;
+
+private:
+	MemoryStore* store;
+	PlaylistCache* playlist_cache;
+};
+
+/**
+ * @brief 播放历史 内存实现, 统计由汇总计数即时排序得出, 不经过 StatsEngine
+ */
+class MemoryPlayHistoryDAO : public PlayHistoryDAO {
+public:
+	explicit MemoryPlayHistoryDAO(MemoryStore* store);
+
+	bool addPlayHistory(const PlayHistory& history) override;
+	std::vector<PlayHistory> getUserPlayHistory(int user_id, int limit = 50,
+												int offset = 0) override;
+	std::optional<int> clearUserPlayHistory(int user_id) override;
+	std::optional<DeletionJobs::Job> getClearJob(int job_id, int user_id) override;
+	bool deletePlayHistory(int64_t history_id, int user_id) override;
+	int getUserRecentPlayCount(int user_id, int days = 7) override;
+	std::optional<StatsEngine::UserStats> getUserStats(int user_id, size_t k) override;
+
+private:
+	MemoryStore* store;
+};
@@ -1,75 +1,123 @@
 #include "PlayHistoryDAO.h"
+#include <algorithm>
 #include <vector>
 #include <spdlog/spdlog.h>
 #include <jdbc/cppconn/exception.h>
 #include <jdbc/cppconn/prepared_statement.h>
 #include <jdbc/cppconn/resultset.h>
 #include "DBManager.h"
+#include "DeletionJobs.h"
+#include "HistoryPartitions.h"
+#include "SongPool.h"
+#include "../utils/PerfCounters.h"
 
 constexpr const char* TAG = "[PlayHistoryDAO]";
 
-PlayHistoryDAO::PlayHistoryDAO() : db_manager{DBManager::getInstance()} {}
+// 列序与 buildFromResultSet 一致; 每行一次播放, 次数取自汇总表
+// 走 (user_id, played_at) 索引, 只访问最近的分区
+const std::string SELECT_HISTORY =
+	std::string("SELECT h.id, h.user_id, COALESCE(st.play_count, 0), "
+				"UNIX_TIMESTAMP(h.played_at), ") +
+	SongPool::COLUMNS +
+	" FROM play_history h JOIN songs s ON s.id = h.song_ref "
+	"LEFT JOIN user_song_stats st ON st.user_id = h.user_id AND st.song_ref = h.song_ref "
+	"WHERE h.user_id = ? AND " +
+	DeletionJobs::HISTORY_VISIBLE + " AND " + HistoryPartitions::NOT_COMPACTED +
+	" ORDER BY h.played_at DESC LIMIT ? OFFSET ?";
+
+// 统计类查询只依赖 getUserStats, 各后端相同
+int PlayHistoryDAO::getUserTotalPlayCount(int user_id) {
+	auto stats = getUserStats(user_id, 0);
+	return stats ? static_cast<int>(stats->total_plays) : 0;
+}
 
-bool PlayHistoryDAO::addPlayHistory(const PlayHistory& history) {
-	try {
-		SqlConnGuard guard(db_manager->getConnection());
+std::vector<std::pair<std::string, int>> PlayHistoryDAO::getUserTopArtists(int user_id, int limit) {
+	std::vector<std::pair<std::string, int>> artists;
 
-		// 1.查询是否 已存在
-		PreStmtPtr pstmt(guard->prepareStatement(
-			"SELECT id, song_count FROM play_history WHERE user_id = ? AND song_id = ?"));
-		pstmt->setInt(1, history.user_id);
-		pstmt->setString(2, history.song_id);
+	auto stats = getUserStats(user_id, static_cast<size_t>(std::max(limit, 0)));
+	if (!stats) return artists;
 
-		ResultSetPtr check_result(pstmt->executeQuery());
-		if (check_result->next()) {
-			int song_count = check_result->getInt("song_count");
-			int id = check_result->getInt("id");
+	artists.reserve(stats->top_artists.size());
+	for (auto& item : stats->top_artists) {
+		artists.emplace_back(std::move(item.singer), item.count);
+	}
+	return artists;
+}
 
-			// 更新播放次数
-			pstmt.reset(
-				guard->prepareStatement("UPDATE play_history SET song_count = ? WHERE id = ?"));
-			pstmt->setInt(1, song_count + 1);
-			pstmt->setInt(2, id);
+std::vector<Song> PlayHistoryDAO::getUserTopSongs(int user_id, int limit) {
+	std::vector<Song> songs;
 
-			return pstmt->executeUpdate() > 0;
-		}
+	auto stats = getUserStats(user_id, static_cast<size_t>(std::max(limit, 0)));
+	if (!stats) return songs;
 
-		// 插入新的播放记录
-		pstmt.reset(guard->prepareStatement(
-			"INSERT INTO play_history (user_id, song_id, song_name, song_singer, song_pic, "
-			"song_where, played_at) VALUES (?, ?, ?, ?, ?, ?)"));
-		pstmt->setInt(1, history.user_id);
-		pstmt->setString(2, history.song_id);
-		pstmt->setString(3, history.song_name);
-		pstmt->setString(4, history.song_singer);
-		if (!history.song_pic.empty())
-			pstmt->setString(5, history.song_pic);
-		else
-			pstmt->setNull(5, sql::DataType::VARCHAR);
-		pstmt->setString(6, history.song_where);
-
-		return pstmt->executeUpdate() > 0;
+	songs.reserve(stats->top_songs.size());
+	for (auto& item : stats->top_songs) {
+		Song song;
+		song.meta = std::move(item.song);
+		songs.push_back(std::move(song));
+	}
+	return songs;
+}
+
+std::vector<std::pair<PlayHistory, int>> PlayHistoryDAO::getMostPlayedSongs(int user_id,
+																			int limit) {
+	std::vector<std::pair<PlayHistory, int>> songs;
+
+	auto stats = getUserStats(user_id, static_cast<size_t>(std::max(limit, 0)));
+	if (!stats) return songs;
+
+	songs.reserve(stats->top_songs.size());
+	for (auto& item : stats->top_songs) {
+		PlayHistory history;
+		history.user_id = user_id;
+		history.song = std::move(item.song);
+		history.song_count = item.count;
+		songs.emplace_back(std::move(history), item.count);
+	}
+	return songs;
+}
+
+MySqlPlayHistoryDAO::MySqlPlayHistoryDAO()
+	: db_manager{DBManager::getInstance()}, stats_engine{StatsEngine::getInstance()} {}
+
+bool MySqlPlayHistoryDAO::addPlayHistory(const PlayHistory& history) {
+	// 同一用户的播放事件与统计加载串行
+	auto user_lock = stats_engine->lockUser(history.user_id);
+	try {
+		SqlConnGuard guard(db_manager->getConnection());
+		SqlTransaction tx(guard);
+
+		SongMetaPtr song = SongPool::getInstance()->resolve(guard, *history.song);
+		if (!song) return false;
+
+		// 播放历史与汇总表在一次 CALL 中更新
+		auto counts = StatsEngine::recordPlay(guard, history.user_id, *song);
+		tx.commit();
+
+		stats_engine->applyPlay(history.user_id, song, counts);
+		return true;
 	} catch (sql::SQLException& e) {
 		spdlog::error("{} Add play history failed: {}, Code: {}", TAG, e.what(), e.getErrorCode());
 		return false;
 	}
 }
 
-std::vector<PlayHistory> PlayHistoryDAO::getUserPlayHistory(int user_id, int limit, int offset) {
+std::vector<PlayHistory> MySqlPlayHistoryDAO::getUserPlayHistory(int user_id, int limit,
+																 int offset) {
 	std::vector<PlayHistory> history_list;
 	try {
 		SqlConnGuard guard(db_manager->getConnection());
-		PreStmtPtr pstmt(guard->prepareStatement(
-			"SELECT * FROM play_history WHERE user_id = ? ORDER BY played_at DESC LIMIT ? OFFSET "
-			"?"));
+		PreStmtPtr pstmt(guard.prepareStatement(SELECT_HISTORY));
 
 		pstmt->setInt(1, user_id);
-		pstmt->setInt(2, limit);
-		pstmt->setInt(3, offset);
+		pstmt->setInt(2, user_id);
+		pstmt->setInt(3, limit);
+		pstmt->setInt(4, offset);
 
 		ResultSetPtr result(pstmt->executeQuery());
 		history_list.reserve(limit);
 
+		PERF_SCOPE("db.map_rows");
 		while (result->next()) {
 			history_list.emplace_back(buildFromResultSet(result));
 		}
@@ -82,68 +130,110 @@ std::vector<PlayHistory> PlayHistoryDAO::getUserPlayHistory(int user_id, int lim
 	}
 }
 
-bool PlayHistoryDAO::clearUserPlayHistory(int user_id) {
+std::optional<int> MySqlPlayHistoryDAO::clearUserPlayHistory(int user_id) {
+	auto user_lock = stats_engine->lockUser(user_id);
 	try {
 		SqlConnGuard guard(db_manager->getConnection());
-		PreStmtPtr pstmt(guard->prepareStatement("DELETE FROM play_history WHERE user_id = ?"));
-		pstmt->setInt(1, user_id);
-		int affected_rows = pstmt->executeUpdate();
-
-		return affected_rows > 0;
+		SqlTransaction tx(guard);
+
+		// 只移动水位线并登记任务, 播放历史由后台分批删除
+		const int64_t cutoff_id = DeletionJobs::hideHistory(guard, user_id);
+		StatsEngine::clearSummary(guard, user_id);
+		const int job_id =
+			DeletionJobs::enqueue(guard, DeletionJobs::Kind::History, user_id, cutoff_id);
+
+		tx.commit();
+		stats_engine->invalidate(user_id);
+		DeletionJobs::getInstance()->notify();
+		return job_id;
 	} catch (sql::SQLException& e) {
 		spdlog::error("{} Clear user play history failed: {}, Code: {}", TAG, e.what(),
 					  e.getErrorCode());
-		return false;
+		return std::nullopt;
 	}
 }
 
-bool PlayHistoryDAO::deletePlayHistory(int history_id, int user_id) {
+bool MySqlPlayHistoryDAO::deletePlayHistory(int64_t history_id, int user_id) {
+	auto user_lock = stats_engine->lockUser(user_id);
 	try {
 		SqlConnGuard guard(db_manager->getConnection());
-		PreStmtPtr pstmt(
-			guard->prepareStatement("DELETE FROM play_history WHERE id = ? AND user_id = ?"));
-		pstmt->setInt(1, history_id);
+		SqlTransaction tx(guard);
+
+		// 先取出被删记录, 从汇总表中扣除这一次播放; 已汇总日期的明细不可单条删除
+		PreStmtPtr pstmt(guard.prepareStatement(
+			std::string("SELECT h.song_ref, s.song_singer FROM play_history h "
+						"JOIN songs s ON s.id = h.song_ref WHERE h.id = ? AND h.user_id = ? AND ") +
+			DeletionJobs::HISTORY_VISIBLE + " AND " + HistoryPartitions::NOT_COMPACTED +
+			" FOR UPDATE"));
+		pstmt->setInt64(1, history_id);
+		pstmt->setInt(2, user_id);
+		pstmt->setInt(3, user_id);
+		ResultSetPtr result(pstmt->executeQuery());
+		if (!result->next()) return false;
+
+		const int song_ref = result->getInt("song_ref");
+		const std::string song_singer = result->getString("song_singer");
+
+		pstmt.reset(
+			guard.prepareStatement("DELETE FROM play_history WHERE id = ? AND user_id = ?"));
+		pstmt->setInt64(1, history_id);
 		pstmt->setInt(2, user_id);
 		int affected_rows = pstmt->executeUpdate();
 
-		return affected_rows > 0;
-	} catch (sql::SQLException& e) {
-		spdlog::error("{} Delete play history failed: {}, Code: {}", TAG, e.what(),
-					  e.getErrorCode());
-		return false;
-	}
-}
+		pstmt.reset(guard.prepareStatement(
+			"UPDATE user_song_stats SET play_count = GREATEST(play_count - 1, 0) "
+			"WHERE user_id = ? AND song_ref = ?"));
+		pstmt->setInt(1, user_id);
+		pstmt->setInt(2, song_ref);
+		pstmt->executeUpdate();
 
-int PlayHistoryDAO::getUserTotalPlayCount(int user_id) {
-	try {
-		SqlConnGuard guard(db_manager->getConnection());
-		PreStmtPtr pstmt(guard->prepareStatement(
-			"SELECT COUNT(*) AS count FROM play_history WHERE user_id = ?"));
+		pstmt.reset(guard.prepareStatement(
+			"UPDATE user_artist_stats SET play_count = GREATEST(play_count - 1, 0) "
+			"WHERE user_id = ? AND song_singer = ?"));
+		pstmt->setInt(1, user_id);
+		pstmt->setString(2, song_singer);
+		pstmt->executeUpdate();
 
+		// 减到 0 的行删除, 与由明细重算的结果一致, 也不会出现在 top-K 中
+		pstmt.reset(guard.prepareStatement(
+			"DELETE FROM user_song_stats WHERE user_id = ? AND song_ref = ? AND play_count = 0"));
 		pstmt->setInt(1, user_id);
-		ResultSetPtr result(pstmt->executeQuery());
+		pstmt->setInt(2, song_ref);
+		pstmt->executeUpdate();
 
-		if (result->next()) {
-			return result->getInt("count");
-		}
+		pstmt.reset(guard.prepareStatement(
+			"DELETE FROM user_artist_stats "
+			"WHERE user_id = ? AND song_singer = ? AND play_count = 0"));
+		pstmt->setInt(1, user_id);
+		pstmt->setString(2, song_singer);
+		pstmt->executeUpdate();
 
-		return 0;
+		pstmt.reset(guard.prepareStatement(
+			"UPDATE user_play_stats SET total_plays = GREATEST(total_plays - 1, 0) "
+			"WHERE user_id = ?"));
+		pstmt->setInt(1, user_id);
+		pstmt->executeUpdate();
+
+		tx.commit();
+		stats_engine->invalidate(user_id);
+		return affected_rows > 0;
 	} catch (sql::SQLException& e) {
-		spdlog::error("{} Get user total play count failed: {}, Code: {}", TAG, e.what(),
+		spdlog::error("{} Delete play history failed: {}, Code: {}", TAG, e.what(),
 					  e.getErrorCode());
-		return 0;
+		return false;
 	}
 }
 
-int PlayHistoryDAO::getUserRecentPlayCount(int user_id, int days) {
+int MySqlPlayHistoryDAO::getUserRecentPlayCount(int user_id, int days) {
 	try {
 		SqlConnGuard guard(db_manager->getConnection());
-		PreStmtPtr pstmt(guard->prepareStatement(
-			"SELECT COUNT(*) AS count FROM play_history WHERE user_id = ? AND played_at >= NOW() - "
-			"INTERVAL ? DAY"));
+		PreStmtPtr pstmt(guard.prepareStatement(
+			std::string("SELECT COUNT(*) AS count FROM play_history h WHERE h.user_id = ? AND ") +
+			DeletionJobs::HISTORY_VISIBLE + " AND h.played_at >= NOW() - INTERVAL ? DAY"));
 
 		pstmt->setInt(1, user_id);
-		pstmt->setInt(2, days);
+		pstmt->setInt(2, user_id);
+		pstmt->setInt(3, days);
 		ResultSetPtr result(pstmt->executeQuery());
 
 		if (result->next()) {
@@ -158,105 +248,21 @@ int PlayHistoryDAO::getUserRecentPlayCount(int user_id, int days) {
 	}
 }
 
-std::vector<std::pair<std::string, int>> PlayHistoryDAO::getUserTopArtists(int user_id, int limit) {
-	std::vector<std::pair<std::string, int>> artists;
-
-	try {
-		SqlConnGuard guard(db_manager->getConnection());
-		PreStmtPtr pstmt(guard->prepareStatement(
-			"SELECT song_singer, SUM(song_count) AS total_plays FROM play_history WHERE user_id = "
-			"? GROUP BY song_singer ORDER BY total_plays DESC LIMIT ?"));
-
-		pstmt->setInt(1, user_id);
-		pstmt->setInt(2, limit);
-		ResultSetPtr result(pstmt->executeQuery());
-
-		while (result->next()) {
-			std::string artist = result->getString("song_singer");
-			int play_count = result->getInt("total_plays");
-			artists.emplace_back(artist, play_count);
-		}
-
-		return artists;
-	} catch (sql::SQLException& e) {
-		spdlog::error("{} Get user top artists failed: {}, Code: {}", TAG, e.what(),
-					  e.getErrorCode());
-		return {};
-	}
-}
-
-std::vector<Song> PlayHistoryDAO::getUserTopSongs(int user_id, int limit) {
-	std::vector<Song> songs;
-
-	try {
-		SqlConnGuard guard(db_manager->getConnection());
-		PreStmtPtr pstmt(guard->prepareStatement(
-			"SELECT * FROM play_history WHERE user_id = ? ORDER BY song_count DESC LIMIT ?"));
-
-		pstmt->setInt(1, user_id);
-		pstmt->setInt(2, limit);
-		ResultSetPtr result(pstmt->executeQuery());
-
-		while (result->next()) {
-			songs.emplace_back(buildSongFromResultSet(result));
-		}
-
-		return songs;
-	} catch (sql::SQLException& e) {
-		spdlog::error("{} Get user top songs failed: {}, Code: {}", TAG, e.what(),
-					  e.getErrorCode());
-		return {};
-	}
+std::optional<StatsEngine::UserStats> MySqlPlayHistoryDAO::getUserStats(int user_id, size_t k) {
+	return stats_engine->getUserStats(user_id, k);
 }
 
-std::vector<std::pair<PlayHistory, int>> PlayHistoryDAO::getMostPlayedSongs(int user_id,
-																			int limit) {
-	std::vector<std::pair<PlayHistory, int>> songs;
-
-	try {
-		SqlConnGuard guard(db_manager->getConnection());
-		PreStmtPtr pstmt(guard->prepareStatement(
-			"SELECT * FROM play_history WHERE user_id = ? ORDER BY song_count DESC LIMIT ?"));
-		pstmt->setInt(1, user_id);
-		pstmt->setInt(2, limit);
-
-		ResultSetPtr result(pstmt->executeQuery());
-		while (result->next()) {
-			PlayHistory history = buildFromResultSet(result);
-			int play_count = result->getInt("song_count");
-			songs.emplace_back(history, play_count);
-		}
-
-		return songs;
-	} catch (sql::SQLException& e) {
-		spdlog::error("{} Get most played songs failed: {}, Code: {}", TAG, e.what(),
-					  e.getErrorCode());
-		return {};
-	}
+std::optional<DeletionJobs::Job> MySqlPlayHistoryDAO::getClearJob(int job_id, int user_id) {
+	return DeletionJobs::getJob(job_id, user_id);
 }
 
-PlayHistory PlayHistoryDAO::buildFromResultSet(const ResultSetPtr& result) {
+PlayHistory MySqlPlayHistoryDAO::buildFromResultSet(const ResultSetPtr& result) {
 	PlayHistory history;
-	history.id = result->getInt("id");
-	history.user_id = result->getInt("user_id");
-	history.song_id = result->getString("song_id");
-	history.song_name = result->getString("song_name");
-	history.song_singer = result->getString("song_singer");
-	if (!result->isNull("song_pic")) history.song_pic = result->getString("song_pic");
-	history.song_where = result->getString("song_where");
-	history.song_count = result->getInt("song_count");
-	history.played_at = result->getString("played_at");
+	history.id = result->getInt64(1);
+	history.user_id = result->getInt(2);
+	history.song_count = result->getInt(3);
+	history.played_at = result->getInt64(4);
+	history.song = SongPool::getInstance()->fromResultSet(result, 5);
 
 	return history;
 }
-
-Song PlayHistoryDAO::buildSongFromResultSet(const ResultSetPtr& result) {
-	Song song;
-	song.song_id = result->getString("song_id");
-	song.name = result->getString("song_name");
-	song.singer = result->getString("song_singer");
-	if (!result->isNull("song_pic")) song.pic = result->getString("song_pic");
-	song.where = result->getString("song_where");
-
-	return song;
-}
@@ -1,62 +1,81 @@
 #pragma once
 
+#include <cstdint>
+#include <optional>
 #include <string>
+#include <utility>
 #include <vector>
 #include "DBManager.h"
+#include "DeletionJobs.h"
+#include "StatsEngine.h"
 #include "../models/playhistory.h"
 #include "../models/song.h"
 
 /**
- * @brief 播放历史数据访问对象
+ * @brief 播放历史数据访问接口, 实现由 Storage 按配置的后端创建
+ *
+ * 统计类查询 (总次数, 最常听的歌曲/歌手) 都由 getUserStats 得出.
  */
 class PlayHistoryDAO {
 public:
-	PlayHistoryDAO();
+	virtual ~PlayHistoryDAO() = default;
 
 	/**
 	 * @brief 添加播放记录
 	 * @param history 播放历史对象
 	 * @return 是否添加成功
 	 */
-	bool addPlayHistory(const PlayHistory& history);
+	virtual bool addPlayHistory(const PlayHistory& history) = 0;
 
 	/**
-	 * @brief 获取用户的播放历史
+	 * @brief 获取用户最近的播放记录, 按播放时间倒序
 	 * @param user_id 用户ID
 	 * @param limit 限制返回数量
 	 * @param offset 偏移量(分页用)
 	 * @return 播放历史记录列表
 	 */
-	std::vector<PlayHistory> getUserPlayHistory(int user_id, int limit = 50, int offset = 0);
+	virtual std::vector<PlayHistory> getUserPlayHistory(int user_id, int limit = 50,
+														int offset = 0) = 0;
 
 	/**
-	 * @brief 清空用户播放历史
+	 * @brief 清空用户播放历史, 记录立即不可见
 	 * @param user_id 用户ID
-	 * @return 是否清空成功
+	 * @return 删除任务ID, 失败返回 nullopt
 	 */
-	bool clearUserPlayHistory(int user_id);
+	virtual std::optional<int> clearUserPlayHistory(int user_id) = 0;
 
 	/**
-	 * @brief 删除特定播放记录
+	 * @brief 清空任务的进度, 只能查询自己的任务
+	 */
+	virtual std::optional<DeletionJobs::Job> getClearJob(int job_id, int user_id) = 0;
+
+	/**
+	 * @brief 删除特定播放记录(一次播放)
 	 * @param history_id 历史记录ID
 	 * @param user_id 用户ID(用于验证权限)
 	 * @return 是否删除成功
 	 */
-	bool deletePlayHistory(int history_id, int user_id);
+	virtual bool deletePlayHistory(int64_t history_id, int user_id) = 0;
 
 	/**
-	 * @brief 获取用户播放历史数目
+	 * @brief 获取用户最近几天的播放次数
 	 * @param user_id 用户ID
-	 * @return 播放总次数
+	 * @return 最近 days 天播放次数
 	 */
-	int getUserTotalPlayCount(int user_id);
+	virtual int getUserRecentPlayCount(int user_id, int days = 7) = 0;
 
 	/**
-	 * @brief 获取用户最近一周的播放次数
+	 * @brief 用户统计, 返回前 k 项 (k 不超过 StatsEngine::TOP_K_MAX), 按次数降序
+	 * @return 查询失败返回 nullopt
+	 */
+	virtual std::optional<StatsEngine::UserStats> getUserStats(int user_id, size_t k) = 0;
+
+	/**
+	 * @brief 获取用户总播放次数
 	 * @param user_id 用户ID
-	 * @return 最近一周播放次数
+	 * @return 播放总次数
 	 */
-	int getUserRecentPlayCount(int user_id, int days = 7);
+	int getUserTotalPlayCount(int user_id);
 
 	/**
 	 * @brief 获取用户最常听的歌手
@@ -81,21 +100,35 @@ public:
 	 * @return 歌曲和播放次数列表
 	 */
 	std::vector<std::pair<PlayHistory, int>> getMostPlayedSongs(int user_id, int limit = 10);
+};
 
-private:
-	DBManager* db_manager;
+/**
+ * @brief MySQL 实现
+ *
+ * 写入历史时在同一事务中更新统计汇总表; 统计由 StatsEngine 提供, 不扫描 play_history.
+ * 明细只保留保留期内的, 更早的只计入统计; 清空历史只移动水位线, 由 DeletionJobs 分批删除.
+ */
+class MySqlPlayHistoryDAO : public PlayHistoryDAO {
+public:
+	MySqlPlayHistoryDAO();
+
+	bool addPlayHistory(const PlayHistory& history) override;
+	std::vector<PlayHistory> getUserPlayHistory(int user_id, int limit = 50,
+												int offset = 0) override;
+	std::optional<int> clearUserPlayHistory(int user_id) override;
+	std::optional<DeletionJobs::Job> getClearJob(int job_id, int user_id) override;
+	bool deletePlayHistory(int64_t history_id, int user_id) override;
+	int getUserRecentPlayCount(int user_id, int days = 7) override;
+	std::optional<StatsEngine::UserStats> getUserStats(int user_id, size_t k) override;
 
 	/**
-	 * @brief 从ResultSet构建PlayHistory对象
+	 * @brief 从ResultSet构建PlayHistory对象 (列序见 SELECT_HISTORY), 不访问数据库
 	 * @param result 结果集
 	 * @return PlayHistory对象
 	 */
 	static PlayHistory buildFromResultSet(const ResultSetPtr& result);
 
-	/**
-	 * @brief 从ResultSet构建Song对象
-	 * @param result 结果集
-	 * @return Song对象
-	 */
-	static Song buildSongFromResultSet(const ResultSetPtr& result);
-};
\ No newline at end of file
+private:
+	DBManager* db_manager;
+	StatsEngine* stats_engine;
+};
@@ -0,0 +1,119 @@
+#include "PlaylistCache.h"
+
+#include <chrono>
+#include <stdexcept>
+#include <utility>
+
+std::unique_ptr<PlaylistCache> PlaylistCache::m_instance = nullptr;
+
+PlaylistCache::PlaylistCache(size_t capacity)
+	: m_capacity(capacity > 0 ? capacity : 1),
+	  m_epoch(std::chrono::duration_cast<std::chrono::seconds>(
+				  std::chrono::system_clock::now().time_since_epoch())
+				  .count()),
+	  m_hits(MetricsRegistry::getInstance()->counter("playlist_cache_hits_total",
+													 "Playlist contents served from memory")),
+	  m_misses(MetricsRegistry::getInstance()->counter("playlist_cache_misses_total",
+													   "Playlist content lookups not in memory")),
+	  m_evictions(MetricsRegistry::getInstance()->counter("playlist_cache_evictions_total",
+														  "Playlists evicted from the cache")),
+	  m_entries_gauge(MetricsRegistry::getInstance()->gauge("playlist_cache_entries",
+															"Playlists tracked by the cache")) {}
+
+void PlaylistCache::init(size_t capacity) {
+	if (!m_instance) {
+		m_instance.reset(new PlaylistCache(capacity));
+	}
+}
+
+PlaylistCache* PlaylistCache::getInstance() {
+	if (!m_instance) {
+		throw std::runtime_error("PlaylistCache not initialized");
+	}
+
+	return m_instance.get();
+}
+
+std::optional<PlaylistCache::Snapshot> PlaylistCache::get(int playlist_id) {
+	std::lock_guard<std::mutex> lock(m_mtx);
+	auto it = m_entries.find(playlist_id);
+	if (it == m_entries.end() || !it->second->playlist) {
+		m_misses.inc();
+		return std::nullopt;
+	}
+
+	m_hits.inc();
+	m_lru.splice(m_lru.begin(), m_lru, it->second);
+	const Entry& entry = *it->second;
+	return Snapshot{entry.version, entry.playlist, entry.songs};
+}
+
+uint64_t PlaylistCache::version(int playlist_id) {
+	std::lock_guard<std::mutex> lock(m_mtx);
+	return touch(playlist_id)->version;
+}
+
+void PlaylistCache::put(int playlist_id, const Snapshot& snapshot) {
+	std::lock_guard<std::mutex> lock(m_mtx);
+	auto it = m_entries.find(playlist_id);
+	if (it == m_entries.end() || it->second->version != snapshot.version) return;
+
+	it->second->playlist = snapshot.playlist;
+	it->second->songs = snapshot.songs;
+}
+
+void PlaylistCache::bump(int playlist_id) {
+	std::lock_guard<std::mutex> lock(m_mtx);
+	auto it = m_entries.find(playlist_id);
+	if (it == m_entries.end()) return; // 下次读取自然分配新版本
+
+	Entry& entry = *it->second;
+	entry.version = ++m_next_version;
+	entry.playlist.reset();
+	entry.songs.reset();
+}
+
+void PlaylistCache::erase(int playlist_id) {
+	std::lock_guard<std::mutex> lock(m_mtx);
+	auto it = m_entries.find(playlist_id);
+	if (it == m_entries.end()) return;
+
+	m_lru.erase(it->second);
+	m_entries.erase(it);
+	m_entries_gauge.set(static_cast<int64_t>(m_entries.size()));
+}
+
+std::string PlaylistCache::etag(uint64_t version) const {
+	return "\"" + std::to_string(m_epoch) + "-" + std::to_string(version) + "\"";
+}
+
+PlaylistCache::Stats PlaylistCache::stats() const {
+	Stats stats;
+	stats.hits = m_hits.value();
+	stats.misses = m_misses.value();
+	stats.evictions = m_evictions.value();
+
+	std::lock_guard<std::mutex> lock(m_mtx);
+	stats.entries = m_entries.size();
+	return stats;
+}
+
+PlaylistCache::EntryList::iterator PlaylistCache::touch(int playlist_id) {
+	auto it = m_entries.find(playlist_id);
+	if (it != m_entries.end()) {
+		m_lru.splice(m_lru.begin(), m_lru, it->second);
+		return it->second;
+	}
+
+	m_lru.push_front(Entry{playlist_id, ++m_next_version, nullptr, nullptr});
+	m_entries.emplace(playlist_id, m_lru.begin());
+
+	while (m_entries.size() > m_capacity) {
+		m_entries.erase(m_lru.back().playlist_id);
+		m_lru.pop_back();
+		m_evictions.inc();
+	}
+	m_entries_gauge.set(static_cast<int64_t>(m_entries.size()));
+
+	return m_lru.begin();
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../models/playlist.h"
+#include "../models/song.h"
+#include "../utils/Metrics.h"
+
+/**
+ * @brief 歌单内容缓存 单例
+ *
+ * 每个歌单有一个版本号, 歌单或其歌曲变更时改为全局递增计数器的新值, 因此版本号在进程内
+ * 不会重复, 条目被淘汰后重新分配也不会与客户端持有的旧版本相同. 版本号作为 ETag,
+ * 客户端重验证时只需比较内存中的版本. 命中/未命中/淘汰与条目数导出到 /metrics
+ * (playlist_cache_*).
+ */
+class PlaylistCache {
+public:
+	struct Snapshot {
+		uint64_t version = 0;
+		std::shared_ptr<const Playlist> playlist;
+		std::shared_ptr<const std::vector<Song>> songs;
+	};
+
+	struct Stats {
+		uint64_t hits = 0;
+		uint64_t misses = 0;
+		uint64_t evictions = 0;
+		uint64_t entries = 0;
+	};
+
+	static void init(size_t capacity);
+	static PlaylistCache* getInstance();
+
+	// 已缓存的歌单内容
+	std::optional<Snapshot> get(int playlist_id);
+
+	/**
+	 * @brief 当前版本号, 未缓存时分配新版本; 查库前调用, 回填时用于检测并发修改
+	 */
+	uint64_t version(int playlist_id);
+
+	// 回填查库结果, 期间版本已变化则丢弃
+	void put(int playlist_id, const Snapshot& snapshot);
+
+	// 歌单内容变更, 分配新版本并丢弃缓存内容
+	void bump(int playlist_id);
+
+	// 歌单已删除
+	void erase(int playlist_id);
+
+	// 版本号对应的强 ETag, 含进程启动时间以区分重启前后的版本
+	std::string etag(uint64_t version) const;
+
+	Stats stats() const;
+
+	~PlaylistCache() = default;
+	PlaylistCache(const PlaylistCache&) = delete;
+	PlaylistCache(PlaylistCache&&) = delete;
+	PlaylistCache& operator=(const PlaylistCache&) = delete;
+	PlaylistCache& operator=(PlaylistCache&&) = delete;
+
+private:
+	explicit PlaylistCache(size_t capacity);
+
+	struct Entry {
+		int playlist_id;
+		uint64_t version;
+		std::shared_ptr<const Playlist> playlist; // 为空表示内容未加载
+		std::shared_ptr<const std::vector<Song>> songs;
+	};
+
+	using EntryList = std::list<Entry>;
+
+	// 调用方持有 m_mtx
+	EntryList::iterator touch(int playlist_id);
+
+private:
+	// 链表头部为最近使用
+	EntryList m_lru;
+	std::unordered_map<int, EntryList::iterator> m_entries;
+	size_t m_capacity;
+	mutable std::mutex m_mtx;
+
+	uint64_t m_next_version = 0;
+	const int64_t m_epoch;
+
+	MetricCounter& m_hits;
+	MetricCounter& m_misses;
+	MetricCounter& m_evictions;
+	MetricGauge& m_entries_gauge;
+
+	static std::unique_ptr<PlaylistCache> m_instance;
+};
@@ -1,44 +1,61 @@
 #include "PlaylistDAO.h"
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
 #include <jdbc/cppconn/exception.h>
 #include <jdbc/cppconn/prepared_statement.h>
 #include <spdlog/spdlog.h>
 #include "DBManager.h"
+#include "SongPool.h"
+#include "../utils/PerfCounters.h"
 
 constexpr const char* TAG = "[PlaylistDAO]";
 
-PlaylistDAO::PlaylistDAO() : db_manager{DBManager::getInstance()} {}
-
-bool PlaylistDAO::createPlaylist(Playlist& playlist) {
+// 列序与 buildPlaylistFromResultSet 一致; 已注销用户的歌单在后台删除前不可见
+constexpr const char* SELECT_PLAYLISTS =
+	"SELECT p.id, p.user_id, p.name, p.cover, UNIX_TIMESTAMP(p.create_at), "
+	"UNIX_TIMESTAMP(p.update_at) FROM playlists p JOIN users u ON u.id = p.user_id "
+	"WHERE u.deleted_at IS NULL ";
+const std::string SELECT_PLAYLIST_BY_ID = std::string(SELECT_PLAYLISTS) + "AND p.id = ?";
+const std::string SELECT_PLAYLISTS_BY_USER =
+	std::string(SELECT_PLAYLISTS) + "AND p.user_id = ? ORDER BY p.id";
+
+// 歌单歌曲, 元数据取自 songs 维表; 列序与 buildSongFromResultSet 一致
+const std::string SELECT_SONGS = std::string("SELECT ps.id, UNIX_TIMESTAMP(ps.added_at), ") +
+								 SongPool::COLUMNS +
+								 " FROM playlist_songs ps JOIN songs s ON s.id = ps.song_ref "
+								 "WHERE ps.playlist_id = ? ORDER BY ps.id";
+
+MySqlPlaylistDAO::MySqlPlaylistDAO()
+	: db_manager{DBManager::getInstance()}, playlist_cache{PlaylistCache::getInstance()} {}
+
+DAOStatus MySqlPlaylistDAO::createPlaylist(Playlist& playlist) {
 	try {
 		SqlConnGuard guard(db_manager->getConnection());
-		PreStmtPtr pstmt(guard->prepareStatement(
-			"INSERT INTO playlists (name, user_id, cover) VALUES (?, ?, ?)"));
-		pstmt->setString(1, playlist.name);
-		pstmt->setInt(2, playlist.user_id);
+		PreStmtPtr pstmt(guard.prepareStatement("CALL create_playlist(?, ?, ?)"));
+		pstmt->setInt(1, playlist.user_id);
+		pstmt->setString(2, playlist.name);
 		if (playlist.cover.empty())
 			pstmt->setNull(3, sql::DataType::VARCHAR);
 		else
 			pstmt->setString(3, playlist.cover);
 
-		pstmt->executeUpdate();
-
-		ResultSetPtr result(pstmt->executeQuery("SELECT LAST_INSERT_ID() AS id"));
-		if (result->next()) {
-			playlist.id = result->getInt("id");
-			return true;
-		}
+		ResultSetPtr result(pstmt->executeQuery());
+		if (result->next()) playlist.id = result->getInt(1);
+		result.reset();
+		finishCall(pstmt);
 
-		return false;
+		return playlist.id > 0 ? DAOStatus::Ok : DAOStatus::Error;
 	} catch (sql::SQLException& e) {
 		spdlog::error("{} Create playlist failed: {}, Code: {}", TAG, e.what(), e.getErrorCode());
-		return false;
+		return toDAOStatus(e);
 	}
 }
 
-std::optional<Playlist> PlaylistDAO::getPlaylistById(int playlist_id) {
+std::optional<Playlist> MySqlPlaylistDAO::getPlaylistById(int playlist_id) {
 	try {
 		SqlConnGuard guard(db_manager->getConnection());
-		PreStmtPtr pstmt(guard->prepareStatement("SELECT * FROM playlists WHERE id = ?"));
+		PreStmtPtr pstmt(guard.prepareStatement(SELECT_PLAYLIST_BY_ID));
 		pstmt->setInt(1, playlist_id);
 
 		ResultSetPtr result(pstmt->executeQuery());
@@ -54,16 +71,17 @@ std::optional<Playlist> PlaylistDAO::getPlaylistById(int playlist_id) {
 	}
 }
 
-std::vector<Playlist> PlaylistDAO::getPlaylistsByUserId(int user_id) {
+std::vector<Playlist> MySqlPlaylistDAO::getPlaylistsByUserId(int user_id) {
 	try {
 		SqlConnGuard guard(db_manager->getConnection());
-		PreStmtPtr pstmt(guard->prepareStatement("SELECT * FROM playlists WHERE user_id = ?"));
+		PreStmtPtr pstmt(guard.prepareStatement(SELECT_PLAYLISTS_BY_USER));
 		pstmt->setInt(1, user_id);
 
 		ResultSetPtr result(pstmt->executeQuery());
 		std::vector<Playlist> playlists;
 		playlists.reserve(result->rowsCount());
 
+		PERF_SCOPE("db.map_rows");
 		while (result->next()) {
 			playlists.emplace_back(buildPlaylistFromResultSet(result));
 		}
@@ -76,11 +94,11 @@ std::vector<Playlist> PlaylistDAO::getPlaylistsByUserId(int user_id) {
 	}
 }
 
-bool PlaylistDAO::updatePlaylist(const Playlist& playlist) {
+bool MySqlPlaylistDAO::updatePlaylist(const Playlist& playlist) {
 	try {
 		SqlConnGuard guard(db_manager->getConnection());
 		PreStmtPtr pstmt(
-			guard->prepareStatement("UPDATE playlists SET name = ?, cover = ? WHERE id = ?"));
+			guard.prepareStatement("UPDATE playlists SET name = ?, cover = ? WHERE id = ?"));
 		pstmt->setString(1, playlist.name);
 
 		if (playlist.cover.empty())
@@ -91,6 +109,7 @@ bool PlaylistDAO::updatePlaylist(const Playlist& playlist) {
 		pstmt->setInt(3, playlist.id);
 		int affected_row = pstmt->executeUpdate();
 
+		playlist_cache->bump(playlist.id);
 		return affected_row > 0;
 	} catch (sql::SQLException& e) {
 		spdlog::error("{} Update playlist failed: {}, Code: {}", TAG, e.what(), e.getErrorCode());
@@ -98,13 +117,14 @@ bool PlaylistDAO::updatePlaylist(const Playlist& playlist) {
 	}
 }
 
-bool PlaylistDAO::deletePlaylist(int id) {
+bool MySqlPlaylistDAO::deletePlaylist(int id) {
 	try {
 		SqlConnGuard guard(db_manager->getConnection());
-		PreStmtPtr pstmt(guard->prepareStatement("DELETE FROM playlists WHERE id = ?"));
+		PreStmtPtr pstmt(guard.prepareStatement("DELETE FROM playlists WHERE id = ?"));
 		pstmt->setInt(1, id);
 		int affected_row = pstmt->executeUpdate();
 
+		playlist_cache->erase(id);
 		return affected_row > 0;
 	} catch (sql::SQLException& e) {
 		spdlog::error("{} Delete playlist failed: {}, Code: {}", TAG, e.what(), e.getErrorCode());
@@ -112,77 +132,211 @@ bool PlaylistDAO::deletePlaylist(int id) {
 	}
 }
 
-bool PlaylistDAO::addSongToPlaylist(int playlist_id, const Song& song) {
+DAOStatus MySqlPlaylistDAO::addSongToPlaylist(int playlist_id, const Song& song) {
 	try {
 		SqlConnGuard guard(db_manager->getConnection());
-		// 是否已存在
-		PreStmtPtr pstmt(guard->prepareStatement(
-			"SELECT COUNT(*) as count FROM playlist_songs WHERE playlist_id = ? AND song_id = ? "
-			"AND song_where = ?"));
-		pstmt->setInt(1, playlist_id);
-		pstmt->setString(2, song.song_id);
-		pstmt->setString(3, song.where);
-		ResultSetPtr result(pstmt->executeQuery());
-
-		if (result->next() && result->getInt("count") > 0) {
-			return true;
+		SongMetaPtr meta = SongPool::getInstance()->resolve(guard, *song.meta);
+		if (!meta) return DAOStatus::Error;
+
+		// 重复由 UNIQUE(playlist_id, song_ref) 判定; 歌单不存在或所属用户已注销时不插入,
+		// 用户行加共享锁与注销互斥
+		PreStmtPtr pstmt(guard.prepareStatement(
+			"INSERT INTO playlist_songs (playlist_id, song_ref) "
+			"SELECT p.id, ? FROM playlists p JOIN users u ON u.id = p.user_id "
+			"WHERE p.id = ? AND u.deleted_at IS NULL FOR SHARE"));
+		pstmt->setInt(1, meta->ref);
+		pstmt->setInt(2, playlist_id);
+		if (pstmt->executeUpdate() == 0) return DAOStatus::NotFound;
+
+		playlist_cache->bump(playlist_id);
+		return DAOStatus::Ok;
+	} catch (sql::SQLException& e) {
+		DAOStatus status = toDAOStatus(e);
+		if (status != DAOStatus::Conflict) {
+			spdlog::error("{} Add song to playlist failed: {}, Code: {}", TAG, e.what(),
+						  e.getErrorCode());
 		}
+		return status;
+	}
+}
 
-		// 插入
-		pstmt.reset(guard->prepareStatement(
-			"INSERT INTO playlist_songs (playlist_id, song_id, song_name, song_singer, song_pic, "
-			"song_where) VALUES (?, ?, ?, ?, ?, ?)"));
-		pstmt->setInt(1, playlist_id);
-		pstmt->setString(2, song.song_id);
-		pstmt->setString(3, song.name);
-		pstmt->setString(4, song.singer);
-		if (song.pic.empty())
-			pstmt->setNull(5, sql::DataType::VARCHAR);
-		else
-			pstmt->setString(5, song.pic);
-		pstmt->setString(6, song.where);
+bool MySqlPlaylistDAO::removeSongFromPlaylist(int playlist_id, const std::string& song_id,
+											  SongSource song_source) {
+	try {
+		SqlConnGuard guard(db_manager->getConnection());
+		PreStmtPtr pstmt(guard.prepareStatement(
+			"DELETE ps FROM playlist_songs ps JOIN songs s ON s.id = ps.song_ref "
+			"WHERE ps.playlist_id = ? AND s.song_id = ? AND s.song_where = ?"));
 
+		pstmt->setInt(1, playlist_id);
+		pstmt->setString(2, song_id);
+		pstmt->setString(3, toString(song_source));
 		int affected_row = pstmt->executeUpdate();
 
+		if (affected_row > 0) playlist_cache->bump(playlist_id);
 		return affected_row > 0;
 	} catch (sql::SQLException& e) {
-		spdlog::error("{} Add song to playlist failed: {}, Code: {}", TAG, e.what(),
+		spdlog::error("{} Remove song from playlist failed: {}, Code: {}", TAG, e.what(),
 					  e.getErrorCode());
 		return false;
 	}
 }
 
-bool PlaylistDAO::removeSongFromPlaylist(int playlist_id, const std::string& song_id,
-										 std::string& song_source) {
+DAOStatus MySqlPlaylistDAO::addSongsToPlaylist(int playlist_id, const std::vector<Song>& songs,
+											   std::vector<DAOStatus>& results) {
+	results.assign(songs.size(), DAOStatus::Error);
 	try {
 		SqlConnGuard guard(db_manager->getConnection());
-		PreStmtPtr pstmt(
-			guard->prepareStatement("DELETE FROM playlist_songs WHERE playlist_id = ? "
-									"AND song_id = ? && song_where = ?"));
+		SqlTransaction tx(guard);
+		if (!lockPlaylist(guard, playlist_id)) return DAOStatus::NotFound;
+
+		std::unordered_set<int> seen;
+		size_t added = 0;
+		for (size_t begin = 0; begin < songs.size(); begin += BATCH_CHUNK) {
+			const size_t end = std::min(songs.size(), begin + BATCH_CHUNK);
+
+			std::vector<SongMeta> metas;
+			metas.reserve(end - begin);
+			for (size_t i = begin; i < end; ++i) metas.push_back(*songs[i].meta);
+			auto resolved = SongPool::getInstance()->resolveBatch(guard, metas);
+
+			// 本组待插入的 song_ref → 下标, 本批内重复的记为 Conflict
+			std::unordered_map<int, size_t> pending;
+			for (size_t k = 0; k < resolved.size(); ++k) {
+				if (!resolved[k]) return DAOStatus::Error;
+				if (seen.insert(resolved[k]->ref).second)
+					pending.emplace(resolved[k]->ref, begin + k);
+				else
+					results[begin + k] = DAOStatus::Conflict;
+			}
+			if (pending.empty()) continue;
+
+			// 歌单行已加锁, 此处查到的即为已存在的歌曲
+			PreStmtPtr pstmt(guard.prepareStatement(
+				"SELECT song_ref FROM playlist_songs WHERE playlist_id = ? AND song_ref IN " +
+				sqlPlaceholders(1, pending.size())));
+			uint32_t param = 1;
+			pstmt->setInt(param++, playlist_id);
+			for (const auto& [ref, index] : pending) pstmt->setInt(param++, ref);
+			ResultSetPtr result(pstmt->executeQuery());
+			while (result->next()) {
+				auto it = pending.find(result->getInt(1));
+				if (it == pending.end()) continue;
+				results[it->second] = DAOStatus::Conflict;
+				pending.erase(it);
+			}
+			if (pending.empty()) continue;
+
+			pstmt.reset(guard.prepareStatement(
+				"INSERT INTO playlist_songs (playlist_id, song_ref) VALUES " +
+				sqlPlaceholders(pending.size(), 2) +
+				" ON DUPLICATE KEY UPDATE song_ref = VALUES(song_ref)"));
+			param = 1;
+			for (const auto& [ref, index] : pending) {
+				pstmt->setInt(param++, playlist_id);
+				pstmt->setInt(param++, ref);
+				results[index] = DAOStatus::Ok;
+			}
+			pstmt->executeUpdate();
+			added += pending.size();
+		}
 
-		pstmt->setInt(1, playlist_id);
-		pstmt->setString(2, song_id);
-		pstmt->setString(3, song_source);
-		int affected_row = pstmt->executeUpdate();
+		tx.commit();
+		if (added > 0) playlist_cache->bump(playlist_id);
+		return DAOStatus::Ok;
+	} catch (sql::SQLException& e) {
+		spdlog::error("{} Add songs to playlist failed: {}, Code: {}", TAG, e.what(),
+					  e.getErrorCode());
+		return toDAOStatus(e);
+	}
+}
 
-		return affected_row > 0;
+DAOStatus MySqlPlaylistDAO::removeSongsFromPlaylist(
+	int playlist_id, const std::vector<std::pair<std::string, SongSource>>& keys,
+	std::vector<DAOStatus>& results) {
+	results.assign(keys.size(), DAOStatus::NotFound);
+	auto makeKey = [](const std::string& song_id, SongSource where) {
+		return static_cast<char>(where) + song_id;
+	};
+
+	try {
+		SqlConnGuard guard(db_manager->getConnection());
+		SqlTransaction tx(guard);
+		if (!lockPlaylist(guard, playlist_id)) return DAOStatus::NotFound;
+
+		size_t removed = 0;
+		for (size_t begin = 0; begin < keys.size(); begin += BATCH_CHUNK) {
+			const size_t end = std::min(keys.size(), begin + BATCH_CHUNK);
+			const std::string where_clause =
+				" WHERE ps.playlist_id = ? AND (s.song_id, s.song_where) IN (" +
+				sqlPlaceholders(end - begin, 2) + ")";
+			auto bind = [&](const PreStmtPtr& pstmt) {
+				uint32_t param = 1;
+				pstmt->setInt(param++, playlist_id);
+				for (size_t i = begin; i < end; ++i) {
+					pstmt->setString(param++, keys[i].first);
+					pstmt->setString(param++, toString(keys[i].second));
+				}
+			};
+
+			PreStmtPtr pstmt(guard.prepareStatement(
+				"SELECT s.song_id, s.song_where + 0 FROM playlist_songs ps "
+				"JOIN songs s ON s.id = ps.song_ref" +
+				where_clause));
+			bind(pstmt);
+			std::unordered_set<std::string> present;
+			ResultSetPtr result(pstmt->executeQuery());
+			while (result->next()) {
+				present.insert(
+					makeKey(result->getString(1), static_cast<SongSource>(result->getInt(2))));
+			}
+			if (present.empty()) continue;
+
+			pstmt.reset(guard.prepareStatement(
+				"DELETE ps FROM playlist_songs ps JOIN songs s ON s.id = ps.song_ref" +
+				where_clause));
+			bind(pstmt);
+			pstmt->executeUpdate();
+
+			// 本批内重复的只有第一项记为已移除
+			for (size_t i = begin; i < end; ++i) {
+				if (present.erase(makeKey(keys[i].first, keys[i].second)) > 0) {
+					results[i] = DAOStatus::Ok;
+					++removed;
+				}
+			}
+		}
+
+		tx.commit();
+		if (removed > 0) playlist_cache->bump(playlist_id);
+		return DAOStatus::Ok;
 	} catch (sql::SQLException& e) {
-		spdlog::error("{} Remove song from playlist failed: {}, Code: {}", TAG, e.what(),
+		spdlog::error("{} Remove songs from playlist failed: {}, Code: {}", TAG, e.what(),
 					  e.getErrorCode());
-		return false;
+		return toDAOStatus(e);
 	}
 }
 
-std::vector<Song> PlaylistDAO::getSongsInPlaylist(int playlist_id) {
+bool MySqlPlaylistDAO::lockPlaylist(const SqlConnGuard& guard, int playlist_id) {
+	// 所属用户已注销的歌单视为不存在, 用户行加共享锁与注销互斥
+	PreStmtPtr pstmt(guard.prepareStatement(
+		"SELECT p.id FROM playlists p JOIN users u ON u.id = p.user_id "
+		"WHERE p.id = ? AND u.deleted_at IS NULL FOR UPDATE OF p FOR SHARE OF u"));
+	pstmt->setInt(1, playlist_id);
+	ResultSetPtr result(pstmt->executeQuery());
+	return result->next();
+}
+
+std::vector<Song> MySqlPlaylistDAO::getSongsInPlaylist(int playlist_id) {
 	try {
 		SqlConnGuard guard(db_manager->getConnection());
-		PreStmtPtr pstmt(
-			guard->prepareStatement("SELECT * FROM playlist_songs WHERE playlist_id = ?"));
+		PreStmtPtr pstmt(guard.prepareStatement(SELECT_SONGS));
 		pstmt->setInt(1, playlist_id);
 		ResultSetPtr result(pstmt->executeQuery());
 
 		std::vector<Song> songs;
 		songs.reserve(result->rowsCount());
+		PERF_SCOPE("db.map_rows");
 		while (result->next()) {
 			songs.emplace_back(buildSongFromResultSet(result));
 		}
@@ -195,10 +349,50 @@ std::vector<Song> PlaylistDAO::getSongsInPlaylist(int playlist_id) {
 	}
 }
 
-int PlaylistDAO::countSongsInPlaylist(int playlist_id) {
+std::optional<PlaylistCache::Snapshot> MySqlPlaylistDAO::getPlaylistSnapshot(int playlist_id) {
+	if (auto snapshot = playlist_cache->get(playlist_id)) return snapshot;
+
+	// 先取版本再查库, 查询期间有修改时不回填
+	uint64_t version = playlist_cache->version(playlist_id);
 	try {
 		SqlConnGuard guard(db_manager->getConnection());
-		PreStmtPtr pstmt(guard->prepareStatement(
+		PreStmtPtr pstmt(guard.prepareStatement(SELECT_PLAYLIST_BY_ID));
+		pstmt->setInt(1, playlist_id);
+		ResultSetPtr result(pstmt->executeQuery());
+		if (!result->next()) return std::nullopt;
+
+		Playlist playlist = buildPlaylistFromResultSet(result);
+
+		pstmt.reset(guard.prepareStatement(SELECT_SONGS));
+		pstmt->setInt(1, playlist_id);
+		result.reset(pstmt->executeQuery());
+
+		std::vector<Song> songs;
+		songs.reserve(result->rowsCount());
+		{
+			PERF_SCOPE("db.map_rows");
+			while (result->next()) {
+				songs.emplace_back(buildSongFromResultSet(result));
+			}
+		}
+
+		PlaylistCache::Snapshot snapshot;
+		snapshot.version = version;
+		snapshot.playlist = std::make_shared<const Playlist>(std::move(playlist));
+		snapshot.songs = std::make_shared<const std::vector<Song>>(std::move(songs));
+		playlist_cache->put(playlist_id, snapshot);
+		return snapshot;
+	} catch (sql::SQLException& e) {
+		spdlog::error("{} Get playlist snapshot failed: {}, Code: {}", TAG, e.what(),
+					  e.getErrorCode());
+		return std::nullopt;
+	}
+}
+
+int MySqlPlaylistDAO::countSongsInPlaylist(int playlist_id) {
+	try {
+		SqlConnGuard guard(db_manager->getConnection());
+		PreStmtPtr pstmt(guard.prepareStatement(
 			"SELECT COUNT(*) as count FROM playlist_songs WHERE playlist_id = ?"));
 
 		pstmt->setInt(1, playlist_id);
@@ -215,29 +409,23 @@ int PlaylistDAO::countSongsInPlaylist(int playlist_id) {
 	}
 }
 
-Playlist PlaylistDAO::buildPlaylistFromResultSet(const ResultSetPtr& result) {
+Playlist MySqlPlaylistDAO::buildPlaylistFromResultSet(const ResultSetPtr& result) {
 	Playlist playlist;
-	playlist.id = result->getInt("id");
-	playlist.name = result->getString("name");
-	playlist.user_id = result->getInt("user_id");
-
-	playlist.cover = result->isNull("cover") ? "" : result->getString("cover");
-
-	playlist.create_at = result->getString("create_at");
-	playlist.update_at = result->getString("update_at");
+	playlist.id = result->getInt(1);
+	playlist.user_id = result->getInt(2);
+	playlist.name = result->getString(3);
+	if (!result->isNull(4)) playlist.cover = result->getString(4);
+	playlist.create_at = result->getInt64(5);
+	playlist.update_at = result->getInt64(6);
 
 	return playlist;
 }
 
-Song PlaylistDAO::buildSongFromResultSet(const ResultSetPtr& result) {
+Song MySqlPlaylistDAO::buildSongFromResultSet(const ResultSetPtr& result) {
 	Song song;
-	song.id = result->getInt("id");
-	song.song_id = result->getString("song_id");
-	song.name = result->getString("song_name");
-	song.singer = result->getString("song_singer");
-	song.where = result->getString("song_where");
-	song.pic = result->isNull("song_pic") ? "" : result->getString("song_pic");
-	song.added_at = result->getString("added_at");
+	song.id = result->getInt(1);
+	song.added_at = result->getInt64(2);
+	song.meta = SongPool::getInstance()->fromResultSet(result, 3);
 
 	return song;
 }
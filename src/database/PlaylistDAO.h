@@ -2,36 +2,105 @@
 
 #include <optional>
 #include <string>
+#include <utility>
 #include <vector>
+#include "DAOStatus.h"
 #include "DBManager.h"
+#include "PlaylistCache.h"
 #include "../models/playlist.h"
 #include "../models/song.h"
 
 /**
- * @brief 歌单数据访问对象
+ * @brief 歌单数据访问接口, 实现由 Storage 按配置的后端创建
+ *
+ * 修改歌单或其歌曲后更新 PlaylistCache 中的版本号.
  */
 class PlaylistDAO {
 public:
-	PlaylistDAO();
+	virtual ~PlaylistDAO() = default;
 
 	// 歌单 CRUD
-	bool createPlaylist(Playlist& playlist);
-	std::optional<Playlist> getPlaylistById(int playlist_id);
-	std::vector<Playlist> getPlaylistsByUserId(int user_id);
-	bool updatePlaylist(const Playlist& playlist);
-	bool deletePlaylist(int id);
+	// 用户不存在时返回 NotFound
+	virtual DAOStatus createPlaylist(Playlist& playlist) = 0;
+	virtual std::optional<Playlist> getPlaylistById(int playlist_id) = 0;
+	// 按歌单 id 升序
+	virtual std::vector<Playlist> getPlaylistsByUserId(int user_id) = 0;
+	virtual bool updatePlaylist(const Playlist& playlist) = 0;
+	virtual bool deletePlaylist(int id) = 0;
 
 	// 歌单歌曲 CRUD
-	bool addSongToPlaylist(int playlist_id, const Song& song);
+	// 已在歌单中返回 Conflict, 歌单不存在返回 NotFound
+	virtual DAOStatus addSongToPlaylist(int playlist_id, const Song& song) = 0;
+	virtual bool removeSongFromPlaylist(int playlist_id, const std::string& song_id,
+										SongSource song_source) = 0;
+
+	/**
+	 * @brief 批量添加歌曲, 整批原子完成
+	 * @param results 与 songs 一一对应: Ok 已添加, Conflict 已在歌单中 (或本批重复)
+	 * @return 整批结果, 非 Ok 时没有歌曲被添加, results 无效
+	 */
+	virtual DAOStatus addSongsToPlaylist(int playlist_id, const std::vector<Song>& songs,
+										 std::vector<DAOStatus>& results) = 0;
+
+	/**
+	 * @brief 批量移除歌曲, 整批原子完成
+	 * @param results 与 keys 一一对应: Ok 已移除, NotFound 不在歌单中
+	 */
+	virtual DAOStatus removeSongsFromPlaylist(
+		int playlist_id, const std::vector<std::pair<std::string, SongSource>>& keys,
+		std::vector<DAOStatus>& results) = 0;
+
+	// 按加入顺序
+	virtual std::vector<Song> getSongsInPlaylist(int playlist_id) = 0;
+
+	/**
+	 * @brief 歌单信息与歌曲 (带版本号), 优先读缓存
+	 * @return 歌单不存在或查询失败时返回 nullopt
+	 */
+	virtual std::optional<PlaylistCache::Snapshot> getPlaylistSnapshot(int playlist_id) = 0;
+
+	virtual int countSongsInPlaylist(int playlist_id) = 0;
+};
+
+/**
+ * @brief MySQL 实现
+ */
+class MySqlPlaylistDAO : public PlaylistDAO {
+public:
+	// 批量操作每组语句的行数
+	static constexpr size_t BATCH_CHUNK = 200;
+
+	MySqlPlaylistDAO();
+
+	DAOStatus createPlaylist(Playlist& playlist) override;
+	std::optional<Playlist> getPlaylistById(int playlist_id) override;
+	std::vector<Playlist> getPlaylistsByUserId(int user_id) override;
+	bool updatePlaylist(const Playlist& playlist) override;
+	bool deletePlaylist(int id) override;
+
+	DAOStatus addSongToPlaylist(int playlist_id, const Song& song) override;
 	bool removeSongFromPlaylist(int playlist_id, const std::string& song_id,
-								std::string& song_source);
-	std::vector<Song> getSongsInPlaylist(int playlist_id);
+								SongSource song_source) override;
 
-	int countSongsInPlaylist(int playlist_id);
+	// 整批在一个事务中, 每 BATCH_CHUNK 首一组多行语句
+	DAOStatus addSongsToPlaylist(int playlist_id, const std::vector<Song>& songs,
+								 std::vector<DAOStatus>& results) override;
+	DAOStatus removeSongsFromPlaylist(int playlist_id,
+									  const std::vector<std::pair<std::string, SongSource>>& keys,
+									  std::vector<DAOStatus>& results) override;
 
-private:
-	DBManager* db_manager;
+	std::vector<Song> getSongsInPlaylist(int playlist_id) override;
+	std::optional<PlaylistCache::Snapshot> getPlaylistSnapshot(int playlist_id) override;
+	int countSongsInPlaylist(int playlist_id) override;
 
+	// 结果集当前行映射为模型 (列序见 SELECT_PLAYLISTS / SELECT_SONGS), 不访问数据库
 	static Playlist buildPlaylistFromResultSet(const ResultSetPtr& result);
 	static Song buildSongFromResultSet(const ResultSetPtr& result);
-};
\ No newline at end of file
+
+private:
+	DBManager* db_manager;
+	PlaylistCache* playlist_cache;
+
+	// 事务中锁定歌单行, 使同一歌单的批量修改串行; 歌单不存在或用户已注销返回 false
+	static bool lockPlaylist(const SqlConnGuard& guard, int playlist_id);
+};
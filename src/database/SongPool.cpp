@@ -0,0 +1,190 @@
+#include "SongPool.h"
+
+#include <jdbc/cppconn/prepared_statement.h>
+
+#include <mutex>
+#include <utility>
+
+std::unique_ptr<SongPool> SongPool::m_instance = nullptr;
+
+namespace {
+
+// 每插入这么多次清理一次已释放的条目
+constexpr size_t SWEEP_INTERVAL = 4096;
+
+bool sameContent(const SongMeta& a, const SongMeta& b) {
+	return a.name == b.name && a.singer == b.singer && a.pic == b.pic;
+}
+
+} // namespace
+
+SongPool* SongPool::getInstance() {
+	static std::once_flag flag;
+	std::call_once(flag, []() { m_instance.reset(new SongPool()); });
+
+	return m_instance.get();
+}
+
+SongMetaPtr SongPool::intern(SongMeta meta) {
+	std::unique_lock<std::shared_mutex> lock(m_mtx);
+	auto it = m_by_ref.find(meta.ref);
+	if (it != m_by_ref.end()) {
+		if (auto existing = it->second.meta.lock()) {
+			if (sameContent(*existing, meta)) return existing;
+		}
+	}
+
+	std::string key = makeKey(meta.song_id, meta.where);
+	auto ptr = std::make_shared<const SongMeta>(std::move(meta));
+	m_by_key[key] = ptr->ref;
+	m_by_ref[ptr->ref] = Entry{ptr, std::move(key)};
+
+	if (++m_inserts % SWEEP_INTERVAL == 0) sweep();
+	return ptr;
+}
+
+SongMetaPtr SongPool::find(int ref) {
+	std::shared_lock<std::shared_mutex> lock(m_mtx);
+	auto it = m_by_ref.find(ref);
+	if (it == m_by_ref.end()) return nullptr;
+
+	return it->second.meta.lock();
+}
+
+SongMetaPtr SongPool::find(const std::string& song_id, SongSource where) {
+	std::shared_lock<std::shared_mutex> lock(m_mtx);
+	auto key_it = m_by_key.find(makeKey(song_id, where));
+	if (key_it == m_by_key.end()) return nullptr;
+
+	auto it = m_by_ref.find(key_it->second);
+	if (it == m_by_ref.end()) return nullptr;
+
+	return it->second.meta.lock();
+}
+
+SongMetaPtr SongPool::resolve(const SqlConnGuard& guard, const SongMeta& meta) {
+	if (auto existing = find(meta.song_id, meta.where)) {
+		if (sameContent(*existing, meta)) return existing;
+	}
+
+	// 存储过程内 upsert 并取回 id (已存在时为原有 id), 一次往返
+	PreStmtPtr pstmt(guard.prepareStatement("CALL resolve_song(?, ?, ?, ?, ?)"));
+	pstmt->setString(1, meta.song_id);
+	pstmt->setString(2, toString(meta.where));
+	pstmt->setString(3, meta.name);
+	pstmt->setString(4, meta.singer);
+	if (meta.pic.empty())
+		pstmt->setNull(5, sql::DataType::VARCHAR);
+	else
+		pstmt->setString(5, meta.pic);
+
+	SongMeta resolved = meta;
+	ResultSetPtr result(pstmt->executeQuery());
+	if (result->next()) resolved.ref = result->getInt(1);
+	result.reset();
+	finishCall(pstmt);
+	if (resolved.ref <= 0) return nullptr;
+
+	return intern(std::move(resolved));
+}
+
+std::vector<SongMetaPtr> SongPool::resolveBatch(const SqlConnGuard& guard,
+												const std::vector<SongMeta>& metas) {
+	std::vector<SongMetaPtr> resolved(metas.size());
+	std::vector<size_t> pending;
+	for (size_t i = 0; i < metas.size(); ++i) {
+		auto existing = find(metas[i].song_id, metas[i].where);
+		if (existing && sameContent(*existing, metas[i]))
+			resolved[i] = std::move(existing);
+		else
+			pending.push_back(i);
+	}
+	if (pending.empty()) return resolved;
+
+	PreStmtPtr pstmt(guard.prepareStatement(
+		"INSERT INTO songs (song_id, song_where, song_name, song_singer, song_pic) VALUES " +
+		sqlPlaceholders(pending.size(), 5) +
+		" ON DUPLICATE KEY UPDATE song_name = VALUES(song_name), "
+		"song_singer = VALUES(song_singer), song_pic = VALUES(song_pic)"));
+	uint32_t param = 1;
+	for (size_t i : pending) {
+		const SongMeta& meta = metas[i];
+		pstmt->setString(param++, meta.song_id);
+		pstmt->setString(param++, toString(meta.where));
+		pstmt->setString(param++, meta.name);
+		pstmt->setString(param++, meta.singer);
+		if (meta.pic.empty())
+			pstmt->setNull(param++, sql::DataType::VARCHAR);
+		else
+			pstmt->setString(param++, meta.pic);
+	}
+	pstmt->executeUpdate();
+
+	// song_id 为 utf8mb4_bin, 取回的 id 与请求逐字节相同, 可按原字符串对应
+	pstmt.reset(guard.prepareStatement(
+		"SELECT id, song_id, song_where + 0 FROM songs WHERE (song_id, song_where) IN (" +
+		sqlPlaceholders(pending.size(), 2) + ")"));
+	param = 1;
+	for (size_t i : pending) {
+		pstmt->setString(param++, metas[i].song_id);
+		pstmt->setString(param++, toString(metas[i].where));
+	}
+
+	std::unordered_map<std::string, int> refs;
+	ResultSetPtr result(pstmt->executeQuery());
+	while (result->next()) {
+		refs.emplace(makeKey(result->getString(2), static_cast<SongSource>(result->getInt(3))),
+					 result->getInt(1));
+	}
+
+	for (size_t i : pending) {
+		auto it = refs.find(makeKey(metas[i].song_id, metas[i].where));
+		if (it == refs.end()) continue;
+
+		SongMeta meta = metas[i];
+		meta.ref = it->second;
+		resolved[i] = intern(std::move(meta));
+	}
+	return resolved;
+}
+
+SongMetaPtr SongPool::fromResultSet(const ResultSetPtr& result, uint32_t first) {
+	const int ref = result->getInt(first);
+	if (auto existing = find(ref)) {
+		m_hits.fetch_add(1, std::memory_order_relaxed);
+		return existing;
+	}
+	m_misses.fetch_add(1, std::memory_order_relaxed);
+
+	SongMeta meta;
+	meta.ref = ref;
+	meta.song_id = result->getString(first + 1);
+	meta.where = static_cast<SongSource>(result->getInt(first + 2));
+	meta.name = result->getString(first + 3);
+	meta.singer = result->getString(first + 4);
+	if (!result->isNull(first + 5)) meta.pic = result->getString(first + 5);
+
+	return intern(std::move(meta));
+}
+
+SongPool::Stats SongPool::stats() const {
+	Stats stats;
+	stats.hits = m_hits.load(std::memory_order_relaxed);
+	stats.misses = m_misses.load(std::memory_order_relaxed);
+
+	std::shared_lock<std::shared_mutex> lock(m_mtx);
+	stats.entries = m_by_ref.size();
+	return stats;
+}
+
+void SongPool::sweep() {
+	for (auto it = m_by_ref.begin(); it != m_by_ref.end();) {
+		if (it->second.meta.expired()) {
+			auto key_it = m_by_key.find(it->second.key);
+			if (key_it != m_by_key.end() && key_it->second == it->first) m_by_key.erase(key_it);
+			it = m_by_ref.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
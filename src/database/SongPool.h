@@ -0,0 +1,93 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "DBManager.h"
+#include "../models/song.h"
+
+/**
+ * @brief 歌曲元数据驻留池 单例
+ *
+ * songs.id → 不可变 SongMeta, 只持有弱引用: 仍被缓存/响应引用的歌曲共享同一份对象,
+ * 无人引用时自动释放. 读取结果集时若已驻留则跳过字符串列, 不再为每行分配元数据.
+ */
+class SongPool {
+public:
+	struct Stats {
+		uint64_t hits = 0;
+		uint64_t misses = 0;
+		uint64_t entries = 0; // 含已过期未清理的条目
+	};
+
+	// fromResultSet 读取的列 (songs 表别名 s), 需在结果集中连续出现
+	static constexpr const char* COLUMNS =
+		"s.id, s.song_id, s.song_where + 0, s.song_name, s.song_singer, s.song_pic";
+	static constexpr uint32_t COLUMN_COUNT = 6;
+
+	static SongPool* getInstance();
+
+	// 驻留元数据 (meta.ref 需已设置), 已存在相同内容时返回已有对象
+	SongMetaPtr intern(SongMeta meta);
+
+	SongMetaPtr find(int ref);
+	SongMetaPtr find(const std::string& song_id, SongSource where);
+
+	/**
+	 * @brief 将歌曲写入 songs 维表 (已存在则更新元数据) 并驻留
+	 * @return 带 ref 的元数据; 已驻留且内容未变时不访问数据库
+	 */
+	SongMetaPtr resolve(const SqlConnGuard& guard, const SongMeta& meta);
+
+	/**
+	 * @brief 批量写入 songs 维表并驻留: 一条多行 upsert 加一条按 (song_id, song_where) 取回 id
+	 * @return 与 metas 一一对应, 已驻留且内容未变的歌曲不访问数据库
+	 */
+	std::vector<SongMetaPtr> resolveBatch(const SqlConnGuard& guard,
+										  const std::vector<SongMeta>& metas);
+
+	/**
+	 * @brief 从结果集当前行读取歌曲
+	 * @param first COLUMNS 中第一列在结果集中的序号 (从 1 开始)
+	 */
+	SongMetaPtr fromResultSet(const ResultSetPtr& result, uint32_t first);
+
+	Stats stats() const;
+
+	~SongPool() = default;
+	SongPool(const SongPool&) = delete;
+	SongPool(SongPool&&) = delete;
+	SongPool& operator=(const SongPool&) = delete;
+	SongPool& operator=(SongPool&&) = delete;
+
+private:
+	SongPool() = default;
+
+	struct Entry {
+		std::weak_ptr<const SongMeta> meta;
+		std::string key;
+	};
+
+	static std::string makeKey(const std::string& song_id, SongSource where) {
+		return static_cast<char>(where) + song_id;
+	}
+
+	// 调用方持有写锁
+	void sweep();
+
+private:
+	std::unordered_map<int, Entry> m_by_ref;
+	std::unordered_map<std::string, int> m_by_key;
+	mutable std::shared_mutex m_mtx;
+	size_t m_inserts = 0;
+
+	std::atomic<uint64_t> m_hits{0};
+	std::atomic<uint64_t> m_misses{0};
+
+	static std::unique_ptr<SongPool> m_instance;
+};
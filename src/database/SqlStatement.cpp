@@ -0,0 +1,386 @@
+#include "SqlStatement.h"
+#include "../utils/Tracing.h"
+
+#include <jdbc/cppconn/exception.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+
+constexpr const char* TAG = "[SqlStats]";
+
+std::unique_ptr<SqlStats> SqlStats::m_instance = nullptr;
+
+namespace {
+
+// 超过语句数上限后的新语句
+constexpr const char* OTHER_STATEMENT = "<other>";
+
+// s[begin] 为 '(' 且括号内只有占位符时返回 ')' 之后的位置, 否则 npos
+size_t placeholderGroupEnd(const std::string& s, size_t begin) {
+	if (begin >= s.size() || s[begin] != '(') return std::string::npos;
+
+	bool placeholder = false;
+	for (size_t i = begin + 1; i < s.size(); ++i) {
+		const char c = s[i];
+		if (c == '?') {
+			placeholder = true;
+		} else if (c == ')') {
+			return placeholder ? i + 1 : std::string::npos;
+		} else if (c != ',' && c != ' ') {
+			return std::string::npos;
+		}
+	}
+	return std::string::npos;
+}
+
+double toMillis(uint64_t micros) { return static_cast<double>(micros) / 1000.0; }
+
+bool startsWith(const std::string& sql, const std::string& keyword) {
+	if (sql.size() < keyword.size()) return false;
+	std::string head = sql.substr(0, keyword.size());
+	std::transform(head.begin(), head.end(), head.begin(),
+				   [](unsigned char c) { return std::toupper(c); });
+	return head == keyword;
+}
+
+} // namespace
+
+SqlStats::Statement::Statement(std::string sql_text)
+	: sql(std::move(sql_text)), id([this]() {
+		  char buf[17];
+		  std::snprintf(buf, sizeof(buf), "%016zx", std::hash<std::string>{}(sql));
+		  return std::string(buf);
+	  }()) {}
+
+SqlStats* SqlStats::getInstance() {
+	if (m_instance) return m_instance.get();
+
+	static std::once_flag flag;
+	std::call_once(flag, []() { m_instance.reset(new SqlStats()); });
+
+	return m_instance.get();
+}
+
+void SqlStats::configure(std::chrono::milliseconds slow_threshold, size_t max_statements) {
+	m_slow_threshold_us.store(
+		std::chrono::duration_cast<std::chrono::microseconds>(slow_threshold).count(),
+		std::memory_order_relaxed);
+
+	std::unique_lock<std::shared_mutex> lock(m_mtx);
+	m_max_statements = max_statements;
+}
+
+SqlStats::Statement& SqlStats::statement(const std::string& sql) {
+	std::string key = normalize(sql);
+	{
+		std::shared_lock<std::shared_mutex> lock(m_mtx);
+		auto it = m_statements.find(key);
+		if (it != m_statements.end()) return *it->second;
+	}
+
+	std::unique_lock<std::shared_mutex> lock(m_mtx);
+	auto it = m_statements.find(key);
+	if (it != m_statements.end()) return *it->second;
+
+	if (m_statements.size() >= m_max_statements) key = OTHER_STATEMENT;
+	auto& slot = m_statements[key];
+	if (!slot) slot = std::make_unique<Statement>(key);
+	return *slot;
+}
+
+bool SqlStats::requestExplain(const std::string& id) {
+	std::shared_lock<std::shared_mutex> lock(m_mtx);
+	for (const auto& [sql, statement] : m_statements) {
+		if (statement->id != id) continue;
+		if (sql == OTHER_STATEMENT || startsWith(sql, "CALL") || startsWith(sql, "ALTER")) {
+			return false;
+		}
+
+		statement->explain_requested.store(true, std::memory_order_relaxed);
+		return true;
+	}
+	return false;
+}
+
+nlohmann::json SqlStats::toJson(const std::string& sort, size_t limit) const {
+	struct Row {
+		nlohmann::json json;
+		double key = 0;
+	};
+
+	std::vector<Row> rows;
+	{
+		std::shared_lock<std::shared_mutex> lock(m_mtx);
+		rows.reserve(m_statements.size());
+		for (const auto& [sql, statement] : m_statements) {
+			const auto snapshot = statement->latency.snapshot();
+			const uint64_t max_us = statement->max_us.load(std::memory_order_relaxed);
+			const double mean_ms =
+				snapshot.count > 0 ? toMillis(snapshot.sum) / static_cast<double>(snapshot.count)
+								   : 0.0;
+
+			Row row;
+			row.json = {{"id", statement->id},
+						{"sql", sql},
+						{"calls", statement->calls.value()},
+						{"errors", statement->errors.value()},
+						{"rows", statement->rows.value()},
+						{"total_ms", toMillis(snapshot.sum)},
+						{"mean_ms", mean_ms},
+						{"p50_ms", toMillis(snapshot.quantile(0.50))},
+						{"p95_ms", toMillis(snapshot.quantile(0.95))},
+						{"p99_ms", toMillis(snapshot.quantile(0.99))},
+						{"max_ms", toMillis(max_us)},
+						{"explain_pending",
+						 statement->explain_requested.load(std::memory_order_relaxed)}};
+			{
+				std::lock_guard<std::mutex> explain_lock(statement->explain_mtx);
+				if (!statement->explain.empty()) {
+					row.json["explain"] = nlohmann::json::parse(statement->explain, nullptr, false);
+					row.json["explain_at"] = statement->explain_at;
+				}
+			}
+
+			if (sort == "mean")
+				row.key = mean_ms;
+			else if (sort == "calls")
+				row.key = static_cast<double>(statement->calls.value());
+			else if (sort == "max")
+				row.key = static_cast<double>(max_us);
+			else if (sort == "errors")
+				row.key = static_cast<double>(statement->errors.value());
+			else
+				row.key = static_cast<double>(snapshot.sum);
+			rows.push_back(std::move(row));
+		}
+	}
+
+	std::sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) { return a.key > b.key; });
+	if (rows.size() > limit) rows.resize(limit);
+
+	nlohmann::json out = nlohmann::json::array();
+	for (auto& row : rows) out.push_back(std::move(row.json));
+	return out;
+}
+
+std::string SqlStats::normalize(const std::string& sql) {
+	// 合并空白
+	std::string compact;
+	compact.reserve(sql.size());
+	bool space = false;
+	for (char c : sql) {
+		if (std::isspace(static_cast<unsigned char>(c))) {
+			space = true;
+			continue;
+		}
+		if (space && !compact.empty()) compact += ' ';
+		space = false;
+		compact += c;
+	}
+
+	// 合并占位符括号组
+	std::string out;
+	out.reserve(compact.size());
+	size_t i = 0;
+	while (i < compact.size()) {
+		size_t end = placeholderGroupEnd(compact, i);
+		if (end == std::string::npos) {
+			out += compact[i++];
+			continue;
+		}
+
+		out += "(...)";
+		i = end;
+		// 紧随其后的 ", (?, ?)" 重复
+		while (i < compact.size() && compact[i] == ',') {
+			size_t next = i + 1;
+			if (next < compact.size() && compact[next] == ' ') ++next;
+			end = placeholderGroupEnd(compact, next);
+			if (end == std::string::npos) break;
+			i = end;
+		}
+	}
+	return out;
+}
+
+SqlStatement::SqlStatement(sql::Connection* conn, sql::PreparedStatement* stmt,
+						   SqlStats::Statement& stats, const std::string& sql)
+	: m_conn(conn),
+	  m_stmt(stmt),
+	  m_stats(stats),
+	  m_capture(stats.explain_requested.load(std::memory_order_relaxed)) {
+	if (m_capture) m_sql = sql;
+}
+
+SqlStatement::Param& SqlStatement::param(unsigned int index) {
+	if (index == 0) throw std::out_of_range("SQL parameter index starts at 1");
+	if (m_params.size() < index) m_params.resize(index);
+	return m_params[index - 1];
+}
+
+void SqlStatement::setInt(unsigned int index, int32_t value) {
+	m_stmt->setInt(index, value);
+	Param& p = param(index);
+	p.kind = Param::Kind::Int;
+	p.number = value;
+}
+
+void SqlStatement::setInt64(unsigned int index, int64_t value) {
+	m_stmt->setInt64(index, value);
+	Param& p = param(index);
+	p.kind = Param::Kind::Int;
+	p.number = value;
+}
+
+void SqlStatement::setString(unsigned int index, const std::string& value) {
+	m_stmt->setString(index, value);
+	Param& p = param(index);
+	p.kind = Param::Kind::String;
+	p.length = value.size();
+	if (m_capture) p.text = value;
+}
+
+void SqlStatement::setNull(unsigned int index, int sql_type) {
+	m_stmt->setNull(index, sql_type);
+	Param& p = param(index);
+	p.kind = Param::Kind::Null;
+	p.number = sql_type;
+}
+
+sql::ResultSet* SqlStatement::executeQuery() {
+	TraceSpan span("db.query");
+	span.setAttribute("db.statement", m_stats.sql);
+	if (m_capture) captureExplain();
+
+	const auto start = std::chrono::steady_clock::now();
+	sql::ResultSet* result = nullptr;
+	try {
+		result = m_stmt->executeQuery();
+	} catch (...) {
+		record(start, -1);
+		throw;
+	}
+
+	// 默认结果集已缓冲在客户端, 行数无需额外往返
+	int64_t rows = 0;
+	try {
+		rows = static_cast<int64_t>(result->rowsCount());
+	} catch (sql::SQLException&) {
+	}
+	record(start, rows);
+	return result;
+}
+
+int SqlStatement::executeUpdate() {
+	TraceSpan span("db.query");
+	span.setAttribute("db.statement", m_stats.sql);
+	if (m_capture) captureExplain();
+
+	const auto start = std::chrono::steady_clock::now();
+	int rows = 0;
+	try {
+		rows = m_stmt->executeUpdate();
+	} catch (...) {
+		record(start, -1);
+		throw;
+	}
+	record(start, rows);
+	return rows;
+}
+
+bool SqlStatement::execute() {
+	TraceSpan span("db.query");
+	span.setAttribute("db.statement", m_stats.sql);
+	if (m_capture) captureExplain();
+
+	const auto start = std::chrono::steady_clock::now();
+	bool has_result = false;
+	try {
+		has_result = m_stmt->execute();
+	} catch (...) {
+		record(start, -1);
+		throw;
+	}
+	record(start, 0);
+	return has_result;
+}
+
+void SqlStatement::record(std::chrono::steady_clock::time_point start, int64_t rows) {
+	const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now() - start);
+	const auto micros = static_cast<uint64_t>(std::max<int64_t>(elapsed.count(), 0));
+
+	m_stats.calls.inc();
+	if (rows < 0)
+		m_stats.errors.inc();
+	else
+		m_stats.rows.inc(static_cast<uint64_t>(rows));
+	m_stats.latency.observe(micros);
+
+	uint64_t max_us = m_stats.max_us.load(std::memory_order_relaxed);
+	while (micros > max_us &&
+		   !m_stats.max_us.compare_exchange_weak(max_us, micros, std::memory_order_relaxed)) {
+	}
+
+	if (elapsed >= SqlStats::getInstance()->slowThreshold()) {
+		spdlog::warn("[SlowQuery] {:.3f} ms, rows {}{}: {} [{}]", toMillis(micros), rows,
+					 rows < 0 ? " (failed)" : "", m_stats.sql, redactedParams());
+	}
+}
+
+std::string SqlStatement::redactedParams() const {
+	std::string out;
+	for (const auto& p : m_params) {
+		if (!out.empty()) out += ", ";
+		switch (p.kind) {
+		case Param::Kind::Unset:
+			out += "?";
+			break;
+		case Param::Kind::Null:
+			out += "null";
+			break;
+		case Param::Kind::Int:
+			out += "int";
+			break;
+		case Param::Kind::String:
+			out += "string(" + std::to_string(p.length) + ")";
+			break;
+		}
+	}
+	return out;
+}
+
+void SqlStatement::captureExplain() {
+	m_capture = false;
+	if (!m_stats.explain_requested.exchange(false)) return; // 已由其他执行捕获
+
+	try {
+		std::unique_ptr<sql::PreparedStatement> explain(
+			m_conn->prepareStatement("EXPLAIN FORMAT=JSON " + m_sql));
+		for (size_t i = 0; i < m_params.size(); ++i) {
+			const Param& p = m_params[i];
+			const auto index = static_cast<unsigned int>(i + 1);
+			if (p.kind == Param::Kind::Int) explain->setInt64(index, p.number);
+			if (p.kind == Param::Kind::String) explain->setString(index, p.text);
+			if (p.kind == Param::Kind::Null) explain->setNull(index, static_cast<int>(p.number));
+		}
+
+		std::unique_ptr<sql::ResultSet> result(explain->executeQuery());
+		if (!result->next()) return;
+
+		std::lock_guard<std::mutex> lock(m_stats.explain_mtx);
+		m_stats.explain = result->getString(1);
+		m_stats.explain_at = std::chrono::duration_cast<std::chrono::seconds>(
+								 std::chrono::system_clock::now().time_since_epoch())
+								 .count();
+		spdlog::info("{} EXPLAIN captured for {}", TAG, m_stats.id);
+	} catch (sql::SQLException& e) {
+		spdlog::warn("{} EXPLAIN of {} failed: {}, Code: {}", TAG, m_stats.id, e.what(),
+					 e.getErrorCode());
+	}
+}
@@ -0,0 +1,137 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+#include <jdbc/cppconn/connection.h>
+#include <jdbc/cppconn/prepared_statement.h>
+#include <jdbc/cppconn/resultset.h>
+#include <nlohmann/json.hpp>
+
+#include "../utils/Metrics.h"
+
+/**
+ * @brief 按语句统计的 SQL 执行耗时 单例
+ *
+ * 语句以规范化后的 SQL 区分: 空白合并, 只含占位符的括号组及其重复 (如 "(?, ?), (?, ?)")
+ * 合并为 "(...)", 使按批大小拼接的语句归为一条. 超过 max_statements 后新语句计入 "<other>".
+ * 慢于阈值的执行记入日志, 参数只记类型与长度, 不记值.
+ */
+class SqlStats {
+public:
+	struct Statement {
+		explicit Statement(std::string sql_text);
+
+		const std::string sql;
+		const std::string id; // sql 的哈希, 供管理接口引用
+		MetricCounter calls;
+		MetricCounter errors;
+		MetricCounter rows; // 查询返回行数 / 更新影响行数
+		MetricHistogram latency;
+		std::atomic<uint64_t> max_us{0};
+
+		// 按需 EXPLAIN: 请求后下一次执行时以相同参数在同一连接上捕获
+		std::atomic<bool> explain_requested{false};
+		mutable std::mutex explain_mtx;
+		std::string explain; // EXPLAIN FORMAT=JSON 的结果
+		int64_t explain_at = 0;
+	};
+
+	static SqlStats* getInstance();
+
+	void configure(std::chrono::milliseconds slow_threshold, size_t max_statements);
+
+	// 查找或创建语句的统计, 返回的引用在进程内一直有效
+	Statement& statement(const std::string& sql);
+
+	std::chrono::microseconds slowThreshold() const {
+		return std::chrono::microseconds(m_slow_threshold_us.load(std::memory_order_relaxed));
+	}
+
+	// 请求捕获语句 id 的执行计划; id 不存在或语句不支持 EXPLAIN 时返回 false
+	bool requestExplain(const std::string& id);
+
+	// 按 sort (total|mean|calls|max|errors) 降序的前 limit 条
+	nlohmann::json toJson(const std::string& sort, size_t limit) const;
+
+	static std::string normalize(const std::string& sql);
+
+	~SqlStats() = default;
+	SqlStats(const SqlStats&) = delete;
+	SqlStats(SqlStats&&) = delete;
+	SqlStats& operator=(const SqlStats&) = delete;
+	SqlStats& operator=(SqlStats&&) = delete;
+
+private:
+	SqlStats() = default;
+
+private:
+	std::atomic<int64_t> m_slow_threshold_us{200 * 1000};
+	size_t m_max_statements = 256;
+
+	std::map<std::string, std::unique_ptr<Statement>> m_statements;
+	mutable std::shared_mutex m_mtx;
+
+	static std::unique_ptr<SqlStats> m_instance;
+};
+
+/**
+ * @brief 计时的预处理语句, 由 SqlConnGuard::prepareStatement 创建
+ *
+ * 转发 DAO 用到的 sql::PreparedStatement 接口; 每次执行计入语句统计与 "db.query" span,
+ * 慢于阈值时记慢查询日志.
+ */
+class SqlStatement {
+public:
+	SqlStatement(sql::Connection* conn, sql::PreparedStatement* stmt, SqlStats::Statement& stats,
+				 const std::string& sql);
+
+	void setInt(unsigned int index, int32_t value);
+	void setInt64(unsigned int index, int64_t value);
+	void setString(unsigned int index, const std::string& value);
+	void setNull(unsigned int index, int sql_type);
+
+	sql::ResultSet* executeQuery();
+	int executeUpdate();
+	bool execute();
+
+	bool getMoreResults() { return m_stmt->getMoreResults(); }
+
+	SqlStatement(const SqlStatement&) = delete;
+	SqlStatement(SqlStatement&&) = delete;
+	SqlStatement& operator=(const SqlStatement&) = delete;
+	SqlStatement& operator=(SqlStatement&&) = delete;
+
+private:
+	struct Param {
+		enum class Kind { Unset, Null, Int, String } kind = Kind::Unset;
+		int64_t number = 0;
+		size_t length = 0;
+		std::string text; // 只在捕获 EXPLAIN 时保存
+	};
+
+	Param& param(unsigned int index);
+
+	// 计时并记录, rows 为 -1 表示失败
+	void record(std::chrono::steady_clock::time_point start, int64_t rows);
+
+	// 参数类型列表, 如 "int, string(12), null"
+	std::string redactedParams() const;
+
+	void captureExplain();
+
+private:
+	sql::Connection* m_conn;
+	std::unique_ptr<sql::PreparedStatement> m_stmt;
+	SqlStats::Statement& m_stats;
+	bool m_capture;	   // 创建时已请求 EXPLAIN, 保存参数值
+	std::string m_sql; // 原始语句, 只在 m_capture 时保存
+	std::vector<Param> m_params;
+};
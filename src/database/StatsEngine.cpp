@@ -0,0 +1,375 @@
+#include "StatsEngine.h"
+#include "DeletionJobs.h"
+#include "HistoryPartitions.h"
+#include "SongPool.h"
+
+#include <jdbc/cppconn/exception.h>
+#include <jdbc/cppconn/prepared_statement.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+constexpr const char* TAG = "[StatsEngine]";
+
+std::unique_ptr<StatsEngine> StatsEngine::m_instance = nullptr;
+
+namespace {
+
+// 汇总表指纹: 行数, 次数之和, 各行内容 CRC 异或
+std::string fingerprint(const SqlConnGuard& guard, int user_id) {
+	PreStmtPtr pstmt(guard.prepareStatement(
+		"SELECT "
+		"(SELECT CONCAT(COUNT(*), ':', COALESCE(SUM(play_count), 0), ':', "
+		"COALESCE(BIT_XOR(CRC32(CONCAT(song_ref, '|', play_count))), 0)) "
+		"FROM user_song_stats WHERE user_id = ?) AS songs, "
+		"(SELECT CONCAT(COUNT(*), ':', COALESCE(SUM(play_count), 0), ':', "
+		"COALESCE(BIT_XOR(CRC32(CONCAT(song_singer, '|', play_count))), 0)) "
+		"FROM user_artist_stats WHERE user_id = ?) AS artists, "
+		"(SELECT COALESCE(MAX(total_plays), 0) FROM user_play_stats WHERE user_id = ?) AS total"));
+	pstmt->setInt(1, user_id);
+	pstmt->setInt(2, user_id);
+	pstmt->setInt(3, user_id);
+
+	ResultSetPtr result(pstmt->executeQuery());
+	if (!result->next()) return {};
+
+	return std::string(result->getString("songs")) + "/" +
+		   std::string(result->getString("artists")) + "/" +
+		   std::string(result->getString("total"));
+}
+
+// 绑定 recompute 中合并统计语句的参数: 目标 user_id, 明细与按日汇总各两次
+void bindPlays(const PreStmtPtr& pstmt, int user_id) {
+	for (int i = 1; i <= 5; ++i) {
+		pstmt->setInt(i, user_id);
+	}
+}
+
+// top-K 顺序, 与 load 的查询及 memory 后端一致: 次数降序, 相同时按 song_ref / 歌手名 (字节序)
+bool songBefore(const StatsEngine::SongCount& a, const StatsEngine::SongCount& b) {
+	return a.count != b.count ? a.count > b.count : a.song->ref < b.song->ref;
+}
+
+bool artistBefore(const StatsEngine::ArtistCount& a, const StatsEngine::ArtistCount& b) {
+	return a.count != b.count ? a.count > b.count : a.singer < b.singer;
+}
+
+} // namespace
+
+StatsEngine::StatsEngine(size_t max_users, std::chrono::hours recompute_interval)
+	: m_max_users(max_users > 0 ? max_users : 1), m_recompute_interval(recompute_interval) {
+	if (m_recompute_interval.count() > 0) {
+		m_recompute_thread = std::thread([this]() { recomputeLoop(); });
+	}
+}
+
+StatsEngine::~StatsEngine() { stop(); }
+
+void StatsEngine::init(size_t max_users, std::chrono::hours recompute_interval) {
+	if (!m_instance) {
+		m_instance.reset(new StatsEngine(max_users, recompute_interval));
+	}
+}
+
+StatsEngine* StatsEngine::getInstance() {
+	if (!m_instance) {
+		throw std::runtime_error("StatsEngine not initialized");
+	}
+
+	return m_instance.get();
+}
+
+void StatsEngine::stop() {
+	{
+		std::lock_guard<std::mutex> lock(m_stop_mtx);
+		m_stop = true;
+	}
+	m_stop_cv.notify_all();
+	if (m_recompute_thread.joinable()) m_recompute_thread.join();
+}
+
+std::unique_lock<std::mutex> StatsEngine::lockUser(int user_id) {
+	return std::unique_lock<std::mutex>(
+		m_user_locks[static_cast<size_t>(user_id) % LOCK_STRIPES]);
+}
+
+StatsEngine::PlayCounts StatsEngine::recordPlay(const SqlConnGuard& guard, int user_id,
+												const SongMeta& song) {
+	PreStmtPtr pstmt(guard.prepareStatement("CALL record_play(?, ?, ?)"));
+	pstmt->setInt(1, user_id);
+	pstmt->setInt(2, song.ref);
+	pstmt->setString(3, song.singer);
+
+	PlayCounts counts;
+	ResultSetPtr result(pstmt->executeQuery());
+	if (result->next()) {
+		counts.song = result->getInt(1);
+		counts.artist = result->getInt(2);
+		counts.total = result->getInt64(3);
+	}
+	result.reset();
+	finishCall(pstmt);
+	return counts;
+}
+
+void StatsEngine::applyPlay(int user_id, const SongMetaPtr& song, const PlayCounts& counts) {
+	auto stats = find(user_id);
+	if (!stats) return; // 未缓存, 下次查询时从汇总表加载
+
+	stats->total_plays = counts.total;
+	bumpSong(stats->top_songs, song, counts.song);
+	bumpArtist(stats->top_artists, song->singer, counts.artist);
+}
+
+void StatsEngine::invalidate(int user_id) {
+	std::lock_guard<std::mutex> lock(m_mtx);
+	auto it = m_users.find(user_id);
+	if (it == m_users.end()) return;
+
+	m_lru.erase(it->second);
+	m_users.erase(it);
+}
+
+void StatsEngine::clearSummary(const SqlConnGuard& guard, int user_id) {
+	for (const char* table : {"user_song_stats", "user_artist_stats", "user_play_stats"}) {
+		PreStmtPtr pstmt(guard.prepareStatement(std::string("DELETE FROM ") + table +
+												 " WHERE user_id = ?"));
+		pstmt->setInt(1, user_id);
+		pstmt->executeUpdate();
+	}
+}
+
+std::optional<StatsEngine::UserStats> StatsEngine::getUserStats(int user_id, size_t k) {
+	auto user_lock = lockUser(user_id);
+	auto stats = find(user_id);
+	if (!stats) stats = load(user_id);
+	if (!stats) return std::nullopt;
+
+	UserStats view;
+	view.total_plays = stats->total_plays;
+	k = std::min(k, TOP_K_MAX);
+	view.top_songs.assign(stats->top_songs.begin(),
+						  stats->top_songs.begin() +
+							  static_cast<long>(std::min(k, stats->top_songs.size())));
+	view.top_artists.assign(stats->top_artists.begin(),
+							stats->top_artists.begin() +
+								static_cast<long>(std::min(k, stats->top_artists.size())));
+	return view;
+}
+
+std::shared_ptr<StatsEngine::UserStats> StatsEngine::find(int user_id) {
+	std::lock_guard<std::mutex> lock(m_mtx);
+	auto it = m_users.find(user_id);
+	if (it == m_users.end()) return nullptr;
+
+	m_lru.splice(m_lru.begin(), m_lru, it->second);
+	return it->second->second;
+}
+
+std::shared_ptr<StatsEngine::UserStats> StatsEngine::load(int user_id) {
+	auto stats = std::make_shared<UserStats>();
+	try {
+		SqlConnGuard guard(DBManager::getInstance()->getConnection());
+		PreStmtPtr pstmt(
+			guard.prepareStatement("SELECT total_plays FROM user_play_stats WHERE user_id = ?"));
+		pstmt->setInt(1, user_id);
+		ResultSetPtr result(pstmt->executeQuery());
+		if (result->next()) stats->total_plays = result->getInt64("total_plays");
+
+		pstmt.reset(guard.prepareStatement(
+			std::string("SELECT st.play_count, ") + SongPool::COLUMNS +
+			" FROM user_song_stats st JOIN songs s ON s.id = st.song_ref "
+			"WHERE st.user_id = ? AND st.play_count > 0 "
+			"ORDER BY st.play_count DESC, st.song_ref LIMIT ?"));
+		pstmt->setInt(1, user_id);
+		pstmt->setInt(2, static_cast<int>(TOP_K_MAX));
+		result.reset(pstmt->executeQuery());
+		while (result->next()) {
+			SongCount item;
+			item.count = result->getInt(1);
+			item.song = SongPool::getInstance()->fromResultSet(result, 2);
+			stats->top_songs.push_back(std::move(item));
+		}
+
+		pstmt.reset(guard.prepareStatement(
+			"SELECT song_singer, play_count FROM user_artist_stats "
+			"WHERE user_id = ? AND play_count > 0 ORDER BY play_count DESC, "
+			"CAST(song_singer AS BINARY) LIMIT ?"));
+		pstmt->setInt(1, user_id);
+		pstmt->setInt(2, static_cast<int>(TOP_K_MAX));
+		result.reset(pstmt->executeQuery());
+		while (result->next()) {
+			stats->top_artists.push_back(
+				ArtistCount{result->getString("song_singer"), result->getInt("play_count")});
+		}
+	} catch (sql::SQLException& e) {
+		spdlog::error("{} Load stats of user {} failed: {}, Code: {}", TAG, user_id, e.what(),
+					  e.getErrorCode());
+		return nullptr;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mtx);
+	m_lru.emplace_front(user_id, stats);
+	m_users[user_id] = m_lru.begin();
+	while (m_users.size() > m_max_users) {
+		m_users.erase(m_lru.back().first);
+		m_lru.pop_back();
+	}
+
+	return stats;
+}
+
+void StatsEngine::bumpSong(std::vector<SongCount>& top, const SongMetaPtr& song, int count) {
+	auto it = std::find_if(top.begin(), top.end(), [&song](const SongCount& item) {
+		return item.song->ref == song->ref;
+	});
+
+	if (it == top.end()) {
+		SongCount item{song, count};
+		if (top.size() < TOP_K_MAX) {
+			top.push_back(std::move(item));
+		} else if (songBefore(item, top.back())) {
+			top.back() = std::move(item);
+		} else {
+			return;
+		}
+		it = top.end() - 1;
+	} else {
+		it->count = count;
+	}
+
+	// 计数只增, 向前冒泡即可保持有序
+	while (it != top.begin() && songBefore(*it, *(it - 1))) {
+		std::iter_swap(it, it - 1);
+		--it;
+	}
+}
+
+void StatsEngine::bumpArtist(std::vector<ArtistCount>& top, const std::string& singer,
+							 int count) {
+	auto it = std::find_if(top.begin(), top.end(),
+						   [&singer](const ArtistCount& item) { return item.singer == singer; });
+
+	if (it == top.end()) {
+		ArtistCount item{singer, count};
+		if (top.size() < TOP_K_MAX) {
+			top.push_back(std::move(item));
+		} else if (artistBefore(item, top.back())) {
+			top.back() = std::move(item);
+		} else {
+			return;
+		}
+		it = top.end() - 1;
+	} else {
+		it->count = count;
+	}
+
+	while (it != top.begin() && artistBefore(*it, *(it - 1))) {
+		std::iter_swap(it, it - 1);
+		--it;
+	}
+}
+
+std::optional<bool> StatsEngine::recompute(int user_id) {
+	auto user_lock = lockUser(user_id);
+	try {
+		SqlConnGuard guard(DBManager::getInstance()->getConnection());
+		SqlTransaction tx(guard);
+
+		const std::string before = fingerprint(guard, user_id);
+
+		clearSummary(guard, user_id);
+
+		// 明细与按日汇总合并统计, 只计入可见部分, 已清空待后台删除的记录不计入;
+		// 已汇总日期的明细在 play_history_daily 中计入
+		const std::string plays =
+			std::string("(SELECT h.song_ref, COUNT(*) AS plays FROM play_history h "
+						"WHERE h.user_id = ? AND ") +
+			DeletionJobs::HISTORY_VISIBLE + " AND " + HistoryPartitions::NOT_COMPACTED +
+			" GROUP BY h.song_ref UNION ALL "
+			"SELECT d.song_ref, SUM(d.play_count) FROM play_history_daily d "
+			"WHERE d.user_id = ? AND " +
+			DeletionJobs::DAILY_VISIBLE + " GROUP BY d.song_ref) p";
+
+		PreStmtPtr pstmt(guard.prepareStatement(
+			"INSERT INTO user_song_stats (user_id, song_ref, play_count) "
+			"SELECT ?, p.song_ref, SUM(p.plays) FROM " +
+			plays + " GROUP BY p.song_ref"));
+		bindPlays(pstmt, user_id);
+		pstmt->executeUpdate();
+
+		pstmt.reset(guard.prepareStatement(
+			"INSERT INTO user_artist_stats (user_id, song_singer, play_count) "
+			"SELECT ?, s.song_singer, SUM(p.plays) FROM " +
+			plays + " JOIN songs s ON s.id = p.song_ref GROUP BY s.song_singer"));
+		bindPlays(pstmt, user_id);
+		pstmt->executeUpdate();
+
+		pstmt.reset(guard.prepareStatement(
+			"INSERT INTO user_play_stats (user_id, total_plays) "
+			"SELECT ?, SUM(p.plays) FROM " +
+			plays + " HAVING SUM(p.plays) > 0"));
+		bindPlays(pstmt, user_id);
+		pstmt->executeUpdate();
+
+		const std::string after = fingerprint(guard, user_id);
+		tx.commit();
+		invalidate(user_id);
+
+		if (before != after) {
+			spdlog::warn("{} Stats of user {} were inconsistent: {} -> {}", TAG, user_id, before,
+						 after);
+		}
+		return before == after;
+	} catch (sql::SQLException& e) {
+		spdlog::error("{} Recompute stats of user {} failed: {}, Code: {}", TAG, user_id,
+					  e.what(), e.getErrorCode());
+		return std::nullopt;
+	}
+}
+
+StatsEngine::CheckResult StatsEngine::recomputeAll() {
+	std::vector<int> user_ids;
+	try {
+		SqlConnGuard guard(DBManager::getInstance()->getConnection());
+		PreStmtPtr pstmt(
+			guard.prepareStatement("SELECT DISTINCT user_id FROM play_history UNION "
+								   "SELECT DISTINCT user_id FROM play_history_daily UNION "
+								   "SELECT user_id FROM user_play_stats"));
+		ResultSetPtr result(pstmt->executeQuery());
+		while (result->next()) {
+			user_ids.push_back(result->getInt("user_id"));
+		}
+	} catch (sql::SQLException& e) {
+		spdlog::error("{} List users for recompute failed: {}, Code: {}", TAG, e.what(),
+					  e.getErrorCode());
+		return {};
+	}
+
+	CheckResult check;
+	for (int user_id : user_ids) {
+		{
+			std::lock_guard<std::mutex> lock(m_stop_mtx);
+			if (m_stop) break;
+		}
+
+		auto consistent = recompute(user_id);
+		if (!consistent) continue;
+		++check.users;
+		if (!*consistent) ++check.mismatched_users;
+	}
+
+	spdlog::info("{} Recomputed stats of {} users, {} inconsistent", TAG, check.users,
+				 check.mismatched_users);
+	return check;
+}
+
+void StatsEngine::recomputeLoop() {
+	std::unique_lock<std::mutex> lock(m_stop_mtx);
+	while (!m_stop_cv.wait_for(lock, m_recompute_interval, [this]() { return m_stop; })) {
+		lock.unlock();
+		recomputeAll();
+		lock.lock();
+	}
+}
@@ -0,0 +1,142 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "DBManager.h"
+#include "../models/song.h"
+
+/**
+ * @brief 播放统计引擎 单例
+ *
+ * 汇总表 user_song_stats / user_artist_stats / user_play_stats 随播放事件在同一事务中
+ * 增量更新, 是统计的持久来源. 内存中按用户缓存有界 top-K (最多 TOP_K_MAX 项), 统计接口
+ * 只读取这 K 项, 不扫描 play_history.
+ *
+ * 播放次数在两次失效之间只增不减, 一首歌只有被播放时才可能进入 top-K, 此时汇总表返回其
+ * 最新计数, 所以有界 top-K 可以增量维护. 删除/清空历史则使该用户缓存失效, 下次按需重载.
+ *
+ * 同一用户的写入与缓存加载通过分段锁串行, 避免加载与事件交错导致重复或遗漏计数.
+ */
+class StatsEngine {
+public:
+	static constexpr size_t TOP_K_MAX = 50;
+
+	struct SongCount {
+		SongMetaPtr song;
+		int count = 0;
+	};
+
+	struct ArtistCount {
+		std::string singer;
+		int count = 0;
+	};
+
+	struct UserStats {
+		int64_t total_plays = 0;
+		std::vector<SongCount> top_songs;	  // 按次数降序
+		std::vector<ArtistCount> top_artists; // 按次数降序
+	};
+
+	// 一次播放后汇总表中的最新计数
+	struct PlayCounts {
+		int song = 0;
+		int artist = 0;
+		int64_t total = 0;
+	};
+
+	struct CheckResult {
+		size_t users = 0;
+		size_t mismatched_users = 0; // 汇总表与 play_history 不一致的用户数
+	};
+
+	static void init(size_t max_users, std::chrono::hours recompute_interval);
+	static StatsEngine* getInstance();
+
+	// 停止定期重算线程, 需在 DBManager 析构前调用
+	void stop();
+
+	/**
+	 * @brief 锁定用户, 写入播放历史与调用 applyPlay/invalidate 时需持有
+	 */
+	std::unique_lock<std::mutex> lockUser(int user_id);
+
+	/**
+	 * @brief 在事务中写入播放历史并更新汇总表 (存储过程 record_play, 调用方负责提交)
+	 * @return 更新后的计数
+	 */
+	static PlayCounts recordPlay(const SqlConnGuard& guard, int user_id, const SongMeta& song);
+
+	// 事务提交后更新内存 top-K, 调用方持有 lockUser
+	void applyPlay(int user_id, const SongMetaPtr& song, const PlayCounts& counts);
+
+	// 删除/清空历史后丢弃内存统计, 调用方持有 lockUser
+	void invalidate(int user_id);
+
+	// 在调用方事务中删除用户的汇总表行 (行数以歌曲/歌手数为界), 提交后调用 invalidate
+	static void clearSummary(const SqlConnGuard& guard, int user_id);
+
+	/**
+	 * @brief 用户统计, 返回前 k 项 (k 不超过 TOP_K_MAX)
+	 * @return 查询失败返回 nullopt
+	 */
+	std::optional<UserStats> getUserStats(int user_id, size_t k);
+
+	/**
+	 * @brief 由 play_history 重算用户的汇总表, 并与重算前比较
+	 * @return 重算前是否一致; 失败返回 nullopt
+	 */
+	std::optional<bool> recompute(int user_id);
+
+	// 重算所有有播放记录的用户
+	CheckResult recomputeAll();
+
+	~StatsEngine();
+	StatsEngine(const StatsEngine&) = delete;
+	StatsEngine(StatsEngine&&) = delete;
+	StatsEngine& operator=(const StatsEngine&) = delete;
+	StatsEngine& operator=(StatsEngine&&) = delete;
+
+private:
+	StatsEngine(size_t max_users, std::chrono::hours recompute_interval);
+
+	// 调用方持有 lockUser
+	std::shared_ptr<UserStats> find(int user_id);
+	std::shared_ptr<UserStats> load(int user_id);
+
+	static void bumpSong(std::vector<SongCount>& top, const SongMetaPtr& song, int count);
+	static void bumpArtist(std::vector<ArtistCount>& top, const std::string& singer, int count);
+
+	void recomputeLoop();
+
+private:
+	static constexpr size_t LOCK_STRIPES = 64;
+
+	std::array<std::mutex, LOCK_STRIPES> m_user_locks;
+
+	// user_id → 统计, 链表头部为最近使用
+	std::list<std::pair<int, std::shared_ptr<UserStats>>> m_lru;
+	std::unordered_map<int, decltype(m_lru)::iterator> m_users;
+	size_t m_max_users;
+	std::mutex m_mtx;
+
+	std::chrono::hours m_recompute_interval;
+	std::thread m_recompute_thread;
+	std::mutex m_stop_mtx;
+	std::condition_variable m_stop_cv;
+	bool m_stop = false;
+
+	static std::unique_ptr<StatsEngine> m_instance;
+};
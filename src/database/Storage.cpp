@@ -0,0 +1,44 @@
+#include "Storage.h"
+
+#include <stdexcept>
+
+std::unique_ptr<Storage> Storage::m_instance = nullptr;
+
+Storage::Storage(Backend backend) : m_backend(backend) {
+	if (backend == Backend::Memory) m_memory = std::make_unique<MemoryStore>();
+}
+
+std::optional<Storage::Backend> Storage::parseBackend(std::string_view name) {
+	if (name == "mysql") return Backend::MySQL;
+	if (name == "memory") return Backend::Memory;
+	return std::nullopt;
+}
+
+void Storage::init(Backend backend) {
+	if (!m_instance) {
+		m_instance.reset(new Storage(backend));
+	}
+}
+
+Storage* Storage::getInstance() {
+	if (!m_instance) {
+		throw std::runtime_error("Storage not initialized");
+	}
+
+	return m_instance.get();
+}
+
+std::unique_ptr<UserDAO> Storage::createUserDAO() {
+	if (m_memory) return std::make_unique<MemoryUserDAO>(m_memory.get());
+	return std::make_unique<MySqlUserDAO>();
+}
+
+std::unique_ptr<PlaylistDAO> Storage::createPlaylistDAO() {
+	if (m_memory) return std::make_unique<MemoryPlaylistDAO>(m_memory.get());
+	return std::make_unique<MySqlPlaylistDAO>();
+}
+
+std::unique_ptr<PlayHistoryDAO> Storage::createPlayHistoryDAO() {
+	if (m_memory) return std::make_unique<MemoryPlayHistoryDAO>(m_memory.get());
+	return std::make_unique<MySqlPlayHistoryDAO>();
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+
+#include "MemoryStore.h"
+#include "PlayHistoryDAO.h"
+#include "PlaylistDAO.h"
+#include "UserDAO.h"
+
+/**
+ * @brief 存储后端 单例, 按配置 database.backend 创建各 DAO
+ *
+ * mysql 为生产后端; memory 把数据保存在进程内, 不依赖数据库, 用于测试与基准测试.
+ * DAO 对象本身很轻, 每个处理器持有自己的一份, 数据由后端共享.
+ */
+class Storage {
+public:
+	enum class Backend : uint8_t { MySQL, Memory };
+
+	static std::optional<Backend> parseBackend(std::string_view name);
+
+	// MySQL 后端需先初始化 DBManager/UserCache/StatsEngine, 两种后端都需先初始化 PlaylistCache
+	static void init(Backend backend);
+	static Storage* getInstance();
+
+	Backend backend() const { return m_backend; }
+
+	std::unique_ptr<UserDAO> createUserDAO();
+	std::unique_ptr<PlaylistDAO> createPlaylistDAO();
+	std::unique_ptr<PlayHistoryDAO> createPlayHistoryDAO();
+
+	~Storage() = default;
+	Storage(const Storage&) = delete;
+	Storage(Storage&&) = delete;
+	Storage& operator=(const Storage&) = delete;
+	Storage& operator=(Storage&&) = delete;
+
+private:
+	explicit Storage(Backend backend);
+
+private:
+	Backend m_backend;
+	std::unique_ptr<MemoryStore> m_memory; // 仅 memory 后端
+
+	static std::unique_ptr<Storage> m_instance;
+};
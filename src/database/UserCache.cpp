@@ -0,0 +1,186 @@
+#include "UserCache.h"
+
+#include <mutex>
+#include <stdexcept>
+
+std::unique_ptr<UserCache> UserCache::m_instance = nullptr;
+
+namespace {
+
+// 每个分片写入这么多次后清理一次过期条目
+constexpr size_t SWEEP_INTERVAL = 1024;
+
+// 删除过期条目, 返回删除数
+template <typename Map, typename TimePoint>
+size_t sweep(Map& map, TimePoint now) {
+	size_t erased = 0;
+	for (auto it = map.begin(); it != map.end();) {
+		if (it->second.expire_at <= now) {
+			it = map.erase(it);
+			++erased;
+		} else {
+			++it;
+		}
+	}
+	return erased;
+}
+
+MetricCounter& lookupCounter(const char* result) {
+	return MetricsRegistry::getInstance()->counter("user_cache_lookups_total",
+												   "User cache lookups by result",
+												   {{"result", result}});
+}
+
+} // namespace
+
+UserCache::UserCache(std::chrono::seconds ttl, std::chrono::seconds negative_ttl, size_t shards)
+	: m_shards(shards > 0 ? shards : 1), m_ttl(ttl), m_negative_ttl(negative_ttl),
+	  m_hits(lookupCounter("hit")), m_negative_hits(lookupCounter("negative_hit")),
+	  m_misses(lookupCounter("miss")),
+	  m_evictions(MetricsRegistry::getInstance()->counter(
+		  "user_cache_evictions_total", "Expired user cache entries swept")) {}
+
+void UserCache::init(std::chrono::seconds ttl, std::chrono::seconds negative_ttl, size_t shards) {
+	if (!m_instance) {
+		m_instance.reset(new UserCache(ttl, negative_ttl, shards));
+	}
+}
+
+UserCache* UserCache::getInstance() {
+	if (!m_instance) {
+		throw std::runtime_error("UserCache not initialized");
+	}
+
+	return m_instance.get();
+}
+
+UserCache::Lookup UserCache::getById(int id) {
+	Shard& shard = shardOf(id);
+	std::shared_lock<std::shared_mutex> lock(shard.mtx);
+	auto it = shard.users.find(id);
+	if (it == shard.users.end() || it->second.expire_at <= Clock::now()) {
+		return record(std::nullopt);
+	}
+	return record(it->second.user);
+}
+
+UserCache::Lookup UserCache::getByUsername(const std::string& username) {
+	return record(getByKey(username, false));
+}
+
+UserCache::Lookup UserCache::getByEmail(const std::string& email) {
+	return record(getByKey(email, true));
+}
+
+UserCache::Lookup UserCache::getByKey(const std::string& key, bool by_email) {
+	int id = 0;
+	{
+		Shard& shard = shardOf(key);
+		std::shared_lock<std::shared_mutex> lock(shard.mtx);
+		auto& index = by_email ? shard.emails : shard.usernames;
+		auto it = index.find(key);
+		if (it == index.end() || it->second.expire_at <= Clock::now()) return std::nullopt;
+		if (it->second.id == 0) return UserPtr{};
+		id = it->second.id;
+	}
+
+	Shard& shard = shardOf(id);
+	std::shared_lock<std::shared_mutex> lock(shard.mtx);
+	auto it = shard.users.find(id);
+	if (it == shard.users.end() || it->second.expire_at <= Clock::now() || !it->second.user) {
+		return std::nullopt;
+	}
+
+	// 用户已改名/改邮箱, 索引过时
+	const User& user = *it->second.user;
+	if ((by_email ? user.email : user.username) != key) return std::nullopt;
+
+	return it->second.user;
+}
+
+void UserCache::put(const User& user, uint64_t version) {
+	auto ptr = std::make_shared<const User>(user);
+	{
+		Shard& shard = shardOf(user.id);
+		std::unique_lock<std::shared_mutex> lock(shard.mtx);
+		if (shard.invalidated_at > version) return;
+		auto now = Clock::now();
+		shard.users[user.id] = UserEntry{ptr, now + m_ttl};
+		if (shard.users.size() % SWEEP_INTERVAL == 0) m_evictions.inc(sweep(shard.users, now));
+	}
+
+	putKey(user.username, false, user.id, m_ttl, version);
+	if (!user.email.empty()) putKey(user.email, true, user.id, m_ttl, version);
+}
+
+void UserCache::putMissingId(int id, uint64_t version) {
+	Shard& shard = shardOf(id);
+	std::unique_lock<std::shared_mutex> lock(shard.mtx);
+	if (shard.invalidated_at > version) return;
+	shard.users[id] = UserEntry{nullptr, Clock::now() + m_negative_ttl};
+}
+
+void UserCache::putMissingUsername(const std::string& username, uint64_t version) {
+	putKey(username, false, 0, m_negative_ttl, version);
+}
+
+void UserCache::putMissingEmail(const std::string& email, uint64_t version) {
+	putKey(email, true, 0, m_negative_ttl, version);
+}
+
+void UserCache::putKey(const std::string& key, bool by_email, int id, Clock::duration ttl,
+					   uint64_t version) {
+	Shard& shard = shardOf(key);
+	std::unique_lock<std::shared_mutex> lock(shard.mtx);
+	if (shard.invalidated_at > version) return;
+	auto& index = by_email ? shard.emails : shard.usernames;
+	auto now = Clock::now();
+	index[key] = KeyEntry{id, now + ttl};
+	if (index.size() % SWEEP_INTERVAL == 0) m_evictions.inc(sweep(index, now));
+}
+
+void UserCache::invalidate(int id) {
+	Shard& shard = shardOf(id);
+	std::unique_lock<std::shared_mutex> lock(shard.mtx);
+	markInvalidated(shard);
+	shard.users.erase(id);
+}
+
+void UserCache::invalidateKeys(const std::string& username, const std::string& email) {
+	if (!username.empty()) {
+		Shard& shard = shardOf(username);
+		std::unique_lock<std::shared_mutex> lock(shard.mtx);
+		markInvalidated(shard);
+		shard.usernames.erase(username);
+	}
+	if (!email.empty()) {
+		Shard& shard = shardOf(email);
+		std::unique_lock<std::shared_mutex> lock(shard.mtx);
+		markInvalidated(shard);
+		shard.emails.erase(email);
+	}
+}
+
+UserCache::Lookup UserCache::record(const Lookup& result) {
+	if (!result)
+		m_misses.inc();
+	else if (*result)
+		m_hits.inc();
+	else
+		m_negative_hits.inc();
+	return result;
+}
+
+UserCache::Stats UserCache::stats() const {
+	Stats stats;
+	stats.hits = m_hits.value();
+	stats.negative_hits = m_negative_hits.value();
+	stats.misses = m_misses.value();
+	stats.evictions = m_evictions.value();
+
+	for (const auto& shard : m_shards) {
+		std::shared_lock<std::shared_mutex> lock(shard.mtx);
+		stats.entries += shard.users.size();
+	}
+	return stats;
+}
@@ -0,0 +1,134 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../models/user.h"
+#include "../utils/Metrics.h"
+
+/**
+ * @brief 用户行缓存 单例
+ *
+ * 按 id 分片存放 User, username / email 索引只记录到 id 的映射, 查找时校验一致,
+ * 因此改名后的旧索引不会返回错误数据. "不存在" 的结果以较短 TTL 缓存.
+ * 命中/未命中与过期清理的条目数导出到 /metrics (user_cache_lookups_total{result},
+ * user_cache_evictions_total).
+ */
+class UserCache {
+public:
+	using UserPtr = std::shared_ptr<const User>;
+
+	struct Stats {
+		uint64_t hits = 0;
+		uint64_t negative_hits = 0; // 命中 "不存在"
+		uint64_t misses = 0;
+		uint64_t evictions = 0; // 过期后被清理的条目
+		uint64_t entries = 0;
+
+		double hitRate() const {
+			uint64_t total = hits + negative_hits + misses;
+			return total == 0 ? 0.0 : static_cast<double>(hits + negative_hits) / total;
+		}
+	};
+
+	/**
+	 * @brief 查找结果
+	 * - nullopt: 未缓存, 需查库
+	 * - nullptr: 已确认不存在
+	 */
+	using Lookup = std::optional<UserPtr>;
+
+	static void init(std::chrono::seconds ttl, std::chrono::seconds negative_ttl, size_t shards);
+	static UserCache* getInstance();
+
+	Lookup getById(int id);
+	Lookup getByUsername(const std::string& username);
+	Lookup getByEmail(const std::string& email);
+
+	/**
+	 * @brief 查库前取得的版本号
+	 *
+	 * 每次失效从全局序号取一个新值记在所在分片上; 回填时目标分片的失效序号大于该版本,
+	 * 说明查库期间该分片有写入, 放弃回填以免缓存旧数据. 其他分片的写入不影响回填.
+	 */
+	uint64_t version() const { return m_clock.load(std::memory_order_acquire); }
+
+	// 缓存查库结果
+	void put(const User& user, uint64_t version);
+	void putMissingId(int id, uint64_t version);
+	void putMissingUsername(const std::string& username, uint64_t version);
+	void putMissingEmail(const std::string& email, uint64_t version);
+
+	// 用户数据变更后失效, 同时清除对应 username/email 的 "不存在" 记录
+	void invalidate(int id);
+	void invalidateKeys(const std::string& username, const std::string& email);
+
+	Stats stats() const;
+
+	~UserCache() = default;
+	UserCache(const UserCache&) = delete;
+	UserCache(UserCache&&) = delete;
+	UserCache& operator=(const UserCache&) = delete;
+	UserCache& operator=(UserCache&&) = delete;
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	struct UserEntry {
+		UserPtr user; // nullptr 表示不存在
+		Clock::time_point expire_at;
+	};
+
+	struct KeyEntry {
+		int id = 0; // 0 表示不存在
+		Clock::time_point expire_at;
+	};
+
+	struct Shard {
+		mutable std::shared_mutex mtx;
+		std::unordered_map<int, UserEntry> users;
+		std::unordered_map<std::string, KeyEntry> usernames;
+		std::unordered_map<std::string, KeyEntry> emails;
+		uint64_t invalidated_at = 0; // 最近一次失效的序号, 持有 mtx 访问
+	};
+
+	UserCache(std::chrono::seconds ttl, std::chrono::seconds negative_ttl, size_t shards);
+
+	Shard& shardOf(int id) { return m_shards[static_cast<size_t>(id) % m_shards.size()]; }
+	Shard& shardOf(const std::string& key) {
+		return m_shards[std::hash<std::string>{}(key) % m_shards.size()];
+	}
+
+	// 按二级索引查找, by_email 选择 email 索引
+	Lookup getByKey(const std::string& key, bool by_email);
+	void putKey(const std::string& key, bool by_email, int id, Clock::duration ttl,
+				uint64_t version);
+
+	Lookup record(const Lookup& result);
+
+	// 调用方持有 shard.mtx 写锁
+	void markInvalidated(Shard& shard) {
+		shard.invalidated_at = m_clock.fetch_add(1, std::memory_order_acq_rel) + 1;
+	}
+
+private:
+	std::vector<Shard> m_shards;
+	Clock::duration m_ttl;
+	Clock::duration m_negative_ttl;
+
+	std::atomic<uint64_t> m_clock{0}; // 失效序号
+
+	MetricCounter& m_hits;
+	MetricCounter& m_negative_hits;
+	MetricCounter& m_misses;
+	MetricCounter& m_evictions;
+
+	static std::unique_ptr<UserCache> m_instance;
+};
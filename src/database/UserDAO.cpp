@@ -1,55 +1,85 @@
 #include "UserDAO.h"
 #include "../utils/PasswordUtil.h"
 #include "DBManager.h"
+#include "DeletionJobs.h"
+#include "PlaylistCache.h"
+#include "StatsEngine.h"
 #include "jdbc/cppconn/datatype.h"
 #include "jdbc/cppconn/exception.h"
 
 #include <jdbc/cppconn/prepared_statement.h>
 #include <spdlog/spdlog.h>
 #include <optional>
+#include <vector>
 
 constexpr const char* TAG = "[UserDAO]";
 
-UserDAO::UserDAO() : db_manager{DBManager::getInstance()} {}
+// 列序与 buildFromResultSet 一致
+constexpr const char* SELECT_USERS =
+	"SELECT id, username, passwd_hash, email, qq_id, netease_id, UNIX_TIMESTAMP(create_at), "
+	"UNIX_TIMESTAMP(update_at) FROM users WHERE deleted_at IS NULL ";
+const std::string SELECT_USER_BY_ID = std::string(SELECT_USERS) + "AND id = ?";
+const std::string SELECT_USER_BY_USERNAME = std::string(SELECT_USERS) + "AND username = ?";
+const std::string SELECT_USER_BY_EMAIL = std::string(SELECT_USERS) + "AND email = ?";
 
-bool UserDAO::createUser(User& user) {
+bool UserDAO::verifyPassword(const std::string& username, const std::string& password) {
+	auto user = getUserByUsername(username);
+	return user && PasswordUtil::verifyPassword(password, user->passwd_hash);
+}
+
+MySqlUserDAO::MySqlUserDAO()
+	: db_manager{DBManager::getInstance()}, user_cache{UserCache::getInstance()} {}
+
+DAOStatus MySqlUserDAO::createUser(User& user) {
 	try {
 		std::string hashed_passwd = PasswordUtil::hashPassword(user.passwd_hash);
 
 		SqlConnGuard guard(db_manager->getConnection());
 
-		PreStmtPtr pstmt(guard->prepareStatement(
-			"INSERT INTO users (username, passwd_hash, email) VALUES (?, ?, ?)"));
+		// 用户名/邮箱唯一性由唯一键保证, 插入与取回 id 一次往返
+		PreStmtPtr pstmt(guard.prepareStatement("CALL create_user(?, ?, ?)"));
 		pstmt->setString(1, user.username);
 		pstmt->setString(2, hashed_passwd);
 		pstmt->setString(3, user.email);
-		pstmt->executeUpdate();
 
-		StmtPtr stmt(guard->createStatement());
-		ResultSetPtr result(stmt->executeQuery("SELECT LAST_INSERT_ID() AS id"));
-		if (result->next()) {
-			user.id = result->getInt("id");
-			return true;
-		}
+		ResultSetPtr result(pstmt->executeQuery());
+		if (result->next()) user.id = result->getInt(1);
+		result.reset();
+		finishCall(pstmt);
+		if (user.id <= 0) return DAOStatus::Error;
 
-		return false;
+		// 清除注册前缓存的 "不存在"
+		user_cache->invalidateKeys(user.username, user.email);
+		return DAOStatus::Ok;
 	} catch (sql::SQLException& e) {
-		spdlog::error("{} Create User Failed: {}, Code:{}", TAG, e.what(), e.getErrorCode());
-		return false;
+		DAOStatus status = toDAOStatus(e);
+		if (status != DAOStatus::Conflict) {
+			spdlog::error("{} Create User Failed: {}, Code:{}", TAG, e.what(), e.getErrorCode());
+		}
+		return status;
 	}
 }
 
-std::optional<User> UserDAO::getUserById(int id) {
+std::optional<User> MySqlUserDAO::getUserById(int id) {
+	if (auto cached = user_cache->getById(id)) {
+		if (*cached) return **cached;
+		return std::nullopt;
+	}
+
 	try {
+		uint64_t version = user_cache->version();
 		SqlConnGuard guard(db_manager->getConnection());
-		PreStmtPtr pstmt(guard->prepareStatement("SELECT * FROM users WHERE id = ?"));
+		PreStmtPtr pstmt(guard.prepareStatement(SELECT_USER_BY_ID));
 		pstmt->setInt(1, id);
 
 		ResultSetPtr result(pstmt->executeQuery());
 		if (result->next()) {
-			return buildFromResultSet(result);
+			User user = buildFromResultSet(result);
+			user_cache->put(user, version);
+			return user;
 		}
 
+		user_cache->putMissingId(id, version);
 		return std::nullopt;
 	} catch (sql::SQLException& e) {
 		spdlog::error("{} Get User By ID Failed: {}, Code:{}", TAG, e.what(), e.getErrorCode());
@@ -57,29 +87,65 @@ std::optional<User> UserDAO::getUserById(int id) {
 	}
 }
 
-std::optional<User> UserDAO::getUserByUsername(const std::string& username) {
+std::optional<User> MySqlUserDAO::getUserByUsername(const std::string& username) {
+	if (auto cached = user_cache->getByUsername(username)) {
+		if (*cached) return **cached;
+		return std::nullopt;
+	}
+
+	uint64_t version = user_cache->version();
+	std::optional<User> user;
+	if (!queryUser(SELECT_USER_BY_USERNAME, username, user)) return std::nullopt;
+
+	if (user)
+		user_cache->put(*user, version);
+	else
+		user_cache->putMissingUsername(username, version);
+
+	return user;
+}
+
+std::optional<User> MySqlUserDAO::getUserByEmail(const std::string& email) {
+	if (auto cached = user_cache->getByEmail(email)) {
+		if (*cached) return **cached;
+		return std::nullopt;
+	}
+
+	uint64_t version = user_cache->version();
+	std::optional<User> user;
+	if (!queryUser(SELECT_USER_BY_EMAIL, email, user)) return std::nullopt;
+
+	if (user)
+		user_cache->put(*user, version);
+	else
+		user_cache->putMissingEmail(email, version);
+
+	return user;
+}
+
+bool MySqlUserDAO::queryUser(const std::string& sql, const std::string& value,
+							 std::optional<User>& user) {
 	try {
 		SqlConnGuard guard(db_manager->getConnection());
-		PreStmtPtr pstmt(guard->prepareStatement("SELECT * FROM users WHERE username = ?"));
-		pstmt->setString(1, username);
+		PreStmtPtr pstmt(guard.prepareStatement(sql));
+		pstmt->setString(1, value);
 
 		ResultSetPtr result(pstmt->executeQuery());
 		if (result->next()) {
-			return buildFromResultSet(result);
+			user = buildFromResultSet(result);
 		}
 
-		return std::nullopt;
+		return true;
 	} catch (sql::SQLException& e) {
-		spdlog::error("{} Get User By Username Failed: {}, Code:{}", TAG, e.what(),
-					  e.getErrorCode());
-		return std::nullopt;
+		spdlog::error("{} Query User Failed: {}, Code:{}", TAG, e.what(), e.getErrorCode());
+		return false;
 	}
 }
 
-bool UserDAO::updateUser(const User& user) {
+bool MySqlUserDAO::updateUser(const User& user) {
 	try {
 		SqlConnGuard guard(db_manager->getConnection());
-		PreStmtPtr pstmt(guard->prepareStatement(
+		PreStmtPtr pstmt(guard.prepareStatement(
 			"UPDATE users SET username = ?, email = ?, qq_id = ?, netease_id = ? WHERE id = ?"));
 
 		pstmt->setString(1, user.username);
@@ -98,6 +164,8 @@ bool UserDAO::updateUser(const User& user) {
 		pstmt->setInt(5, user.id);
 		int affected_row = pstmt->executeUpdate();
 
+		user_cache->invalidate(user.id);
+		user_cache->invalidateKeys(user.username, user.email);
 		return affected_row > 0;
 	} catch (const sql::SQLException& e) {
 		spdlog::error("{} Update User Failed: {}, Code: {}", TAG, e.what(), e.getErrorCode());
@@ -105,28 +173,62 @@ bool UserDAO::updateUser(const User& user) {
 	}
 }
 
-bool UserDAO::deleteUser(int id) {
+std::optional<int> MySqlUserDAO::deleteUser(int id) {
+	StatsEngine* stats_engine = StatsEngine::getInstance();
+	auto user_lock = stats_engine->lockUser(id);
 	try {
 		SqlConnGuard guard(db_manager->getConnection());
-		PreStmtPtr pstmt(guard->prepareStatement("DELETE FROM users WHERE id = ?"));
+		SqlTransaction tx(guard);
+
+		PreStmtPtr pstmt(guard.prepareStatement(
+			"SELECT username, email FROM users WHERE id = ? AND deleted_at IS NULL FOR UPDATE"));
 		pstmt->setInt(1, id);
-		int affected_row = pstmt->executeUpdate();
+		ResultSetPtr result(pstmt->executeQuery());
+		if (!result->next()) return std::nullopt;
 
-		return affected_row > 0;
+		const std::string username = result->getString(1);
+		const std::string email = result->getString(2);
+
+		// 标记注销并隐藏播放历史, 级联删除改由后台任务分批完成
+		pstmt.reset(guard.prepareStatement(
+			"UPDATE users SET deleted_at = CURRENT_TIMESTAMP WHERE id = ?"));
+		pstmt->setInt(1, id);
+		pstmt->executeUpdate();
+
+		DeletionJobs::hideHistory(guard, id);
+		StatsEngine::clearSummary(guard, id);
+		const int job_id = DeletionJobs::enqueue(guard, DeletionJobs::Kind::User, id);
+
+		// 歌单数量很少, 一并取出以丢弃缓存的歌单内容
+		pstmt.reset(guard.prepareStatement("SELECT id FROM playlists WHERE user_id = ?"));
+		pstmt->setInt(1, id);
+		result.reset(pstmt->executeQuery());
+		std::vector<int> playlist_ids;
+		while (result->next()) playlist_ids.push_back(result->getInt(1));
+
+		tx.commit();
+
+		user_cache->invalidate(id);
+		user_cache->invalidateKeys(username, email);
+		stats_engine->invalidate(id);
+		for (int playlist_id : playlist_ids) PlaylistCache::getInstance()->erase(playlist_id);
+		DeletionJobs::getInstance()->notify();
+		return job_id;
 	} catch (const sql::SQLException& e) {
 		spdlog::error("{} Delete User Failed: {}, Code:{}", TAG, e.what(), e.getErrorCode());
-		return false;
+		return std::nullopt;
 	}
 }
 
-bool UserDAO::updatePassword(int user_id, const std::string& new_password) {
+bool MySqlUserDAO::updatePassword(int user_id, const std::string& new_password) {
 	try {
 		SqlConnGuard guard(db_manager->getConnection());
-		PreStmtPtr pstmt(guard->prepareStatement("UPDATE users SET passwd_hash = ? WHERE id = ?"));
+		PreStmtPtr pstmt(guard.prepareStatement("UPDATE users SET passwd_hash = ? WHERE id = ?"));
 		pstmt->setString(1, PasswordUtil::hashPassword(new_password));
 		pstmt->setInt(2, user_id);
 		pstmt->executeUpdate();
 
+		user_cache->invalidate(user_id);
 		return true;
 	} catch (const sql::SQLException& e) {
 		spdlog::error("{} Update Password Failed: {}, Code:{}", TAG, e.what(), e.getErrorCode());
@@ -134,14 +236,15 @@ bool UserDAO::updatePassword(int user_id, const std::string& new_password) {
 	}
 }
 
-bool UserDAO::updateQQId(int user_id, const std::string& qq_id) {
+bool MySqlUserDAO::updateQQId(int user_id, const std::string& qq_id) {
 	try {
 		SqlConnGuard guard(db_manager->getConnection());
-		PreStmtPtr pstmt(guard->prepareStatement("UPDATE users SET qq_id = ? WHERE id = ?"));
+		PreStmtPtr pstmt(guard.prepareStatement("UPDATE users SET qq_id = ? WHERE id = ?"));
 		pstmt->setString(1, qq_id);
 		pstmt->setInt(2, user_id);
 		pstmt->executeUpdate();
 
+		user_cache->invalidate(user_id);
 		return true;
 	} catch (const sql::SQLException& e) {
 		spdlog::error("{} Update QQ ID Failed: {}, Code: {}", TAG, e.what(), e.getErrorCode());
@@ -149,14 +252,15 @@ bool UserDAO::updateQQId(int user_id, const std::string& qq_id) {
 	}
 }
 
-bool UserDAO::updateNetEaseId(int user_id, const std::string& netease_id) {
+bool MySqlUserDAO::updateNetEaseId(int user_id, const std::string& netease_id) {
 	try {
 		SqlConnGuard guard(db_manager->getConnection());
-		PreStmtPtr pstmt(guard->prepareStatement("UPDATE users SET netease_id = ? WHERE id = ?"));
+		PreStmtPtr pstmt(guard.prepareStatement("UPDATE users SET netease_id = ? WHERE id = ?"));
 		pstmt->setString(1, netease_id);
 		pstmt->setInt(2, user_id);
 		pstmt->executeUpdate();
 
+		user_cache->invalidate(user_id);
 		return true;
 	} catch (const sql::SQLException& e) {
 		spdlog::error("{} Update NetEase ID Failed: {}, Code: {}", TAG, e.what(), e.getErrorCode());
@@ -164,21 +268,16 @@ bool UserDAO::updateNetEaseId(int user_id, const std::string& netease_id) {
 	}
 }
 
-User UserDAO::buildFromResultSet(const ResultSetPtr& result) {
+User MySqlUserDAO::buildFromResultSet(const ResultSetPtr& result) {
 	User user;
-	user.id = result->getInt("id");
-	user.username = result->getString("username");
-	user.passwd_hash = result->getString("passwd_hash");
-	user.email = result->getString("email");
-	user.create_at = result->getString("create_at");
-	user.update_at = result->getString("update_at");
-
-	if (!result->isNull("qq_id")) {
-		user.qq_id = result->getString("qq_id");
-	}
-	if (!result->isNull("netease_id")) {
-		user.netease_id = result->getString("netease_id");
-	}
+	user.id = result->getInt(1);
+	user.username = result->getString(2);
+	user.passwd_hash = result->getString(3);
+	user.email = result->getString(4);
+	if (!result->isNull(5)) user.qq_id = result->getString(5);
+	if (!result->isNull(6)) user.netease_id = result->getString(6);
+	user.create_at = result->getInt64(7);
+	user.update_at = result->getInt64(8);
 
 	return user;
 }
@@ -3,38 +3,79 @@
 #include <string>
 
 #include "../models/user.h"
+#include "DAOStatus.h"
 #include "DBManager.h"
+#include "UserCache.h"
 
 /**
- * @brief 用户数据访问对象
+ * @brief 用户数据访问接口, 实现由 Storage 按配置的后端创建
  */
 class UserDAO {
 public:
-	UserDAO();
+	virtual ~UserDAO() = default;
 
 	/**
 	 * @brief 创建用户(username, email, passwd)
+	 * @return 用户名或邮箱已存在时返回 Conflict
 	 */
-	bool createUser(User& user);
-	std::optional<User> getUserById(int id);
-	std::optional<User> getUserByUsername(const std::string& username);
+	virtual DAOStatus createUser(User& user) = 0;
+	virtual std::optional<User> getUserById(int id) = 0;
+	virtual std::optional<User> getUserByUsername(const std::string& username) = 0;
+	virtual std::optional<User> getUserByEmail(const std::string& email) = 0;
 
 	/**
 	 * @brief 更新 username, email, qq_id, netease_id
 	 */
-	bool updateUser(const User& user);
-	bool deleteUser(int id);
+	virtual bool updateUser(const User& user) = 0;
 
-	// 用户登录/修改密码
-	bool verifyPassword(const std::string& username_or_email, const std::string& password);
-	bool updatePassword(int user_id, const std::string& new_password);
+	/**
+	 * @brief 注销用户: 立即不可见, 歌单/播放历史等随后删除
+	 * @return 删除任务ID, 用户不存在或失败返回 nullopt
+	 */
+	virtual std::optional<int> deleteUser(int id) = 0;
+
+	// 修改密码
+	virtual bool updatePassword(int user_id, const std::string& new_password) = 0;
 
 	// 关联QQ/NetEase
-	bool updateQQId(int user_id, const std::string& qq_id);
-	bool updateNetEaseId(int user_id, const std::string& netease_id);
+	virtual bool updateQQId(int user_id, const std::string& qq_id) = 0;
+	virtual bool updateNetEaseId(int user_id, const std::string& netease_id) = 0;
+
+	// 用户登录/修改密码: 按用户名查找, 再校验密码哈希
+	bool verifyPassword(const std::string& username, const std::string& password);
+};
+
+/**
+ * @brief MySQL 实现
+ *
+ * 查询先读 UserCache, 未命中再查库并回填; 写操作成功后使缓存失效.
+ * 注销只做标记, 歌单/播放历史等由 DeletionJobs 分批删除后再删除用户行. 标记之后播放与歌单
+ * 的写入一律拒绝 (1452, 对应 NotFound), 与 memory 后端一致.
+ */
+class MySqlUserDAO : public UserDAO {
+public:
+	MySqlUserDAO();
+
+	DAOStatus createUser(User& user) override;
+	std::optional<User> getUserById(int id) override;
+	std::optional<User> getUserByUsername(const std::string& username) override;
+	std::optional<User> getUserByEmail(const std::string& email) override;
+	bool updateUser(const User& user) override;
+	std::optional<int> deleteUser(int id) override;
+	bool updatePassword(int user_id, const std::string& new_password) override;
+	bool updateQQId(int user_id, const std::string& qq_id) override;
+	bool updateNetEaseId(int user_id, const std::string& netease_id) override;
+
+	// 结果集当前行映射为用户 (列序见 SELECT_USERS), 不访问数据库
+	static User buildFromResultSet(const ResultSetPtr& result);
 
 private:
 	DBManager* db_manager;
+	UserCache* user_cache;
 
-	static User buildFromResultSet(const ResultSetPtr& result);
-};
\ No newline at end of file
+	/**
+	 * @brief 按单列条件查询一个用户
+	 * @return 查询是否成功, 失败时不应缓存为 "不存在"
+	 */
+	bool queryUser(const std::string& sql, const std::string& value, std::optional<User>& user);
+};
@@ -0,0 +1,153 @@
+#include "AdminHandler.h"
+#include "../database/SqlStatement.h"
+#include "../utils/HttpUtil.h"
+#include "../utils/JsonUtil.h"
+#include "../utils/Profiler.h"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <utility>
+
+constexpr const char* TAG = "[AdminHandler]";
+
+namespace {
+
+// 比较耗时与不匹配的位置无关
+bool tokenEquals(beast::string_view given, const std::string& expected) {
+	if (given.size() != expected.size()) return false;
+
+	unsigned char diff = 0;
+	for (size_t i = 0; i < expected.size(); ++i) {
+		diff |= static_cast<unsigned char>(given[i] ^ expected[i]);
+	}
+	return diff == 0;
+}
+
+} // namespace
+
+AdminHandler::AdminHandler(std::string admin_token) : m_admin_token{std::move(admin_token)} {}
+
+HttpResponse AdminHandler::handleSqlStats(const HttpRequest& req) {
+	try {
+		if (auto error = checkToken(req)) return std::move(*error);
+
+		const std::string sort = HttpUtil::getQueryParam(req.target(), "sort").value_or("total");
+		size_t limit = 50;
+		if (auto param = HttpUtil::getQueryParam(req.target(), "limit")) {
+			limit = static_cast<size_t>(std::clamp(std::atoi(param->c_str()), 1, 1000));
+		}
+
+		SqlStats* stats = SqlStats::getInstance();
+		json response = {{"code", 200},
+						 {"message", "SQL statement stats retrieved"},
+						 {"slow_query_ms", stats->slowThreshold().count() / 1000.0},
+						 {"statements", stats->toJson(sort, limit)}};
+		return JsonUtil::buildSuccessResponse(req.version(), JsonUtil::dump(response));
+	} catch (const std::exception& e) {
+		spdlog::error("{} Exception in {}: {}", TAG, __FUNCTION__, e.what());
+		return JsonUtil::buildErrorResponse(http::status::internal_server_error, req.version(),
+											"Internal server error");
+	}
+}
+
+HttpResponse AdminHandler::handleSqlExplain(const HttpRequest& req) {
+	try {
+		if (auto error = checkToken(req)) return std::move(*error);
+
+		json body = json::parse(req.body(), nullptr, false);
+		if (body.is_discarded() || !body.contains("id") || !body["id"].is_string()) {
+			return JsonUtil::buildErrorResponse(http::status::bad_request, req.version(),
+												"Statement id is required");
+		}
+
+		const std::string id = body["id"].get<std::string>();
+		if (!SqlStats::getInstance()->requestExplain(id)) {
+			return JsonUtil::buildErrorResponse(http::status::not_found, req.version(),
+												"Unknown statement or EXPLAIN not supported");
+		}
+
+		spdlog::info("{} EXPLAIN requested for statement {}", TAG, id);
+		json response = {{"code", 202},
+						 {"message", "EXPLAIN will be captured on the next execution"},
+						 {"id", id}};
+		auto res = JsonUtil::buildSuccessResponse(req.version(), JsonUtil::dump(response));
+		res.result(http::status::accepted);
+		return res;
+	} catch (const std::exception& e) {
+		spdlog::error("{} Exception in {}: {}", TAG, __FUNCTION__, e.what());
+		return JsonUtil::buildErrorResponse(http::status::internal_server_error, req.version(),
+											"Internal server error");
+	}
+}
+
+HttpResponse AdminHandler::handleCpuProfile(const HttpRequest& req) {
+	try {
+		if (auto error = checkToken(req)) return std::move(*error);
+
+		int seconds = 10;
+		int hz = 99; // 与常见定时任务的频率错开
+		if (auto param = HttpUtil::getQueryParam(req.target(), "seconds")) {
+			seconds = std::atoi(param->c_str());
+		}
+		if (auto param = HttpUtil::getQueryParam(req.target(), "hz")) {
+			hz = std::atoi(param->c_str());
+		}
+
+		auto folded = Profiler::getInstance()->profileCpu(std::chrono::seconds(seconds), hz);
+		if (!folded) {
+			return JsonUtil::buildErrorResponse(http::status::conflict, req.version(),
+												"Another CPU profile is running");
+		}
+
+		HttpResponse res{http::status::ok, req.version()};
+		res.set(http::field::server, "MusicPlayer-BackEnd");
+		res.set(http::field::content_type, "text/plain; charset=utf-8");
+		res.set(http::field::cache_control, "no-store");
+		res.body() = std::move(*folded);
+		res.prepare_payload();
+		return res;
+	} catch (const std::exception& e) {
+		spdlog::error("{} Exception in {}: {}", TAG, __FUNCTION__, e.what());
+		return JsonUtil::buildErrorResponse(http::status::internal_server_error, req.version(),
+											"Internal server error");
+	}
+}
+
+HttpResponse AdminHandler::handleHeapProfile(const HttpRequest& req) {
+	try {
+		if (auto error = checkToken(req)) return std::move(*error);
+
+		auto snapshot = Profiler::getInstance()->heapSnapshot();
+		if (!snapshot) {
+			return JsonUtil::buildErrorResponse(http::status::not_implemented, req.version(),
+												"Heap profiling not available");
+		}
+
+		HttpResponse res{http::status::ok, req.version()};
+		res.set(http::field::server, "MusicPlayer-BackEnd");
+		res.set(http::field::content_type, snapshot->content_type);
+		res.set(http::field::cache_control, "no-store");
+		res.body() = std::move(snapshot->body);
+		res.prepare_payload();
+		return res;
+	} catch (const std::exception& e) {
+		spdlog::error("{} Exception in {}: {}", TAG, __FUNCTION__, e.what());
+		return JsonUtil::buildErrorResponse(http::status::internal_server_error, req.version(),
+											"Internal server error");
+	}
+}
+
+std::optional<HttpResponse> AdminHandler::checkToken(const HttpRequest& req) const {
+	if (m_admin_token.empty()) {
+		return JsonUtil::buildErrorResponse(http::status::forbidden, req.version(),
+											"Admin API disabled");
+	}
+	if (!tokenEquals(req["X-Admin-Token"], m_admin_token)) {
+		return JsonUtil::buildErrorResponse(http::status::unauthorized, req.version(),
+											"Invalid admin token");
+	}
+	return std::nullopt;
+}
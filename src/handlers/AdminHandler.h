@@ -0,0 +1,47 @@
+// AdminHandler.h
+#pragma once
+#include <optional>
+#include <string>
+
+#include "../server/Router.h"
+#include "../common/net.h"
+
+/**
+ * @brief 管理接口, 请求需带 X-Admin-Token (与 server.admin_token 一致), 未配置令牌时关闭
+ */
+class AdminHandler {
+public:
+	explicit AdminHandler(std::string admin_token);
+
+	/**
+	 * @brief 按语句的 SQL 执行统计
+	 * @param req 查询参数 sort (total|mean|calls|max|errors, 默认 total), limit (默认 50)
+	 * @return 语句列表, 含调用数、行数、耗时分位数与已捕获的执行计划
+	 */
+	HttpResponse handleSqlStats(const HttpRequest& req);
+
+	/**
+	 * @brief 请求捕获语句的执行计划, 在该语句下一次执行时以相同参数 EXPLAIN
+	 * @param req 请求体 {"id": 语句 id}
+	 */
+	HttpResponse handleSqlExplain(const HttpRequest& req);
+
+	/**
+	 * @brief 进程内 CPU 采样, 阻塞当前工作线程直到采样结束
+	 * @param req 查询参数 seconds (默认 10, 最多 60), hz (默认 99)
+	 * @return folded 调用栈 (text/plain), 可直接生成火焰图; 已有采样进行中时 409
+	 */
+	HttpResponse handleCpuProfile(const HttpRequest& req);
+
+	/**
+	 * @brief 堆快照: jemalloc prof.dump, 或 glibc malloc_info; 都不可用时 501
+	 */
+	HttpResponse handleHeapProfile(const HttpRequest& req);
+
+private:
+	// 未授权时返回错误响应
+	std::optional<HttpResponse> checkToken(const HttpRequest& req) const;
+
+private:
+	std::string m_admin_token;
+};
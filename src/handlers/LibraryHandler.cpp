@@ -0,0 +1,113 @@
+#include "LibraryHandler.h"
+#include "../database/DeletionJobs.h"
+#include "../database/LibraryDAO.h"
+#include "../utils/JsonUtil.h"
+
+#include <jdbc/cppconn/exception.h>
+#include <spdlog/spdlog.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+
+constexpr const char* TAG = "[LibraryHandler]";
+
+LibraryHandler::LibraryHandler(const std::string& jwt_secret) : jwt_util{jwt_secret} {}
+
+RouteResponse LibraryHandler::handleExport(const HttpRequest& req) {
+	try {
+		int user_id = 0;
+		if (!extractUserIdFromToken(req, user_id)) {
+			return JsonUtil::buildErrorResponse(http::status::unauthorized, req.version(),
+												"Invalid token");
+		}
+
+		HttpResponse res{http::status::ok, req.version()};
+		res.set(http::field::server, "MusicPlayer-BackEnd");
+		res.set(http::field::content_type, "application/x-ndjson");
+		res.set(http::field::content_disposition,
+				"attachment; filename=\"library-" + std::to_string(user_id) + ".ndjson\"");
+		res.set(http::field::cache_control, "no-store");
+
+		// 响应头发出后无法再返回错误状态, 查询失败由 Session 中断连接, 客户端收不到结束块
+		auto exporter = std::make_shared<LibraryExport>(user_id);
+		RouteResponse reply(std::move(res));
+		reply.stream = [exporter, user_id](std::string& chunk) {
+			try {
+				return exporter->next(chunk);
+			} catch (const sql::SQLException& e) {
+				spdlog::error("{} Export of user {} failed: {} (code: {})", TAG, user_id, e.what(),
+							  e.getErrorCode());
+				throw;
+			}
+		};
+		return reply;
+	} catch (const std::exception& e) {
+		spdlog::error("{} Exception in {}: {}", TAG, __FUNCTION__, e.what());
+		return JsonUtil::buildErrorResponse(http::status::internal_server_error, req.version(),
+											"Internal server error");
+	}
+}
+
+HttpResponse LibraryHandler::handleImport(const HttpRequest& req, const std::string& body_file) {
+	try {
+		int user_id = 0;
+		if (!extractUserIdFromToken(req, user_id)) {
+			return JsonUtil::buildErrorResponse(http::status::unauthorized, req.version(),
+												"Invalid token");
+		}
+
+		// 清空/注销任务未完成时, 合并写入可能落到待删除的记录上
+		if (DeletionJobs::hasPending(user_id)) {
+			return JsonUtil::buildErrorResponse(http::status::conflict, req.version(),
+												"Deletion in progress, retry later");
+		}
+
+		std::ifstream body(body_file, std::ios::binary);
+		if (!body) {
+			return JsonUtil::buildErrorResponse(http::status::internal_server_error, req.version(),
+												"Failed to read request body");
+		}
+
+		// 逐行解析, 内存占用只与一行及写入缓冲有关
+		LibraryImport importer(user_id);
+		std::string line;
+		while (std::getline(body, line)) {
+			if (line.empty() || line == "\r") continue;
+
+			json j = json::parse(line, nullptr, false);
+			if (j.is_discarded() || !j.is_object()) {
+				importer.add(json::object());
+				continue;
+			}
+			importer.add(j);
+		}
+		importer.finish();
+
+		const LibraryImport::Summary& summary = importer.summary();
+		json data = {{"playlists", summary.playlists},
+					 {"playlist_songs", summary.playlist_songs},
+					 {"history", summary.history},
+					 {"skipped", summary.skipped}};
+		return JsonUtil::buildSuccessResponse(
+			req.version(),
+			json{{"code", 200}, {"message", "Library imported"}, {"data", data}}.dump());
+	} catch (const sql::SQLException& e) {
+		spdlog::error("{} SQL error in {}: {} (code: {})", TAG, __FUNCTION__, e.what(),
+					  e.getErrorCode());
+		return JsonUtil::buildErrorResponse(http::status::internal_server_error, req.version(),
+											"Import interrupted, partially imported");
+	} catch (const std::exception& e) {
+		spdlog::error("{} Exception in {}: {}", TAG, __FUNCTION__, e.what());
+		return JsonUtil::buildErrorResponse(http::status::internal_server_error, req.version(),
+											"Internal server error");
+	}
+}
+
+bool LibraryHandler::extractUserIdFromToken(const HttpRequest& req, int& user_id) {
+	const std::string token = jwt_util.verifyToken(std::string(req["Authorization"]));
+	if (token.empty()) return false;
+
+	user_id = atoi(JWTUtil::getClaim(token, "id").c_str());
+	return user_id > 0;
+}
@@ -0,0 +1,35 @@
+// LibraryHandler.h
+#pragma once
+#include <cstdint>
+#include <string>
+
+#include "../server/Router.h"
+#include "../utils/JWTUtil.h"
+#include "../common/net.h"
+
+class LibraryHandler {
+public:
+	// 导入请求体上限, 请求体落盘, 不占内存
+	static constexpr uint64_t IMPORT_BODY_LIMIT = 1024ULL * 1024 * 1024;
+
+	LibraryHandler(const std::string& jwt_secret);
+
+	/**
+	 * @brief 导出当前用户的曲库(资料, 歌单及歌曲, 播放历史)
+	 * @return NDJSON 流式响应, chunked 编码, 逐页查询
+	 */
+	RouteResponse handleExport(const HttpRequest& req);
+
+	/**
+	 * @brief 从 NDJSON 请求体导入曲库, 歌单新建, 播放历史与已有记录合并
+	 * @param body_file 落盘的请求体
+	 * @return 各类记录的导入条数与跳过行数
+	 */
+	HttpResponse handleImport(const HttpRequest& req, const std::string& body_file);
+
+private:
+	JWTUtil jwt_util;
+
+	// 从请求中提取用户ID
+	bool extractUserIdFromToken(const HttpRequest& req, int& user_id);
+};
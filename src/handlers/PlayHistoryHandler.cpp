@@ -0,0 +1,253 @@
+#include "PlayHistoryHandler.h"
+#include "../database/DeletionJobs.h"
+#include "../database/Storage.h"
+#include "../utils/JsonUtil.h"
+#include "../utils/HttpUtil.h"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <string>
+
+constexpr const char* TAG = "[HistoryHandler]";
+
+HistoryHandler::HistoryHandler(const std::string& jwt_secret)
+	: history_dao{Storage::getInstance()->createPlayHistoryDAO()}, jwt_util{jwt_secret} {}
+
+HttpResponse HistoryHandler::handleAddHistory(const HttpRequest& req) {
+	try {
+		int user_id = 0;
+		if (!extractUserIdFromToken(req, user_id)) {
+			return JsonUtil::buildErrorResponse(http::status::unauthorized, req.version(),
+												"Invalid token");
+		}
+
+		json j = JsonUtil::parse(req.body());
+		if (!j.contains("song_id") || !j.contains("where")) {
+			return JsonUtil::buildErrorResponse(http::status::bad_request, req.version(),
+												"Missing song_id or where");
+		}
+
+		auto where = parseSongSource(j["where"].get<std::string>());
+		if (!where) {
+			return JsonUtil::buildErrorResponse(http::status::bad_request, req.version(),
+												"Invalid where");
+		}
+
+		SongMeta meta;
+		meta.song_id = j["song_id"];
+		meta.where = *where;
+		meta.name = j.value("name", "");
+		meta.singer = j.value("singer", "");
+		meta.pic = j.value("pic", "");
+
+		PlayHistory history;
+		history.user_id = user_id;
+		history.song = std::make_shared<const SongMeta>(std::move(meta));
+
+		if (!history_dao->addPlayHistory(history)) {
+			return JsonUtil::buildErrorResponse(http::status::internal_server_error, req.version(),
+												"Failed to add history");
+		}
+
+		return JsonUtil::buildSuccessResponse(
+			req.version(), json{{"code", 200}, {"message", "Song added to history"}}.dump());
+	} catch (const json::exception& e) {
+		spdlog::error("{} JSON parse error in {}: {}", TAG, __FUNCTION__, e.what());
+		return JsonUtil::buildErrorResponse(http::status::bad_request, req.version(),
+											"Invalid JSON format");
+	} catch (const std::exception& e) {
+		spdlog::error("{} Exception in {}: {}", TAG, __FUNCTION__, e.what());
+		return JsonUtil::buildErrorResponse(http::status::internal_server_error, req.version(),
+											"Internal server error");
+	}
+}
+
+HttpResponse HistoryHandler::handleGetHistory(const HttpRequest& req) {
+	try {
+		int user_id = 0;
+		if (!extractUserIdFromToken(req, user_id)) {
+			return JsonUtil::buildErrorResponse(http::status::unauthorized, req.version(),
+												"Invalid token");
+		}
+
+		int limit =
+			static_cast<int>(std::clamp<int64_t>(extractIntParam(req, "limit", 50), 1, 200));
+		int offset = static_cast<int>(std::clamp<int64_t>(extractIntParam(req, "offset", 0), 0,
+														  std::numeric_limits<int>::max()));
+
+		json history = json::array();
+		for (const auto& item : history_dao->getUserPlayHistory(user_id, limit, offset)) {
+			history.push_back({{"id", item.id},
+							   {"song_id", item.song->song_id},
+							   {"name", item.song->name},
+							   {"singer", item.song->singer},
+							   {"pic", item.song->pic},
+							   {"where", toString(item.song->where)},
+							   {"count", item.song_count},
+							   {"played_at", JsonUtil::formatTimestamp(item.played_at)}});
+		}
+
+		json response = {{"code", 200},
+						 {"message", "All songs in history retrieved"},
+						 {"history", std::move(history)}};
+		return JsonUtil::buildSuccessResponse(req.version(), JsonUtil::dump(response));
+	} catch (const std::exception& e) {
+		spdlog::error("{} Exception in {}: {}", TAG, __FUNCTION__, e.what());
+		return JsonUtil::buildErrorResponse(http::status::internal_server_error, req.version(),
+											"Internal server error");
+	}
+}
+
+HttpResponse HistoryHandler::handleDeleteHistory(const HttpRequest& req) {
+	try {
+		int user_id = 0;
+		if (!extractUserIdFromToken(req, user_id)) {
+			return JsonUtil::buildErrorResponse(http::status::unauthorized, req.version(),
+												"Invalid token");
+		}
+
+		int64_t history_id = extractIntParam(req, "history_id", 0);
+		if (history_id <= 0) {
+			return JsonUtil::buildErrorResponse(http::status::bad_request, req.version(),
+												"Missing history_id");
+		}
+
+		if (!history_dao->deletePlayHistory(history_id, user_id)) {
+			return JsonUtil::buildErrorResponse(http::status::not_found, req.version(),
+												"History not found");
+		}
+
+		return JsonUtil::buildSuccessResponse(
+			req.version(), json{{"code", 200}, {"message", "Song removed from history"}}.dump());
+	} catch (const std::exception& e) {
+		spdlog::error("{} Exception in {}: {}", TAG, __FUNCTION__, e.what());
+		return JsonUtil::buildErrorResponse(http::status::internal_server_error, req.version(),
+											"Internal server error");
+	}
+}
+
+HttpResponse HistoryHandler::handleClearHistory(const HttpRequest& req) {
+	try {
+		int user_id = 0;
+		if (!extractUserIdFromToken(req, user_id)) {
+			return JsonUtil::buildErrorResponse(http::status::unauthorized, req.version(),
+												"Invalid token");
+		}
+
+		auto job_id = history_dao->clearUserPlayHistory(user_id);
+		if (!job_id) {
+			return JsonUtil::buildErrorResponse(http::status::internal_server_error, req.version(),
+												"Failed to clear history");
+		}
+
+		// 历史已不可见, 实际删除由后台任务完成, 进度见 /history/clear/status
+		json response = {{"code", 200}, {"message", "History cleared"}, {"job_id", *job_id}};
+		return JsonUtil::buildSuccessResponse(req.version(), JsonUtil::dump(response));
+	} catch (const std::exception& e) {
+		spdlog::error("{} Exception in {}: {}", TAG, __FUNCTION__, e.what());
+		return JsonUtil::buildErrorResponse(http::status::internal_server_error, req.version(),
+											"Internal server error");
+	}
+}
+
+HttpResponse HistoryHandler::handleGetClearStatus(const HttpRequest& req) {
+	try {
+		int user_id = 0;
+		if (!extractUserIdFromToken(req, user_id)) {
+			return JsonUtil::buildErrorResponse(http::status::unauthorized, req.version(),
+												"Invalid token");
+		}
+
+		const int job_id = static_cast<int>(extractIntParam(req, "job_id", 0));
+		auto job = history_dao->getClearJob(job_id, user_id);
+		if (!job) {
+			return JsonUtil::buildErrorResponse(http::status::not_found, req.version(),
+												"Job not found");
+		}
+
+		json response = {{"code", 200},
+						 {"message", "Clear job retrieved"},
+						 {"job_id", job->id},
+						 {"state", DeletionJobs::toString(job->state)},
+						 {"deleted_rows", job->deleted_rows},
+						 {"create_at", JsonUtil::formatTimestamp(job->created_at)},
+						 {"update_at", JsonUtil::formatTimestamp(job->updated_at)}};
+		return JsonUtil::buildSuccessResponse(req.version(), JsonUtil::dump(response));
+	} catch (const std::exception& e) {
+		spdlog::error("{} Exception in {}: {}", TAG, __FUNCTION__, e.what());
+		return JsonUtil::buildErrorResponse(http::status::internal_server_error, req.version(),
+											"Internal server error");
+	}
+}
+
+HttpResponse HistoryHandler::handleGetStats(const HttpRequest& req) {
+	try {
+		int user_id = 0;
+		if (!extractUserIdFromToken(req, user_id)) {
+			return JsonUtil::buildErrorResponse(http::status::unauthorized, req.version(),
+												"Invalid token");
+		}
+
+		int limit = static_cast<int>(std::clamp<int64_t>(
+			extractIntParam(req, "limit", 10), 1, static_cast<int64_t>(StatsEngine::TOP_K_MAX)));
+
+		auto stats = history_dao->getUserStats(user_id, limit);
+		if (!stats) {
+			return JsonUtil::buildErrorResponse(http::status::internal_server_error, req.version(),
+												"Failed to get stats");
+		}
+
+		json top_songs = json::array();
+		for (const auto& item : stats->top_songs) {
+			top_songs.push_back({{"song_id", item.song->song_id},
+								 {"name", item.song->name},
+								 {"singer", item.song->singer},
+								 {"pic", item.song->pic},
+								 {"where", toString(item.song->where)},
+								 {"count", item.count}});
+		}
+
+		json top_artists = json::array();
+		for (const auto& item : stats->top_artists) {
+			top_artists.push_back({{"singer", item.singer}, {"count", item.count}});
+		}
+
+		json response = {{"code", 200},
+						 {"message", "Most played songs retrieved"},
+						 {"total_plays", stats->total_plays},
+						 {"top_songs", std::move(top_songs)},
+						 {"top_artists", std::move(top_artists)}};
+		return JsonUtil::buildSuccessResponse(req.version(), JsonUtil::dump(response));
+	} catch (const std::exception& e) {
+		spdlog::error("{} Exception in {}: {}", TAG, __FUNCTION__, e.what());
+		return JsonUtil::buildErrorResponse(http::status::internal_server_error, req.version(),
+											"Internal server error");
+	}
+}
+
+bool HistoryHandler::extractUserIdFromToken(const HttpRequest& req, int& user_id) {
+	const std::string token = jwt_util.verifyToken(std::string(req["Authorization"]));
+	if (token.empty()) return false;
+
+	user_id = atoi(JWTUtil::getClaim(token, "id").c_str());
+	return user_id > 0;
+}
+
+int64_t HistoryHandler::extractIntParam(const HttpRequest& req, const std::string& name,
+										int64_t default_value) {
+	if (auto param = HttpUtil::getQueryParam(req.target(), name)) {
+		return atoll(param->c_str());
+	}
+
+	if (req.body().empty()) return default_value;
+
+	json j = json::parse(req.body(), nullptr, false);
+	if (j.is_discarded() || !j.contains(name) || !j[name].is_number_integer())
+		return default_value;
+
+	return j[name].get<int64_t>();
+}
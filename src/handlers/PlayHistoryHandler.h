@@ -1,29 +1,47 @@
 // HistoryHandler.h
 #pragma once
-// #include "../database/PlayHistoryDAO.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "../database/PlayHistoryDAO.h"
 #include "../utils/JWTUtil.h"
 #include "../common/net.h"
 
-// class HistoryHandler {
-// public:
-// 	HistoryHandler(const std::string& jwt_secret);
+class HistoryHandler {
+public:
+	HistoryHandler(const std::string& jwt_secret);
+
+	// 记录播放历史
+	HttpResponse handleAddHistory(const HttpRequest& req);
+
+	// 获取播放历史(limit/offset 分页)
+	HttpResponse handleGetHistory(const HttpRequest& req);
+
+	// 删除单条播放历史
+	HttpResponse handleDeleteHistory(const HttpRequest& req);
 
-// 	// 记录播放历史
-// 	HttpResponse handleAddHistory(const HttpRequest& req);
+	// 清空播放历史, 立即返回后台删除任务ID
+	HttpResponse handleClearHistory(const HttpRequest& req);
 
-// 	// 获取播放历史
-// 	HttpResponse handleGetHistory(const HttpRequest& req);
+	// 清空任务进度(查询参数 job_id)
+	HttpResponse handleGetClearStatus(const HttpRequest& req);
 
-// 	// 清空播放历史
-// 	HttpResponse handleClearHistory(const HttpRequest& req);
+	/**
+	 * @brief 获取播放统计(总次数, 最常听的歌曲与歌手), 只读取增量维护的 top-K
+	 * @param req HTTP请求(查询参数 limit, 默认 10)
+	 * @return HTTP响应
+	 */
+	HttpResponse handleGetStats(const HttpRequest& req);
 
-// 	// 获取播放统计
-// 	HttpResponse handleGetStats(const HttpRequest& req);
+private:
+	std::unique_ptr<PlayHistoryDAO> history_dao;
+	JWTUtil jwt_util;
 
-// private:
-// 	PlayHistoryDAO history_dao;
-// 	JWTUtil jwt_util;
+	// 从请求中提取用户ID
+	bool extractUserIdFromToken(const HttpRequest& req, int& user_id);
 
-// 	// 从请求中提取用户ID
-// 	bool extractUserIdFromToken(const HttpRequest& req, int& user_id);
-// };
\ No newline at end of file
+	// 查询参数或 JSON 请求体中的整数, 缺省返回 default_value
+	static int64_t extractIntParam(const HttpRequest& req, const std::string& name,
+								   int64_t default_value);
+};
@@ -0,0 +1,584 @@
+#include "PlaylistHandler.h"
+#include "../database/Storage.h"
+#include "../utils/JsonUtil.h"
+#include "../utils/HttpUtil.h"
+
+#include <spdlog/spdlog.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+
+constexpr const char* TAG = "[PlaylistHandler]";
+
+PlaylistHandler::PlaylistHandler(const std::string& jwt_secret)
+	: playlist_dao{Storage::getInstance()->createPlaylistDAO()}, jwt_util{jwt_secret} {}
+
+HttpResponse PlaylistHandler::handleCreatePlaylist(const HttpRequest& req) {
+	try {
+		int user_id = 0;
+		if (!extractUserIdFromToken(req, user_id)) {
+			return JsonUtil::buildErrorResponse(http::status::unauthorized, req.version(),
+												"Invalid token");
+		}
+
+		json j = JsonUtil::parse(req.body());
+		if (!j.contains("name") || !j["name"].is_string()) {
+			return JsonUtil::buildErrorResponse(http::status::bad_request, req.version(),
+												"Missing playlist name");
+		}
+
+		Playlist playlist;
+		playlist.user_id = user_id;
+		playlist.name = j["name"];
+		playlist.cover = j.value("cover", "");
+
+		DAOStatus status = playlist_dao->createPlaylist(playlist);
+		if (status == DAOStatus::NotFound) {
+			return JsonUtil::buildErrorResponse(http::status::not_found, req.version(),
+												"User not found");
+		}
+		if (status != DAOStatus::Ok) {
+			return JsonUtil::buildErrorResponse(http::status::internal_server_error, req.version(),
+												"Failed to create playlist");
+		}
+
+		json response = {{"code", 200},
+						 {"message", "Playlist created successfully"},
+						 {"playlist_id", playlist.id}};
+		return JsonUtil::buildSuccessResponse(req.version(), JsonUtil::dump(response));
+	} catch (const json::exception& e) {
+		spdlog::error("{} JSON parse error in {}: {}", TAG, __FUNCTION__, e.what());
+		return JsonUtil::buildErrorResponse(http::status::bad_request, req.version(),
+											"Invalid JSON format");
+	} catch (const std::exception& e) {
+		spdlog::error("{} Exception in {}: {}", TAG, __FUNCTION__, e.what());
+		return JsonUtil::buildErrorResponse(http::status::internal_server_error, req.version(),
+											"Internal server error");
+	}
+}
+
+HttpResponse PlaylistHandler::handleGetPlaylists(const HttpRequest& req) {
+	try {
+		int user_id = 0;
+		if (!extractUserIdFromToken(req, user_id)) {
+			return JsonUtil::buildErrorResponse(http::status::unauthorized, req.version(),
+												"Invalid token");
+		}
+
+		json playlists = json::array();
+		for (const auto& playlist : playlist_dao->getPlaylistsByUserId(user_id)) {
+			playlists.push_back(playlistToJson(playlist));
+		}
+
+		json response = {{"code", 200},
+						 {"message", "Playlists retrieved successfully"},
+						 {"playlists", std::move(playlists)}};
+		return JsonUtil::buildSuccessResponse(req.version(), JsonUtil::dump(response));
+	} catch (const std::exception& e) {
+		spdlog::error("{} Exception in {}: {}", TAG, __FUNCTION__, e.what());
+		return JsonUtil::buildErrorResponse(http::status::internal_server_error, req.version(),
+											"Internal server error");
+	}
+}
+
+HttpResponse PlaylistHandler::handleGetPlaylistById(const HttpRequest& req) {
+	try {
+		int user_id = 0;
+		if (!extractUserIdFromToken(req, user_id)) {
+			return JsonUtil::buildErrorResponse(http::status::unauthorized, req.version(),
+												"Invalid token");
+		}
+
+		auto playlist_id = extractPlaylistId(req);
+		if (!playlist_id) {
+			return JsonUtil::buildErrorResponse(http::status::bad_request, req.version(),
+												"Missing playlist_id");
+		}
+
+		auto snapshot = playlist_dao->getPlaylistSnapshot(*playlist_id);
+		if (!snapshot || snapshot->playlist->user_id != user_id) {
+			return JsonUtil::buildErrorResponse(http::status::not_found, req.version(),
+												"Playlist not found");
+		}
+
+		json playlist = playlistToJson(*snapshot->playlist);
+		playlist["song_count"] = snapshot->songs->size();
+
+		json response = {{"code", 200},
+						 {"message", "Playlist retrieved successfully"},
+						 {"playlist", std::move(playlist)}};
+		return JsonUtil::buildSuccessResponse(req.version(), JsonUtil::dump(response));
+	} catch (const std::exception& e) {
+		spdlog::error("{} Exception in {}: {}", TAG, __FUNCTION__, e.what());
+		return JsonUtil::buildErrorResponse(http::status::internal_server_error, req.version(),
+											"Internal server error");
+	}
+}
+
+HttpResponse PlaylistHandler::handleUpdatePlaylist(const HttpRequest& req) {
+	try {
+		int user_id = 0;
+		if (!extractUserIdFromToken(req, user_id)) {
+			return JsonUtil::buildErrorResponse(http::status::unauthorized, req.version(),
+												"Invalid token");
+		}
+
+		json j = JsonUtil::parse(req.body());
+		auto playlist_id = extractPlaylistId(req);
+		if (!playlist_id || !j.contains("name") || !j["name"].is_string()) {
+			return JsonUtil::buildErrorResponse(http::status::bad_request, req.version(),
+												"Missing playlist_id or name");
+		}
+
+		if (!verifyPlaylistOwnership(*playlist_id, user_id)) {
+			return JsonUtil::buildErrorResponse(http::status::not_found, req.version(),
+												"Playlist not found");
+		}
+
+		Playlist playlist;
+		playlist.id = *playlist_id;
+		playlist.user_id = user_id;
+		playlist.name = j["name"];
+		playlist.cover = j.value("cover", "");
+
+		if (!playlist_dao->updatePlaylist(playlist)) {
+			return JsonUtil::buildErrorResponse(http::status::internal_server_error, req.version(),
+												"Failed to update playlist");
+		}
+
+		return JsonUtil::buildSuccessResponse(
+			req.version(),
+			json{{"code", 200}, {"message", "Playlist updated successfully"}}.dump());
+	} catch (const json::exception& e) {
+		spdlog::error("{} JSON parse error in {}: {}", TAG, __FUNCTION__, e.what());
+		return JsonUtil::buildErrorResponse(http::status::bad_request, req.version(),
+											"Invalid JSON format");
+	} catch (const std::exception& e) {
+		spdlog::error("{} Exception in {}: {}", TAG, __FUNCTION__, e.what());
+		return JsonUtil::buildErrorResponse(http::status::internal_server_error, req.version(),
+											"Internal server error");
+	}
+}
+
+HttpResponse PlaylistHandler::handleDeletePlaylist(const HttpRequest& req) {
+	try {
+		int user_id = 0;
+		if (!extractUserIdFromToken(req, user_id)) {
+			return JsonUtil::buildErrorResponse(http::status::unauthorized, req.version(),
+												"Invalid token");
+		}
+
+		auto playlist_id = extractPlaylistId(req);
+		if (!playlist_id) {
+			return JsonUtil::buildErrorResponse(http::status::bad_request, req.version(),
+												"Missing playlist_id");
+		}
+
+		if (!verifyPlaylistOwnership(*playlist_id, user_id)) {
+			return JsonUtil::buildErrorResponse(http::status::not_found, req.version(),
+												"Playlist not found");
+		}
+
+		if (!playlist_dao->deletePlaylist(*playlist_id)) {
+			return JsonUtil::buildErrorResponse(http::status::internal_server_error, req.version(),
+												"Failed to delete playlist");
+		}
+
+		return JsonUtil::buildSuccessResponse(
+			req.version(),
+			json{{"code", 200}, {"message", "Playlist deleted successfully"}}.dump());
+	} catch (const std::exception& e) {
+		spdlog::error("{} Exception in {}: {}", TAG, __FUNCTION__, e.what());
+		return JsonUtil::buildErrorResponse(http::status::internal_server_error, req.version(),
+											"Internal server error");
+	}
+}
+
+HttpResponse PlaylistHandler::handleAddSongToPlaylist(const HttpRequest& req) {
+	try {
+		int user_id = 0;
+		if (!extractUserIdFromToken(req, user_id)) {
+			return JsonUtil::buildErrorResponse(http::status::unauthorized, req.version(),
+												"Invalid token");
+		}
+
+		json j = JsonUtil::parse(req.body());
+		auto playlist_id = extractPlaylistId(req);
+		if (!playlist_id || !j.contains("song") || !j["song"].is_object()) {
+			return JsonUtil::buildErrorResponse(http::status::bad_request, req.version(),
+												"Missing playlist_id or song");
+		}
+
+		const json& s = j["song"];
+		if (!s.contains("song_id") || !s.contains("where")) {
+			return JsonUtil::buildErrorResponse(http::status::bad_request, req.version(),
+												"Missing song_id or where");
+		}
+
+		if (!verifyPlaylistOwnership(*playlist_id, user_id)) {
+			return JsonUtil::buildErrorResponse(http::status::not_found, req.version(),
+												"Playlist not found");
+		}
+
+		auto where = parseSongSource(s["where"].get<std::string>());
+		if (!where) {
+			return JsonUtil::buildErrorResponse(http::status::bad_request, req.version(),
+												"Invalid where");
+		}
+
+		SongMeta meta;
+		meta.song_id = s["song_id"];
+		meta.where = *where;
+		meta.name = s.value("name", "");
+		meta.singer = s.value("singer", "");
+		meta.pic = s.value("pic", "");
+
+		Song song{};
+		song.meta = std::make_shared<const SongMeta>(std::move(meta));
+
+		DAOStatus status = playlist_dao->addSongToPlaylist(*playlist_id, song);
+		if (status == DAOStatus::Conflict) {
+			return JsonUtil::buildErrorResponse(http::status::conflict, req.version(),
+												"Song already in playlist");
+		}
+		if (status == DAOStatus::NotFound) {
+			return JsonUtil::buildErrorResponse(http::status::not_found, req.version(),
+												"Playlist not found");
+		}
+		if (status != DAOStatus::Ok) {
+			return JsonUtil::buildErrorResponse(http::status::internal_server_error, req.version(),
+												"Failed to add song to playlist");
+		}
+
+		return JsonUtil::buildSuccessResponse(
+			req.version(), json{{"code", 200}, {"message", "Song added to playlist"}}.dump());
+	} catch (const json::exception& e) {
+		spdlog::error("{} JSON parse error in {}: {}", TAG, __FUNCTION__, e.what());
+		return JsonUtil::buildErrorResponse(http::status::bad_request, req.version(),
+											"Invalid JSON format");
+	} catch (const std::exception& e) {
+		spdlog::error("{} Exception in {}: {}", TAG, __FUNCTION__, e.what());
+		return JsonUtil::buildErrorResponse(http::status::internal_server_error, req.version(),
+											"Internal server error");
+	}
+}
+
+HttpResponse PlaylistHandler::handleRemoveSongFromPlaylist(const HttpRequest& req) {
+	try {
+		int user_id = 0;
+		if (!extractUserIdFromToken(req, user_id)) {
+			return JsonUtil::buildErrorResponse(http::status::unauthorized, req.version(),
+												"Invalid token");
+		}
+
+		json j = JsonUtil::parse(req.body());
+		auto playlist_id = extractPlaylistId(req);
+		if (!playlist_id || !j.contains("song_id") || !j.contains("where")) {
+			return JsonUtil::buildErrorResponse(http::status::bad_request, req.version(),
+												"Missing playlist_id, song_id or where");
+		}
+
+		if (!verifyPlaylistOwnership(*playlist_id, user_id)) {
+			return JsonUtil::buildErrorResponse(http::status::not_found, req.version(),
+												"Playlist not found");
+		}
+
+		auto where = parseSongSource(j["where"].get<std::string>());
+		if (!where) {
+			return JsonUtil::buildErrorResponse(http::status::bad_request, req.version(),
+												"Invalid where");
+		}
+
+		const std::string song_id = j["song_id"];
+		if (!playlist_dao->removeSongFromPlaylist(*playlist_id, song_id, *where)) {
+			return JsonUtil::buildErrorResponse(http::status::not_found, req.version(),
+												"Song not in playlist");
+		}
+
+		return JsonUtil::buildSuccessResponse(
+			req.version(), json{{"code", 200}, {"message", "Song removed from playlist"}}.dump());
+	} catch (const json::exception& e) {
+		spdlog::error("{} JSON parse error in {}: {}", TAG, __FUNCTION__, e.what());
+		return JsonUtil::buildErrorResponse(http::status::bad_request, req.version(),
+											"Invalid JSON format");
+	} catch (const std::exception& e) {
+		spdlog::error("{} Exception in {}: {}", TAG, __FUNCTION__, e.what());
+		return JsonUtil::buildErrorResponse(http::status::internal_server_error, req.version(),
+											"Internal server error");
+	}
+}
+
+HttpResponse PlaylistHandler::handleAddSongsToPlaylist(const HttpRequest& req) {
+	try {
+		int user_id = 0;
+		if (!extractUserIdFromToken(req, user_id)) {
+			return JsonUtil::buildErrorResponse(http::status::unauthorized, req.version(),
+												"Invalid token");
+		}
+
+		json j = JsonUtil::parse(req.body());
+		auto playlist_id = extractPlaylistId(req);
+		if (!playlist_id || !j.contains("songs") || !j["songs"].is_array()) {
+			return JsonUtil::buildErrorResponse(http::status::bad_request, req.version(),
+												"Missing playlist_id or songs");
+		}
+		const json& items = j["songs"];
+		if (items.size() > MAX_BATCH_SONGS) {
+			return JsonUtil::buildErrorResponse(http::status::payload_too_large, req.version(),
+												"Too many songs in one batch");
+		}
+
+		if (!verifyPlaylistOwnership(*playlist_id, user_id)) {
+			return JsonUtil::buildErrorResponse(http::status::not_found, req.version(),
+												"Playlist not found");
+		}
+
+		// 无效项不提交, 其余按原顺序交给 DAO
+		std::vector<Song> songs;
+		std::vector<size_t> song_index(items.size(), SIZE_MAX);
+		for (size_t i = 0; i < items.size(); ++i) {
+			const json& s = items[i];
+			if (!s.is_object() || !s.contains("song_id") || !s["song_id"].is_string() ||
+				!s.contains("where") || !s["where"].is_string())
+				continue;
+			auto where = parseSongSource(s["where"].get<std::string>());
+			if (!where) continue;
+
+			SongMeta meta;
+			meta.song_id = s["song_id"];
+			meta.where = *where;
+			meta.name = s.value("name", "");
+			meta.singer = s.value("singer", "");
+			meta.pic = s.value("pic", "");
+
+			Song song{};
+			song.meta = std::make_shared<const SongMeta>(std::move(meta));
+			song_index[i] = songs.size();
+			songs.push_back(std::move(song));
+		}
+
+		std::vector<DAOStatus> statuses;
+		DAOStatus status = playlist_dao->addSongsToPlaylist(*playlist_id, songs, statuses);
+		if (status == DAOStatus::NotFound) {
+			return JsonUtil::buildErrorResponse(http::status::not_found, req.version(),
+												"Playlist not found");
+		}
+		if (status != DAOStatus::Ok) {
+			return JsonUtil::buildErrorResponse(http::status::internal_server_error, req.version(),
+												"Failed to add songs to playlist");
+		}
+
+		size_t added = 0;
+		json results = json::array();
+		for (size_t i = 0; i < items.size(); ++i) {
+			const char* result = "invalid";
+			if (song_index[i] != SIZE_MAX) {
+				bool ok = statuses[song_index[i]] == DAOStatus::Ok;
+				result = ok ? "added" : "exists";
+				added += ok;
+			}
+			results.push_back({{"index", i}, {"status", result}});
+		}
+
+		json response = {{"code", 200},
+						 {"message", "Songs added to playlist"},
+						 {"added", added},
+						 {"results", std::move(results)}};
+		return JsonUtil::buildSuccessResponse(req.version(), JsonUtil::dump(response));
+	} catch (const json::exception& e) {
+		spdlog::error("{} JSON parse error in {}: {}", TAG, __FUNCTION__, e.what());
+		return JsonUtil::buildErrorResponse(http::status::bad_request, req.version(),
+											"Invalid JSON format");
+	} catch (const std::exception& e) {
+		spdlog::error("{} Exception in {}: {}", TAG, __FUNCTION__, e.what());
+		return JsonUtil::buildErrorResponse(http::status::internal_server_error, req.version(),
+											"Internal server error");
+	}
+}
+
+HttpResponse PlaylistHandler::handleRemoveSongsFromPlaylist(const HttpRequest& req) {
+	try {
+		int user_id = 0;
+		if (!extractUserIdFromToken(req, user_id)) {
+			return JsonUtil::buildErrorResponse(http::status::unauthorized, req.version(),
+												"Invalid token");
+		}
+
+		json j = JsonUtil::parse(req.body());
+		auto playlist_id = extractPlaylistId(req);
+		if (!playlist_id || !j.contains("songs") || !j["songs"].is_array()) {
+			return JsonUtil::buildErrorResponse(http::status::bad_request, req.version(),
+												"Missing playlist_id or songs");
+		}
+		const json& items = j["songs"];
+		if (items.size() > MAX_BATCH_SONGS) {
+			return JsonUtil::buildErrorResponse(http::status::payload_too_large, req.version(),
+												"Too many songs in one batch");
+		}
+
+		if (!verifyPlaylistOwnership(*playlist_id, user_id)) {
+			return JsonUtil::buildErrorResponse(http::status::not_found, req.version(),
+												"Playlist not found");
+		}
+
+		std::vector<std::pair<std::string, SongSource>> keys;
+		std::vector<size_t> key_index(items.size(), SIZE_MAX);
+		for (size_t i = 0; i < items.size(); ++i) {
+			const json& s = items[i];
+			if (!s.is_object() || !s.contains("song_id") || !s["song_id"].is_string() ||
+				!s.contains("where") || !s["where"].is_string())
+				continue;
+			auto where = parseSongSource(s["where"].get<std::string>());
+			if (!where) continue;
+
+			key_index[i] = keys.size();
+			keys.emplace_back(s["song_id"].get<std::string>(), *where);
+		}
+
+		std::vector<DAOStatus> statuses;
+		DAOStatus status = playlist_dao->removeSongsFromPlaylist(*playlist_id, keys, statuses);
+		if (status == DAOStatus::NotFound) {
+			return JsonUtil::buildErrorResponse(http::status::not_found, req.version(),
+												"Playlist not found");
+		}
+		if (status != DAOStatus::Ok) {
+			return JsonUtil::buildErrorResponse(http::status::internal_server_error, req.version(),
+												"Failed to remove songs from playlist");
+		}
+
+		size_t removed = 0;
+		json results = json::array();
+		for (size_t i = 0; i < items.size(); ++i) {
+			const char* result = "invalid";
+			if (key_index[i] != SIZE_MAX) {
+				bool ok = statuses[key_index[i]] == DAOStatus::Ok;
+				result = ok ? "removed" : "not_found";
+				removed += ok;
+			}
+			results.push_back({{"index", i}, {"status", result}});
+		}
+
+		json response = {{"code", 200},
+						 {"message", "Songs removed from playlist"},
+						 {"removed", removed},
+						 {"results", std::move(results)}};
+		return JsonUtil::buildSuccessResponse(req.version(), JsonUtil::dump(response));
+	} catch (const json::exception& e) {
+		spdlog::error("{} JSON parse error in {}: {}", TAG, __FUNCTION__, e.what());
+		return JsonUtil::buildErrorResponse(http::status::bad_request, req.version(),
+											"Invalid JSON format");
+	} catch (const std::exception& e) {
+		spdlog::error("{} Exception in {}: {}", TAG, __FUNCTION__, e.what());
+		return JsonUtil::buildErrorResponse(http::status::internal_server_error, req.version(),
+											"Internal server error");
+	}
+}
+
+HttpResponse PlaylistHandler::handleGetSongsInPlaylist(const HttpRequest& req) {
+	try {
+		int user_id = 0;
+		if (!extractUserIdFromToken(req, user_id)) {
+			return JsonUtil::buildErrorResponse(http::status::unauthorized, req.version(),
+												"Invalid token");
+		}
+
+		auto playlist_id = extractPlaylistId(req);
+		if (!playlist_id) {
+			return JsonUtil::buildErrorResponse(http::status::bad_request, req.version(),
+												"Missing playlist_id");
+		}
+
+		// 缓存命中时无需访问数据库
+		auto snapshot = playlist_dao->getPlaylistSnapshot(*playlist_id);
+		if (!snapshot || snapshot->playlist->user_id != user_id) {
+			return JsonUtil::buildErrorResponse(http::status::not_found, req.version(),
+												"Playlist not found");
+		}
+
+		const std::string etag = PlaylistCache::getInstance()->etag(snapshot->version);
+		if (req.find(http::field::if_none_match) != req.end() &&
+			HttpUtil::etagMatches(req[http::field::if_none_match], etag)) {
+			HttpResponse res{http::status::not_modified, req.version()};
+			res.set(http::field::server, "MusicPlayer-BackEnd");
+			res.set(http::field::etag, etag);
+			res.set(http::field::cache_control, "private, no-cache");
+			return res;
+		}
+
+		json songs = json::array();
+		for (const auto& song : *snapshot->songs) {
+			songs.push_back(songToJson(song));
+		}
+
+		json response = {{"code", 200},
+						 {"message", "All songs in playlist retrieved"},
+						 {"playlist", playlistToJson(*snapshot->playlist)},
+						 {"version", snapshot->version},
+						 {"songs", std::move(songs)}};
+
+		HttpResponse res = JsonUtil::buildSuccessResponse(req.version(), JsonUtil::dump(response));
+		res.set(http::field::etag, etag);
+		res.set(http::field::cache_control, "private, no-cache");
+		return res;
+	} catch (const std::exception& e) {
+		spdlog::error("{} Exception in {}: {}", TAG, __FUNCTION__, e.what());
+		return JsonUtil::buildErrorResponse(http::status::internal_server_error, req.version(),
+											"Internal server error");
+	}
+}
+
+bool PlaylistHandler::extractUserIdFromToken(const HttpRequest& req, int& user_id) {
+	const std::string token = jwt_util.verifyToken(std::string(req["Authorization"]));
+	if (token.empty()) return false;
+
+	user_id = atoi(JWTUtil::getClaim(token, "id").c_str());
+	return user_id > 0;
+}
+
+bool PlaylistHandler::verifyPlaylistOwnership(int playlist_id, int user_id) {
+	// 只需歌单行: 已缓存的内容直接用, 否则单独读歌单行, 不因版本变化重新加载全部歌曲
+	if (auto cached = PlaylistCache::getInstance()->get(playlist_id)) {
+		return cached->playlist->user_id == user_id;
+	}
+	auto playlist = playlist_dao->getPlaylistById(playlist_id);
+	return playlist && playlist->user_id == user_id;
+}
+
+std::optional<int> PlaylistHandler::extractPlaylistId(const HttpRequest& req) {
+	if (auto param = HttpUtil::getQueryParam(req.target(), "playlist_id")) {
+		int id = atoi(param->c_str());
+		if (id > 0) return id;
+		return std::nullopt;
+	}
+
+	if (req.body().empty()) return std::nullopt;
+
+	json j = json::parse(req.body(), nullptr, false);
+	if (j.is_discarded() || !j.contains("playlist_id") || !j["playlist_id"].is_number_integer())
+		return std::nullopt;
+
+	int id = j["playlist_id"];
+	if (id > 0) return id;
+	return std::nullopt;
+}
+
+json PlaylistHandler::songToJson(const Song& song) {
+	const SongMeta& meta = *song.meta;
+	return json{{"song_id", meta.song_id},
+				{"name", meta.name},
+				{"singer", meta.singer},
+				{"pic", meta.pic},
+				{"where", toString(meta.where)},
+				{"added_at", JsonUtil::formatTimestamp(song.added_at)}};
+}
+
+json PlaylistHandler::playlistToJson(const Playlist& playlist) {
+	return json{{"id", playlist.id},
+				{"name", playlist.name},
+				{"cover", playlist.cover},
+				{"create_at", JsonUtil::formatTimestamp(playlist.create_at)},
+				{"update_at", JsonUtil::formatTimestamp(playlist.update_at)}};
+}
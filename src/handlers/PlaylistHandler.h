@@ -1,11 +1,17 @@
 // PlaylistHandler.h
 #pragma once
+#include <memory>
+#include <optional>
+#include <string>
+
 #include "../database/PlaylistDAO.h"
 #include "../utils/JWTUtil.h"
 #include "../common/net.h"
 
 class PlaylistHandler {
 public:
+	static constexpr size_t MAX_BATCH_SONGS = 1000;
+
 	PlaylistHandler(const std::string& jwt_secret);
 
 	// 创建歌单
@@ -29,11 +35,25 @@ public:
 	// 从歌单中删除歌曲
 	HttpResponse handleRemoveSongFromPlaylist(const HttpRequest& req);
 
-	// 获取歌单中的所有歌曲
+	/**
+	 * @brief 批量添加/移除歌曲, 请求体 {"playlist_id", "songs": [...]} (最多 MAX_BATCH_SONGS 项)
+	 * @return 按请求顺序逐项返回结果 (added/exists/invalid 或 removed/not_found/invalid)
+	 */
+	HttpResponse handleAddSongsToPlaylist(const HttpRequest& req);
+	HttpResponse handleRemoveSongsFromPlaylist(const HttpRequest& req);
+
+	/**
+	 * @brief 获取歌单中的所有歌曲
+	 * @return HTTP响应(ETag 为歌单版本号, If-None-Match 命中时返回 304)
+	 */
 	HttpResponse handleGetSongsInPlaylist(const HttpRequest& req);
 
+	// 模型 → JSON, 时间戳在此格式化
+	static json songToJson(const Song& song);
+	static json playlistToJson(const Playlist& playlist);
+
 private:
-	PlaylistDAO playlist_dao;
+	std::unique_ptr<PlaylistDAO> playlist_dao;
 	JWTUtil jwt_util;
 
 	// 从请求中提取用户ID
@@ -42,6 +62,6 @@ private:
 	// 验证用户是否有权限操作此歌单
 	bool verifyPlaylistOwnership(int playlist_id, int user_id);
 
-	// 从URL中提取ID
-	int extractIdFromPath(const std::string& path, const std::string& pattern);
+	// 从查询参数或 JSON 请求体中提取 playlist_id
+	static std::optional<int> extractPlaylistId(const HttpRequest& req);
 };
\ No newline at end of file
@@ -1,6 +1,10 @@
 #include "UserHandler.h"
+#include "../database/Storage.h"
 #include "../utils/JsonUtil.h"
 #include "../utils/PasswordUtil.h"
+#include "../utils/HttpUtil.h"
+#include "../utils/EmailUtil.h"
+#include "../storage/AvatarStore.h"
 #include "../server/VerifyService.h"
 
 #include <spdlog/spdlog.h>
@@ -8,19 +12,22 @@
 #include <chrono>
 #include <cstdlib>
 #include <string>
-#include <regex>
 #include <filesystem>
 #include <fstream>
 
+#include <fcntl.h>
+#include <unistd.h>
+
 constexpr const char* TAG = "[UserHandler]";
 
 namespace fs = std::filesystem;
 
-UserHandler::UserHandler(const std::string& jwt_secret) : jwt_util{jwt_secret} {}
+UserHandler::UserHandler(const std::string& jwt_secret)
+	: user_dao{Storage::getInstance()->createUserDAO()}, jwt_util{jwt_secret} {}
 
 HttpResponse UserHandler::handleGetVerifyCode(const HttpRequest& req) {
 	try {
-		json j = json::parse(req.body());
+		json j = JsonUtil::parse(req.body());
 		if (!j.contains("email") || !j.contains("action")) {
 			return JsonUtil::buildErrorResponse(http::status::bad_request, req.version(),
 												"Missing email or action");
@@ -28,7 +35,7 @@ HttpResponse UserHandler::handleGetVerifyCode(const HttpRequest& req) {
 
 		std::string email = j["email"];
 		std::string action = j["action"];
-		if (!isValidEmail(email)) {
+		if (!EmailUtil::isValidEmail(email)) {
 			return JsonUtil::buildErrorResponse(http::status::bad_request, req.version(),
 												"Invalid email format");
 		}
@@ -60,7 +67,7 @@ HttpResponse UserHandler::handleGetVerifyCode(const HttpRequest& req) {
 
 HttpResponse UserHandler::handleRegister(const HttpRequest& req) {
 	try {
-		json j = json::parse(req.body());
+		json j = JsonUtil::parse(req.body());
 
 		// 提取参数
 		if (!j.contains("username") || !j.contains("password") || !j.contains("email") ||
@@ -80,18 +87,17 @@ HttpResponse UserHandler::handleRegister(const HttpRequest& req) {
 												"Invalid verification code");
 		}
 
-		// 检查用户是否已存在
-		if (user_dao.getUserByUsername(username)) {
-			return JsonUtil::buildErrorResponse(http::status::conflict, req.version(),
-												"Username already exists");
-		}
-
 		User user;
 		user.username = username;
 		user.passwd_hash = password;
 		user.email = email;
 
-		if (!user_dao.createUser(user)) {
+		DAOStatus status = user_dao->createUser(user);
+		if (status == DAOStatus::Conflict) {
+			return JsonUtil::buildErrorResponse(http::status::conflict, req.version(),
+												"Username or email already exists");
+		}
+		if (status != DAOStatus::Ok) {
 			return JsonUtil::buildErrorResponse(http::status::internal_server_error, req.version(),
 												"Failed to create user");
 		}
@@ -99,7 +105,7 @@ HttpResponse UserHandler::handleRegister(const HttpRequest& req) {
 		json response = {
 			{"code", 200}, {"message", "User registered successfully"}, {"user_id", user.id}};
 
-		return JsonUtil::buildSuccessResponse(req.version(), response.dump());
+		return JsonUtil::buildSuccessResponse(req.version(), JsonUtil::dump(response));
 	} catch (const json::exception& e) {
 		spdlog::error("{} JSON parse error in {}: {}", TAG, __FUNCTION__, e.what());
 		return JsonUtil::buildErrorResponse(http::status::bad_request, req.version(),
@@ -113,7 +119,7 @@ HttpResponse UserHandler::handleRegister(const HttpRequest& req) {
 
 HttpResponse UserHandler::handleLogin(const HttpRequest& req) {
 	try {
-		json j = json::parse(req.body());
+		json j = JsonUtil::parse(req.body());
 
 		if (!j.contains("username") || !j.contains("password")) {
 			return JsonUtil::buildErrorResponse(http::status::bad_request, req.version(),
@@ -124,7 +130,7 @@ HttpResponse UserHandler::handleLogin(const HttpRequest& req) {
 		std::string password = j["password"];
 
 		// 检查用户是否存在
-		auto user = user_dao.getUserByUsername(username);
+		auto user = user_dao->getUserByUsername(username);
 		if (!user) {
 			return JsonUtil::buildErrorResponse(http::status::not_found, req.version(),
 												"User not found");
@@ -149,7 +155,7 @@ HttpResponse UserHandler::handleLogin(const HttpRequest& req) {
                 {"id", user->id},
                 {"username", user->username},
                 {"email", user->email},
-                {"create_at", user->create_at},
+                {"create_at", JsonUtil::formatTimestamp(user->create_at)},
                 {"qq_id", user->qq_id},
                 {"netease_id", user->netease_id}
             }}
@@ -182,7 +188,7 @@ HttpResponse UserHandler::handleGetProfile(const HttpRequest& req) {
 
 		int user_id = atoi(JWTUtil::getClaim(token, "id").c_str());
 
-		auto user = user_dao.getUserById(user_id);
+		auto user = user_dao->getUserById(user_id);
 		if (!user) {
 			return JsonUtil::buildErrorResponse(http::status::not_found, req.version(),
 												"User not found");
@@ -195,13 +201,13 @@ HttpResponse UserHandler::handleGetProfile(const HttpRequest& req) {
 				{"id", user->id},
 				{"username", user->username},
 				{"email", user->email},
-				{"create_at", user->create_at},
+				{"create_at", JsonUtil::formatTimestamp(user->create_at)},
 				{"qq_id", user->qq_id},
 				{"netease_id", user->netease_id}
 			}}
 		};
 
-		return JsonUtil::buildSuccessResponse(req.version(), response.dump());
+		return JsonUtil::buildSuccessResponse(req.version(), JsonUtil::dump(response));
 	} catch (const json::exception& e) {
 		spdlog::error("{} JSON parse error in {}: {}", TAG, __FUNCTION__, e.what());
 		return JsonUtil::buildErrorResponse(http::status::bad_request, req.version(),
@@ -214,7 +220,7 @@ HttpResponse UserHandler::handleGetProfile(const HttpRequest& req) {
 	
 }
 
-HttpResponse UserHandler::handleUpdateAvatar(const HttpRequest& req) {
+HttpResponse UserHandler::handleUpdateAvatar(const HttpRequest& req, const std::string& body_file) {
 	try {
 		const std::string token = this->jwt_util.verifyToken( req["Authorization"]);
 		if (token.empty()) {
@@ -222,34 +228,31 @@ HttpResponse UserHandler::handleUpdateAvatar(const HttpRequest& req) {
 												"Invalid token");
 		}
 
-		json j = json::parse(req.body());
+		// 直接从落盘的请求体解析, 避免请求体与 JSON 各占一份内存
+		std::ifstream body(body_file, std::ios::binary);
+		if (!body) {
+			return JsonUtil::buildErrorResponse(http::status::internal_server_error, req.version(),
+												"Failed to read request body");
+		}
+
+		json j = json::parse(body);
 		if (!j.contains("avatar_data")) {
 			return JsonUtil::buildErrorResponse(http::status::bad_request, req.version(),
 												"Missing avatar_data");
 		}
 
 		std::string avatar_data = j["avatar_data"];
-		if (avatar_data.size() > 1024 * 1024) {
+		if (avatar_data.size() > AVATAR_MAX_SIZE) {
 			return JsonUtil::buildErrorResponse(http::status::bad_request, req.version(),
 												"Avatar data requires not more than 1MB");
 		}
 
 		int user_id = atoi(JWTUtil::getClaim(token, "id").c_str());
 
-		// 创建用户头像目录
-		if (!fs::exists(UserHandler::AVATAR_PATH)) {
-			fs::create_directory(UserHandler::AVATAR_PATH);
-		}
-
-		std::string avatar_path = UserHandler::AVATAR_PATH + "/" + std::to_string(user_id);
-
-		std::ofstream avatar_file(avatar_path, std::ios::binary);
-		if (!avatar_file) {
+		if (!AvatarStore::getInstance()->putData(user_id, avatar_data)) {
 			return JsonUtil::buildErrorResponse(http::status::internal_server_error, req.version(),
 												"Failed to save avatar");
 		}
-		avatar_file << avatar_data;
-		avatar_file.close();
 
 		return JsonUtil::buildSuccessResponse(req.version(),
 											  json{{"code", 200}, {"message", "Avatar updated successfully"}}.dump());	
@@ -274,27 +277,33 @@ HttpResponse UserHandler::handleGetAvatar(const HttpRequest& req) {
 		}
 
 		int user_id = atoi(JWTUtil::getClaim(token, "id").c_str());
-		std::string avatar_path = UserHandler::AVATAR_PATH + "/" + std::to_string(user_id);
-		if (!fs::exists(avatar_path)) {
+		AvatarStore* store = AvatarStore::getInstance();
+		auto info = store->getInfo(user_id);
+		if (!info) {
 			return JsonUtil::buildErrorResponse(http::status::not_found, req.version(),
 												"Avatar not found");
 		}
 
-		std::ifstream avatar_file(avatar_path, std::ios::binary);
-		if (!avatar_file) {
-			return JsonUtil::buildErrorResponse(http::status::internal_server_error, req.version(),
-												"Failed to read avatar");
+		std::string avatar_data;
+		if (auto blob = store->getBlob(info->hash)) {
+			avatar_data = *blob;
+		} else {
+			std::ifstream avatar_file(store->blobPath(info->hash), std::ios::binary);
+			if (!avatar_file) {
+				return JsonUtil::buildErrorResponse(http::status::internal_server_error,
+													req.version(), "Failed to read avatar");
+			}
+			avatar_data.assign(std::istreambuf_iterator<char>(avatar_file),
+							   std::istreambuf_iterator<char>());
 		}
-		std::string avatar_data((std::istreambuf_iterator<char>(avatar_file)),
-								std::istreambuf_iterator<char>());
-		avatar_file.close();
+
 		json response = {
 			{"code", 200},
 			{"message", "Avatar retrieved successfully"},
 			{"avatar_data", avatar_data}
 		};
 
-		return JsonUtil::buildSuccessResponse(req.version(), response.dump());
+		return JsonUtil::buildSuccessResponse(req.version(), JsonUtil::dump(response));
 	} catch (const json::exception& e) {
 		spdlog::error("{} JSON parse error in {}: {}", TAG, __FUNCTION__, e.what());
 		return JsonUtil::buildErrorResponse(http::status::bad_request, req.version(),
@@ -307,9 +316,150 @@ HttpResponse UserHandler::handleGetAvatar(const HttpRequest& req) {
 }
 
 
+HttpResponse UserHandler::handlePutAvatar(const HttpRequest& req, const std::string& body_file) {
+	try {
+		const std::string token = this->jwt_util.verifyToken(std::string(req["Authorization"]));
+		if (token.empty()) {
+			return JsonUtil::buildErrorResponse(http::status::unauthorized, req.version(),
+												"Invalid token");
+		}
+
+		std::error_code ec;
+		auto size = fs::file_size(body_file, ec);
+		if (ec || size == 0) {
+			return JsonUtil::buildErrorResponse(http::status::bad_request, req.version(),
+												"Missing avatar data");
+		}
+		if (size > AVATAR_MAX_SIZE) {
+			return JsonUtil::buildErrorResponse(http::status::payload_too_large, req.version(),
+												"Avatar data requires not more than 1MB");
+		}
+
+		int user_id = atoi(JWTUtil::getClaim(token, "id").c_str());
+		// 请求体文件直接移动到 blob 目录(内容已存在时丢弃)
+		if (!AvatarStore::getInstance()->putFile(user_id, body_file)) {
+			return JsonUtil::buildErrorResponse(http::status::internal_server_error, req.version(),
+												"Failed to save avatar");
+		}
+
+		return JsonUtil::buildSuccessResponse(
+			req.version(), json{{"code", 200}, {"message", "Avatar updated successfully"}}.dump());
+	} catch (const std::exception& e) {
+		spdlog::error("{} Exception in {}: {}", TAG, __FUNCTION__, e.what());
+		return JsonUtil::buildErrorResponse(http::status::internal_server_error, req.version(),
+											"Internal server error");
+	}
+}
+
+RouteResponse UserHandler::handleGetAvatarFile(const HttpRequest& req) {
+	try {
+		const std::string token = this->jwt_util.verifyToken(std::string(req["Authorization"]));
+		if (token.empty()) {
+			return JsonUtil::buildErrorResponse(http::status::unauthorized, req.version(),
+												"Invalid token");
+		}
+
+		int user_id = atoi(JWTUtil::getClaim(token, "id").c_str());
+
+		// 索引常驻内存, 条件请求无需任何磁盘访问
+		AvatarStore* store = AvatarStore::getInstance();
+		auto info = store->getInfo(user_id);
+		if (!info) {
+			return JsonUtil::buildErrorResponse(http::status::not_found, req.version(),
+												"Avatar not found");
+		}
+
+		// 内容寻址, hash 即强 ETag
+		const std::string etag = "\"" + info->hash + "\"";
+		const uint64_t size = info->size;
+
+		HttpResponse res{http::status::ok, req.version()};
+		res.set(http::field::server, "MusicPlayer-BackEnd");
+		res.set(http::field::etag, etag);
+		res.set(http::field::last_modified, HttpUtil::formatHttpDate(info->updated_at));
+		res.set(http::field::cache_control, "private, no-cache");
+		res.set(http::field::accept_ranges, "bytes");
+
+		// 条件请求: If-None-Match 优先于 If-Modified-Since
+		bool not_modified = false;
+		if (req.find(http::field::if_none_match) != req.end()) {
+			not_modified = HttpUtil::etagMatches(req[http::field::if_none_match], etag);
+		} else if (req.find(http::field::if_modified_since) != req.end()) {
+			auto since = HttpUtil::parseHttpDate(std::string(req[http::field::if_modified_since]));
+			not_modified = since && info->updated_at <= *since;
+		}
+
+		if (not_modified) {
+			res.result(http::status::not_modified);
+			return res;
+		}
+
+		// Range, If-Range 与当前 ETag 不一致时返回完整内容
+		uint64_t offset = 0;
+		uint64_t length = size;
+		bool use_range = req.find(http::field::range) != req.end();
+		if (use_range && req.find(http::field::if_range) != req.end()) {
+			use_range = req[http::field::if_range] == etag;
+		}
+
+		if (use_range) {
+			bool satisfiable = true;
+			auto range = HttpUtil::parseRange(req[http::field::range], size, satisfiable);
+			if (!satisfiable) {
+				res.result(http::status::range_not_satisfiable);
+				res.set(http::field::content_range, fmt::format("bytes */{}", size));
+				res.prepare_payload();
+				return res;
+			}
+
+			if (range) {
+				res.result(http::status::partial_content);
+				res.set(http::field::content_range,
+						fmt::format("bytes {}-{}/{}", range->offset,
+									range->offset + range->length - 1, size));
+				offset = range->offset;
+				length = range->length;
+			}
+		}
+
+		// 热点头像直接从内存返回
+		if (auto blob = store->getBlob(info->hash)) {
+			res.set(http::field::content_type, detectImageType(*blob));
+			res.body().assign(*blob, offset, length);
+			res.prepare_payload();
+			return res;
+		}
+
+		// 未缓存(超过单条缓存上限)时以 sendfile 发送 blob 文件
+		auto file = std::make_shared<FileHandle>(
+			::open(store->blobPath(info->hash).c_str(), O_RDONLY | O_CLOEXEC));
+		if (!*file) {
+			return JsonUtil::buildErrorResponse(http::status::internal_server_error, req.version(),
+												"Failed to read avatar");
+		}
+
+		std::string magic(16, '\0');
+		ssize_t n = ::pread(file->get(), magic.data(), magic.size(), 0);
+		magic.resize(n > 0 ? static_cast<size_t>(n) : 0);
+		res.set(http::field::content_type, detectImageType(magic));
+		res.content_length(length);
+
+		RouteResponse reply(std::move(res));
+		reply.file = std::move(file);
+		reply.offset = offset;
+		reply.length = length;
+
+		return reply;
+	} catch (const std::exception& e) {
+		spdlog::error("{} Exception in {}: {}", TAG, __FUNCTION__, e.what());
+		return JsonUtil::buildErrorResponse(http::status::internal_server_error, req.version(),
+											"Internal server error");
+	}
+}
+
 HttpResponse UserHandler::handleChangePassword(const HttpRequest& req) {
 	try {
-		json j = json::parse(req.body());
+		json j = JsonUtil::parse(req.body());
 
 		if ( !j.contains("new_password") || !j.contains("verify_code") || !j.contains("email")) { 
 			return JsonUtil::buildErrorResponse(http::status::bad_request, req.version(),
@@ -332,7 +482,7 @@ HttpResponse UserHandler::handleChangePassword(const HttpRequest& req) {
 												"Invalid verification code");
 		}
 
-		if (!user_dao.updatePassword(user_id,new_password))
+		if (!user_dao->updatePassword(user_id,new_password))
 			return JsonUtil::buildErrorResponse(http::status::internal_server_error,
 												req.version(), "Failed to update password");
 
@@ -361,7 +511,7 @@ HttpResponse UserHandler::handleBindPlatform(const HttpRequest& req) {
 		}
 
 		int user_id = atoi(JWTUtil::getClaim(token, "id").c_str());
-		json j = json::parse(req.body());
+		json j = JsonUtil::parse(req.body());
 		if (!j.contains("platform") || !j.contains("platform_id")) {
 			return JsonUtil::buildErrorResponse(http::status::bad_request, req.version(),
 												"Missing platform or platform_id");
@@ -370,12 +520,12 @@ HttpResponse UserHandler::handleBindPlatform(const HttpRequest& req) {
 		const std::string platform = j["platform"];
 		const std::string platform_id = j["platform_id"];
 		if (platform == "qq") {
-			if (!user_dao.updateQQId(user_id, platform_id)) {
+			if (!user_dao->updateQQId(user_id, platform_id)) {
 				return JsonUtil::buildErrorResponse(http::status::internal_server_error,
 													req.version(), "Failed to bind QQ account");
 			}
 		} else if (platform == "netease") {
-			if (!user_dao.updateNetEaseId(user_id, platform_id)) {
+			if (!user_dao->updateNetEaseId(user_id, platform_id)) {
 				return JsonUtil::buildErrorResponse(http::status::internal_server_error,
 													req.version(), "Failed to bind NetEase account");
 			}
@@ -389,7 +539,7 @@ HttpResponse UserHandler::handleBindPlatform(const HttpRequest& req) {
 			{"message", "Platform account bound successfully"}
 		};
 
-		return JsonUtil::buildSuccessResponse(req.version(), response.dump());
+		return JsonUtil::buildSuccessResponse(req.version(), JsonUtil::dump(response));
 	} catch (const json::exception& e) {
 		spdlog::error("{} JSON parse error in {}: {}", TAG, __FUNCTION__, e.what());
 		return JsonUtil::buildErrorResponse(http::status::bad_request, req.version(),
@@ -401,8 +551,15 @@ HttpResponse UserHandler::handleBindPlatform(const HttpRequest& req) {
 	}
 }
 
-bool UserHandler::isValidEmail(const std::string& email) {
-	std::regex email_regex(
-		R"((^[a-zA-Z0-9_.+-]+@[a-zA-Z0-9-]+\.[a-zA-Z0-9-.]+$))");
-	return std::regex_match(email, email_regex);
+std::string UserHandler::detectImageType(const std::string& data) {
+	auto startsWith = [&data](size_t pos, const char* magic, size_t len) {
+		return data.size() >= pos + len && data.compare(pos, len, magic, len) == 0;
+	};
+
+	if (startsWith(0, "\x89PNG\r\n\x1a\n", 8)) return "image/png";
+	if (startsWith(0, "\xFF\xD8\xFF", 3)) return "image/jpeg";
+	if (startsWith(0, "GIF87a", 6) || startsWith(0, "GIF89a", 6)) return "image/gif";
+	if (startsWith(0, "RIFF", 4) && startsWith(8, "WEBP", 4)) return "image/webp";
+
+	return "application/octet-stream";
 }
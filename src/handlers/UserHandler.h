@@ -1,12 +1,20 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <string>
 
 #include "../database//UserDAO.h"
 #include "../utils/JWTUtil.h"
 #include "../common/net.h"
+#include "../server/Router.h"
 
 class UserHandler {
 public:
+	// 头像数据上限 1MB, 请求体另留 JSON 转义余量
+	static constexpr size_t AVATAR_MAX_SIZE = 1024 * 1024;
+	static constexpr uint64_t AVATAR_BODY_LIMIT = 2 * AVATAR_MAX_SIZE;
+
 	UserHandler(const std::string& jwt_secret);
 
 	// 获取验证码
@@ -33,10 +41,11 @@ public:
 
 	/**
 	 * @brief 更新用户头像(JWT-Token)
-	 * @param req HTTP请求
+	 * @param req HTTP请求(仅头部)
+	 * @param body_file 请求体临时文件
 	 * @return HTTP响应
 	 */
-	HttpResponse handleUpdateAvatar(const HttpRequest& req);
+	HttpResponse handleUpdateAvatar(const HttpRequest& req, const std::string& body_file);
 
 	/**
 	 * @brief 获取用户头像(JWT-Token)
@@ -45,6 +54,21 @@ public:
 	 */
 	HttpResponse handleGetAvatar(const HttpRequest& req);
 
+	/**
+	 * @brief 上传二进制头像(JWT-Token), 请求体即图片数据, 按内容去重存储
+	 * @param req HTTP请求(仅头部)
+	 * @param body_file 请求体临时文件
+	 * @return HTTP响应
+	 */
+	HttpResponse handlePutAvatar(const HttpRequest& req, const std::string& body_file);
+
+	/**
+	 * @brief 下载二进制头像(JWT-Token), 支持 ETag/Last-Modified 条件请求与 Range
+	 * @param req HTTP请求
+	 * @return 路由结果(响应体为文件区间, sendfile 发送)
+	 */
+	RouteResponse handleGetAvatarFile(const HttpRequest& req);
+
 	/**
 	 * @brief 重置密码(JWT-Token)
 	 * @param req HTTP请求
@@ -60,11 +84,10 @@ public:
 	HttpResponse handleBindPlatform(const HttpRequest& req);
 
 private:
-	// 验证邮箱格式
-	static bool isValidEmail(const std::string& email);
+	// 根据文件头识别图片 Content-Type
+	static std::string detectImageType(const std::string& data);
 
 private:
-	UserDAO user_dao;
+	std::unique_ptr<UserDAO> user_dao;
 	JWTUtil jwt_util;
-	const std::string AVATAR_PATH = "./avatars";
 };
\ No newline at end of file
@@ -1,18 +1,16 @@
 #pragma once
 
-#include <string>
+#include <cstdint>
+
+#include "song.h"
 
 /**
- * @brief 播放历史
+ * @brief 播放历史(一次播放)
  */
 struct PlayHistory {
-	int id = 0;
+	int64_t id = 0; // 每次播放一行
 	int user_id = 0;
-	std::string song_id;
-	std::string song_name;
-	std::string song_singer;
-	std::string song_pic;
-	std::string song_where;
-	std::string played_at;
-	int song_count = 0;
-};
\ No newline at end of file
+	int song_count = 0; // 该歌曲的累计播放次数
+	int64_t played_at = 0; // Unix 时间戳 (秒)
+	SongMetaPtr song;
+};
@@ -1,4 +1,5 @@
 #pragma once
+#include <cstdint>
 #include <string>
 
 /**
@@ -7,8 +8,8 @@
 struct Playlist {
 	int id = 0;
 	int user_id = 0;
+	int64_t create_at = 0; // Unix 时间戳 (秒)
+	int64_t update_at = 0;
 	std::string name;
 	std::string cover;
-	std::string create_at;
-	std::string update_at;
 };
\ No newline at end of file
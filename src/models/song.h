@@ -1,16 +1,50 @@
 #pragma once
 
+#include <cstdint>
+#include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
 
 /**
- * @brief 歌曲
+ * @brief 歌曲来源平台, 取值与 songs.song_where 的 ENUM 序号一致
  */
-struct Song {
-	int id;
+enum class SongSource : uint8_t {
+	QQ = 1,
+	NetEase = 2,
+};
+
+inline const char* toString(SongSource source) {
+	return source == SongSource::NetEase ? "NetEase" : "QQ";
+}
+
+inline std::optional<SongSource> parseSongSource(std::string_view value) {
+	if (value == "QQ") return SongSource::QQ;
+	if (value == "NetEase") return SongSource::NetEase;
+	return std::nullopt;
+}
+
+/**
+ * @brief 歌曲元数据, 对应 songs 维表的一行
+ *
+ * 由 SongPool 驻留, 各 DAO 结果共享同一份不可变对象.
+ */
+struct SongMeta {
+	int ref = 0; // songs.id, 未入库时为 0
+	SongSource where = SongSource::QQ;
 	std::string song_id;
 	std::string name;
 	std::string singer;
 	std::string pic;
-	std::string where;
-	std::string added_at;
-};
\ No newline at end of file
+};
+
+using SongMetaPtr = std::shared_ptr<const SongMeta>;
+
+/**
+ * @brief 歌曲 (歌单中的一项)
+ */
+struct Song {
+	int id = 0;
+	int64_t added_at = 0; // Unix 时间戳 (秒)
+	SongMetaPtr meta;
+};
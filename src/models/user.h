@@ -1,13 +1,14 @@
 #pragma once
+#include <cstdint>
 #include <string>
 
 struct User {
 	int id = 0;
+	int64_t create_at = 0; // Unix 时间戳 (秒)
+	int64_t update_at = 0;
 	std::string username;
 	std::string passwd_hash;
 	std::string email;
 	std::string qq_id;
 	std::string netease_id;
-	std::string create_at;
-	std::string update_at;
 };
\ No newline at end of file
@@ -1,35 +1,172 @@
 #include "Router.h"
 #include "../utils/JsonUtil.h"
+#include "../utils/Metrics.h"
+#include "../utils/PerfCounters.h"
+#include "../utils/Tracing.h"
 
 #include <boost/beast/http/status.hpp>
 #include <spdlog/spdlog.h>
 #include <boost/beast/http/verb.hpp>
 
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <string>
+#include <string_view>
 #include <utility>
 
-void Router::addRouter(const http::verb& method, const std::string& url, RouterHandler handler) {
+class RouteMetrics {
+public:
+	RouteMetrics(std::string method, std::string route)
+		: m_labels{{"method", std::move(method)}, {"route", std::move(route)}},
+		  m_latency(MetricsRegistry::getInstance()->histogram(
+			  "http_request_duration_seconds", "Time spent in the route handler", m_labels)) {}
+
+	const std::string& route() const { return m_labels[1].second; }
+
+	void record(unsigned status, std::chrono::steady_clock::duration elapsed) {
+		m_latency.observe(elapsed);
+		if (status < 100 || status > 599) status = 500;
+		requests(status).inc();
+	}
+
+private:
+	// 状态码首次出现时注册计数器, 之后无锁读取
+	MetricCounter& requests(unsigned status) {
+		auto& slot = m_requests[status - 100];
+		if (MetricCounter* counter = slot.load(std::memory_order_acquire)) return *counter;
+
+		MetricLabels labels = m_labels;
+		labels.emplace_back("code", std::to_string(status));
+		MetricCounter* counter = &MetricsRegistry::getInstance()->counter(
+			"http_requests_total", "HTTP requests by route and status code", labels);
+		slot.store(counter, std::memory_order_release);
+		return *counter;
+	}
+
+private:
+	MetricLabels m_labels;
+	MetricHistogram& m_latency;
+	std::array<std::atomic<MetricCounter*>, 500> m_requests{}; // 状态码 100~599
+};
+
+namespace {
+
+MetricGauge& inFlight() {
+	static MetricGauge& gauge = MetricsRegistry::getInstance()->gauge(
+		"http_requests_in_flight", "Requests currently in a route handler");
+	return gauge;
+}
+
+// 未匹配任何路由的请求
+RouteMetrics& unmatchedMetrics() {
+	static RouteMetrics metrics("*", "unmatched");
+	return metrics;
+}
+
+} // namespace
+
+void Router::addRouter(const http::verb& method, const std::string& url, RouterHandler handler,
+					   uint64_t body_limit) {
+	Route route;
+	route.handler = std::move(handler);
+	route.body_limit = body_limit;
+	addRoute(method, url, std::move(route));
+}
+
+void Router::addUploadRouter(const http::verb& method, const std::string& url,
+							 UploadHandler handler, uint64_t body_limit) {
+	Route route;
+	route.upload_handler = std::move(handler);
+	route.body_limit = body_limit;
+	addRoute(method, url, std::move(route));
+}
+
+void Router::addFileRouter(const http::verb& method, const std::string& url,
+						   FileHandler handler) {
+	Route route;
+	route.file_handler = std::move(handler);
+	route.body_limit = DEFAULT_BODY_LIMIT;
+	addRoute(method, url, std::move(route));
+}
+
+void Router::addRoute(const http::verb& method, const std::string& url, Route route) {
+	route.path = url;
+	route.metrics = std::make_shared<RouteMetrics>(std::string(http::to_string(method)), url);
+
 	if (method == http::verb::get) {
-		m_router_get[url] = std::move(handler);
+		m_router_get[url] = std::move(route);
 		return;
 	}
 
 	if (method == http::verb::post) {
-		m_router_post[url] = std::move(handler);
+		m_router_post[url] = std::move(route);
+		return;
+	}
+
+	if (method == http::verb::put) {
+		m_router_put[url] = std::move(route);
 	}
 }
 
-HttpResponse Router::handleRouter(const HttpRequest& request) {
-	const http::verb method = request.method();
-	const std::string target = request.target();
+const Route* Router::findRoute(http::verb method, beast::string_view target) const {
+	std::string_view path(target.data(), target.size());
+	path = path.substr(0, path.find('?'));
+
+	// 多个工作线程并发查找, 只读访问路由表
+	if (method == http::verb::get) {
+		auto it = m_router_get.find(path);
+		if (it != m_router_get.end()) return &it->second;
+	}
 
-	if (method == http::verb::get && m_router_get.find(target) != m_router_get.end()) {
-		return m_router_get[target](request);
+	if (method == http::verb::post) {
+		auto it = m_router_post.find(path);
+		if (it != m_router_post.end()) return &it->second;
 	}
 
-	if (method == http::verb::post && m_router_post.find(target) != m_router_post.end()) {
-		return m_router_post[target](request);
+	if (method == http::verb::put) {
+		auto it = m_router_put.find(path);
+		if (it != m_router_put.end()) return &it->second;
 	}
 
-	return JsonUtil::buildErrorResponse(http::status::not_found, request.version(), "Not found");
+	return nullptr;
+}
+
+RouteResponse Router::handleRouter(const HttpRequest& request) const {
+	return handleRoute(findRoute(request.method(), request.target()), request);
+}
+
+RouteResponse Router::handleRoute(const Route* route, const HttpRequest& request,
+								  const std::string& body_file) {
+	RouteMetrics& metrics = route != nullptr ? *route->metrics : unmatchedMetrics();
+	TraceSpan span("route");
+	span.setAttribute("http.route", metrics.route());
+	const auto start = std::chrono::steady_clock::now();
+	inFlight().add(1);
+	try {
+		RouteResponse reply = dispatch(route, request, body_file);
+		inFlight().add(-1);
+		metrics.record(reply.response.result_int(), std::chrono::steady_clock::now() - start);
+		return reply;
+	} catch (...) {
+		// 由 Session 转为 500
+		inFlight().add(-1);
+		metrics.record(500, std::chrono::steady_clock::now() - start);
+		throw;
+	}
+}
+
+RouteResponse Router::dispatch(const Route* route, const HttpRequest& request,
+							   const std::string& body_file) {
+	PERF_SCOPE("router.dispatch");
+	if (route == nullptr) {
+		return JsonUtil::buildErrorResponse(http::status::not_found, request.version(),
+											"Not found");
+	}
+
+	if (route->upload_handler) return route->upload_handler(request, body_file);
+
+	if (route->file_handler) return route->file_handler(request);
+
+	return route->handler(request);
 }
@@ -1,20 +1,96 @@
 #pragma once
 #include "../common/net.h"
+#include "../common/FileHandle.h"
 
+#include <cstdint>
+#include <functional>
 #include <map>
+#include <memory>
+#include <string>
+
+/**
+ * @brief 流式响应体的生产者, 在工作线程中调用
+ * 向 chunk 追加下一块数据, 之后没有数据时返回 false; 抛出异常时中断连接
+ */
+using ChunkProducer = std::function<bool(std::string& chunk)>;
+
+/**
+ * @brief 路由处理结果
+ *
+ * 普通路由只有 response; file 非空时 response 只作为响应头(需设置 Content-Length),
+ * 响应体为 file 的 [offset, offset + length) 区间, 由 Session 以 sendfile 零拷贝发送.
+ * stream 非空时 response 只作为响应头, 响应体以 chunked 编码逐块发送, 上一块写完才生产下一块.
+ */
+struct RouteResponse {
+	HttpResponse response;
+	std::shared_ptr<FileHandle> file;
+	uint64_t offset = 0;
+	uint64_t length = 0;
+	ChunkProducer stream;
+
+	RouteResponse() = default;
+	RouteResponse(HttpResponse res) : response(std::move(res)) {}
+};
 
 // 路由回调类型
 using RouterHandler = std::function<HttpResponse(const HttpRequest&)>;
 
+// 上传路由回调类型: 请求体已流式写入临时文件 body_file (request.body() 为空),
+// 处理结束后 Session 删除该文件, 回调可 rename 接管
+using UploadHandler =
+	std::function<HttpResponse(const HttpRequest& request, const std::string& body_file)>;
+
+// 文件路由回调类型: 可返回文件区间由 Session 零拷贝发送, 或返回流式响应体
+using FileHandler = std::function<RouteResponse(const HttpRequest&)>;
+
+// 路由指标 (请求数按状态码, 处理耗时), 定义见 Router.cpp
+class RouteMetrics;
+
+struct Route {
+	std::string path; // 注册时的 url
+	RouterHandler handler;
+	UploadHandler upload_handler; // 非空表示请求体落盘
+	FileHandler file_handler;	  // 非空表示响应体可能为文件或流
+	uint64_t body_limit = 0;	  // 请求体上限(字节)
+	std::shared_ptr<RouteMetrics> metrics;
+};
+
 class Router {
 public:
+	// 默认请求体上限 (与 Beast request_parser 默认值一致)
+	static constexpr uint64_t DEFAULT_BODY_LIMIT = 1024 * 1024;
+
 	// 添加路由
-	void addRouter(const http::verb& method, const std::string& url, RouterHandler handler);
+	void addRouter(const http::verb& method, const std::string& url, RouterHandler handler,
+				   uint64_t body_limit = DEFAULT_BODY_LIMIT);
+
+	// 添加上传路由, 请求体不进入内存
+	void addUploadRouter(const http::verb& method, const std::string& url, UploadHandler handler,
+						 uint64_t body_limit);
+
+	// 添加文件路由, 响应体以 sendfile 发送
+	void addFileRouter(const http::verb& method, const std::string& url, FileHandler handler);
+
+	// 查找路由(忽略查询参数), 未找到返回 nullptr
+	const Route* findRoute(http::verb method, beast::string_view target) const;
+
+	// 处理路由(线程安全, 路由表在服务启动后只读)
+	RouteResponse handleRouter(const HttpRequest& request) const;
+
+	// 调用已查找到的路由并记录指标, route 为空时返回 404
+	static RouteResponse handleRoute(const Route* route, const HttpRequest& request,
+									 const std::string& body_file = {});
+
+private:
+	void addRoute(const http::verb& method, const std::string& url, Route route);
+
+	static RouteResponse dispatch(const Route* route, const HttpRequest& request,
+								  const std::string& body_file);
 
-	// 处理路由
-	HttpResponse handleRouter(const HttpRequest& request);
+	using RouteMap = std::map<std::string, Route, std::less<>>;
 
 private:
-	std::map<std::string, RouterHandler> m_router_get;
-	std::map<std::string, RouterHandler> m_router_post;
-};
\ No newline at end of file
+	RouteMap m_router_get;
+	RouteMap m_router_post;
+	RouteMap m_router_put;
+};
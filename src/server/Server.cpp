@@ -4,19 +4,31 @@
 
 #include <chrono>
 #include <cstdio>
+#include <filesystem>
 #include <memory>
 #include <utility>
 
 #include <boost/asio/io_context.hpp>
 #include <boost/asio/socket_base.hpp>
+#include <boost/asio/strand.hpp>
 #include <spdlog/spdlog.h>
 
 constexpr const char* TAG = "[Server]";
 
-Server::Server(const std::string& ip, uint16_t port, int num_threads)
-	: m_addr(ip), m_port(port), m_num_threads(num_threads), m_ioc(num_threads), m_acceptor(m_ioc) {
+Server::Server(const std::string& ip, uint16_t port, int num_threads, int num_workers,
+			   SessionOptions options)
+	: m_addr(ip),
+	  m_port(port),
+	  m_num_threads(num_threads),
+	  m_session_options(std::move(options)),
+	  m_ioc(num_threads),
+	  m_workers(num_workers > 0 ? num_workers : 1),
+	  m_acceptor(m_ioc) {
 	m_work_guards = std::make_shared<work_guard>(m_ioc.get_executor());
 
+	if (m_session_options.pipeline_depth == 0) m_session_options.pipeline_depth = 1;
+	std::filesystem::create_directories(m_session_options.upload_tmp_dir);
+
 	tcp::endpoint ep;
 	if (m_addr == "0.0.0.0")
 		ep = tcp::endpoint(tcp::v4(), m_port);
@@ -69,6 +81,8 @@ void Server::stop() {
 	m_acceptor.close();
 	m_ioc.stop();
 	m_work_guards->reset();
+	m_workers.stop();
+	m_workers.join();
 
 	for (auto& thread : m_threads) {
 		if (thread.joinable()) thread.join();
@@ -81,11 +95,15 @@ void Server::stop() {
 void Server::doAccept() {
 	if (!m_running) return;
 
-	m_acceptor.async_accept([this](const boost::system::error_code& ec, tcp::socket socket) {
+	// 每个连接绑定独立 strand, 流水线中的读/写/回调串行执行
+	m_acceptor.async_accept(net::make_strand(m_ioc), [this](const boost::system::error_code& ec,
+															tcp::socket socket) {
 		if (ec) {
 			spdlog::error("{} Accept error: {}", TAG, ec.message());
 		} else {
-			std::make_shared<Session>(std::move(socket), m_router)->run();
+			std::make_shared<Session>(std::move(socket), m_router, m_workers.get_executor(),
+									  m_session_options)
+				->run();
 		}
 
 		// 继续接受下一个连接
@@ -1,5 +1,6 @@
 #pragma once
 #include "Router.h"
+#include "Session.h"
 
 #include <memory>
 #include <atomic>
@@ -9,6 +10,7 @@
 #include <utility>
 #include <vector>
 
+#include <boost/asio/thread_pool.hpp>
 #include <boost/beast/http/verb.hpp>
 
 /**
@@ -21,15 +23,26 @@ public:
 	Server& operator=(const Server&) = delete;
 	Server& operator=(Server&&) = delete;
 
-	Server(const std::string& ip, uint16_t port, int num_threads);
+	Server(const std::string& ip, uint16_t port, int num_threads, int num_workers = 4,
+		   SessionOptions options = {});
 	~Server();
 
 	void run();
 
 	void stop();
 
-	void addRouter(const http::verb& method, const std::string& url, RouterHandler handler) {
-		m_router.addRouter(method, url, std::move(handler));
+	void addRouter(const http::verb& method, const std::string& url, RouterHandler handler,
+				   uint64_t body_limit = Router::DEFAULT_BODY_LIMIT) {
+		m_router.addRouter(method, url, std::move(handler), body_limit);
+	}
+
+	void addUploadRouter(const http::verb& method, const std::string& url, UploadHandler handler,
+						 uint64_t body_limit) {
+		m_router.addUploadRouter(method, url, std::move(handler), body_limit);
+	}
+
+	void addFileRouter(const http::verb& method, const std::string& url, FileHandler handler) {
+		m_router.addFileRouter(method, url, std::move(handler));
 	}
 
 private:
@@ -40,8 +53,10 @@ private:
 	std::string m_addr;
 	uint16_t m_port;
 	int m_num_threads;
+	SessionOptions m_session_options;
 
 	net::io_context m_ioc;
+	net::thread_pool m_workers; // 请求处理线程池, 避免阻塞 io 线程
 	std::vector<std::thread> m_threads;
 	std::shared_ptr<work_guard> m_work_guards;
 
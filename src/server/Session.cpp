@@ -1,79 +1,486 @@
 #include "Session.h"
 #include "../utils/JsonUtil.h"
 
+#include <boost/asio/post.hpp>
 #include <boost/beast/core/error.hpp>
+#include <boost/beast/core/file.hpp>
 #include <boost/beast/core/stream_traits.hpp>
 #include <boost/beast/http.hpp>
 #include <boost/beast/http/error.hpp>
 #include <boost/beast/http/field.hpp>
+#include <boost/beast/http/file_body.hpp>
 #include <boost/beast/http/status.hpp>
 #include <boost/beast/http/write.hpp>
 #include <spdlog/spdlog.h>
 
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <utility>
+
+#include <sys/sendfile.h>
+#include <unistd.h>
+
 constexpr const char* TAG = "[Session]";
 
-Session::Session(tcp::socket socket, Router& router)
-	: m_socket(std::move(socket)), m_router{router} {}
+Session::Session(tcp::socket socket, Router& router, net::thread_pool::executor_type workers,
+				 const SessionOptions& options)
+	: m_socket(std::move(socket)),
+	  m_router{router},
+	  m_workers{std::move(workers)},
+	  m_options{options} {}
 
 Session::~Session() {
 	// spdlog::info("{} Session closed", TAG);
 }
 
-void Session::run() { doRead(); }
+void Session::run() {
+	// 在 strand 上启动, 保证会话状态串行访问
+	net::dispatch(m_socket.get_executor(), [self = shared_from_this()]() { self->doRead(); });
+}
 
 void Session::doRead() {
-	auto self = shared_from_this();
+	// 正在读取 / 连接即将关闭 / 流水线已满
+	if (m_reading || m_closing || m_pending.size() >= m_options.pipeline_depth) return;
 
 	// TODO: 设置超时
 
-	http::async_read(m_socket, m_buffer, m_request,
-					 [self](const beast::error_code& ec, size_t bytes_transferred) {
+	m_reading = true;
+	m_parser.emplace();
+	http::async_read_header(
+		m_socket, m_buffer, *m_parser,
+		[self = shared_from_this()](const beast::error_code& ec, size_t bytes_transferred) {
+			self->onReadHeader(ec);
+		});
+}
+
+void Session::onReadHeader(const beast::error_code& ec) {
+	if (ec) {
+		onReadError(ec);
+		return;
+	}
+
+	const auto& header = m_parser->get();
+	m_version = header.version();
+	const Route* route = m_router.findRoute(header.method(), header.target());
+
+	const auto request_id = header["X-Request-Id"];
+	m_access = AccessRecord{};
+	m_access.request_id = makeRequestId({request_id.data(), request_id.size()});
+	m_access.method = std::string(header.method_string());
+	m_access.route = route != nullptr ? route->path : "unmatched";
+	m_access.start = std::chrono::steady_clock::now();
+
+	const std::string target(header.target());
+	m_trace = Tracer::startTrace(m_access.method + " " + target.substr(0, target.find('?')));
+	if (m_trace) {
+		m_trace->setAttribute(0, "http.method", m_access.method);
+		m_trace->setAttribute(0, "http.target", target);
+		m_trace->setAttribute(0, "http.request_id", m_access.request_id);
+		m_read_span = m_trace->begin("read");
+	}
+	const uint64_t body_limit = route ? route->body_limit : Router::DEFAULT_BODY_LIMIT;
+
+	// 根据 Content-Length 提前拒绝, 不读取请求体
+	auto content_length = m_parser->content_length();
+	if (content_length && *content_length > body_limit) {
+		m_reading = false;
+		reject(http::status::payload_too_large, "Request body too large");
+		return;
+	}
+
+	// Expect: 100-continue, 头部已通过检查, 通知客户端发送请求体.
+	// 临时响应同样按请求顺序写回, 流水线中之前的响应写完后才发出
+	if (header[http::field::expect] == "100-continue") {
+		auto pending = std::make_shared<Pending>();
+		pending->interim = true;
+		pending->continue_route = route;
+		pending->ready = true;
+		m_pending.push_back(pending);
+		doWrite();
+		return;
+	}
+
+	doReadBody(route);
+}
+
+void Session::doReadBody(const Route* route) {
+	const uint64_t body_limit = route ? route->body_limit : Router::DEFAULT_BODY_LIMIT;
+
+	// 上传路由: 请求体流式写入临时文件
+	if (route != nullptr && route->upload_handler) {
+		auto parser = std::make_shared<http::request_parser<http::file_body>>(std::move(*m_parser));
+		parser->body_limit(body_limit);
+		m_parser.reset();
+
+		std::string body_file = makeUploadPath();
+		beast::error_code ec;
+		parser->get().body().open(body_file.c_str(), beast::file_mode::write, ec);
+		if (ec) {
+			spdlog::error("{} Open upload file {} failed: {}", TAG, body_file, ec.message());
+			m_reading = false;
+			reject(http::status::internal_server_error, "Failed to store request body");
+			return;
+		}
+
+		http::async_read(m_socket, m_buffer, *parser,
+						 [self = shared_from_this(), parser, route, body_file](
+							 const beast::error_code& ec, size_t bytes_transferred) {
+							 if (ec) {
+								 std::error_code ignored;
+								 std::filesystem::remove(body_file, ignored);
+								 self->onReadError(ec);
+								 return;
+							 }
+
+							 self->m_reading = false;
+							 if (self->m_trace) self->m_trace->end(self->m_read_span);
+							 // 析构 file_body 关闭文件, 只保留请求头
+							 auto request = std::make_shared<HttpRequest>(
+								 std::move(parser->release().base()));
+							 self->dispatch(route, std::move(request), body_file);
+							 self->doRead();
+						 });
+		return;
+	}
+
+	auto parser = std::make_shared<http::request_parser<http::string_body>>(std::move(*m_parser));
+	parser->body_limit(body_limit);
+	m_parser.reset();
+
+	http::async_read(m_socket, m_buffer, *parser,
+					 [self = shared_from_this(), parser, route](const beast::error_code& ec,
+																size_t bytes_transferred) {
 						 if (ec) {
-							 if (ec != http::error::end_of_stream)
-								 spdlog::error("{} Read error: {}", TAG, ec.message());
+							 self->onReadError(ec);
 							 return;
 						 }
 
-						 self->handleRequest();
-						 self->doWrite();
+						 self->m_reading = false;
+						 if (self->m_trace) self->m_trace->end(self->m_read_span);
+						 self->dispatch(route, std::make_shared<HttpRequest>(parser->release()));
+
+						 // 继续解析缓冲区/连接中排队的请求
+						 self->doRead();
 					 });
 }
 
+void Session::onReadError(const beast::error_code& ec) {
+	m_reading = false;
+	m_parser.reset();
+	m_trace.reset();
+
+	// 分块传输的请求体超出上限
+	if (ec == http::error::body_limit) {
+		reject(http::status::payload_too_large, "Request body too large");
+		return;
+	}
+
+	if (ec != http::error::end_of_stream) spdlog::error("{} Read error: {}", TAG, ec.message());
+
+	// 已排队的请求仍会按序写回
+	m_closing = true;
+}
+
+void Session::reject(http::status status, const std::string& message) {
+	auto pending = enqueue(false);
+	pending->trace = std::move(m_trace);
+	pending->access = std::move(m_access);
+	pending->reply.response = JsonUtil::buildErrorResponse(status, m_version, message);
+	pending->reply.response.set("X-Request-Id", pending->access.request_id);
+	pending->reply.response.keep_alive(false);
+	pending->ready = true;
+	doWrite();
+}
+
+std::shared_ptr<Session::Pending> Session::enqueue(bool keep_alive) {
+	auto pending = std::make_shared<Pending>();
+	pending->keep_alive = keep_alive;
+	m_pending.push_back(pending);
+
+	// 客户端要求关闭连接, 之后的数据不再解析
+	if (!keep_alive) m_closing = true;
+
+	return pending;
+}
+
+void Session::dispatch(const Route* route, std::shared_ptr<HttpRequest> request,
+					   std::string body_file) {
+	auto pending = enqueue(request->keep_alive());
+	pending->trace = std::move(m_trace);
+	pending->access = std::move(m_access);
+	const size_t queue_span = pending->trace ? pending->trace->begin("queue") : Trace::NO_SPAN;
+
+	net::post(m_workers, [self = shared_from_this(), route, request = std::move(request),
+						  body_file = std::move(body_file), pending = std::move(pending),
+						  queue_span]() mutable {
+		RouteResponse reply;
+		setRequestUser({});
+		if (pending->trace) {
+			pending->trace->end(queue_span);
+			TraceScope scope(pending->trace);
+			reply = self->handleRequest(route, *request, body_file);
+			if (Tracer::getInstance()->serverTiming()) {
+				reply.response.set("Server-Timing", pending->trace->serverTiming());
+			}
+		} else {
+			reply = self->handleRequest(route, *request, body_file);
+		}
+		pending->access.user_id = takeRequestUser();
+		reply.response.set("X-Request-Id", pending->access.request_id);
+		reply.response.keep_alive(pending->keep_alive);
+
+		// 回调未接管的临时文件
+		if (!body_file.empty()) {
+			std::error_code ignored;
+			std::filesystem::remove(body_file, ignored);
+		}
+
+		net::post(self->m_socket.get_executor(),
+				  [self, pending = std::move(pending), reply = std::move(reply)]() mutable {
+					  pending->reply = std::move(reply);
+					  pending->ready = true;
+					  self->doWrite();
+				  });
+	});
+}
+
 void Session::doWrite() {
-	auto self = shared_from_this();
+	// 只写队首, 保证响应顺序与请求顺序一致
+	if (m_writing || m_pending.empty() || !m_pending.front()->ready || !m_socket.is_open()) return;
+
 	// TODO: 设置超时
 
-	http::async_write(m_socket, m_response,
-					  [self](const beast::error_code& ec, size_t bytes_transferred) {
+	m_writing = true;
+	auto pending = m_pending.front();
+	if (pending->interim) {
+		writeContinue(pending);
+		return;
+	}
+
+	pending->access.status = pending->reply.response.result_int();
+	if (pending->trace) {
+		pending->trace->setAttribute(0, "http.status_code",
+									 std::to_string(pending->access.status));
+		pending->write_span = pending->trace->begin("write");
+	}
+	if (pending->reply.file) {
+		doWriteFile(pending);
+		return;
+	}
+	if (pending->reply.stream) {
+		doWriteStream(pending);
+		return;
+	}
+
+	pending->access.bytes = pending->reply.response.body().size();
+	http::async_write(m_socket, pending->reply.response,
+					  [self = shared_from_this(), pending](const beast::error_code& ec,
+														   size_t bytes_transferred) {
+						  self->onWrite(ec, pending);
+					  });
+}
+
+void Session::writeContinue(const std::shared_ptr<Pending>& pending) {
+	auto res = std::make_shared<http::response<http::empty_body>>(http::status::continue_,
+																  m_version);
+	http::async_write(m_socket, *res,
+					  [self = shared_from_this(), res, pending](const beast::error_code& ec,
+																size_t bytes_transferred) {
+						  self->m_writing = false;
+						  self->m_pending.pop_front();
 						  if (ec) {
-							  spdlog::error("{} Write error: {}", TAG, ec.message());
+							  self->onReadError(ec);
 							  return;
 						  }
+						  self->doReadBody(pending->continue_route);
+					  });
+}
 
-						  // spdlog::info("{} Connection: {}", TAG,
-						  // self->m_request[http::field::connection]);
+void Session::doWriteFile(const std::shared_ptr<Pending>& pending) {
+	auto serializer =
+		std::make_shared<http::response_serializer<http::string_body>>(pending->reply.response);
 
-						  // 关闭连接
-						  if (self->m_request.need_eof()) {
-							  beast::error_code ec;
-							  self->m_socket.shutdown(tcp::socket::shutdown_send, ec);
-							  return;
-						  }
+	http::async_write_header(m_socket, *serializer,
+							 [self = shared_from_this(), pending, serializer](
+								 const beast::error_code& ec, size_t bytes_transferred) {
+								 if (ec) {
+									 self->onWrite(ec, pending);
+									 return;
+								 }
+								 self->sendFile(pending);
+							 });
+}
 
-						  self->m_request = {};
-						  // 保持连接
-						  self->doRead();
-					  });
+void Session::sendFile(const std::shared_ptr<Pending>& pending) {
+	RouteResponse& reply = pending->reply;
+
+	beast::error_code ec;
+	if (!m_socket.native_non_blocking()) m_socket.native_non_blocking(true, ec);
+
+	while (reply.length > 0) {
+		auto offset = static_cast<off_t>(reply.offset);
+		ssize_t n = ::sendfile(m_socket.native_handle(), reply.file->get(), &offset,
+							   static_cast<size_t>(reply.length));
+		if (n > 0) {
+			reply.offset += static_cast<uint64_t>(n);
+			reply.length -= static_cast<uint64_t>(n);
+			pending->access.bytes += static_cast<uint64_t>(n);
+			continue;
+		}
+
+		if (n < 0 && errno == EINTR) continue;
+
+		// 发送缓冲区已满, 等待可写
+		if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			m_socket.async_wait(tcp::socket::wait_write,
+								[self = shared_from_this(), pending](const beast::error_code& ec) {
+									if (ec) {
+										self->onWrite(ec, pending);
+										return;
+									}
+									self->sendFile(pending);
+								});
+			return;
+		}
+
+		// 出错或文件被截断
+		onWrite(n < 0 ? beast::error_code(errno, boost::system::system_category())
+					  : beast::error_code(net::error::eof),
+				pending);
+		return;
+	}
+
+	onWrite({}, pending);
 }
 
-void Session::handleRequest() {
+void Session::doWriteStream(const std::shared_ptr<Pending>& pending) {
+	pending->reply.response.chunked(true);
+	auto serializer =
+		std::make_shared<http::response_serializer<http::string_body>>(pending->reply.response);
+
+	http::async_write_header(m_socket, *serializer,
+							 [self = shared_from_this(), pending, serializer](
+								 const beast::error_code& ec, size_t bytes_transferred) {
+								 if (ec) {
+									 self->onWrite(ec, pending);
+									 return;
+								 }
+								 self->nextChunk(pending);
+							 });
+}
+
+void Session::nextChunk(const std::shared_ptr<Pending>& pending) {
+	// 生产者可能访问数据库, 不在 strand 上执行
+	net::post(m_workers, [self = shared_from_this(), pending]() {
+		auto chunk = std::make_shared<std::string>();
+		bool more = false;
+		try {
+			// 生产者中的数据库访问记入写回 span
+			std::optional<TraceScope> scope;
+			if (pending->trace) scope.emplace(pending->trace, pending->write_span);
+			TraceSpan span("stream.chunk");
+			more = pending->reply.stream(*chunk);
+		} catch (const std::exception& e) {
+			// 响应头已发出, 只能中断连接
+			spdlog::error("{} Stream producer failed: {}", TAG, e.what());
+			net::post(self->m_socket.get_executor(), [self, pending]() {
+				self->onWrite(net::error::connection_aborted, pending);
+			});
+			return;
+		}
+
+		net::post(self->m_socket.get_executor(),
+				  [self, pending, chunk = std::move(chunk), more]() mutable {
+					  self->writeChunk(pending, std::move(chunk), more);
+				  });
+	});
+}
+
+void Session::writeChunk(const std::shared_ptr<Pending>& pending,
+						 std::shared_ptr<std::string> chunk, bool more) {
+	if (!chunk->empty()) {
+		pending->access.bytes += chunk->size();
+		net::async_write(m_socket, http::make_chunk(net::buffer(*chunk)),
+						 [self = shared_from_this(), pending, chunk, more](
+							 const beast::error_code& ec, size_t bytes_transferred) {
+							 if (ec) {
+								 self->onWrite(ec, pending);
+								 return;
+							 }
+							 if (more) {
+								 self->nextChunk(pending);
+								 return;
+							 }
+							 self->writeChunk(pending, std::make_shared<std::string>(), false);
+						 });
+		return;
+	}
+
+	if (more) {
+		nextChunk(pending);
+		return;
+	}
+
+	net::async_write(m_socket, http::make_chunk_last(),
+					 [self = shared_from_this(), pending](const beast::error_code& ec,
+														  size_t bytes_transferred) {
+						 self->onWrite(ec, pending);
+					 });
+}
+
+void Session::onWrite(const beast::error_code& ec, const std::shared_ptr<Pending>& pending) {
+	m_writing = false;
+	finishRequest(pending, ec ? "write error" : nullptr);
+
+	if (ec) {
+		spdlog::error("{} Write error: {}", TAG, ec.message());
+		m_closing = true;
+		beast::error_code ignored;
+		m_socket.close(ignored);
+		return;
+	}
+
+	m_pending.pop_front();
+
+	// 关闭连接
+	if (!pending->keep_alive) {
+		beast::error_code ignored;
+		m_socket.shutdown(tcp::socket::shutdown_send, ignored);
+		return;
+	}
+
+	// 保持连接: 写下一个已就绪的响应, 流水线有空位时恢复读取
+	doWrite();
+	doRead();
+}
+
+void Session::finishRequest(const std::shared_ptr<Pending>& pending, const char* error) {
+	Logging::access(pending->access);
+	if (!pending->trace) return;
+
+	pending->trace->end(pending->write_span);
+	if (error != nullptr) pending->trace->setAttribute(0, "error", error);
+	Tracer::getInstance()->finish(pending->trace);
+	pending->trace.reset();
+}
+
+RouteResponse Session::handleRequest(const Route* route, const HttpRequest& request,
+									 const std::string& body_file) {
 	try {
-		m_response = m_router.handleRouter(m_request);
-		spdlog::info("{} {} {}", __FUNCTION__, m_request.method_string(), m_request.target());
+		return Router::handleRoute(route, request, body_file);
 	} catch (const std::exception& e) {
 		// 500 错误
 		spdlog::error("{} Handle Request: {}", TAG, e.what());
-		m_response = JsonUtil::buildErrorResponse(http::status::internal_server_error,
-												  m_request.version(), e.what());
+		return JsonUtil::buildErrorResponse(http::status::internal_server_error,
+											request.version(), e.what());
 	}
 }
+
+std::string Session::makeUploadPath() {
+	static std::atomic<uint64_t> s_seq{0};
+	return m_options.upload_tmp_dir + "/upload_" + std::to_string(::getpid()) + "_" +
+		   std::to_string(s_seq.fetch_add(1, std::memory_order_relaxed));
+}
@@ -1,21 +1,65 @@
 #pragma once
 #include "Router.h"
+#include "../utils/Logging.h"
+#include "../utils/Tracing.h"
 
+#include <deque>
 #include <memory>
+#include <optional>
+#include <string>
 
+#include <boost/asio/thread_pool.hpp>
 #include <boost/beast/core/flat_buffer.hpp>
+#include <boost/beast/http/empty_body.hpp>
+#include <boost/beast/http/parser.hpp>
+
+/**
+ * @brief 会话参数
+ */
+struct SessionOptions {
+	size_t pipeline_depth = 8;				  // 单连接最大流水线请求数
+	std::string upload_tmp_dir = "./uploads"; // 上传请求体落盘目录
+};
 
 /**
  * @brief HttpSession 单个连接会话管理
+ *
+ * 支持 HTTP/1.1 流水线: 连续读取同一连接上排队的请求并投递到工作线程池处理,
+ * 响应严格按请求顺序写回. 未写回的请求数达到 pipeline_depth 时暂停读取.
+ * 会话状态只在 socket 所属的 strand 上访问.
+ *
+ * 请求先只解析头部, 按路由的 body_limit 检查 Content-Length, 超限直接返回 413;
+ * 上传路由的请求体流式写入临时文件, 不进入内存; 文件响应体以 sendfile 零拷贝发送;
+ * 流式响应体以 chunked 编码发送, 同一时刻只有一块在内存中.
+ *
+ * 每个请求写回结束 (成功或出错) 时记一条访问日志, 响应带 X-Request-Id.
+ * 启用追踪时每个请求一个 Trace: 读请求体、排队、路由处理与写回各为一个 span, 处理过程中
+ * 的 span (鉴权、数据库等) 经 TraceScope 记入工作线程.
  */
 class Session : public std::enable_shared_from_this<Session> {
+	// 流水线中的一个请求槽位
+	struct Pending {
+		RouteResponse reply;
+		bool ready = false;		 // 响应是否已生成
+		bool keep_alive = true;	 // 写回后是否保持连接
+		std::shared_ptr<Trace> trace; // 未启用追踪时为空
+		size_t write_span = Trace::NO_SPAN;
+		AccessRecord access; // 写回结束时记入访问日志
+		// 100 Continue 临时响应: 写出后继续读取该路由的请求体, 不计访问日志
+		bool interim = false;
+		const Route* continue_route = nullptr;
+	};
+
+	using HeaderParser = http::request_parser<http::empty_body>;
+
 public:
 	Session(const Session&) = delete;
 	Session(Session&&) = delete;
 	Session& operator=(const Session&) = delete;
 	Session& operator=(Session&&) = delete;
 
-	Session(tcp::socket socket, Router& router);
+	Session(tcp::socket socket, Router& router, net::thread_pool::executor_type workers,
+			const SessionOptions& options);
 	~Session();
 
 	void run();
@@ -23,15 +67,65 @@ public:
 private:
 	void doRead();
 
+	void onReadHeader(const beast::error_code& ec);
+
+	// 头部通过检查后读取请求体
+	void doReadBody(const Route* route);
+
+	void onReadError(const beast::error_code& ec);
+
+	// 不读取请求体直接返回错误, 并在写回后关闭连接
+	void reject(http::status status, const std::string& message);
+
+	// 入队并投递到工作线程处理, 完成后回到 strand 写回
+	void dispatch(const Route* route, std::shared_ptr<HttpRequest> request,
+				  std::string body_file = {});
+
 	void doWrite();
 
-	void handleRequest();
+	// 写出 100 Continue, 随后读取请求体
+	void writeContinue(const std::shared_ptr<Pending>& pending);
+
+	// 先写响应头, 再以 sendfile 发送文件区间
+	void doWriteFile(const std::shared_ptr<Pending>& pending);
+
+	void sendFile(const std::shared_ptr<Pending>& pending);
+
+	// 先写 chunked 响应头, 再交替在工作线程生产数据块、在 strand 上写出
+	void doWriteStream(const std::shared_ptr<Pending>& pending);
+
+	void nextChunk(const std::shared_ptr<Pending>& pending);
+
+	void writeChunk(const std::shared_ptr<Pending>& pending, std::shared_ptr<std::string> chunk,
+					bool more);
+
+	void onWrite(const beast::error_code& ec, const std::shared_ptr<Pending>& pending);
+
+	std::shared_ptr<Pending> enqueue(bool keep_alive);
+
+	// 写回结束 (成功或出错), 提交请求的 trace 并记访问日志
+	static void finishRequest(const std::shared_ptr<Pending>& pending, const char* error = nullptr);
+
+	RouteResponse handleRequest(const Route* route, const HttpRequest& request,
+							   const std::string& body_file);
+
+	std::string makeUploadPath();
 
 private:
 	tcp::socket m_socket;
 	Router& m_router;
+	net::thread_pool::executor_type m_workers;
+	SessionOptions m_options;
 
 	beast::flat_buffer m_buffer;
-	HttpRequest m_request;
-	HttpResponse m_response;
-};
\ No newline at end of file
+	std::optional<HeaderParser> m_parser; // 正在读取的请求头
+	std::shared_ptr<Trace> m_trace;		  // 正在读取的请求的 trace
+	AccessRecord m_access;				  // 正在读取的请求的访问日志
+	unsigned m_version = 11;			  // 正在读取的请求的 HTTP 版本
+	size_t m_read_span = Trace::NO_SPAN;
+
+	std::deque<std::shared_ptr<Pending>> m_pending; // 按请求顺序排队, 等待写回
+	bool m_reading = false;
+	bool m_writing = false;
+	bool m_closing = false; // 不再读取新请求
+};
@@ -1,6 +1,7 @@
 #include "VerifyService.h"
 #include "../utils/Config.h"
 #include "../utils/EmailUtil.h"
+#include "../utils/Metrics.h"
 
 #include <chrono>
 #include <cstddef>
@@ -9,6 +10,38 @@
 
 std::unique_ptr<VerifyService> VerifyService::m_instance = nullptr;
 
+namespace {
+
+struct VerifyMetrics {
+	MetricHistogram& send;
+	MetricCounter& sent;
+	MetricCounter& send_failed;
+	MetricCounter& verified;
+	MetricCounter& missing;
+	MetricCounter& rejected;
+	MetricGauge& pending;
+};
+
+VerifyMetrics& verifyMetrics() {
+	static VerifyMetrics metrics = []() {
+		auto* registry = MetricsRegistry::getInstance();
+		const std::string send_help = "Verification code emails by result";
+		const std::string check_help = "Verification code checks by result";
+		return VerifyMetrics{
+			registry->histogram("verify_email_send_duration_seconds",
+								"Time spent sending a verification email"),
+			registry->counter("verify_emails_total", send_help, {{"result", "ok"}}),
+			registry->counter("verify_emails_total", send_help, {{"result", "failed"}}),
+			registry->counter("verify_checks_total", check_help, {{"result", "ok"}}),
+			registry->counter("verify_checks_total", check_help, {{"result", "missing"}}),
+			registry->counter("verify_checks_total", check_help, {{"result", "rejected"}}),
+			registry->gauge("verify_codes_pending", "Verification codes held in memory")};
+	}();
+	return metrics;
+}
+
+} // namespace
+
 VerifyService* VerifyService::getInstance() {
 	if (m_instance) return m_instance.get();
 
@@ -22,9 +55,18 @@ bool VerifyService::sendVerifyCode(const std::string& to_email, const std::strin
 	// 生成验证码
 	std::string verify_code = EmailUtil::generateVerificationCode();
 
-	bool success = EmailUtil::sendTextEmail(to_email, "Verification Code",
-											"Your verification code is: " + verify_code);
-	if (!success) return false; // 发送验证码失败
+	VerifyMetrics& metrics = verifyMetrics();
+	bool success = false;
+	{
+		MetricTimer timer(metrics.send);
+		success = EmailUtil::sendTextEmail(to_email, "Verification Code",
+										   "Your verification code is: " + verify_code);
+	}
+	if (!success) {
+		metrics.send_failed.inc();
+		return false; // 发送验证码失败
+	}
+	metrics.sent.inc();
 
 	std::chrono::seconds expiry_time(
 		Config::getInstance()->getVerifyServiceConfig().verfication_code_expiry);
@@ -32,6 +74,7 @@ bool VerifyService::sendVerifyCode(const std::string& to_email, const std::strin
 	// 存储验证码和过期时间
 	std::lock_guard<std::mutex> lock(m_mtx);
 	m_codes[to_email] = {verify_code, std::chrono::system_clock::now() + expiry_time, action};
+	metrics.pending.set(static_cast<int64_t>(m_codes.size()));
 
 	return true;
 }
@@ -43,6 +86,7 @@ bool VerifyService::verifyCode(const std::string& email, const std::string& acti
 		std::lock_guard<std::mutex> lock(m_mtx);
 		auto it = m_codes.find(email);
 		if (it == m_codes.end()) {
+			verifyMetrics().missing.inc();
 			return false; // 验证码不存在
 		}
 		pInfo = &it->second;
@@ -50,7 +94,10 @@ bool VerifyService::verifyCode(const std::string& email, const std::string& acti
 
 	// 验证码已过期或操作不匹配
 	auto now = std::chrono::system_clock::now();
-	return !(pInfo->expire_time < now || pInfo->action != action || pInfo->code != verify_code);
+	const bool ok =
+		!(pInfo->expire_time < now || pInfo->action != action || pInfo->code != verify_code);
+	(ok ? verifyMetrics().verified : verifyMetrics().rejected).inc();
+	return ok;
 }
 
 size_t VerifyService::cleanupExpiredCodes() {
@@ -66,6 +113,7 @@ size_t VerifyService::cleanupExpiredCodes() {
 			++it;
 		}
 	}
+	verifyMetrics().pending.set(static_cast<int64_t>(m_codes.size()));
 
 	return count;
 }
@@ -1,8 +1,24 @@
 #include "Server.h"
 #include "../database/DBManager.h"
+#include "../database/UserCache.h"
+#include "../database/PlaylistCache.h"
+#include "../database/StatsEngine.h"
+#include "../database/DeletionJobs.h"
+#include "../database/HistoryPartitions.h"
+#include "../database/SqlStatement.h"
+#include "../database/Storage.h"
 #include "../utils/JsonUtil.h"
 #include "../utils/Config.h"
+#include "../utils/Logging.h"
+#include "../utils/Metrics.h"
+#include "../utils/PerfCounters.h"
+#include "../utils/Tracing.h"
 #include "../handlers/UserHandler.h"
+#include "../handlers/PlaylistHandler.h"
+#include "../handlers/PlayHistoryHandler.h"
+#include "../handlers/LibraryHandler.h"
+#include "../handlers/AdminHandler.h"
+#include "../storage/AvatarStore.h"
 
 #include <spdlog/common.h>
 #include <spdlog/spdlog.h>
@@ -31,17 +47,67 @@ int main() {
 			return 1;
 		}
 
-		spdlog::set_level(spdlog::level::from_str(config->getLogConfig().level));
-		DBManager::init(config->getDatabaseConfig().host, config->getDatabaseConfig().port,
-						config->getDatabaseConfig().user, config->getDatabaseConfig().password,
-						config->getDatabaseConfig().dbname,
-						config->getDatabaseConfig().connection_pool_size);
+		Logging::init(config->getLogConfig());
+		const DatabaseConfig& database = config->getDatabaseConfig();
+		const auto backend = Storage::parseBackend(database.backend);
+		if (!backend) {
+			spdlog::error("Unknown database backend: {}", database.backend);
+			return 1;
+		}
+
+		// memory 后端不连接数据库, 也没有缓存与后台任务
+		const bool use_mysql = *backend == Storage::Backend::MySQL;
+		if (use_mysql) {
+			DBManager::init(database.host, database.port, database.user, database.password,
+							database.dbname, database.connection_pool_size);
+			SqlStats::getInstance()->configure(std::chrono::milliseconds(database.slow_query_ms),
+											   database.max_statements);
+			UserCache::init(std::chrono::seconds(config->getCacheConfig().user_ttl),
+							std::chrono::seconds(config->getCacheConfig().user_negative_ttl),
+							config->getCacheConfig().user_shards);
+			const StatsConfig& stats = config->getStatsConfig();
+			StatsEngine::init(stats.max_users, std::chrono::hours(stats.recompute_interval_hours));
+			const DeletionConfig& deletion = config->getDeletionConfig();
+			DeletionJobs::init(deletion.batch_size,
+							   std::chrono::milliseconds(deletion.batch_interval_ms),
+							   std::chrono::seconds(deletion.poll_interval_seconds),
+							   deletion.max_attempts);
+			const HistoryConfig& history = config->getHistoryConfig();
+			HistoryPartitions::init(history.partition_months_ahead, history.retention_days,
+									std::chrono::hours(history.maintenance_interval_hours),
+									std::chrono::milliseconds(history.compact_interval_ms));
+		}
+		PlaylistCache::init(config->getCacheConfig().playlist_capacity);
+		Storage::init(*backend);
+		const TracingConfig& tracing = config->getTracingConfig();
+		if (tracing.enabled) {
+			Tracer::init(tracing.sample_rate, std::chrono::milliseconds(tracing.slow_threshold_ms),
+						 tracing.export_path, tracing.queue_size, tracing.server_timing);
+		}
+		const StorageConfig& storage = config->getStorageConfig();
+		AvatarStore::init(storage.avatar_path, storage.avatar_cache_capacity,
+						  FileIO::create(storage.file_io_backend, storage.file_io_threads,
+										 storage.io_uring_queue_depth));
+
+		SessionOptions session_options;
+		session_options.pipeline_depth = config->getServerConfig().pipeline_depth;
+		session_options.upload_tmp_dir = config->getServerConfig().upload_tmp_dir;
 
 		Server server(config->getServerConfig().host, config->getServerConfig().port,
-					  config->getServerConfig().threads);
+					  config->getServerConfig().threads, config->getServerConfig().worker_threads,
+					  session_options);
 		g_server = &server;
 		setupRoutes(server);
 		server.run();
+		if (use_mysql) {
+			HistoryPartitions::getInstance()->stop();
+			DeletionJobs::getInstance()->stop();
+			StatsEngine::getInstance()->stop();
+		}
+		if (tracing.enabled) Tracer::getInstance()->stop();
+		// 以 MUSICPLAYER_PERF_COUNTERS 构建时才有区域, 否则不写文件
+		PerfCounters::getInstance()->dump(config->getLogConfig().path + "/perf_counters.txt");
+		Logging::getInstance()->stop();
 
 	} catch (const std::exception& e) {
 		spdlog::error("Exception: {}", e.what());
@@ -82,16 +148,33 @@ void setupRoutes(Server& server) {
 		return user_handler->handleGetProfile(request);
 	});
 
-	// 4.修改用户头像 		POST /users/avatar
-	server.addRouter(http::verb::post, "/users/avatar", [user_handler](const HttpRequest& request) {
-		return user_handler->handleUpdateAvatar(request);
-	});
+	// 4.修改用户头像 		POST /users/avatar (请求体落盘, 不进入内存)
+	server.addUploadRouter(
+		http::verb::post, "/users/avatar",
+		[user_handler](const HttpRequest& request, const std::string& body_file) {
+			return user_handler->handleUpdateAvatar(request, body_file);
+		},
+		UserHandler::AVATAR_BODY_LIMIT);
 
 	// 5.获取用户头像 		GET /users/avatar
 	server.addRouter(http::verb::get, "/users/avatar", [user_handler](const HttpRequest& request) {
 		return user_handler->handleGetAvatar(request);
 	});
 
+	// 5.上传二进制头像 		PUT /users/avatar/raw (请求体即图片数据)
+	server.addUploadRouter(
+		http::verb::put, "/users/avatar/raw",
+		[user_handler](const HttpRequest& request, const std::string& body_file) {
+			return user_handler->handlePutAvatar(request, body_file);
+		},
+		UserHandler::AVATAR_MAX_SIZE);
+
+	// 5.下载二进制头像 		GET /users/avatar/raw (sendfile, 支持 ETag/Range)
+	server.addFileRouter(http::verb::get, "/users/avatar/raw",
+						 [user_handler](const HttpRequest& request) {
+							 return user_handler->handleGetAvatarFile(request);
+						 });
+
 	// 6.修改密码 			POST /users/password
 	server.addRouter(http::verb::post, "/users/password",
 					 [user_handler](const HttpRequest& request) {
@@ -102,63 +185,162 @@ void setupRoutes(Server& server) {
 		return user_handler->handleBindPlatform(request);
 	});
 
-	/*********************************** 歌曲路由 ****************************************/
+	/*********************************** 歌单路由 ****************************************/
+	auto playlist_handler =
+		std::make_shared<PlaylistHandler>(Config::getInstance()->getJWTConfig().secret);
+
 	// 1.歌单列表 			POST /playlists
-	server.addRouter(http::verb::post, "/playlists", [](const HttpRequest& request) {
-		return JsonUtil::buildSuccessResponse(request.version(),
-											  json{{"Playlists retrieved successfully"}}.dump());
-	});
-	// 2.歌单所有歌曲 	 	POST /playlists/songs
-	server.addRouter(http::verb::post, "/playlists/songs", [](const HttpRequest& request) {
-		return JsonUtil::buildSuccessResponse(request.version(),
-											  json{{"All songs in playlist retrieved"}}.dump());
-	});
+	server.addRouter(http::verb::post, "/playlists",
+					 [playlist_handler](const HttpRequest& request) {
+						 return playlist_handler->handleGetPlaylists(request);
+					 });
+	// 2.歌单所有歌曲 	 	GET /playlists/songs?playlist_id= (ETag 为歌单版本)
+	server.addRouter(http::verb::get, "/playlists/songs",
+					 [playlist_handler](const HttpRequest& request) {
+						 return playlist_handler->handleGetSongsInPlaylist(request);
+					 });
+	server.addRouter(http::verb::post, "/playlists/songs",
+					 [playlist_handler](const HttpRequest& request) {
+						 return playlist_handler->handleGetSongsInPlaylist(request);
+					 });
 	// 3.歌单添加歌曲 	 	POST /playlists/add
-	server.addRouter(http::verb::post, "/playlists/add", [](const HttpRequest& request) {
-		return JsonUtil::buildSuccessResponse(request.version(),
-											  json{{"msg", "Song added to playlist"}}.dump());
-	});
+	server.addRouter(http::verb::post, "/playlists/add",
+					 [playlist_handler](const HttpRequest& request) {
+						 return playlist_handler->handleAddSongToPlaylist(request);
+					 });
 	// 4.歌单删除歌曲 	 	POST /playlists/erase
-	server.addRouter(http::verb::post, "/playlists/erase", [](const HttpRequest& request) {
-		return JsonUtil::buildSuccessResponse(request.version(),
-											  json{{"msg", "Song removed from playlist"}}.dump());
-	});
+	server.addRouter(http::verb::post, "/playlists/erase",
+					 [playlist_handler](const HttpRequest& request) {
+						 return playlist_handler->handleRemoveSongFromPlaylist(request);
+					 });
+	// 歌单批量添加/删除歌曲	POST /playlists/add/batch, /playlists/erase/batch
+	server.addRouter(http::verb::post, "/playlists/add/batch",
+					 [playlist_handler](const HttpRequest& request) {
+						 return playlist_handler->handleAddSongsToPlaylist(request);
+					 });
+	server.addRouter(http::verb::post, "/playlists/erase/batch",
+					 [playlist_handler](const HttpRequest& request) {
+						 return playlist_handler->handleRemoveSongsFromPlaylist(request);
+					 });
 	// 5.歌单创建 			POST /playlists/create
-	server.addRouter(http::verb::post, "/playlists/create", [](const HttpRequest& request) {
-		return JsonUtil::buildSuccessResponse(request.version(),
-											  json{{"Playlist created successfully"}}.dump());
-	});
+	server.addRouter(http::verb::post, "/playlists/create",
+					 [playlist_handler](const HttpRequest& request) {
+						 return playlist_handler->handleCreatePlaylist(request);
+					 });
 	// 6.歌单删除 			POST /playlists/delete
-	server.addRouter(http::verb::post, "/playlists/delete", [](const HttpRequest& request) {
-		return JsonUtil::buildSuccessResponse(
-			request.version(), json{{"msg", "Playlist deleted successfully"}}.dump());
-	});
+	server.addRouter(http::verb::post, "/playlists/delete",
+					 [playlist_handler](const HttpRequest& request) {
+						 return playlist_handler->handleDeletePlaylist(request);
+					 });
+	// 7.歌单信息修改 		POST /playlists/update
+	server.addRouter(http::verb::post, "/playlists/update",
+					 [playlist_handler](const HttpRequest& request) {
+						 return playlist_handler->handleUpdatePlaylist(request);
+					 });
+	// 8.歌单详情 			GET /playlists/info?playlist_id=
+	server.addRouter(http::verb::get, "/playlists/info",
+					 [playlist_handler](const HttpRequest& request) {
+						 return playlist_handler->handleGetPlaylistById(request);
+					 });
 
 	/*********************************** 播放历史路由 ****************************************/
+	auto history_handler =
+		std::make_shared<HistoryHandler>(Config::getInstance()->getJWTConfig().secret);
+
 	// 1.播放历史所有歌曲	  	POST	/history
-	server.addRouter(http::verb::post, "/history", [](const HttpRequest& request) {
-		return JsonUtil::buildSuccessResponse(request.version(),
-											  json{{"All songs in history retrieved"}}.dump());
+	server.addRouter(http::verb::post, "/history", [history_handler](const HttpRequest& request) {
+		return history_handler->handleGetHistory(request);
 	});
 	// 2.播放历史添加歌曲 	POST /history/add
-	server.addRouter(http::verb::post, "/history/add", [](const HttpRequest& request) {
-		return JsonUtil::buildSuccessResponse(request.version(),
-											  json{{"Song added to history"}}.dump());
-	});
+	server.addRouter(http::verb::post, "/history/add",
+					 [history_handler](const HttpRequest& request) {
+						 return history_handler->handleAddHistory(request);
+					 });
 	// 3.播放历史删除歌曲 	POST /history/erase
-	server.addRouter(http::verb::post, "/history/erase", [](const HttpRequest& request) {
-		return JsonUtil::buildSuccessResponse(request.version(),
-											  json{{"msg", "Song removed from history"}}.dump());
-	});
+	server.addRouter(http::verb::post, "/history/erase",
+					 [history_handler](const HttpRequest& request) {
+						 return history_handler->handleDeleteHistory(request);
+					 });
 
 	// 4.播放历史清空 		POST /history/clear
-	server.addRouter(http::verb::post, "/history/clear", [](const HttpRequest& request) {
-		return JsonUtil::buildSuccessResponse(request.version(), json{{"History cleared"}}.dump());
-	});
+	server.addRouter(http::verb::post, "/history/clear",
+					 [history_handler](const HttpRequest& request) {
+						 return history_handler->handleClearHistory(request);
+					 });
+
+	// 4.清空任务进度 		GET /history/clear/status?job_id=
+	server.addRouter(http::verb::get, "/history/clear/status",
+					 [history_handler](const HttpRequest& request) {
+						 return history_handler->handleGetClearStatus(request);
+					 });
+
+	// 5.用户最常听的歌曲 POST /history/like
+	server.addRouter(http::verb::post, "/history/like",
+					 [history_handler](const HttpRequest& request) {
+						 return history_handler->handleGetStats(request);
+					 });
+	// 6.播放统计 			GET /history/stats?limit= (O(K), 不扫描播放历史)
+	server.addRouter(http::verb::get, "/history/stats",
+					 [history_handler](const HttpRequest& request) {
+						 return history_handler->handleGetStats(request);
+					 });
+
+	/*********************************** 曲库导入导出路由 ************************************/
+	// 导入导出直接读写 MySQL, 仅 mysql 后端提供
+	if (Storage::getInstance()->backend() == Storage::Backend::MySQL) {
+		auto library_handler =
+			std::make_shared<LibraryHandler>(Config::getInstance()->getJWTConfig().secret);
 
-	// 5.用户最常听的歌曲 GET /history/like
-	server.addRouter(http::verb::post, "/history/like", [](const HttpRequest& request) {
-		return JsonUtil::buildSuccessResponse(request.version(),
-											  json{{"Most played songs retrieved"}}.dump());
+		// 1.导出曲库 			GET /library/export (NDJSON, chunked)
+		server.addFileRouter(http::verb::get, "/library/export",
+							 [library_handler](const HttpRequest& request) {
+								 return library_handler->handleExport(request);
+							 });
+
+		// 2.导入曲库 			POST /library/import (NDJSON, 请求体落盘)
+		server.addUploadRouter(
+			http::verb::post, "/library/import",
+			[library_handler](const HttpRequest& request, const std::string& body_file) {
+				return library_handler->handleImport(request, body_file);
+			},
+			LibraryHandler::IMPORT_BODY_LIMIT);
+	}
+
+	/*********************************** 运维路由 ****************************************/
+	// 1.指标 				GET /metrics (Prometheus 文本格式)
+	server.addRouter(http::verb::get, "/metrics", [](const HttpRequest& request) {
+		HttpResponse res{http::status::ok, request.version()};
+		res.set(http::field::content_type, "text/plain; version=0.0.4");
+		res.set(http::field::server, "MusicPlayer-BackEnd");
+		res.body() = MetricsRegistry::getInstance()->render();
+		res.prepare_payload();
+		return res;
 	});
-}
\ No newline at end of file
+
+	auto admin_handler =
+		std::make_shared<AdminHandler>(Config::getInstance()->getServerConfig().admin_token);
+
+	// 2.SQL 语句统计 		GET /admin/sql/stats?sort=&limit=
+	server.addRouter(http::verb::get, "/admin/sql/stats",
+					 [admin_handler](const HttpRequest& request) {
+						 return admin_handler->handleSqlStats(request);
+					 });
+
+	// 3.捕获执行计划 		POST /admin/sql/explain
+	server.addRouter(http::verb::post, "/admin/sql/explain",
+					 [admin_handler](const HttpRequest& request) {
+						 return admin_handler->handleSqlExplain(request);
+					 });
+
+	// 4.CPU 采样 			GET /admin/profile/cpu?seconds=&hz= (folded 调用栈)
+	server.addRouter(http::verb::get, "/admin/profile/cpu",
+					 [admin_handler](const HttpRequest& request) {
+						 return admin_handler->handleCpuProfile(request);
+					 });
+
+	// 5.堆快照 			GET /admin/profile/heap
+	server.addRouter(http::verb::get, "/admin/profile/heap",
+					 [admin_handler](const HttpRequest& request) {
+						 return admin_handler->handleHeapProfile(request);
+					 });
+}
@@ -0,0 +1,343 @@
+#include "AvatarStore.h"
+
+#include <openssl/evp.h>
+#include <spdlog/spdlog.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <mutex>
+#include <sstream>
+#include <utility>
+
+#include <unistd.h>
+
+constexpr const char* TAG = "[AvatarStore]";
+
+namespace fs = std::filesystem;
+
+std::unique_ptr<AvatarStore> AvatarStore::m_instance = nullptr;
+
+namespace {
+
+std::string toHex(const unsigned char* data, size_t len) {
+	static const char* digits = "0123456789abcdef";
+	std::string hex(len * 2, '0');
+	for (size_t i = 0; i < len; ++i) {
+		hex[2 * i] = digits[data[i] >> 4];
+		hex[2 * i + 1] = digits[data[i] & 0x0F];
+	}
+	return hex;
+}
+
+// SHA-256 增量计算
+class Sha256 {
+public:
+	Sha256() : m_ctx(EVP_MD_CTX_new()) { EVP_DigestInit_ex(m_ctx, EVP_sha256(), nullptr); }
+	~Sha256() { EVP_MD_CTX_free(m_ctx); }
+	Sha256(const Sha256&) = delete;
+	Sha256& operator=(const Sha256&) = delete;
+
+	void update(const void* data, size_t len) { EVP_DigestUpdate(m_ctx, data, len); }
+
+	std::string hexDigest() {
+		std::array<unsigned char, EVP_MAX_MD_SIZE> digest{};
+		unsigned int len = 0;
+		EVP_DigestFinal_ex(m_ctx, digest.data(), &len);
+		return toHex(digest.data(), len);
+	}
+
+private:
+	EVP_MD_CTX* m_ctx;
+};
+
+// 与 path 同目录的临时文件名, 并发写入同一目标时各用各的, 不会互相覆盖
+std::string tempPath(const std::string& path) {
+	static std::atomic<uint64_t> s_seq{0};
+	return path + "." + std::to_string(::getpid()) + "_" +
+		   std::to_string(s_seq.fetch_add(1, std::memory_order_relaxed)) + ".tmp";
+}
+
+// 同一文件系统内 rename, 否则复制到目标目录再 rename
+bool moveFile(const std::string& src, const std::string& dst) {
+	std::error_code ec;
+	fs::rename(src, dst, ec);
+	if (!ec) return true;
+
+	const std::string tmp = tempPath(dst);
+	fs::copy_file(src, tmp, fs::copy_options::overwrite_existing, ec);
+	if (!ec) fs::rename(tmp, dst, ec);
+	if (ec) {
+		spdlog::error("{} Move {} to {} failed: {}", TAG, src, dst, ec.message());
+		std::error_code ignored;
+		fs::remove(tmp, ignored);
+		return false;
+	}
+
+	fs::remove(src, ec);
+	return true;
+}
+
+} // namespace
+
+AvatarStore::AvatarStore(std::string root, size_t cache_capacity, std::unique_ptr<FileIO> io)
+	: m_root(std::move(root)), m_io(std::move(io)), m_cache_capacity(cache_capacity),
+	  m_hits(MetricsRegistry::getInstance()->counter("avatar_cache_hits_total",
+													 "Avatar blobs served from memory")),
+	  m_misses(MetricsRegistry::getInstance()->counter("avatar_cache_misses_total",
+													   "Avatar blob lookups not in memory")),
+	  m_evictions(MetricsRegistry::getInstance()->counter("avatar_cache_evictions_total",
+														  "Avatar blobs evicted from memory")),
+	  m_bytes_gauge(MetricsRegistry::getInstance()->gauge("avatar_cache_bytes",
+														  "Bytes of avatar blobs in memory")),
+	  m_entries_gauge(MetricsRegistry::getInstance()->gauge("avatar_cache_entries",
+															"Avatar blobs in memory")) {
+	fs::create_directories(m_root + "/blobs");
+	fs::create_directories(m_root + "/users");
+}
+
+void AvatarStore::init(std::string root, size_t cache_capacity, std::unique_ptr<FileIO> io) {
+	if (!m_instance) {
+		spdlog::info("{} File I/O backend: {}", TAG, io->name());
+		m_instance.reset(new AvatarStore(std::move(root), cache_capacity, std::move(io)));
+	}
+}
+
+AvatarStore* AvatarStore::getInstance() {
+	if (!m_instance) {
+		throw std::runtime_error("AvatarStore not initialized");
+	}
+
+	return m_instance.get();
+}
+
+bool AvatarStore::putFile(int user_id, const std::string& src_file, AvatarInfo* info) {
+	// 头像受上传路由的 body_limit 限制, 整体读入计算 hash
+	std::string data;
+	std::error_code ec = m_io->readFile(src_file, data);
+	if (ec) {
+		spdlog::error("{} Read {} failed: {}", TAG, src_file, ec.message());
+		return false;
+	}
+
+	const std::string hash = hashData(data);
+	if (!storeBlob(src_file, hash)) return false;
+
+	const uint64_t size = data.size();
+	if (size <= maxEntrySize()) {
+		cachePut(hash, std::make_shared<const std::string>(std::move(data)));
+	}
+
+	return setAvatar(user_id, hash, size, info);
+}
+
+bool AvatarStore::putData(int user_id, const std::string& data, AvatarInfo* info) {
+	const std::string hash = hashData(data);
+
+	std::error_code ec;
+	if (!fs::exists(blobPath(hash), ec)) {
+		const std::string tmp = tempPath(m_root + "/blobs/" + hash);
+		ec = m_io->writeFile(tmp, data, true);
+		if (ec) {
+			spdlog::error("{} Write {} failed: {}", TAG, tmp, ec.message());
+			fs::remove(tmp, ec);
+			return false;
+		}
+		if (!storeBlob(tmp, hash)) return false;
+	}
+
+	// 刚上传的头像通常马上会被读取
+	if (data.size() <= maxEntrySize()) {
+		cachePut(hash, std::make_shared<const std::string>(data));
+	}
+
+	return setAvatar(user_id, hash, data.size(), info);
+}
+
+std::optional<AvatarStore::AvatarInfo> AvatarStore::getInfo(int user_id) {
+	{
+		std::shared_lock<std::shared_mutex> lock(m_index_mtx);
+		auto it = m_index.find(user_id);
+		if (it != m_index.end()) {
+			if (it->second.hash.empty()) return std::nullopt; // 已确认无头像
+			return it->second;
+		}
+	}
+
+	auto info = loadIndex(user_id);
+
+	std::unique_lock<std::shared_mutex> lock(m_index_mtx);
+	// 加载期间可能已被 putFile 更新
+	auto [it, inserted] = m_index.try_emplace(user_id, info.value_or(AvatarInfo{}));
+	if (it->second.hash.empty()) return std::nullopt;
+	return it->second;
+}
+
+std::shared_ptr<const std::string> AvatarStore::getBlob(const std::string& hash) {
+	if (auto data = cacheGet(hash)) {
+		m_hits.inc();
+		return data;
+	}
+	m_misses.inc();
+
+	const std::string path = blobPath(hash);
+	std::error_code ec;
+	uint64_t size = fs::file_size(path, ec);
+	if (ec || size > maxEntrySize()) return nullptr;
+
+	std::string data;
+	ec = m_io->readFile(path, data);
+	if (ec) {
+		spdlog::error("{} Read {} failed: {}", TAG, path, ec.message());
+		return nullptr;
+	}
+
+	auto blob = std::make_shared<const std::string>(std::move(data));
+	cachePut(hash, blob);
+	return blob;
+}
+
+std::string AvatarStore::blobPath(const std::string& hash) const {
+	return m_root + "/blobs/" + hash.substr(0, 2) + "/" + hash;
+}
+
+AvatarStore::CacheStats AvatarStore::stats() const {
+	CacheStats stats;
+	stats.hits = m_hits.value();
+	stats.misses = m_misses.value();
+	stats.evictions = m_evictions.value();
+
+	std::lock_guard<std::mutex> lock(m_cache_mtx);
+	stats.bytes = m_cache_bytes;
+	stats.entries = m_cache.size();
+	return stats;
+}
+
+std::string AvatarStore::indexPath(int user_id) const {
+	return m_root + "/users/" + std::to_string(user_id);
+}
+
+std::string AvatarStore::legacyPath(int user_id) const {
+	return m_root + "/" + std::to_string(user_id);
+}
+
+bool AvatarStore::storeBlob(const std::string& src_file, const std::string& hash) {
+	const std::string path = blobPath(hash);
+
+	std::error_code ec;
+	// 内容已存在, 去重
+	if (fs::exists(path, ec)) {
+		fs::remove(src_file, ec);
+		return true;
+	}
+
+	fs::create_directories(m_root + "/blobs/" + hash.substr(0, 2), ec);
+	return moveFile(src_file, path);
+}
+
+bool AvatarStore::setAvatar(int user_id, const std::string& hash, uint64_t size,
+							AvatarInfo* info) {
+	AvatarInfo avatar;
+	avatar.hash = hash;
+	avatar.size = size;
+	avatar.updated_at = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+
+	// 索引先写临时文件再 rename
+	const std::string path = indexPath(user_id);
+	const std::string tmp = tempPath(path);
+	std::error_code ec = m_io->writeFile(tmp, hash + " " + std::to_string(size) + "\n");
+	if (ec) {
+		spdlog::error("{} Write index for user {} failed: {}", TAG, user_id, ec.message());
+		fs::remove(tmp, ec);
+		return false;
+	}
+
+	{
+		// rename 与内存索引在同一把锁内更新, 并发设置时两者以同一次为准
+		std::unique_lock<std::shared_mutex> lock(m_index_mtx);
+		fs::rename(tmp, path, ec);
+		if (ec) {
+			spdlog::error("{} Commit index for user {} failed: {}", TAG, user_id, ec.message());
+			lock.unlock();
+			fs::remove(tmp, ec);
+			return false;
+		}
+		m_index[user_id] = avatar;
+	}
+
+	if (info != nullptr) *info = std::move(avatar);
+	return true;
+}
+
+std::optional<AvatarStore::AvatarInfo> AvatarStore::loadIndex(int user_id) {
+	const std::string path = indexPath(user_id);
+
+	std::string content;
+	if (!m_io->readFile(path, content)) {
+		AvatarInfo info;
+		std::istringstream iss(content);
+		if (!(iss >> info.hash >> info.size)) return std::nullopt;
+
+		std::error_code ec;
+		auto mtime = fs::last_write_time(path, ec);
+		if (!ec) {
+			// C++17 无 clock_cast, 按当前时间差换算
+			auto sys_now = std::chrono::system_clock::now();
+			auto file_now = fs::file_time_type::clock::now();
+			info.updated_at = std::chrono::system_clock::to_time_t(
+				sys_now + std::chrono::duration_cast<std::chrono::system_clock::duration>(
+							  mtime - file_now));
+		}
+		return info;
+	}
+
+	// 旧版按 user_id 存放的头像, 迁移到 blob 存储
+	const std::string legacy = legacyPath(user_id);
+	std::error_code ec;
+	if (fs::is_regular_file(legacy, ec)) {
+		AvatarInfo info;
+		if (putFile(user_id, legacy, &info)) {
+			spdlog::info("{} Migrated legacy avatar of user {}", TAG, user_id);
+			return info;
+		}
+	}
+
+	return std::nullopt;
+}
+
+std::string AvatarStore::hashData(const std::string& data) {
+	Sha256 sha;
+	sha.update(data.data(), data.size());
+	return sha.hexDigest();
+}
+
+std::shared_ptr<const std::string> AvatarStore::cacheGet(const std::string& hash) {
+	std::lock_guard<std::mutex> lock(m_cache_mtx);
+	auto it = m_cache.find(hash);
+	if (it == m_cache.end()) return nullptr;
+
+	m_lru.splice(m_lru.begin(), m_lru, it->second);
+	return it->second->data;
+}
+
+void AvatarStore::cachePut(const std::string& hash, std::shared_ptr<const std::string> data) {
+	std::lock_guard<std::mutex> lock(m_cache_mtx);
+	if (m_cache.count(hash) > 0) return;
+
+	m_cache_bytes += data->size();
+	m_lru.push_front(CacheEntry{hash, std::move(data)});
+	m_cache.emplace(hash, m_lru.begin());
+
+	while (m_cache_bytes > m_cache_capacity && !m_lru.empty()) {
+		const CacheEntry& victim = m_lru.back();
+		m_cache_bytes -= victim.data->size();
+		m_cache.erase(victim.hash);
+		m_lru.pop_back();
+		m_evictions.inc();
+	}
+
+	m_bytes_gauge.set(static_cast<int64_t>(m_cache_bytes));
+	m_entries_gauge.set(static_cast<int64_t>(m_cache.size()));
+}
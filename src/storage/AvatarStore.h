@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+#include "FileIO.h"
+#include "../utils/Metrics.h"
+
+/**
+ * @brief 头像存储 单例
+ *
+ * 按内容 SHA-256 寻址, 相同图片只存一份:
+ *   <root>/blobs/<hash 前两位>/<hash>	头像数据
+ *   <root>/users/<user_id>			用户当前头像的 hash
+ * 用户→hash 索引常驻内存; 热点头像数据缓存在按字节数限制的 LRU 中.
+ * 头像数据与索引的读写经 FileIO 的同步封装执行, 调用方 (工作线程) 等待 I/O 完成, 存在性与大小
+ * 检查直接同步 stat. 网络线程不受磁盘延迟影响, 但无论选哪种后端, 每个未命中缓存的请求都占用
+ * 一个工作线程直到 I/O 完成; io_uring 后端在这里不减少占用, 只替换执行 I/O 的线程.
+ * 缓存命中/未命中/淘汰与占用导出到 /metrics (avatar_cache_*).
+ */
+class AvatarStore {
+public:
+	struct AvatarInfo {
+		std::string hash;			// 内容 hash, 可直接作为强 ETag
+		uint64_t size = 0;			// 字节数
+		std::time_t updated_at = 0; // 用户设置头像的时间
+	};
+
+	struct CacheStats {
+		uint64_t hits = 0;
+		uint64_t misses = 0;
+		uint64_t evictions = 0;
+		uint64_t bytes = 0;	  // 当前缓存字节数
+		uint64_t entries = 0; // 当前缓存条目数
+	};
+
+	static void init(std::string root, size_t cache_capacity, std::unique_ptr<FileIO> io);
+	static AvatarStore* getInstance();
+
+	/**
+	 * @brief 用已写好的文件设置用户头像, 文件被移动到 blob 目录或在重复时丢弃
+	 * @return 是否成功
+	 */
+	bool putFile(int user_id, const std::string& src_file, AvatarInfo* info = nullptr);
+
+	// 用内存数据设置用户头像
+	bool putData(int user_id, const std::string& data, AvatarInfo* info = nullptr);
+
+	// 用户当前头像信息, 无头像返回 nullopt (不读取头像数据)
+	std::optional<AvatarInfo> getInfo(int user_id);
+
+	/**
+	 * @brief 读取头像数据, 优先命中内存缓存
+	 * @return 头像数据; 不存在或超过单条缓存上限时返回 nullptr (调用方可改用 blobPath 发送文件)
+	 */
+	std::shared_ptr<const std::string> getBlob(const std::string& hash);
+
+	std::string blobPath(const std::string& hash) const;
+
+	CacheStats stats() const;
+
+	~AvatarStore() = default;
+	AvatarStore(const AvatarStore&) = delete;
+	AvatarStore(AvatarStore&&) = delete;
+	AvatarStore& operator=(const AvatarStore&) = delete;
+	AvatarStore& operator=(AvatarStore&&) = delete;
+
+private:
+	AvatarStore(std::string root, size_t cache_capacity, std::unique_ptr<FileIO> io);
+
+	std::string indexPath(int user_id) const;
+	std::string legacyPath(int user_id) const;
+
+	// 将文件纳入 blob 目录, 已存在相同内容时直接丢弃 src_file
+	bool storeBlob(const std::string& src_file, const std::string& hash);
+
+	bool setAvatar(int user_id, const std::string& hash, uint64_t size, AvatarInfo* info);
+	std::optional<AvatarInfo> loadIndex(int user_id);
+
+	static std::string hashData(const std::string& data);
+
+	// 单条数据缓存上限, 超过的头像直接走文件
+	size_t maxEntrySize() const { return m_cache_capacity / 8; }
+
+	// LRU
+	std::shared_ptr<const std::string> cacheGet(const std::string& hash);
+	void cachePut(const std::string& hash, std::shared_ptr<const std::string> data);
+
+private:
+	struct CacheEntry {
+		std::string hash;
+		std::shared_ptr<const std::string> data;
+	};
+
+	std::string m_root;
+	std::unique_ptr<FileIO> m_io;
+
+	// user_id → 头像
+	std::unordered_map<int, AvatarInfo> m_index;
+	mutable std::shared_mutex m_index_mtx;
+
+	// hash → 数据, 链表头部为最近使用
+	std::list<CacheEntry> m_lru;
+	std::unordered_map<std::string, std::list<CacheEntry>::iterator> m_cache;
+	size_t m_cache_capacity;
+	size_t m_cache_bytes = 0;
+	mutable std::mutex m_cache_mtx;
+
+	MetricCounter& m_hits;
+	MetricCounter& m_misses;
+	MetricCounter& m_evictions;
+	MetricGauge& m_bytes_gauge;
+	MetricGauge& m_entries_gauge;
+
+	static std::unique_ptr<AvatarStore> m_instance;
+};
@@ -0,0 +1,339 @@
+#include "FileIO.h"
+#include "../common/FileHandle.h"
+
+#include <boost/asio/post.hpp>
+#include <boost/asio/thread_pool.hpp>
+#include <spdlog/spdlog.h>
+
+#include <cerrno>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef MUSICPLAYER_HAS_IO_URING
+#include <liburing.h>
+#endif
+
+constexpr const char* TAG = "[FileIO]";
+
+namespace {
+
+std::error_code lastError() { return {errno, std::generic_category()}; }
+
+std::error_code openForRead(const std::string& path, FileHandle& file, size_t& size) {
+	file = FileHandle(::open(path.c_str(), O_RDONLY | O_CLOEXEC));
+	if (!file) return lastError();
+
+	struct stat st {};
+	if (::fstat(file.get(), &st) != 0) return lastError();
+
+	size = static_cast<size_t>(st.st_size);
+	return {};
+}
+
+std::error_code openForWrite(const std::string& path, FileHandle& file) {
+	file = FileHandle(::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644));
+	if (!file) return lastError();
+
+	return {};
+}
+
+/**
+ * @brief 线程池后端: 阻塞 pread/pwrite 在独立线程池中执行
+ */
+class ThreadPoolFileIO : public FileIO {
+public:
+	explicit ThreadPoolFileIO(size_t threads) : m_pool(threads > 0 ? threads : 1) {}
+	~ThreadPoolFileIO() override { m_pool.join(); }
+
+	void asyncReadFile(const std::string& path, ReadCallback callback) override {
+		boost::asio::post(m_pool, [path, callback = std::move(callback)]() {
+			FileHandle file;
+			size_t size = 0;
+			std::string data;
+			std::error_code ec = openForRead(path, file, size);
+			if (!ec) {
+				data.resize(size);
+				size_t done = 0;
+				while (done < size) {
+					ssize_t n = ::pread(file.get(), data.data() + done, size - done,
+										static_cast<off_t>(done));
+					if (n < 0 && errno == EINTR) continue;
+					if (n < 0) {
+						ec = lastError();
+						break;
+					}
+					if (n == 0) break; // 文件被截断
+					done += static_cast<size_t>(n);
+				}
+				data.resize(done);
+			}
+			callback(ec, std::move(data));
+		});
+	}
+
+	void asyncWriteFile(const std::string& path, std::string data, bool sync,
+						WriteCallback callback) override {
+		boost::asio::post(m_pool, [path, data = std::move(data), sync,
+								   callback = std::move(callback)]() {
+			FileHandle file;
+			std::error_code ec = openForWrite(path, file);
+			size_t done = 0;
+			while (!ec && done < data.size()) {
+				ssize_t n = ::pwrite(file.get(), data.data() + done, data.size() - done,
+									 static_cast<off_t>(done));
+				if (n < 0 && errno == EINTR) continue;
+				if (n < 0) ec = lastError();
+				else done += static_cast<size_t>(n);
+			}
+			if (!ec && sync && ::fsync(file.get()) != 0) ec = lastError();
+			callback(ec);
+		});
+	}
+
+	const char* name() const override { return "threadpool"; }
+
+private:
+	boost::asio::thread_pool m_pool;
+};
+
+#ifdef MUSICPLAYER_HAS_IO_URING
+
+/**
+ * @brief io_uring 后端
+ *
+ * 所有线程共享一个 ring, 提交侧加锁; 单独的完成线程收割 CQE 并分发回调.
+ * 短读/短写在完成线程中续提交, 写入需要落盘时追加一次 fsync.
+ */
+class UringFileIO : public FileIO {
+	struct Request {
+		enum class Op { Read, Write, Fsync };
+
+		Op op;
+		FileHandle file;
+		std::string data;
+		size_t done = 0;
+		bool sync = false;
+		ReadCallback on_read;
+		WriteCallback on_write;
+	};
+
+public:
+	explicit UringFileIO(unsigned queue_depth) {
+		int ret = io_uring_queue_init(queue_depth, &m_ring, 0);
+		if (ret < 0) {
+			throw std::system_error(-ret, std::generic_category(), "io_uring_queue_init");
+		}
+		m_thread = std::thread([this]() { completionLoop(); });
+	}
+
+	~UringFileIO() override {
+		// 以 user_data 为空的 NOP 通知完成线程退出
+		{
+			std::lock_guard<std::mutex> lock(m_submit_mtx);
+			io_uring_sqe* sqe = getSqe();
+			if (sqe != nullptr) {
+				io_uring_prep_nop(sqe);
+				io_uring_sqe_set_data(sqe, nullptr);
+				io_uring_submit(&m_ring);
+			}
+		}
+		if (m_thread.joinable()) m_thread.join();
+		io_uring_queue_exit(&m_ring);
+	}
+
+	void asyncReadFile(const std::string& path, ReadCallback callback) override {
+		auto* req = new Request{};
+		req->op = Request::Op::Read;
+		req->on_read = std::move(callback);
+
+		size_t size = 0;
+		std::error_code ec = openForRead(path, req->file, size);
+		if (ec || size == 0) {
+			complete(req, ec);
+			return;
+		}
+
+		req->data.resize(size);
+		submit(req);
+	}
+
+	void asyncWriteFile(const std::string& path, std::string data, bool sync,
+						WriteCallback callback) override {
+		auto* req = new Request{};
+		req->op = Request::Op::Write;
+		req->data = std::move(data);
+		req->sync = sync;
+		req->on_write = std::move(callback);
+
+		std::error_code ec = openForWrite(path, req->file);
+		if (ec) {
+			complete(req, ec);
+			return;
+		}
+
+		// 空文件只需 fsync
+		if (req->data.empty()) {
+			if (!sync) {
+				complete(req, {});
+				return;
+			}
+			req->op = Request::Op::Fsync;
+		}
+
+		submit(req);
+	}
+
+	const char* name() const override { return "io_uring"; }
+
+private:
+	// 调用方持有 m_submit_mtx
+	io_uring_sqe* getSqe() {
+		io_uring_sqe* sqe = io_uring_get_sqe(&m_ring);
+		if (sqe == nullptr) {
+			// SQ 已满, 先提交再取
+			io_uring_submit(&m_ring);
+			sqe = io_uring_get_sqe(&m_ring);
+		}
+		return sqe;
+	}
+
+	void submit(Request* req) {
+		std::lock_guard<std::mutex> lock(m_submit_mtx);
+		io_uring_sqe* sqe = getSqe();
+		if (sqe == nullptr) {
+			complete(req, std::make_error_code(std::errc::resource_unavailable_try_again));
+			return;
+		}
+
+		const size_t remaining = req->data.size() - req->done;
+		switch (req->op) {
+			case Request::Op::Read:
+				io_uring_prep_read(sqe, req->file.get(), req->data.data() + req->done,
+								   static_cast<unsigned>(remaining), req->done);
+				break;
+			case Request::Op::Write:
+				io_uring_prep_write(sqe, req->file.get(), req->data.data() + req->done,
+									static_cast<unsigned>(remaining), req->done);
+				break;
+			case Request::Op::Fsync:
+				io_uring_prep_fsync(sqe, req->file.get(), 0);
+				break;
+		}
+		io_uring_sqe_set_data(sqe, req);
+		io_uring_submit(&m_ring);
+	}
+
+	void completionLoop() {
+		while (true) {
+			io_uring_cqe* cqe = nullptr;
+			int ret = io_uring_wait_cqe(&m_ring, &cqe);
+			if (ret == -EINTR) continue;
+			if (ret < 0) {
+				spdlog::error("{} io_uring_wait_cqe failed: {}", TAG, -ret);
+				return;
+			}
+
+			auto* req = static_cast<Request*>(io_uring_cqe_get_data(cqe));
+			const int res = cqe->res;
+			io_uring_cqe_seen(&m_ring, cqe);
+
+			if (req == nullptr) return; // 退出信号
+			onComplete(req, res);
+		}
+	}
+
+	void onComplete(Request* req, int res) {
+		if (res < 0) {
+			if (res == -EINTR || res == -EAGAIN) {
+				submit(req);
+				return;
+			}
+			complete(req, {-res, std::generic_category()});
+			return;
+		}
+
+		switch (req->op) {
+			case Request::Op::Read:
+				req->done += static_cast<size_t>(res);
+				// res == 0: 文件被截断, 按已读内容返回
+				if (res > 0 && req->done < req->data.size()) {
+					submit(req);
+					return;
+				}
+				req->data.resize(req->done);
+				break;
+			case Request::Op::Write:
+				req->done += static_cast<size_t>(res);
+				if (req->done < req->data.size()) {
+					submit(req);
+					return;
+				}
+				if (req->sync) {
+					req->op = Request::Op::Fsync;
+					submit(req);
+					return;
+				}
+				break;
+			case Request::Op::Fsync:
+				break;
+		}
+
+		complete(req, {});
+	}
+
+	static void complete(Request* req, std::error_code ec) {
+		std::unique_ptr<Request> owner(req);
+		if (req->on_read) req->on_read(ec, std::move(req->data));
+		if (req->on_write) req->on_write(ec);
+	}
+
+private:
+	io_uring m_ring{};
+	std::mutex m_submit_mtx;
+	std::thread m_thread;
+};
+
+#endif // MUSICPLAYER_HAS_IO_URING
+
+} // namespace
+
+std::error_code FileIO::readFile(const std::string& path, std::string& data) {
+	std::promise<std::error_code> done;
+	auto future = done.get_future();
+	asyncReadFile(path, [&done, &data](std::error_code ec, std::string result) {
+		data = std::move(result);
+		done.set_value(ec);
+	});
+	return future.get();
+}
+
+std::error_code FileIO::writeFile(const std::string& path, std::string data, bool sync) {
+	std::promise<std::error_code> done;
+	auto future = done.get_future();
+	asyncWriteFile(path, std::move(data), sync,
+				   [&done](std::error_code ec) { done.set_value(ec); });
+	return future.get();
+}
+
+std::unique_ptr<FileIO> FileIO::create(const std::string& backend, size_t threads,
+									   [[maybe_unused]] unsigned queue_depth) {
+	if (backend == "io_uring") {
+#ifdef MUSICPLAYER_HAS_IO_URING
+		try {
+			return std::make_unique<UringFileIO>(queue_depth);
+		} catch (const std::system_error& e) {
+			spdlog::warn("{} io_uring unavailable ({}), fallback to threadpool", TAG, e.what());
+		}
+#else
+		spdlog::warn("{} Built without liburing, fallback to threadpool", TAG);
+#endif
+	}
+
+	return std::make_unique<ThreadPoolFileIO>(threads);
+}
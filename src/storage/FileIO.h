@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <system_error>
+
+/**
+ * @brief 异步文件 I/O 接口
+ *
+ * 回调在 I/O 线程(线程池线程或 io_uring 完成线程)中执行, 不可阻塞.
+ * 实现:
+ *   threadpool	独立线程池执行阻塞 pread/pwrite
+ *   io_uring	单个 ring 提交读写, 完成线程分发回调 (编译时需 liburing)
+ */
+class FileIO {
+public:
+	using ReadCallback = std::function<void(std::error_code ec, std::string data)>;
+	using WriteCallback = std::function<void(std::error_code ec)>;
+
+	virtual ~FileIO() = default;
+
+	// 读取整个文件
+	virtual void asyncReadFile(const std::string& path, ReadCallback callback) = 0;
+
+	// 写入(覆盖)文件, sync 为 true 时落盘后才回调
+	virtual void asyncWriteFile(const std::string& path, std::string data, bool sync,
+								WriteCallback callback) = 0;
+
+	virtual const char* name() const = 0;
+
+	// 同步封装, 供工作线程调用: 调用线程阻塞到 I/O 完成, 后端为 io_uring 时也是如此
+	std::error_code readFile(const std::string& path, std::string& data);
+	std::error_code writeFile(const std::string& path, std::string data, bool sync = false);
+
+	/**
+	 * @brief 创建 I/O 后端
+	 * @param backend "io_uring" 或 "threadpool", io_uring 不可用时回退到线程池
+	 * @param threads 线程池线程数
+	 * @param queue_depth io_uring 队列深度
+	 */
+	static std::unique_ptr<FileIO> create(const std::string& backend, size_t threads,
+										  unsigned queue_depth);
+};
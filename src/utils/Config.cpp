@@ -47,6 +47,14 @@ bool Config::loadFromFile(const std::string& filename) {
 		else
 			return false;
 
+		// 可选, 缺省使用默认值
+		if (config_json.contains("storage")) parseStorageConfig(config_json["storage"]);
+		if (config_json.contains("cache")) parseCacheConfig(config_json["cache"]);
+		if (config_json.contains("stats")) parseStatsConfig(config_json["stats"]);
+		if (config_json.contains("deletion")) parseDeletionConfig(config_json["deletion"]);
+		if (config_json.contains("history")) parseHistoryConfig(config_json["history"]);
+		if (config_json.contains("tracing")) parseTracingConfig(config_json["tracing"]);
+
 		if (config_json.contains("verify_service"))
 			parseVerifyServiceConfig(config_json["verify_service"]);
 		else
@@ -98,6 +106,15 @@ void Config::parseDatabaseConfig(const nlohmann::json& j) {
 		m_db_config.connection_timeout = j["connection_timeout"].get<uint32_t>();
 	else
 		throw std::runtime_error("Database connection timeout is required");
+
+	if (j.contains("slow_query_ms") && j["slow_query_ms"].is_number_integer())
+		m_db_config.slow_query_ms = j["slow_query_ms"].get<uint32_t>();
+
+	if (j.contains("max_statements") && j["max_statements"].is_number_integer())
+		m_db_config.max_statements = j["max_statements"].get<size_t>();
+
+	if (j.contains("backend") && j["backend"].is_string())
+		m_db_config.backend = j["backend"].get<std::string>();
 }
 
 void Config::parseServerConfig(const nlohmann::json& j) {
@@ -120,6 +137,18 @@ void Config::parseServerConfig(const nlohmann::json& j) {
 		m_server_config.request_timeout = j["request_timeout"].get<uint32_t>();
 	else
 		throw std::runtime_error("Server request timeout is required");
+
+	if (j.contains("worker_threads") && j["worker_threads"].is_number_integer())
+		m_server_config.worker_threads = j["worker_threads"].get<int>();
+
+	if (j.contains("pipeline_depth") && j["pipeline_depth"].is_number_integer())
+		m_server_config.pipeline_depth = j["pipeline_depth"].get<size_t>();
+
+	if (j.contains("upload_tmp_dir") && j["upload_tmp_dir"].is_string())
+		m_server_config.upload_tmp_dir = j["upload_tmp_dir"].get<std::string>();
+
+	if (j.contains("admin_token") && j["admin_token"].is_string())
+		m_server_config.admin_token = j["admin_token"].get<std::string>();
 }
 
 void Config::parseJWTConfig(const nlohmann::json& j) {
@@ -149,6 +178,38 @@ void Config::parseLogConfig(const nlohmann::json& j) {
 		m_log_config.path = j["path"].get<std::string>();
 	else
 		throw std::runtime_error("Log path is required");
+
+	if (j.contains("queue_size") && j["queue_size"].is_number_integer())
+		m_log_config.queue_size = j["queue_size"].get<uint32_t>();
+
+	if (j.contains("max_file_mb") && j["max_file_mb"].is_number_integer())
+		m_log_config.max_file_mb = j["max_file_mb"].get<uint32_t>();
+
+	if (j.contains("max_files") && j["max_files"].is_number_integer())
+		m_log_config.max_files = j["max_files"].get<uint32_t>();
+
+	// {"info": {"sample_rate": 0.1, "per_second": 1000}, ...}
+	auto parseLimits = [](const nlohmann::json& limits) {
+		std::map<std::string, LogLevelLimit> out;
+		if (!limits.is_object()) return out;
+		for (const auto& [level, limit] : limits.items()) {
+			LogLevelLimit& item = out[level];
+			if (limit.contains("sample_rate") && limit["sample_rate"].is_number())
+				item.sample_rate = limit["sample_rate"].get<double>();
+			if (limit.contains("per_second") && limit["per_second"].is_number_integer())
+				item.per_second = limit["per_second"].get<uint32_t>();
+		}
+		return out;
+	};
+
+	if (j.contains("limits")) m_log_config.limits = parseLimits(j["limits"]);
+
+	if (j.contains("access") && j["access"].is_object()) {
+		const auto& access = j["access"];
+		if (access.contains("enabled") && access["enabled"].is_boolean())
+			m_log_config.access_log = access["enabled"].get<bool>();
+		if (access.contains("limits")) m_log_config.access_limits = parseLimits(access["limits"]);
+	}
 }
 
 void Config::parseVerifyServiceConfig(const nlohmann::json& j) {
@@ -177,3 +238,92 @@ void Config::parseVerifyServiceConfig(const nlohmann::json& j) {
 	else
 		throw std::runtime_error("Email from is required");
 }
+
+void Config::parseStorageConfig(const nlohmann::json& j) {
+	if (j.contains("avatar_path") && j["avatar_path"].is_string())
+		m_storage_config.avatar_path = j["avatar_path"].get<std::string>();
+
+	if (j.contains("avatar_cache_capacity") && j["avatar_cache_capacity"].is_number_integer())
+		m_storage_config.avatar_cache_capacity = j["avatar_cache_capacity"].get<size_t>();
+
+	if (j.contains("file_io_backend") && j["file_io_backend"].is_string())
+		m_storage_config.file_io_backend = j["file_io_backend"].get<std::string>();
+
+	if (j.contains("file_io_threads") && j["file_io_threads"].is_number_integer())
+		m_storage_config.file_io_threads = j["file_io_threads"].get<size_t>();
+
+	if (j.contains("io_uring_queue_depth") && j["io_uring_queue_depth"].is_number_integer())
+		m_storage_config.io_uring_queue_depth = j["io_uring_queue_depth"].get<unsigned>();
+}
+
+void Config::parseCacheConfig(const nlohmann::json& j) {
+	if (j.contains("user_ttl") && j["user_ttl"].is_number_integer())
+		m_cache_config.user_ttl = j["user_ttl"].get<uint32_t>();
+
+	if (j.contains("user_negative_ttl") && j["user_negative_ttl"].is_number_integer())
+		m_cache_config.user_negative_ttl = j["user_negative_ttl"].get<uint32_t>();
+
+	if (j.contains("user_shards") && j["user_shards"].is_number_integer())
+		m_cache_config.user_shards = j["user_shards"].get<size_t>();
+
+	if (j.contains("playlist_capacity") && j["playlist_capacity"].is_number_integer())
+		m_cache_config.playlist_capacity = j["playlist_capacity"].get<size_t>();
+}
+
+void Config::parseStatsConfig(const nlohmann::json& j) {
+	if (j.contains("max_users") && j["max_users"].is_number_integer())
+		m_stats_config.max_users = j["max_users"].get<size_t>();
+
+	if (j.contains("recompute_interval_hours") && j["recompute_interval_hours"].is_number_integer())
+		m_stats_config.recompute_interval_hours = j["recompute_interval_hours"].get<uint32_t>();
+}
+
+void Config::parseDeletionConfig(const nlohmann::json& j) {
+	if (j.contains("batch_size") && j["batch_size"].is_number_integer())
+		m_deletion_config.batch_size = j["batch_size"].get<size_t>();
+
+	if (j.contains("batch_interval_ms") && j["batch_interval_ms"].is_number_integer())
+		m_deletion_config.batch_interval_ms = j["batch_interval_ms"].get<uint32_t>();
+
+	if (j.contains("poll_interval_seconds") && j["poll_interval_seconds"].is_number_integer())
+		m_deletion_config.poll_interval_seconds = j["poll_interval_seconds"].get<uint32_t>();
+
+	if (j.contains("max_attempts") && j["max_attempts"].is_number_integer())
+		m_deletion_config.max_attempts = j["max_attempts"].get<uint32_t>();
+}
+
+void Config::parseHistoryConfig(const nlohmann::json& j) {
+	if (j.contains("partition_months_ahead") && j["partition_months_ahead"].is_number_integer())
+		m_history_config.partition_months_ahead = j["partition_months_ahead"].get<uint32_t>();
+
+	if (j.contains("retention_days") && j["retention_days"].is_number_integer())
+		m_history_config.retention_days = j["retention_days"].get<uint32_t>();
+
+	if (j.contains("maintenance_interval_hours") &&
+		j["maintenance_interval_hours"].is_number_integer())
+		m_history_config.maintenance_interval_hours =
+			j["maintenance_interval_hours"].get<uint32_t>();
+
+	if (j.contains("compact_interval_ms") && j["compact_interval_ms"].is_number_integer())
+		m_history_config.compact_interval_ms = j["compact_interval_ms"].get<uint32_t>();
+}
+
+void Config::parseTracingConfig(const nlohmann::json& j) {
+	if (j.contains("enabled") && j["enabled"].is_boolean())
+		m_tracing_config.enabled = j["enabled"].get<bool>();
+
+	if (j.contains("sample_rate") && j["sample_rate"].is_number())
+		m_tracing_config.sample_rate = j["sample_rate"].get<double>();
+
+	if (j.contains("slow_threshold_ms") && j["slow_threshold_ms"].is_number_integer())
+		m_tracing_config.slow_threshold_ms = j["slow_threshold_ms"].get<uint32_t>();
+
+	if (j.contains("export_path") && j["export_path"].is_string())
+		m_tracing_config.export_path = j["export_path"].get<std::string>();
+
+	if (j.contains("queue_size") && j["queue_size"].is_number_integer())
+		m_tracing_config.queue_size = j["queue_size"].get<uint32_t>();
+
+	if (j.contains("server_timing") && j["server_timing"].is_boolean())
+		m_tracing_config.server_timing = j["server_timing"].get<bool>();
+}
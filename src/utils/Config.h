@@ -1,5 +1,6 @@
 #pragma once
 
+#include <map>
 #include <memory>
 #include <string>
 #include <cstdint>
@@ -16,13 +17,20 @@ struct DatabaseConfig {
 	std::string dbname;
 	size_t connection_pool_size = 5;
 	uint32_t connection_timeout = 3; // 秒
+	uint32_t slow_query_ms = 200;	 // 慢查询日志阈值
+	size_t max_statements = 256;	 // 按语句统计的语句数上限
+	std::string backend = "mysql";	 // DAO 存储后端: mysql / memory
 };
 
 struct ServerConfig {
 	std::string host = "0.0.0.0";
 	uint16_t port = 8080;
 	int threads = 4;
-	uint32_t request_timeout = 30; // 秒
+	uint32_t request_timeout = 30;			  // 秒
+	int worker_threads = 4;					  // 请求处理线程数
+	size_t pipeline_depth = 8;				  // 单连接最大流水线请求数
+	std::string upload_tmp_dir = "./uploads"; // 上传请求体落盘目录
+	std::string admin_token;				  // 管理接口令牌 (X-Admin-Token), 为空时关闭
 };
 
 struct JWTConfig {
@@ -31,9 +39,20 @@ struct JWTConfig {
 	std::string issuer = "music-player-backend";
 };
 
+struct LogLevelLimit {
+	double sample_rate = 1.0; // 保留比例
+	uint32_t per_second = 0;  // 每秒上限, 0 不限
+};
+
 struct LogConfig {
-	std::string level = "info";		   // 日志级别
-	std::string path = "logs/app.log"; // 日志文件路径
+	std::string level = "info";	   // 日志级别
+	std::string path = "logs";	   // 日志目录 (app.log, access.log)
+	uint32_t queue_size = 8192;	   // 异步队列容量 (条), 满时丢弃
+	uint32_t max_file_mb = 64;	   // 单个文件上限, 超过后滚动
+	uint32_t max_files = 5;		   // 保留的滚动文件数
+	bool access_log = true;		   // 访问日志
+	std::map<std::string, LogLevelLimit> limits;		// 应用日志按级别名的限额
+	std::map<std::string, LogLevelLimit> access_limits; // 访问日志按级别名的限额
 };
 
 struct VerifyServiceConfig {
@@ -44,6 +63,49 @@ struct VerifyServiceConfig {
 	std::string email_from;
 };
 
+struct StorageConfig {
+	std::string avatar_path = "./avatars";			  // 头像存储根目录
+	size_t avatar_cache_capacity = 64 * 1024 * 1024; // 头像内存缓存上限(字节)
+	std::string file_io_backend = "threadpool";		  // 文件 I/O 后端: io_uring / threadpool
+	size_t file_io_threads = 4;						  // threadpool 后端线程数
+	unsigned io_uring_queue_depth = 64;				  // io_uring 队列深度
+};
+
+struct CacheConfig {
+	uint32_t user_ttl = 300;		  // 用户缓存有效期(秒)
+	uint32_t user_negative_ttl = 30; // "用户不存在" 缓存有效期(秒)
+	size_t user_shards = 16;		  // 用户缓存分片数
+	size_t playlist_capacity = 10000; // 歌单内容缓存条目数
+};
+
+struct StatsConfig {
+	size_t max_users = 10000;			  // 内存中缓存统计的用户数
+	uint32_t recompute_interval_hours = 24; // 由播放历史重算汇总表的间隔, 0 关闭
+};
+
+struct DeletionConfig {
+	size_t batch_size = 1000;			// 每批删除的行数, 每批一个事务
+	uint32_t batch_interval_ms = 50;	// 批之间的间隔, 给 purge 与其他事务让出资源
+	uint32_t poll_interval_seconds = 5; // 空闲时检查新任务的间隔
+	uint32_t max_attempts = 5;			// 连续失败次数上限, 超过后标记为 failed
+};
+
+struct HistoryConfig {
+	uint32_t partition_months_ahead = 3;	 // 提前创建的未来月分区数
+	uint32_t retention_days = 90;			 // 明细保留天数, 更早的分区按日汇总后删除
+	uint32_t maintenance_interval_hours = 24; // 分区维护间隔, 0 只在启动时执行一次
+	uint32_t compact_interval_ms = 50;		 // 逐日汇总之间的间隔
+};
+
+struct TracingConfig {
+	bool enabled = true;
+	double sample_rate = 0.01;					// 按比例采样导出
+	uint32_t slow_threshold_ms = 500;			// 总耗时不小于该值的请求总是导出
+	std::string export_path = "logs/traces.jsonl"; // OTLP JSON, 每行一个请求
+	uint32_t queue_size = 1024;					// 待导出队列上限, 满时丢弃
+	bool server_timing = false;					// 响应附带 Server-Timing 头
+};
+
 class Config {
 public:
 	~Config() = default;
@@ -68,6 +130,18 @@ public:
 
 	const VerifyServiceConfig& getVerifyServiceConfig() const { return m_verify_service_config; }
 
+	const StorageConfig& getStorageConfig() const { return m_storage_config; }
+
+	const CacheConfig& getCacheConfig() const { return m_cache_config; }
+
+	const StatsConfig& getStatsConfig() const { return m_stats_config; }
+
+	const DeletionConfig& getDeletionConfig() const { return m_deletion_config; }
+
+	const HistoryConfig& getHistoryConfig() const { return m_history_config; }
+
+	const TracingConfig& getTracingConfig() const { return m_tracing_config; }
+
 private:
 	Config() = default;
 	void parseDatabaseConfig(const nlohmann::json& j);
@@ -75,6 +149,12 @@ private:
 	void parseJWTConfig(const nlohmann::json& j);
 	void parseLogConfig(const nlohmann::json& j);
 	void parseVerifyServiceConfig(const nlohmann::json& j);
+	void parseStorageConfig(const nlohmann::json& j);
+	void parseCacheConfig(const nlohmann::json& j);
+	void parseStatsConfig(const nlohmann::json& j);
+	void parseDeletionConfig(const nlohmann::json& j);
+	void parseHistoryConfig(const nlohmann::json& j);
+	void parseTracingConfig(const nlohmann::json& j);
 
 private:
 	DatabaseConfig m_db_config;
@@ -82,6 +162,12 @@ private:
 	JWTConfig m_jwt_config;
 	LogConfig m_log_config;
 	VerifyServiceConfig m_verify_service_config;
+	StorageConfig m_storage_config;
+	CacheConfig m_cache_config;
+	StatsConfig m_stats_config;
+	DeletionConfig m_deletion_config;
+	HistoryConfig m_history_config;
+	TracingConfig m_tracing_config;
 
 	static std::unique_ptr<Config> m_instance;
 };
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include <spdlog/spdlog.h>
 
 #include <random>
+#include <regex>
 #include <sstream>
 #include <string>
 
@@ -76,6 +77,12 @@ std::string EmailUtil::generateVerificationCode(int length) {
 	return code;
 }
 
+bool EmailUtil::isValidEmail(const std::string& email) {
+	// 只编译一次; regex_match 不修改 regex, 可多线程共用
+	static const std::regex email_regex(R"((^[a-zA-Z0-9_.+-]+@[a-zA-Z0-9-]+\.[a-zA-Z0-9-.]+$))");
+	return std::regex_match(email, email_regex);
+}
+
 size_t EmailUtil::readCallback(void* ptr, size_t size, size_t nmemb, void* data) {
 	EmailData* email_data = static_cast<EmailData*>(data);
 	size_t buffer_size = size * nmemb;
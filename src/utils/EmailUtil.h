@@ -17,6 +17,9 @@ public:
 
 	static std::string generateVerificationCode(int length = 6);
 
+	// 验证邮箱格式
+	static bool isValidEmail(const std::string& email);
+
 private:
 	static size_t readCallback(void* ptr, size_t size, size_t nmemb, void* data);
 };
\ No newline at end of file
@@ -0,0 +1,123 @@
+#include "HttpUtil.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <string_view>
+
+std::string HttpUtil::formatHttpDate(std::time_t t) {
+	std::tm tm{};
+	gmtime_r(&t, &tm);
+
+	char buf[64];
+	size_t n = std::strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+	return {buf, n};
+}
+
+std::optional<std::time_t> HttpUtil::parseHttpDate(const std::string& date) {
+	std::tm tm{};
+	const char* end = strptime(date.c_str(), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+	if (end == nullptr) return std::nullopt;
+
+	return timegm(&tm);
+}
+
+bool HttpUtil::etagMatches(beast::string_view if_none_match, const std::string& etag) {
+	std::string_view header(if_none_match.data(), if_none_match.size());
+	std::string_view target(etag);
+	if (target.substr(0, 2) == "W/") target.remove_prefix(2);
+
+	while (!header.empty()) {
+		size_t comma = header.find(',');
+		std::string_view item = header.substr(0, comma);
+		header = comma == std::string_view::npos ? std::string_view{} : header.substr(comma + 1);
+
+		while (!item.empty() && std::isspace(static_cast<unsigned char>(item.front())))
+			item.remove_prefix(1);
+		while (!item.empty() && std::isspace(static_cast<unsigned char>(item.back())))
+			item.remove_suffix(1);
+
+		if (item == "*") return true;
+		if (item.substr(0, 2) == "W/") item.remove_prefix(2);
+		if (item == target) return true;
+	}
+
+	return false;
+}
+
+std::optional<HttpUtil::ByteRange> HttpUtil::parseRange(beast::string_view range, uint64_t size,
+														bool& satisfiable) {
+	satisfiable = true;
+
+	std::string_view spec(range.data(), range.size());
+	if (spec.substr(0, 6) != "bytes=") return std::nullopt;
+	spec.remove_prefix(6);
+
+	// 多区间不支持, 返回完整内容
+	if (spec.find(',') != std::string_view::npos) return std::nullopt;
+
+	size_t dash = spec.find('-');
+	if (dash == std::string_view::npos) return std::nullopt;
+
+	auto parseNumber = [](std::string_view s, uint64_t& out) {
+		if (s.empty() || s.size() > 19) return false;
+		out = 0;
+		for (char c : s) {
+			if (c < '0' || c > '9') return false;
+			out = out * 10 + static_cast<uint64_t>(c - '0');
+		}
+		return true;
+	};
+
+	std::string_view first = spec.substr(0, dash);
+	std::string_view last = spec.substr(dash + 1);
+	uint64_t start = 0;
+	uint64_t end = 0;
+
+	if (first.empty()) {
+		// bytes=-n 最后 n 个字节
+		uint64_t suffix = 0;
+		if (!parseNumber(last, suffix)) return std::nullopt;
+		if (suffix == 0 || size == 0) {
+			satisfiable = false;
+			return std::nullopt;
+		}
+		start = suffix >= size ? 0 : size - suffix;
+		end = size - 1;
+	} else {
+		if (!parseNumber(first, start)) return std::nullopt;
+		if (last.empty()) {
+			end = size == 0 ? 0 : size - 1;
+		} else if (!parseNumber(last, end) || end < start) {
+			return std::nullopt;
+		}
+
+		if (start >= size) {
+			satisfiable = false;
+			return std::nullopt;
+		}
+		if (end >= size) end = size - 1;
+	}
+
+	return ByteRange{start, end - start + 1};
+}
+
+std::optional<std::string> HttpUtil::getQueryParam(beast::string_view target,
+												   const std::string& name) {
+	std::string_view view(target.data(), target.size());
+	size_t pos = view.find('?');
+	if (pos == std::string_view::npos) return std::nullopt;
+	view.remove_prefix(pos + 1);
+
+	while (!view.empty()) {
+		size_t amp = view.find('&');
+		std::string_view pair = view.substr(0, amp);
+		view = amp == std::string_view::npos ? std::string_view{} : view.substr(amp + 1);
+
+		size_t eq = pair.find('=');
+		if (pair.substr(0, eq) == name) {
+			return eq == std::string_view::npos ? std::string{} : std::string(pair.substr(eq + 1));
+		}
+	}
+
+	return std::nullopt;
+}
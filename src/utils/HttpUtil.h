@@ -0,0 +1,37 @@
+#pragma once
+#include "../common/net.h"
+
+#include <cstdint>
+#include <ctime>
+#include <optional>
+#include <string>
+
+/**
+ * @brief HTTP 缓存/条件请求/Range 辅助函数
+ */
+class HttpUtil {
+public:
+	struct ByteRange {
+		uint64_t offset = 0;
+		uint64_t length = 0;
+	};
+
+	// RFC 7231 IMF-fixdate, 如 "Sun, 06 Nov 1994 08:49:37 GMT"
+	static std::string formatHttpDate(std::time_t t);
+	static std::optional<std::time_t> parseHttpDate(const std::string& date);
+
+	// If-None-Match 是否命中 etag (支持 "*" 与逗号分隔的列表, 弱比较)
+	static bool etagMatches(beast::string_view if_none_match, const std::string& etag);
+
+	/**
+	 * @brief 解析单区间 Range 头 (bytes=a-b / bytes=a- / bytes=-n)
+	 * @return 区间; 多区间或格式不支持时返回 nullopt (按完整响应处理)
+	 * @param satisfiable 区间超出文件大小时置 false (应返回 416)
+	 */
+	static std::optional<ByteRange> parseRange(beast::string_view range, uint64_t size,
+											   bool& satisfiable);
+
+	// 查询参数, 如 target "/a?x=1&y=2" 取 "y" 得 "2"
+	static std::optional<std::string> getQueryParam(beast::string_view target,
+													const std::string& name);
+};
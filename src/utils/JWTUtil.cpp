@@ -1,6 +1,35 @@
 #include "JWTUtil.h"
+#include "Logging.h"
+#include "Metrics.h"
+#include "PerfCounters.h"
+#include "Tracing.h"
+
 #include <string>
 
+namespace {
+
+struct JwtMetrics {
+	MetricHistogram& verify;
+	MetricCounter& ok;
+	MetricCounter& expired;
+	MetricCounter& invalid;
+};
+
+JwtMetrics& jwtMetrics() {
+	static JwtMetrics metrics = []() {
+		auto* registry = MetricsRegistry::getInstance();
+		const std::string help = "JWT verifications by result";
+		return JwtMetrics{
+			registry->histogram("jwt_verify_duration_seconds", "Time spent verifying a JWT"),
+			registry->counter("jwt_verifications_total", help, {{"result", "ok"}}),
+			registry->counter("jwt_verifications_total", help, {{"result", "expired"}}),
+			registry->counter("jwt_verifications_total", help, {{"result", "invalid"}})};
+	}();
+	return metrics;
+}
+
+} // namespace
+
 // 生成 JWT Token
 std::string JWTUtil::generateToken(const std::string& subject,
 								   const std::map<std::string, std::string>& claims,
@@ -28,6 +57,10 @@ std::string JWTUtil::generateToken(const std::string& subject,
 
 // 验证 JWT Token 返回解码后的 JWT
 std::string JWTUtil::verifyToken(const std::string& token) const {
+	JwtMetrics& metrics = jwtMetrics();
+	MetricTimer timer(metrics.verify);
+	TraceSpan span("auth");
+	PERF_SCOPE("jwt.verify");
 	try {
 		auto decoded = jwt::decode(token);
 
@@ -41,10 +74,18 @@ std::string JWTUtil::verifyToken(const std::string& token) const {
 
 		auto t = decoded.get_token();
 		// 检查 token 是否过期
-		if (isTokenExpired(t)) return {};
+		if (isTokenExpired(t)) {
+			metrics.expired.inc();
+			return {};
+		}
 
+		metrics.ok.inc();
+		if (decoded.has_payload_claim("id")) {
+			setRequestUser(decoded.get_payload_claim("id").as_string());
+		}
 		return t;
 	} catch (const std::exception& e) {
+		metrics.invalid.inc();
 		return {};
 	}
 }
@@ -1,8 +1,11 @@
 #include "JsonUtil.h"
+#include "PerfCounters.h"
 
 #include <boost/beast/http/field.hpp>
 #include <boost/beast/http/message_fwd.hpp>
 
+#include <cstdio>
+#include <ctime>
 #include <string>
 
 HttpResponse JsonUtil::buildErrorResponse(const http::status& status, unsigned int version,
@@ -17,6 +20,16 @@ HttpResponse JsonUtil::buildErrorResponse(const http::status& status, unsigned i
 	return res;
 }
 
+json JsonUtil::parse(const std::string& text) {
+	PERF_SCOPE("json.parse");
+	return json::parse(text);
+}
+
+std::string JsonUtil::dump(const json& value) {
+	PERF_SCOPE("json.dump");
+	return value.dump();
+}
+
 HttpResponse JsonUtil::buildSuccessResponse(unsigned int version, const std::string& json_msg) {
 	HttpResponse res{http::status::ok, version};
 	res.set(http::field::content_type, "application/json");
@@ -27,3 +40,14 @@ HttpResponse JsonUtil::buildSuccessResponse(unsigned int version, const std::str
 
 	return res;
 }
+
+std::string JsonUtil::formatTimestamp(int64_t seconds) {
+	std::time_t t = static_cast<std::time_t>(seconds);
+	std::tm tm{};
+	localtime_r(&t, &tm);
+
+	char buf[32];
+	int n = std::snprintf(buf, sizeof(buf), "%04d-%02d-%02d %02d:%02d:%02d", tm.tm_year + 1900,
+						  tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec);
+	return {buf, static_cast<size_t>(n)};
+}
@@ -3,6 +3,7 @@
 
 #include <boost/beast/http/status.hpp>
 
+#include <cstdint>
 #include <string>
 
 class JsonUtil {
@@ -11,6 +12,13 @@ public:
 										   const std::string& message = "Internal Server Error");
 
 	static HttpResponse buildSuccessResponse(unsigned int version, const std::string& json_msg);
+
+	// 请求体解析与响应序列化, 计入 json.parse / json.dump 计数区域; 解析失败抛 json::exception
+	static json parse(const std::string& text);
+	static std::string dump(const json& value);
+
+	// 模型中的 Unix 时间戳 (秒) 按本地时区格式化为 "YYYY-MM-DD HH:MM:SS", 仅在序列化时调用
+	static std::string formatTimestamp(int64_t seconds);
 };
 
 // void connection::file_reply(core::string_view path) {
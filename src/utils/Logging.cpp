@@ -0,0 +1,303 @@
+#include "Logging.h"
+#include "Metrics.h"
+
+#include <spdlog/details/os.h>
+#include <spdlog/fmt/fmt.h>
+#include <spdlog/logger.h>
+#include <spdlog/sinks/rotating_file_sink.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include <spdlog/spdlog.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <stdexcept>
+#include <utility>
+
+std::unique_ptr<Logging> Logging::m_instance = nullptr;
+
+namespace {
+
+// 写线程在队列为空时的等待间隔, 生产者不唤醒写线程
+constexpr auto WRITER_IDLE = std::chrono::milliseconds(10);
+
+MetricCounter& droppedCounter(const std::string& log, const char* reason) {
+	return MetricsRegistry::getInstance()->counter(
+		"log_messages_dropped_total", "Log messages dropped before reaching a file",
+		{{"log", log}, {"reason", reason}});
+}
+
+size_t roundUpPow2(size_t n) {
+	size_t capacity = 2;
+	while (capacity < n) capacity <<= 1;
+	return capacity;
+}
+
+bool isRequestIdChar(char c) {
+	return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+		   c == '-' || c == '_' || c == '.' || c == ':';
+}
+
+thread_local std::string t_request_user;
+
+} // namespace
+
+AsyncLogSink::AsyncLogSink(std::string name, std::vector<spdlog::sink_ptr> sinks, size_t capacity,
+						   const std::map<std::string, LogLevelLimit>& limits)
+	: m_sinks(std::move(sinks)),
+	  m_slots(new Slot[roundUpPow2(capacity)]),
+	  m_mask(roundUpPow2(capacity) - 1),
+	  m_sampled(droppedCounter(name, "sampled")),
+	  m_rate_limited(droppedCounter(name, "rate_limited")),
+	  m_queue_full(droppedCounter(name, "queue_full")) {
+	for (size_t i = 0; i <= m_mask; ++i) m_slots[i].seq.store(i, std::memory_order_relaxed);
+
+	for (const auto& [level, limit] : limits) {
+		const auto index = spdlog::level::from_str(level);
+		if (index == spdlog::level::off && level != "off") {
+			throw std::runtime_error("Unknown log level in limits: " + level);
+		}
+		m_levels[index].limit = limit;
+	}
+
+	m_thread = std::thread([this]() { runLoop(); });
+}
+
+AsyncLogSink::~AsyncLogSink() { stop(); }
+
+bool AsyncLogSink::admit(spdlog::level::level_enum level) {
+	LevelState& state = m_levels[level];
+
+	if (state.limit.sample_rate < 1.0) {
+		thread_local std::mt19937 engine(std::random_device{}());
+		if (std::uniform_real_distribution<double>(0.0, 1.0)(engine) >= state.limit.sample_rate) {
+			m_sampled.inc();
+			return false;
+		}
+	}
+
+	if (state.limit.per_second > 0) {
+		const int64_t second = std::chrono::duration_cast<std::chrono::seconds>(
+								   std::chrono::steady_clock::now().time_since_epoch())
+								   .count();
+		int64_t window = state.window.load(std::memory_order_relaxed);
+		// 进入新的一秒时由一个线程清零, 边界上少量多放可以接受
+		if (window != second &&
+			state.window.compare_exchange_strong(window, second, std::memory_order_relaxed)) {
+			state.count.store(0, std::memory_order_relaxed);
+		}
+		if (state.count.fetch_add(1, std::memory_order_relaxed) >= state.limit.per_second) {
+			m_rate_limited.inc();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void AsyncLogSink::enqueue(const spdlog::details::log_msg& msg) {
+	Entry entry;
+	entry.time = msg.time;
+	entry.level = msg.level;
+	entry.thread_id = msg.thread_id;
+	entry.logger_name.assign(msg.logger_name.data(), msg.logger_name.size());
+	entry.payload.assign(msg.payload.data(), msg.payload.size());
+
+	if (m_stop.load(std::memory_order_acquire)) {
+		write(entry);
+		return;
+	}
+
+	if (!tryPush(std::move(entry))) m_queue_full.inc();
+}
+
+void AsyncLogSink::log(const spdlog::details::log_msg& msg) {
+	if (admit(msg.level)) enqueue(msg);
+}
+
+void AsyncLogSink::flush() {
+	// 由写线程在队列排空时 flush, 这里不阻塞调用线程
+}
+
+void AsyncLogSink::set_pattern(const std::string& pattern) {
+	for (auto& sink : m_sinks) sink->set_pattern(pattern);
+}
+
+void AsyncLogSink::set_formatter(std::unique_ptr<spdlog::formatter> sink_formatter) {
+	for (auto& sink : m_sinks) sink->set_formatter(sink_formatter->clone());
+}
+
+void AsyncLogSink::stop() {
+	if (m_stop.exchange(true)) return;
+
+	m_cv.notify_all();
+	if (m_thread.joinable()) m_thread.join();
+}
+
+bool AsyncLogSink::tryPush(Entry&& entry) {
+	size_t pos = m_head.load(std::memory_order_relaxed);
+	while (true) {
+		Slot& slot = m_slots[pos & m_mask];
+		const size_t seq = slot.seq.load(std::memory_order_acquire);
+		const auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+		if (diff == 0) {
+			if (m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+		} else if (diff < 0) {
+			return false; // 满
+		} else {
+			pos = m_head.load(std::memory_order_relaxed);
+		}
+	}
+
+	Slot& slot = m_slots[pos & m_mask];
+	slot.entry = std::move(entry);
+	slot.seq.store(pos + 1, std::memory_order_release);
+	return true;
+}
+
+bool AsyncLogSink::tryPop(Entry& entry) {
+	Slot& slot = m_slots[m_tail & m_mask];
+	if (slot.seq.load(std::memory_order_acquire) != m_tail + 1) return false;
+
+	entry = std::move(slot.entry);
+	slot.seq.store(m_tail + m_mask + 1, std::memory_order_release);
+	++m_tail;
+	return true;
+}
+
+void AsyncLogSink::runLoop() {
+	Entry entry;
+	while (true) {
+		bool written = false;
+		while (tryPop(entry)) {
+			write(entry);
+			written = true;
+		}
+
+		if (written) {
+			for (auto& sink : m_sinks) sink->flush();
+			continue;
+		}
+
+		// 停止前已入队的消息都已写出
+		if (m_stop.load(std::memory_order_acquire)) return;
+
+		std::unique_lock<std::mutex> lock(m_mtx);
+		m_cv.wait_for(lock, WRITER_IDLE);
+	}
+}
+
+void AsyncLogSink::write(const Entry& entry) {
+	spdlog::details::log_msg msg(entry.time, spdlog::source_loc{}, entry.logger_name, entry.level,
+								 entry.payload);
+	msg.thread_id = entry.thread_id;
+	for (auto& sink : m_sinks) {
+		if (!sink->should_log(msg.level)) continue;
+		try {
+			sink->log(msg);
+		} catch (const std::exception& e) {
+			std::fprintf(stderr, "[Logging] Write log failed: %s\n", e.what());
+		}
+	}
+}
+
+Logging::Logging(const LogConfig& config) {
+	std::filesystem::create_directories(config.path);
+	const size_t max_size = static_cast<size_t>(config.max_file_mb) * 1024 * 1024;
+
+	auto console = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
+	auto app_file = std::make_shared<spdlog::sinks::rotating_file_sink_mt>(
+		config.path + "/app.log", max_size, config.max_files);
+	m_app_sink = std::make_shared<AsyncLogSink>(
+		"app", std::vector<spdlog::sink_ptr>{console, app_file}, config.queue_size, config.limits);
+
+	auto logger = std::make_shared<spdlog::logger>("app", m_app_sink);
+	logger->set_level(spdlog::level::from_str(config.level));
+	spdlog::set_default_logger(logger);
+
+	if (config.access_log) {
+		auto access_file = std::make_shared<spdlog::sinks::rotating_file_sink_mt>(
+			config.path + "/access.log", max_size, config.max_files);
+		access_file->set_pattern("%v");
+		m_access_sink = std::make_shared<AsyncLogSink>(
+			"access", std::vector<spdlog::sink_ptr>{access_file}, config.queue_size,
+			config.access_limits);
+	}
+}
+
+Logging::~Logging() { stop(); }
+
+void Logging::init(const LogConfig& config) {
+	if (!m_instance) {
+		m_instance.reset(new Logging(config));
+	}
+}
+
+Logging* Logging::getInstance() {
+	if (!m_instance) {
+		throw std::runtime_error("Logging not initialized");
+	}
+
+	return m_instance.get();
+}
+
+void Logging::access(const AccessRecord& record) {
+	if (!m_instance || !m_instance->m_access_sink) return;
+
+	const auto level = record.status >= 500   ? spdlog::level::err
+					   : record.status >= 400 ? spdlog::level::warn
+											  : spdlog::level::info;
+	AsyncLogSink& sink = *m_instance->m_access_sink;
+	if (!sink.admit(level)) return;
+
+	// 字段都不含需要转义的字符: route 来自路由表, request_id 已校验, user_id 为数字
+	const auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now() - record.start);
+	const auto now = spdlog::log_clock::now();
+	const std::string line = fmt::format(
+		R"({{"ts":{},"request_id":"{}","method":"{}","route":"{}","status":{},"bytes":{},)"
+		R"("latency_us":{},"user_id":{}}})",
+		std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count(),
+		record.request_id, record.method, record.route, record.status, record.bytes,
+		latency.count(), record.user_id.empty() ? "null" : record.user_id);
+
+	spdlog::details::log_msg msg(now, spdlog::source_loc{}, "access", level, line);
+	msg.thread_id = spdlog::details::os::thread_id();
+	sink.enqueue(msg);
+}
+
+void Logging::stop() {
+	if (m_access_sink) m_access_sink->stop();
+	m_app_sink->stop();
+}
+
+std::string makeRequestId(std::string_view client_id) {
+	if (!client_id.empty() && client_id.size() <= 64) {
+		bool valid = true;
+		for (char c : client_id) valid = valid && isRequestIdChar(c);
+		if (valid) return std::string(client_id);
+	}
+
+	// 进程随机前缀 + 序号
+	static const uint32_t s_prefix = std::random_device{}();
+	static std::atomic<uint64_t> s_seq{0};
+	char buf[32];
+	std::snprintf(buf, sizeof(buf), "%08x-%llx", s_prefix,
+				  static_cast<unsigned long long>(s_seq.fetch_add(1, std::memory_order_relaxed)));
+	return buf;
+}
+
+void setRequestUser(std::string user_id) {
+	// 访问日志按数字直接输出
+	for (char c : user_id) {
+		if (c < '0' || c > '9') return;
+	}
+	t_request_user = std::move(user_id);
+}
+
+std::string takeRequestUser() {
+	std::string user_id;
+	user_id.swap(t_request_user);
+	return user_id;
+}
@@ -0,0 +1,153 @@
+#pragma once
+#include "Config.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <spdlog/sinks/sink.h>
+
+class MetricCounter;
+
+/**
+ * @brief 异步日志 sink
+ *
+ * 调用线程只做级别采样/限流与一次入队: 有界无锁环形队列 (Vyukov MPMC, 只有一个消费者),
+ * 队列满时丢弃并计数, 从不阻塞. 写线程取出后交给下游 sink (滚动文件、控制台) 格式化写入,
+ * 队列排空时 flush. 停止后直接写下游 sink.
+ */
+class AsyncLogSink final : public spdlog::sinks::sink {
+public:
+	AsyncLogSink(std::string name, std::vector<spdlog::sink_ptr> sinks, size_t capacity,
+				 const std::map<std::string, LogLevelLimit>& limits);
+	~AsyncLogSink() override;
+
+	// 按级别采样与限流, 未通过的计入丢弃
+	bool admit(spdlog::level::level_enum level);
+
+	// 已通过 admit 的消息入队
+	void enqueue(const spdlog::details::log_msg& msg);
+
+	void log(const spdlog::details::log_msg& msg) override;
+	void flush() override;
+	void set_pattern(const std::string& pattern) override;
+	void set_formatter(std::unique_ptr<spdlog::formatter> sink_formatter) override;
+
+	// 写完队列中的消息后停止写线程
+	void stop();
+
+	AsyncLogSink(const AsyncLogSink&) = delete;
+	AsyncLogSink(AsyncLogSink&&) = delete;
+	AsyncLogSink& operator=(const AsyncLogSink&) = delete;
+	AsyncLogSink& operator=(AsyncLogSink&&) = delete;
+
+private:
+	struct Entry {
+		spdlog::log_clock::time_point time;
+		spdlog::level::level_enum level = spdlog::level::info;
+		size_t thread_id = 0;
+		std::string logger_name;
+		std::string payload;
+	};
+
+	struct Slot {
+		std::atomic<size_t> seq{0};
+		Entry entry;
+	};
+
+	struct LevelState {
+		LogLevelLimit limit;
+		std::atomic<int64_t> window{0}; // 当前计数的秒
+		std::atomic<uint32_t> count{0};
+	};
+
+	bool tryPush(Entry&& entry);
+	bool tryPop(Entry& entry);
+
+	void runLoop();
+
+	void write(const Entry& entry);
+
+private:
+	std::vector<spdlog::sink_ptr> m_sinks;
+	std::array<LevelState, spdlog::level::n_levels> m_levels;
+
+	std::unique_ptr<Slot[]> m_slots;
+	size_t m_mask;
+	alignas(64) std::atomic<size_t> m_head{0}; // 生产者
+	alignas(64) size_t m_tail = 0;			   // 写线程独占
+
+	MetricCounter& m_sampled;
+	MetricCounter& m_rate_limited;
+	MetricCounter& m_queue_full;
+
+	std::thread m_thread;
+	std::mutex m_mtx;
+	std::condition_variable m_cv;
+	std::atomic<bool> m_stop{false};
+};
+
+/**
+ * @brief 一条访问日志
+ */
+struct AccessRecord {
+	std::string request_id;
+	std::string method;
+	std::string route; // 路由模板, 未匹配为 "unmatched"
+	std::string user_id;
+	unsigned status = 0;
+	uint64_t bytes = 0; // 响应体字节数
+	std::chrono::steady_clock::time_point start;
+};
+
+/**
+ * @brief 日志 单例
+ *
+ * 应用日志 (默认 logger) 写入 {path}/app.log 与控制台, 访问日志以 JSON 行写入
+ * {path}/access.log; 二者各有一个 AsyncLogSink 与各自的级别限额. 访问日志的级别按状态码:
+ * 5xx 为 err, 4xx 为 warn, 其余为 info; 在格式化之前采样.
+ */
+class Logging {
+public:
+	static void init(const LogConfig& config);
+
+	static Logging* getInstance();
+
+	// 记录一次请求; 未初始化或未启用访问日志时忽略
+	static void access(const AccessRecord& record);
+
+	// 写完队列并停止写线程
+	void stop();
+
+	~Logging();
+	Logging(const Logging&) = delete;
+	Logging(Logging&&) = delete;
+	Logging& operator=(const Logging&) = delete;
+	Logging& operator=(Logging&&) = delete;
+
+private:
+	explicit Logging(const LogConfig& config);
+
+private:
+	std::shared_ptr<AsyncLogSink> m_app_sink;
+	std::shared_ptr<AsyncLogSink> m_access_sink; // 未启用访问日志时为空
+
+	static std::unique_ptr<Logging> m_instance;
+};
+
+// 请求 id: 客户端提供的 X-Request-Id 合法 (字母数字与 -_.:, 不超过 64 字符) 时沿用, 否则生成
+std::string makeRequestId(std::string_view client_id);
+
+// 当前线程处理中请求的认证用户, JWT 验证成功时记录, 供访问日志读取
+void setRequestUser(std::string user_id);
+std::string takeRequestUser();
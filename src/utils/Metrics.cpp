@@ -0,0 +1,210 @@
+#include "Metrics.h"
+
+#include <cstdio>
+#include <mutex>
+#include <stdexcept>
+
+std::unique_ptr<MetricsRegistry> MetricsRegistry::m_instance = nullptr;
+
+namespace {
+
+// 导出的 le 边界为 2^j 微秒 (64us ~ 67s), 与子桶边界对齐, 合并时没有误差
+constexpr uint32_t EXPORT_MIN_EXPONENT = 6;
+constexpr uint32_t EXPORT_MAX_EXPONENT = 26;
+
+std::string formatDouble(double value) {
+	char buf[32];
+	std::snprintf(buf, sizeof(buf), "%.9g", value);
+	return buf;
+}
+
+std::string escapeLabelValue(const std::string& value) {
+	std::string out;
+	out.reserve(value.size());
+	for (char c : value) {
+		if (c == '\\' || c == '"') {
+			out += '\\';
+			out += c;
+		} else if (c == '\n') {
+			out += "\\n";
+		} else {
+			out += c;
+		}
+	}
+	return out;
+}
+
+// {labels} 或 {labels,extra}; 都为空时为空串
+std::string braces(const std::string& labels, const std::string& extra = {}) {
+	if (labels.empty() && extra.empty()) return {};
+	if (labels.empty()) return "{" + extra + "}";
+	if (extra.empty()) return "{" + labels + "}";
+	return "{" + labels + "," + extra + "}";
+}
+
+} // namespace
+
+size_t metricShardIndex() {
+	static std::atomic<size_t> s_next{0};
+	thread_local const size_t index =
+		s_next.fetch_add(1, std::memory_order_relaxed) % METRIC_SHARDS;
+	return index;
+}
+
+uint64_t MetricCounter::value() const {
+	uint64_t total = 0;
+	for (const auto& shard : m_shards) total += shard.value.load(std::memory_order_relaxed);
+	return total;
+}
+
+size_t MetricHistogram::bucketIndex(uint64_t micros) {
+	if (micros < SUB_BUCKETS) return static_cast<size_t>(micros);
+
+	const uint32_t exponent = 63 - static_cast<uint32_t>(__builtin_clzll(micros));
+	if (exponent >= MAX_EXPONENT) return BUCKETS - 1;
+
+	const uint32_t shift = exponent - SUB_BUCKET_BITS;
+	const uint64_t sub = (micros >> shift) & (SUB_BUCKETS - 1);
+	return SUB_BUCKETS + static_cast<size_t>(shift) * SUB_BUCKETS + static_cast<size_t>(sub);
+}
+
+uint64_t MetricHistogram::bucketUpperBound(size_t index) {
+	if (index < SUB_BUCKETS) return index + 1;
+
+	const size_t shift = (index - SUB_BUCKETS) / SUB_BUCKETS;
+	const uint64_t sub = (index - SUB_BUCKETS) % SUB_BUCKETS;
+	return (SUB_BUCKETS + sub + 1) << shift;
+}
+
+void MetricHistogram::observe(uint64_t micros) {
+	Shard& shard = m_shards[metricShardIndex()];
+	shard.buckets[bucketIndex(micros)].fetch_add(1, std::memory_order_relaxed);
+	shard.sum.fetch_add(micros, std::memory_order_relaxed);
+}
+
+MetricHistogram::Snapshot MetricHistogram::snapshot() const {
+	Snapshot snapshot;
+	snapshot.buckets.assign(BUCKETS, 0);
+	for (const auto& shard : m_shards) {
+		for (size_t i = 0; i < BUCKETS; ++i) {
+			snapshot.buckets[i] += shard.buckets[i].load(std::memory_order_relaxed);
+		}
+		snapshot.sum += shard.sum.load(std::memory_order_relaxed);
+	}
+	for (uint64_t n : snapshot.buckets) snapshot.count += n;
+	return snapshot;
+}
+
+uint64_t MetricHistogram::Snapshot::quantile(double q) const {
+	if (count == 0) return 0;
+
+	const auto rank = static_cast<uint64_t>(q * static_cast<double>(count - 1)) + 1;
+	uint64_t seen = 0;
+	for (size_t i = 0; i < buckets.size(); ++i) {
+		seen += buckets[i];
+		if (seen >= rank) return bucketUpperBound(i);
+	}
+	return bucketUpperBound(buckets.size() - 1);
+}
+
+MetricsRegistry* MetricsRegistry::getInstance() {
+	if (m_instance) return m_instance.get();
+
+	static std::once_flag flag;
+	std::call_once(flag, []() { m_instance.reset(new MetricsRegistry()); });
+
+	return m_instance.get();
+}
+
+MetricsRegistry::Family& MetricsRegistry::family(const std::string& name, const std::string& help,
+												  Type type) {
+	auto [it, inserted] = m_families.try_emplace(name);
+	if (inserted) {
+		it->second.help = help;
+		it->second.type = type;
+	} else if (it->second.type != type) {
+		throw std::logic_error("Metric " + name + " registered with another type");
+	}
+	return it->second;
+}
+
+MetricCounter& MetricsRegistry::counter(const std::string& name, const std::string& help,
+										const MetricLabels& labels) {
+	std::lock_guard<std::mutex> lock(m_mtx);
+	auto& slot = family(name, help, Type::Counter).counters[formatLabels(labels)];
+	if (!slot) slot = std::make_unique<MetricCounter>();
+	return *slot;
+}
+
+MetricGauge& MetricsRegistry::gauge(const std::string& name, const std::string& help,
+									const MetricLabels& labels) {
+	std::lock_guard<std::mutex> lock(m_mtx);
+	auto& slot = family(name, help, Type::Gauge).gauges[formatLabels(labels)];
+	if (!slot) slot = std::make_unique<MetricGauge>();
+	return *slot;
+}
+
+MetricHistogram& MetricsRegistry::histogram(const std::string& name, const std::string& help,
+											const MetricLabels& labels) {
+	std::lock_guard<std::mutex> lock(m_mtx);
+	auto& slot = family(name, help, Type::Histogram).histograms[formatLabels(labels)];
+	if (!slot) slot = std::make_unique<MetricHistogram>();
+	return *slot;
+}
+
+std::string MetricsRegistry::formatLabels(const MetricLabels& labels) {
+	std::string out;
+	for (const auto& [key, value] : labels) {
+		if (!out.empty()) out += ',';
+		out += key + "=\"" + escapeLabelValue(value) + "\"";
+	}
+	return out;
+}
+
+std::string MetricsRegistry::render() const {
+	std::lock_guard<std::mutex> lock(m_mtx);
+
+	std::string out;
+	for (const auto& [name, family] : m_families) {
+		out += "# HELP " + name + " " + family.help + "\n";
+		switch (family.type) {
+		case Type::Counter:
+			out += "# TYPE " + name + " counter\n";
+			for (const auto& [labels, counter] : family.counters) {
+				out += name + braces(labels) + " " + std::to_string(counter->value()) + "\n";
+			}
+			break;
+		case Type::Gauge:
+			out += "# TYPE " + name + " gauge\n";
+			for (const auto& [labels, gauge] : family.gauges) {
+				out += name + braces(labels) + " " + std::to_string(gauge->value()) + "\n";
+			}
+			break;
+		case Type::Histogram:
+			out += "# TYPE " + name + " histogram\n";
+			for (const auto& [labels, histogram] : family.histograms) {
+				const auto snapshot = histogram->snapshot();
+				uint64_t cumulative = 0;
+				size_t bucket = 0;
+				for (uint32_t exp = EXPORT_MIN_EXPONENT; exp <= EXPORT_MAX_EXPONENT; ++exp) {
+					const uint64_t bound = uint64_t{1} << exp;
+					while (bucket < MetricHistogram::BUCKETS - 1 &&
+						   MetricHistogram::bucketUpperBound(bucket) <= bound) {
+						cumulative += snapshot.buckets[bucket++];
+					}
+					out += name + "_bucket" +
+						   braces(labels, "le=\"" + formatDouble(bound / 1e6) + "\"") + " " +
+						   std::to_string(cumulative) + "\n";
+				}
+				out += name + "_bucket" + braces(labels, "le=\"+Inf\"") + " " +
+					   std::to_string(snapshot.count) + "\n";
+				out += name + "_sum" + braces(labels) + " " + formatDouble(snapshot.sum / 1e6) +
+					   "\n";
+				out += name + "_count" + braces(labels) + " " + std::to_string(snapshot.count) +
+					   "\n";
+			}
+			break;
+		}
+	}
+	return out;
+}
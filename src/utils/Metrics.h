@@ -0,0 +1,165 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief 进程内指标, 以 Prometheus 文本格式导出 (GET /metrics)
+ *
+ * 计数器与直方图按线程分片: 每个线程固定写入一个缓存行对齐的分片, 记录只是一次 relaxed
+ * 原子加, 不加锁, 线程之间不争用缓存行; 导出时合并各分片. 指标在注册表中按名字与标签查找
+ * 或创建 (加锁), 调用方应在初始化时取得引用并保存, 热路径上不查找.
+ */
+constexpr size_t METRIC_SHARDS = 16; // 线程多于分片数时轮询共享分片
+
+// 当前线程的分片序号
+size_t metricShardIndex();
+
+class MetricCounter {
+public:
+	void inc(uint64_t n = 1) {
+		m_shards[metricShardIndex()].value.fetch_add(n, std::memory_order_relaxed);
+	}
+
+	uint64_t value() const;
+
+private:
+	struct alignas(64) Shard {
+		std::atomic<uint64_t> value{0};
+	};
+	std::array<Shard, METRIC_SHARDS> m_shards;
+};
+
+class MetricGauge {
+public:
+	void set(int64_t value) { m_value.store(value, std::memory_order_relaxed); }
+	void add(int64_t delta) { m_value.fetch_add(delta, std::memory_order_relaxed); }
+	int64_t value() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+	std::atomic<int64_t> m_value{0};
+};
+
+/**
+ * @brief 延迟直方图 (微秒), HDR 风格对数线性分桶
+ *
+ * 小于 2^SUB_BUCKET_BITS 的值各占一个桶, 之后每个 2 的幂区间等分为 2^SUB_BUCKET_BITS 个子桶,
+ * 相对误差不超过 12.5%; 不小于 2^MAX_EXPONENT 的值计入最后一个桶.
+ */
+class MetricHistogram {
+public:
+	static constexpr uint32_t SUB_BUCKET_BITS = 3;
+	static constexpr uint32_t SUB_BUCKETS = 1U << SUB_BUCKET_BITS;
+	static constexpr uint32_t MAX_EXPONENT = 32; // 2^32 微秒约 71 分钟
+	static constexpr size_t BUCKETS = SUB_BUCKETS * (MAX_EXPONENT - SUB_BUCKET_BITS + 1);
+
+	struct Snapshot {
+		std::vector<uint64_t> buckets;
+		uint64_t count = 0;
+		uint64_t sum = 0; // 微秒
+
+		// 分位数 q (0~1) 所在桶的上界, 没有记录时为 0
+		uint64_t quantile(double q) const;
+	};
+
+	void observe(uint64_t micros);
+
+	void observe(std::chrono::steady_clock::duration elapsed) {
+		const auto micros = std::chrono::duration_cast<std::chrono::microseconds>(elapsed);
+		observe(static_cast<uint64_t>(micros.count() > 0 ? micros.count() : 0));
+	}
+
+	Snapshot snapshot() const;
+
+	static size_t bucketIndex(uint64_t micros);
+
+	// 桶 index 的上界 (不含)
+	static uint64_t bucketUpperBound(size_t index);
+
+private:
+	struct alignas(64) Shard {
+		std::array<std::atomic<uint64_t>, BUCKETS> buckets{};
+		std::atomic<uint64_t> sum{0};
+	};
+	std::array<Shard, METRIC_SHARDS> m_shards;
+};
+
+/**
+ * @brief 作用域计时, 析构时把耗时记入直方图
+ */
+class MetricTimer {
+public:
+	explicit MetricTimer(MetricHistogram& histogram)
+		: m_histogram(histogram), m_start(std::chrono::steady_clock::now()) {}
+	~MetricTimer() { m_histogram.observe(std::chrono::steady_clock::now() - m_start); }
+
+	MetricTimer(const MetricTimer&) = delete;
+	MetricTimer(MetricTimer&&) = delete;
+	MetricTimer& operator=(const MetricTimer&) = delete;
+	MetricTimer& operator=(MetricTimer&&) = delete;
+
+private:
+	MetricHistogram& m_histogram;
+	std::chrono::steady_clock::time_point m_start;
+};
+
+using MetricLabels = std::vector<std::pair<std::string, std::string>>;
+
+/**
+ * @brief 指标注册表 单例
+ *
+ * 同名指标为一族 (HELP/TYPE 相同), 以标签区分; 返回的引用在进程内一直有效.
+ * 直方图以微秒记录, 导出为秒 (名字应以 _seconds 结尾).
+ */
+class MetricsRegistry {
+public:
+	static MetricsRegistry* getInstance();
+
+	MetricCounter& counter(const std::string& name, const std::string& help,
+						   const MetricLabels& labels = {});
+	MetricGauge& gauge(const std::string& name, const std::string& help,
+					   const MetricLabels& labels = {});
+	MetricHistogram& histogram(const std::string& name, const std::string& help,
+							   const MetricLabels& labels = {});
+
+	// Prometheus 文本格式 (version 0.0.4)
+	std::string render() const;
+
+	~MetricsRegistry() = default;
+	MetricsRegistry(const MetricsRegistry&) = delete;
+	MetricsRegistry(MetricsRegistry&&) = delete;
+	MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+	MetricsRegistry& operator=(MetricsRegistry&&) = delete;
+
+private:
+	MetricsRegistry() = default;
+
+	enum class Type { Counter, Gauge, Histogram };
+
+	struct Family {
+		std::string help;
+		Type type = Type::Counter;
+		// 渲染后的标签 (如 method="GET",route="/"), 有序便于导出稳定
+		std::map<std::string, std::unique_ptr<MetricCounter>> counters;
+		std::map<std::string, std::unique_ptr<MetricGauge>> gauges;
+		std::map<std::string, std::unique_ptr<MetricHistogram>> histograms;
+	};
+
+	Family& family(const std::string& name, const std::string& help, Type type);
+
+	static std::string formatLabels(const MetricLabels& labels);
+
+private:
+	std::map<std::string, Family> m_families;
+	mutable std::mutex m_mtx;
+
+	static std::unique_ptr<MetricsRegistry> m_instance;
+};
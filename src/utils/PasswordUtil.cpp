@@ -1,4 +1,5 @@
 #include "PasswordUtil.h"
+#include "PerfCounters.h"
 
 #include <array>
 #include <iomanip>
@@ -8,6 +9,7 @@
 #include <openssl/evp.h>
 
 std::string PasswordUtil::hashPassword(const std::string& password) {
+	PERF_SCOPE("password.hash");
 	std::array<uint8_t, SHA256_DIGEST_LENGTH> hash{};
 	unsigned int hashLen{};
 
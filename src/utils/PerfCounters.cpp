@@ -0,0 +1,195 @@
+#include "PerfCounters.h"
+
+#include <spdlog/fmt/fmt.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+constexpr const char* TAG = "[PerfCounters]";
+
+std::unique_ptr<PerfCounters> PerfCounters::m_instance = nullptr;
+
+namespace {
+
+constexpr std::array<uint64_t, PerfCounters::EVENTS> EVENT_CONFIGS = {
+	PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES,
+	PERF_COUNT_HW_BRANCH_MISSES};
+
+int openEvent(uint64_t config, int group_fd) {
+	perf_event_attr attr{};
+	attr.size = sizeof(attr);
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.config = config;
+	attr.disabled = group_fd == -1 ? 1 : 0; // 组长启用时整组一起开始
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	attr.read_format =
+		PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+	// pid = 0, cpu = -1: 当前线程, 跟随其在任意 CPU 上运行
+	return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0));
+}
+
+// 线程的计数器组, 线程退出时关闭
+class ThreadGroup {
+public:
+	ThreadGroup() {
+		m_fds.fill(-1);
+		for (size_t i = 0; i < PerfCounters::EVENTS; ++i) {
+			m_fds[i] = openEvent(EVENT_CONFIGS[i], m_fds[0]);
+			if (m_fds[i] < 0) {
+				warnOnce(PerfCounters::EVENT_NAMES[i], errno);
+				close();
+				return;
+			}
+		}
+		ioctl(m_fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+		ioctl(m_fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+	}
+
+	~ThreadGroup() { close(); }
+
+	ThreadGroup(const ThreadGroup&) = delete;
+	ThreadGroup& operator=(const ThreadGroup&) = delete;
+
+	bool read(PerfScope::Reading& reading) const {
+		if (m_fds[0] < 0) return false;
+
+		// nr, time_enabled, time_running, values[nr]
+		uint64_t buf[3 + PerfCounters::EVENTS];
+		if (::read(m_fds[0], buf, sizeof(buf)) != static_cast<ssize_t>(sizeof(buf))) return false;
+
+		reading.enabled = buf[1];
+		reading.running = buf[2];
+		for (size_t i = 0; i < PerfCounters::EVENTS; ++i) reading.values[i] = buf[3 + i];
+		return true;
+	}
+
+private:
+	void close() {
+		for (int& fd : m_fds) {
+			if (fd >= 0) ::close(fd);
+			fd = -1;
+		}
+	}
+
+	static void warnOnce(const char* event, int error) {
+		static std::atomic<bool> s_warned{false};
+		if (s_warned.exchange(true)) return;
+		// 常见原因: 虚拟机未暴露 PMU, 或 kernel.perf_event_paranoid 过高
+		spdlog::warn("{} perf_event_open({}) failed: {}", TAG, event, std::strerror(error));
+	}
+
+private:
+	std::array<int, PerfCounters::EVENTS> m_fds;
+};
+
+ThreadGroup& threadGroup() {
+	thread_local ThreadGroup group;
+	return group;
+}
+
+} // namespace
+
+PerfCounters::Region::Region(const std::string& region_name)
+	: name(region_name),
+	  calls(MetricsRegistry::getInstance()->counter(
+		  "perf_region_calls_total", "Entries into a hardware-counter instrumented region",
+		  {{"region", region_name}})),
+	  unavailable(MetricsRegistry::getInstance()->counter(
+		  "perf_region_unavailable_total",
+		  "Region entries on threads where hardware counters could not be opened",
+		  {{"region", region_name}})) {
+	for (size_t i = 0; i < EVENTS; ++i) {
+		events[i] = &MetricsRegistry::getInstance()->counter(
+			"perf_region_events_total", "Hardware events counted in a region (user space)",
+			{{"region", region_name}, {"event", EVENT_NAMES[i]}});
+	}
+}
+
+PerfCounters* PerfCounters::getInstance() {
+	if (m_instance) return m_instance.get();
+
+	static std::once_flag flag;
+	std::call_once(flag, []() { m_instance.reset(new PerfCounters()); });
+
+	return m_instance.get();
+}
+
+PerfCounters::Region& PerfCounters::region(const std::string& name) {
+	std::lock_guard<std::mutex> lock(m_mtx);
+	auto& region = m_regions[name];
+	if (!region) region = std::make_unique<Region>(name);
+	return *region;
+}
+
+std::string PerfCounters::report() const {
+	std::lock_guard<std::mutex> lock(m_mtx);
+	if (m_regions.empty()) return {};
+
+	std::string out = fmt::format("{:<24} {:>12}", "region", "calls");
+	for (const char* event : EVENT_NAMES) out += fmt::format(" {:>16} {:>12}", event, "/call");
+	out += fmt::format(" {:>6}\n", "ipc");
+
+	for (const auto& [name, region] : m_regions) {
+		const uint64_t calls = region->calls.value();
+		const uint64_t counted = calls - std::min(calls, region->unavailable.value());
+		std::array<uint64_t, EVENTS> totals{};
+		for (size_t i = 0; i < EVENTS; ++i) totals[i] = region->events[i]->value();
+
+		out += fmt::format("{:<24} {:>12}", name, calls);
+		for (uint64_t total : totals) {
+			out += fmt::format(" {:>16} {:>12.1f}", total,
+							   counted > 0 ? static_cast<double>(total) / counted : 0.0);
+		}
+		out += fmt::format(" {:>6.2f}\n",
+						   totals[0] > 0 ? static_cast<double>(totals[1]) / totals[0] : 0.0);
+	}
+	return out;
+}
+
+bool PerfCounters::dump(const std::string& path) const {
+	const std::string content = report();
+	if (content.empty()) return false;
+
+	std::ofstream file(path, std::ios::trunc);
+	if (!file) {
+		spdlog::error("{} Failed to open {}", TAG, path);
+		return false;
+	}
+	file << content;
+	return static_cast<bool>(file);
+}
+
+PerfScope::PerfScope(PerfCounters::Region& region)
+	: m_region(region), m_valid(threadGroup().read(m_start)) {}
+
+PerfScope::~PerfScope() {
+	m_region.calls.inc();
+
+	Reading end;
+	if (!m_valid || !threadGroup().read(end)) {
+		m_region.unavailable.inc();
+		return;
+	}
+
+	// 区域内计数器只运行了部分时间时按比例换算
+	const uint64_t enabled = end.enabled - m_start.enabled;
+	const uint64_t running = end.running - m_start.running;
+	const double scale =
+		running > 0 && running < enabled ? static_cast<double>(enabled) / running : 1.0;
+
+	for (size_t i = 0; i < PerfCounters::EVENTS; ++i) {
+		const uint64_t delta = end.values[i] - m_start.values[i];
+		m_region.events[i]->inc(scale == 1.0 ? delta : static_cast<uint64_t>(delta * scale));
+	}
+}
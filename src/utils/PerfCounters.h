@@ -0,0 +1,102 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "Metrics.h"
+
+/**
+ * @brief 硬件性能计数器 按代码区域统计
+ *
+ * 每个线程首次进入区域时以 perf_event_open 打开一组计数器 (cycles 为组长, 另有 instructions,
+ * cache-misses, branch-misses), 只计用户态. PerfScope 在进入与离开时各读一次整组, 差值计入区域;
+ * 嵌套区域各自计入, 外层包含内层. 计数器被内核分时复用时按 enabled / running 换算.
+ * 每次读取是一次系统调用, 只适合压测与调优, 常规构建中 PERF_SCOPE 展开为空
+ * (以 -DMUSICPLAYER_PERF_COUNTERS=ON 构建时启用).
+ *
+ * 区域以 perf_region_calls_total{region} 与 perf_region_events_total{region,event} 导出到
+ * /metrics, 也可以 report / dump 输出为表格.
+ */
+class PerfCounters {
+public:
+	static constexpr size_t EVENTS = 4;
+	static constexpr std::array<const char*, EVENTS> EVENT_NAMES = {
+		"cycles", "instructions", "cache_misses", "branch_misses"};
+
+	struct Region {
+		explicit Region(const std::string& name);
+
+		const std::string name;
+		MetricCounter& calls;
+		MetricCounter& unavailable; // 本线程打不开计数器, 只计次数
+		std::array<MetricCounter*, EVENTS> events;
+	};
+
+	static PerfCounters* getInstance();
+
+	// 查找或创建区域, 返回的引用在进程内一直有效
+	Region& region(const std::string& name);
+
+	// 每个区域一行: 调用次数, 各事件总数与每次调用的均值, IPC
+	std::string report() const;
+
+	// report 写入文件, 没有区域时不写
+	bool dump(const std::string& path) const;
+
+	~PerfCounters() = default;
+	PerfCounters(const PerfCounters&) = delete;
+	PerfCounters(PerfCounters&&) = delete;
+	PerfCounters& operator=(const PerfCounters&) = delete;
+	PerfCounters& operator=(PerfCounters&&) = delete;
+
+private:
+	PerfCounters() = default;
+
+private:
+	std::map<std::string, std::unique_ptr<Region>> m_regions;
+	mutable std::mutex m_mtx;
+
+	static std::unique_ptr<PerfCounters> m_instance;
+};
+
+/**
+ * @brief 作用域计数, 析构时把本线程计数器的差值计入区域
+ */
+class PerfScope {
+public:
+	explicit PerfScope(PerfCounters::Region& region);
+	~PerfScope();
+
+	PerfScope(const PerfScope&) = delete;
+	PerfScope(PerfScope&&) = delete;
+	PerfScope& operator=(const PerfScope&) = delete;
+	PerfScope& operator=(PerfScope&&) = delete;
+
+	struct Reading {
+		uint64_t enabled = 0; // ns
+		uint64_t running = 0; // ns
+		std::array<uint64_t, PerfCounters::EVENTS> values{};
+	};
+
+private:
+	PerfCounters::Region& m_region;
+	Reading m_start;
+	bool m_valid;
+};
+
+#define PERF_CONCAT_INNER(a, b) a##b
+#define PERF_CONCAT(a, b) PERF_CONCAT_INNER(a, b)
+
+// 统计所在作用域的剩余部分, name 为字符串字面量
+#ifdef MUSICPLAYER_PERF_COUNTERS
+#define PERF_SCOPE(name)                                                                   \
+	static PerfCounters::Region& PERF_CONCAT(perf_region_, __LINE__) =                     \
+		PerfCounters::getInstance()->region(name);                                         \
+	PerfScope PERF_CONCAT(perf_scope_, __LINE__)(PERF_CONCAT(perf_region_, __LINE__))
+#else
+#define PERF_SCOPE(name) static_cast<void>(0)
+#endif
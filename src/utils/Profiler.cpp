@@ -0,0 +1,258 @@
+#include "Profiler.h"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <malloc.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+constexpr const char* TAG = "[Profiler]";
+
+std::unique_ptr<Profiler> Profiler::m_instance = nullptr;
+
+namespace {
+
+constexpr int MAX_DEPTH = 48;
+constexpr size_t MAX_SAMPLES = 50000;
+// 信号处理函数与 sigaction 跳板
+constexpr int SKIP_FRAMES = 2;
+
+struct Sample {
+	int depth;
+	void* frames[MAX_DEPTH];
+};
+
+// 信号处理函数只访问这些变量
+Sample* g_samples = nullptr;
+size_t g_capacity = 0;
+std::atomic<size_t> g_next{0};
+std::atomic<bool> g_active{false};
+std::atomic<int> g_in_handler{0};
+
+// g_in_handler 与 g_active 的读写都用 seq_cst: 处理函数先增计数再读 g_active, 停止方先写
+// g_active 再读计数, 两者至少有一方看到对方的写入, 释放样本数组时不会有处理函数仍在写
+void onProf(int, siginfo_t*, void*) {
+	g_in_handler.fetch_add(1, std::memory_order_seq_cst);
+	const int saved_errno = errno;
+	if (g_active.load(std::memory_order_seq_cst)) {
+		const size_t index = g_next.fetch_add(1, std::memory_order_relaxed);
+		if (index < g_capacity) {
+			Sample& sample = g_samples[index];
+			sample.depth = backtrace(sample.frames, MAX_DEPTH);
+		}
+	}
+	errno = saved_errno;
+	g_in_handler.fetch_sub(1, std::memory_order_seq_cst);
+}
+
+using Mallctl = int (*)(const char*, void*, size_t*, void*, size_t);
+
+Mallctl findMallctl() {
+	return reinterpret_cast<Mallctl>(dlsym(RTLD_DEFAULT, "mallctl"));
+}
+
+// 函数名 (已 demangle), 或 "模块+0x偏移"
+std::string symbolize(void* address) {
+	// 返回地址指向调用指令之后, 减一落在调用所在的函数内
+	void* lookup = static_cast<char*>(address) - 1;
+
+	Dl_info info{};
+	if (dladdr(lookup, &info) == 0) {
+		char buf[32];
+		std::snprintf(buf, sizeof(buf), "%p", address);
+		return buf;
+	}
+
+	if (info.dli_sname != nullptr) {
+		int status = 0;
+		char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+		std::string name = status == 0 && demangled != nullptr ? demangled : info.dli_sname;
+		std::free(demangled);
+		return name;
+	}
+
+	const char* module = info.dli_fname != nullptr ? std::strrchr(info.dli_fname, '/') : nullptr;
+	module = module != nullptr ? module + 1 : (info.dli_fname != nullptr ? info.dli_fname : "?");
+	char buf[64];
+	std::snprintf(buf, sizeof(buf), "+0x%zx",
+				  static_cast<size_t>(static_cast<char*>(lookup) -
+									  static_cast<char*>(info.dli_fbase)));
+	return module + std::string(buf);
+}
+
+// folded 格式中 ';' 分隔帧, 空格分隔计数
+std::string sanitizeFrame(std::string frame) {
+	std::replace(frame.begin(), frame.end(), ';', ':');
+	std::replace(frame.begin(), frame.end(), ' ', '_');
+	return frame;
+}
+
+} // namespace
+
+Profiler* Profiler::getInstance() {
+	if (m_instance) return m_instance.get();
+
+	static std::once_flag flag;
+	std::call_once(flag, []() { m_instance.reset(new Profiler()); });
+
+	return m_instance.get();
+}
+
+std::optional<std::string> Profiler::profileCpu(std::chrono::seconds duration, int hz) {
+	if (m_cpu_busy.exchange(true)) return std::nullopt;
+	// 任何出口 (含符号化中的异常) 都释放, 否则之后无法再次采样
+	struct BusyGuard {
+		std::atomic<bool>& busy;
+		~BusyGuard() { busy.store(false); }
+	} busy_guard{m_cpu_busy};
+
+	duration = std::clamp(duration, std::chrono::seconds(1), MAX_DURATION);
+	hz = std::clamp(hz, 1, MAX_HZ);
+
+	// ITIMER_PROF 按进程 CPU 时间计, 所有核都忙时每秒约 hz * 核数个样本
+	const size_t cores = std::max(1U, std::thread::hardware_concurrency());
+	const size_t capacity = std::min(
+		MAX_SAMPLES, static_cast<size_t>(hz) * static_cast<size_t>(duration.count()) * cores);
+	std::vector<Sample> samples(capacity);
+
+	// 首次调用 backtrace 会加载 libgcc, 不能发生在信号处理函数中
+	void* warmup[1];
+	backtrace(warmup, 1);
+
+	g_samples = samples.data();
+	g_capacity = capacity;
+	g_next.store(0, std::memory_order_relaxed);
+	g_active.store(true, std::memory_order_seq_cst);
+
+	struct sigaction action {};
+	action.sa_sigaction = onProf;
+	action.sa_flags = SA_SIGINFO | SA_RESTART;
+	sigemptyset(&action.sa_mask);
+	struct sigaction previous {};
+	sigaction(SIGPROF, &action, &previous);
+
+	const long interval_us = 1000000L / hz;
+	struct itimerval timer {};
+	timer.it_interval.tv_sec = interval_us / 1000000;
+	timer.it_interval.tv_usec = interval_us % 1000000;
+	timer.it_value = timer.it_interval;
+	setitimer(ITIMER_PROF, &timer, nullptr);
+
+	spdlog::info("{} CPU profile started: {}s at {} Hz", TAG, duration.count(), hz);
+	std::this_thread::sleep_for(duration);
+
+	// 先停止计时器, 再等已进入的处理函数返回, 之后才能释放样本数组
+	struct itimerval stop {};
+	setitimer(ITIMER_PROF, &stop, nullptr);
+	g_active.store(false, std::memory_order_seq_cst);
+	while (g_in_handler.load(std::memory_order_seq_cst) != 0) std::this_thread::yield();
+	// 原处置为默认 (终止进程) 时保留 onProf: 计时器停止前产生但尚未递送给某个线程的 SIGPROF
+	// 仍可能到达, 此时 g_active 为 false, 处理函数直接返回
+	if ((previous.sa_flags & SA_SIGINFO) != 0 || previous.sa_handler != SIG_DFL) {
+		sigaction(SIGPROF, &previous, nullptr);
+	}
+
+	const size_t taken = std::min(g_next.load(std::memory_order_relaxed), capacity);
+	const size_t dropped = g_next.load(std::memory_order_relaxed) - taken;
+	g_samples = nullptr;
+	g_capacity = 0;
+
+	// 按调用栈合并, 每个地址只符号化一次
+	std::unordered_map<void*, std::string> symbols;
+	std::map<std::string, size_t> folded;
+	for (size_t i = 0; i < taken; ++i) {
+		const Sample& sample = samples[i];
+		std::string stack;
+		for (int depth = sample.depth - 1; depth >= SKIP_FRAMES; --depth) {
+			void* address = sample.frames[depth];
+			auto it = symbols.find(address);
+			if (it == symbols.end()) {
+				it = symbols.emplace(address, sanitizeFrame(symbolize(address))).first;
+			}
+			if (!stack.empty()) stack += ';';
+			stack += it->second;
+		}
+		if (!stack.empty()) ++folded[stack];
+	}
+
+	std::vector<std::pair<std::string, size_t>> stacks(folded.begin(), folded.end());
+	std::sort(stacks.begin(), stacks.end(),
+			  [](const auto& a, const auto& b) { return a.second > b.second; });
+
+	std::string out;
+	for (const auto& [stack, count] : stacks) {
+		out += stack + " " + std::to_string(count) + "\n";
+	}
+
+	spdlog::info("{} CPU profile finished: {} samples, {} dropped, {} stacks", TAG, taken,
+				 dropped, stacks.size());
+	return out;
+}
+
+std::optional<Profiler::HeapSnapshot> Profiler::heapSnapshot() {
+	// jemalloc 未开启 prof 时没有可用的快照
+	if (findMallctl() != nullptr) return jemallocDump();
+
+	// glibc: 各 arena 的分配统计, 不含调用栈
+	char* buffer = nullptr;
+	size_t size = 0;
+	FILE* stream = open_memstream(&buffer, &size);
+	if (stream == nullptr) return std::nullopt;
+
+	const int rc = malloc_info(0, stream);
+	std::fclose(stream);
+	HeapSnapshot snapshot{"application/xml", std::string(buffer, size)};
+	std::free(buffer);
+	if (rc != 0) return std::nullopt;
+
+	return snapshot;
+}
+
+std::optional<Profiler::HeapSnapshot> Profiler::jemallocDump() {
+	Mallctl mallctl = findMallctl();
+	if (mallctl == nullptr) return std::nullopt;
+
+	bool enabled = false;
+	size_t length = sizeof(enabled);
+	if (mallctl("opt.prof", &enabled, &length, nullptr, 0) != 0 || !enabled) {
+		spdlog::warn("{} jemalloc heap profiling is off, start with MALLOC_CONF=prof:true", TAG);
+		return std::nullopt;
+	}
+
+	char path[] = "/tmp/musicplayer-heap-XXXXXX";
+	const int fd = mkstemp(path);
+	if (fd < 0) return std::nullopt;
+	close(fd);
+
+	const char* filename = path;
+	const int rc = mallctl("prof.dump", nullptr, nullptr, &filename, sizeof(filename));
+	std::ifstream file(path, std::ios::binary);
+	std::ostringstream body;
+	body << file.rdbuf();
+	file.close();
+	std::remove(path);
+
+	if (rc != 0) {
+		spdlog::error("{} jemalloc prof.dump failed: {}", TAG, std::strerror(rc));
+		return std::nullopt;
+	}
+	return HeapSnapshot{"application/octet-stream", body.str()};
+}
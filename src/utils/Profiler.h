@@ -0,0 +1,55 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <string>
+
+/**
+ * @brief 进程内 CPU 采样与堆快照 单例
+ *
+ * CPU: setitimer(ITIMER_PROF) 按进程 CPU 时间触发 SIGPROF, 信号处理函数以 backtrace 把调用栈
+ * 写入预分配的样本数组 (只有原子操作, 不分配内存); 结束后以 dladdr 符号化并按调用栈合并为
+ * folded 格式 ("main;foo;bar 42"), 可直接交给 flamegraph.pl. 可执行文件需导出符号
+ * (-rdynamic), 否则静态函数只显示为 "模块+偏移". 同一时刻只允许一次采样.
+ *
+ * 堆: 运行在 jemalloc 上时以 prof.dump 导出堆 profile (需 MALLOC_CONF=prof:true), 可由 jeprof
+ * 解析; 不在 jemalloc 上时退回 glibc malloc_info 的分配器统计 (XML).
+ */
+class Profiler {
+public:
+	static constexpr int MAX_HZ = 1000;
+	static constexpr std::chrono::seconds MAX_DURATION{60};
+
+	struct HeapSnapshot {
+		std::string content_type;
+		std::string body;
+	};
+
+	static Profiler* getInstance();
+
+	/**
+	 * @brief 阻塞采样 duration, 返回 folded 调用栈
+	 * @return 已有采样进行中时返回 nullopt
+	 */
+	std::optional<std::string> profileCpu(std::chrono::seconds duration, int hz);
+
+	// 堆快照; 分配器都不支持时返回 nullopt
+	std::optional<HeapSnapshot> heapSnapshot();
+
+	~Profiler() = default;
+	Profiler(const Profiler&) = delete;
+	Profiler(Profiler&&) = delete;
+	Profiler& operator=(const Profiler&) = delete;
+	Profiler& operator=(Profiler&&) = delete;
+
+private:
+	Profiler() = default;
+
+	std::optional<HeapSnapshot> jemallocDump();
+
+private:
+	std::atomic<bool> m_cpu_busy{false};
+
+	static std::unique_ptr<Profiler> m_instance;
+};
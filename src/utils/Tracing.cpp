@@ -0,0 +1,288 @@
+#include "Tracing.h"
+#include "Metrics.h"
+
+#include <spdlog/spdlog.h>
+
+#include <cinttypes>
+#include <cstdio>
+#include <filesystem>
+#include <map>
+#include <random>
+#include <stdexcept>
+
+constexpr const char* TAG = "[Tracing]";
+
+std::unique_ptr<Tracer> Tracer::m_instance = nullptr;
+
+namespace {
+
+// 当前线程激活的 trace 与父 span
+thread_local Trace* t_trace = nullptr;
+thread_local size_t t_parent = 0;
+
+uint64_t randomId() {
+	thread_local std::mt19937_64 engine(std::random_device{}());
+	uint64_t id = 0;
+	while (id == 0) id = engine();
+	return id;
+}
+
+std::string hex(uint64_t value) {
+	char buf[17];
+	std::snprintf(buf, sizeof(buf), "%016" PRIx64, value);
+	return buf;
+}
+
+MetricCounter& traceCounter(const char* result) {
+	return MetricsRegistry::getInstance()->counter("traces_total", "Finished traces by outcome",
+												   {{"result", result}});
+}
+
+} // namespace
+
+Trace::Trace(std::string name, bool sampled)
+	: m_sampled(sampled),
+	  m_trace_id{randomId(), randomId()},
+	  m_start(std::chrono::steady_clock::now()),
+	  m_start_unix_ns(std::chrono::duration_cast<std::chrono::nanoseconds>(
+						  std::chrono::system_clock::now().time_since_epoch())
+						  .count()) {
+	m_spans.reserve(16);
+	Span root;
+	root.name = std::move(name);
+	root.id = randomId();
+	m_spans.push_back(std::move(root));
+}
+
+int64_t Trace::now() const {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() -
+																m_start)
+		.count();
+}
+
+size_t Trace::begin(std::string name, size_t parent) {
+	std::lock_guard<std::mutex> lock(m_mtx);
+	if (m_spans.size() >= MAX_SPANS || parent >= m_spans.size()) {
+		++m_dropped;
+		return NO_SPAN;
+	}
+
+	Span span;
+	span.name = std::move(name);
+	span.id = randomId();
+	span.parent_id = m_spans[parent].id;
+	span.start_ns = now();
+	m_spans.push_back(std::move(span));
+	return m_spans.size() - 1;
+}
+
+void Trace::end(size_t span) {
+	std::lock_guard<std::mutex> lock(m_mtx);
+	if (span < m_spans.size() && m_spans[span].end_ns < 0) m_spans[span].end_ns = now();
+}
+
+void Trace::setAttribute(size_t span, std::string key, std::string value) {
+	std::lock_guard<std::mutex> lock(m_mtx);
+	if (span < m_spans.size()) {
+		m_spans[span].attributes.emplace_back(std::move(key), std::move(value));
+	}
+}
+
+std::chrono::nanoseconds Trace::elapsed() const {
+	std::lock_guard<std::mutex> lock(m_mtx);
+	const int64_t end = m_spans[0].end_ns;
+	return std::chrono::nanoseconds(end >= 0 ? end : now());
+}
+
+std::string Trace::serverTiming() const {
+	std::map<std::string, int64_t> totals;
+	{
+		std::lock_guard<std::mutex> lock(m_mtx);
+		for (size_t i = 1; i < m_spans.size(); ++i) {
+			const Span& span = m_spans[i];
+			const int64_t end = span.end_ns >= 0 ? span.end_ns : now();
+			totals[span.name] += end - span.start_ns;
+		}
+	}
+
+	std::string out;
+	char buf[32];
+	for (const auto& [name, total] : totals) {
+		if (!out.empty()) out += ", ";
+		std::snprintf(buf, sizeof(buf), "%.3f", static_cast<double>(total) / 1e6);
+		out += name + ";dur=" + buf;
+	}
+	return out;
+}
+
+nlohmann::json Trace::toOtlpJson() const {
+	std::lock_guard<std::mutex> lock(m_mtx);
+	const std::string trace_id = hex(m_trace_id[0]) + hex(m_trace_id[1]);
+	const int64_t fallback_end = now();
+
+	nlohmann::json spans = nlohmann::json::array();
+	for (size_t i = 0; i < m_spans.size(); ++i) {
+		const Span& span = m_spans[i];
+		nlohmann::json attributes = nlohmann::json::array();
+		for (const auto& [key, value] : span.attributes) {
+			attributes.push_back({{"key", key}, {"value", {{"stringValue", value}}}});
+		}
+		if (i == 0 && m_dropped > 0) {
+			attributes.push_back({{"key", "trace.dropped_spans"},
+								  {"value", {{"intValue", std::to_string(m_dropped)}}}});
+		}
+
+		const int64_t end = span.end_ns >= 0 ? span.end_ns : fallback_end;
+		nlohmann::json item = {
+			{"traceId", trace_id},
+			{"spanId", hex(span.id)},
+			{"name", span.name},
+			{"kind", i == 0 ? 2 : 1}, // SPAN_KIND_SERVER / SPAN_KIND_INTERNAL
+			{"startTimeUnixNano", std::to_string(m_start_unix_ns + span.start_ns)},
+			{"endTimeUnixNano", std::to_string(m_start_unix_ns + end)},
+			{"attributes", std::move(attributes)}};
+		if (span.parent_id != 0) item["parentSpanId"] = hex(span.parent_id);
+		spans.push_back(std::move(item));
+	}
+	return spans;
+}
+
+TraceScope::TraceScope(const std::shared_ptr<Trace>& trace, size_t parent)
+	: m_prev_trace(t_trace), m_prev_parent(t_parent) {
+	t_trace = trace.get();
+	t_parent = parent;
+}
+
+TraceScope::~TraceScope() {
+	t_trace = m_prev_trace;
+	t_parent = m_prev_parent;
+}
+
+TraceSpan::TraceSpan(const char* name) : m_trace(t_trace) {
+	if (m_trace == nullptr) return;
+
+	m_span = m_trace->begin(name, t_parent);
+	if (m_span == Trace::NO_SPAN) return;
+
+	m_prev_parent = t_parent;
+	t_parent = m_span;
+}
+
+TraceSpan::~TraceSpan() {
+	if (m_span == Trace::NO_SPAN) return;
+
+	m_trace->end(m_span);
+	t_parent = m_prev_parent;
+}
+
+void TraceSpan::setAttribute(std::string key, std::string value) {
+	if (m_span != Trace::NO_SPAN) m_trace->setAttribute(m_span, std::move(key), std::move(value));
+}
+
+Tracer::Tracer(double sample_rate, std::chrono::milliseconds slow_threshold,
+			   const std::string& export_path, size_t queue_size, bool server_timing)
+	: m_sample_rate(sample_rate),
+	  m_slow_threshold(slow_threshold),
+	  m_queue_size(queue_size > 0 ? queue_size : 1),
+	  m_server_timing(server_timing) {
+	std::error_code ec;
+	const auto dir = std::filesystem::path(export_path).parent_path();
+	if (!dir.empty()) std::filesystem::create_directories(dir, ec);
+
+	m_out.open(export_path, std::ios::app);
+	if (!m_out) {
+		spdlog::error("{} Open trace file {} failed, traces will be dropped", TAG, export_path);
+	}
+	m_thread = std::thread([this]() { runLoop(); });
+}
+
+Tracer::~Tracer() { stop(); }
+
+void Tracer::init(double sample_rate, std::chrono::milliseconds slow_threshold,
+				  const std::string& export_path, size_t queue_size, bool server_timing) {
+	if (!m_instance) {
+		m_instance.reset(
+			new Tracer(sample_rate, slow_threshold, export_path, queue_size, server_timing));
+	}
+}
+
+Tracer* Tracer::getInstance() {
+	if (!m_instance) {
+		throw std::runtime_error("Tracer not initialized");
+	}
+
+	return m_instance.get();
+}
+
+std::shared_ptr<Trace> Tracer::startTrace(std::string name) {
+	if (!m_instance) return nullptr;
+
+	thread_local std::mt19937_64 engine(std::random_device{}());
+	const bool sampled =
+		std::uniform_real_distribution<double>(0.0, 1.0)(engine) < m_instance->m_sample_rate;
+	return std::make_shared<Trace>(std::move(name), sampled);
+}
+
+void Tracer::finish(const std::shared_ptr<Trace>& trace) {
+	trace->end(0);
+	if (!trace->sampled() && trace->elapsed() < m_slow_threshold) return;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mtx);
+		if (m_stop || m_queue.size() >= m_queue_size) {
+			static MetricCounter& dropped = traceCounter("dropped");
+			dropped.inc();
+			return;
+		}
+		m_queue.push_back(trace);
+	}
+	m_cv.notify_one();
+}
+
+void Tracer::stop() {
+	{
+		std::lock_guard<std::mutex> lock(m_mtx);
+		m_stop = true;
+	}
+	m_cv.notify_all();
+	if (m_thread.joinable()) m_thread.join();
+}
+
+void Tracer::runLoop() {
+	std::vector<std::shared_ptr<Trace>> batch;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(m_mtx);
+			m_cv.wait(lock, [this]() { return m_stop || !m_queue.empty(); });
+			if (m_queue.empty()) return; // 已停止且队列为空
+
+			batch.assign(m_queue.begin(), m_queue.end());
+			m_queue.clear();
+		}
+
+		write(batch);
+		batch.clear();
+	}
+}
+
+void Tracer::write(const std::vector<std::shared_ptr<Trace>>& batch) {
+	static MetricCounter& exported = traceCounter("exported");
+	if (!m_out) return;
+
+	// 一个 ExportTraceServiceRequest
+	nlohmann::json spans = nlohmann::json::array();
+	for (const auto& trace : batch) {
+		for (auto& span : trace->toOtlpJson()) spans.push_back(std::move(span));
+	}
+
+	nlohmann::json request = {
+		{"resourceSpans",
+		 {{{"resource",
+			{{"attributes",
+			  {{{"key", "service.name"}, {"value", {{"stringValue", "music-player-backend"}}}}}}}},
+		   {"scopeSpans", {{{"scope", {{"name", "music-player-backend"}}}, {"spans", spans}}}}}}}};
+
+	m_out << request.dump() << '\n';
+	m_out.flush();
+	exported.inc(batch.size());
+}
@@ -0,0 +1,164 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+/**
+ * @brief 一个请求的 span 树
+ *
+ * 根 span (序号 0) 从读到请求头开始, 到响应写完结束. 请求在 io 线程与工作线程之间交接,
+ * 同一时刻只有一个线程写入, 加锁只为保证交接之外的可见性. span 数超过 MAX_SPANS 后不再记录.
+ */
+class Trace {
+public:
+	static constexpr size_t MAX_SPANS = 256;
+	static constexpr size_t NO_SPAN = static_cast<size_t>(-1);
+
+	struct Span {
+		std::string name;
+		uint64_t id = 0;
+		uint64_t parent_id = 0; // 0 表示根
+		int64_t start_ns = 0;	// 相对 trace 开始
+		int64_t end_ns = -1;	// 未结束为 -1
+		std::vector<std::pair<std::string, std::string>> attributes;
+	};
+
+	Trace(std::string name, bool sampled);
+
+	// 开始 parent 下的子 span, 超过上限返回 NO_SPAN
+	size_t begin(std::string name, size_t parent = 0);
+	void end(size_t span);
+	void setAttribute(size_t span, std::string key, std::string value);
+
+	// 根 span 的耗时, 未结束时为至今的耗时
+	std::chrono::nanoseconds elapsed() const;
+
+	// 按 span 名合并耗时, 如 "db;dur=1.2, auth;dur=0.3" (不含根)
+	std::string serverTiming() const;
+
+	// OTLP JSON 的 spans 数组
+	nlohmann::json toOtlpJson() const;
+
+	bool sampled() const { return m_sampled; }
+
+private:
+	int64_t now() const;
+
+private:
+	const bool m_sampled; // 按比例采样命中; 未命中时仍可因超过阈值而导出
+	const uint64_t m_trace_id[2];
+	const std::chrono::steady_clock::time_point m_start;
+	const int64_t m_start_unix_ns;
+
+	mutable std::mutex m_mtx;
+	std::vector<Span> m_spans;
+	size_t m_dropped = 0;
+};
+
+/**
+ * @brief 在当前线程上激活 trace, 作用域内的 TraceSpan 记入其 parent 之下
+ */
+class TraceScope {
+public:
+	explicit TraceScope(const std::shared_ptr<Trace>& trace, size_t parent = 0);
+	~TraceScope();
+
+	TraceScope(const TraceScope&) = delete;
+	TraceScope(TraceScope&&) = delete;
+	TraceScope& operator=(const TraceScope&) = delete;
+	TraceScope& operator=(TraceScope&&) = delete;
+
+private:
+	Trace* m_prev_trace;
+	size_t m_prev_parent;
+};
+
+/**
+ * @brief 作用域 span; 当前线程没有激活的 trace 时不做任何事
+ */
+class TraceSpan {
+public:
+	explicit TraceSpan(const char* name);
+	~TraceSpan();
+
+	void setAttribute(std::string key, std::string value);
+
+	TraceSpan(const TraceSpan&) = delete;
+	TraceSpan(TraceSpan&&) = delete;
+	TraceSpan& operator=(const TraceSpan&) = delete;
+	TraceSpan& operator=(TraceSpan&&) = delete;
+
+private:
+	Trace* m_trace;
+	size_t m_span = Trace::NO_SPAN;
+	size_t m_prev_parent = 0;
+};
+
+/**
+ * @brief 请求追踪 单例
+ *
+ * 每个请求都记录 span (开销为每个 span 一次加锁与一次 vector 追加), 结束时决定是否导出:
+ * 按 sample_rate 采样命中, 或总耗时不小于 slow_threshold. 导出由后台线程以 OTLP JSON
+ * (ExportTraceServiceRequest, 每行一个) 追加到文件, 可由 OpenTelemetry Collector 的
+ * otlpjsonfile receiver 读取; 队列满时丢弃.
+ */
+class Tracer {
+public:
+	static void init(double sample_rate, std::chrono::milliseconds slow_threshold,
+					 const std::string& export_path, size_t queue_size, bool server_timing);
+
+	static Tracer* getInstance();
+
+	// 开始一个请求的 trace; 未初始化时返回 nullptr
+	static std::shared_ptr<Trace> startTrace(std::string name);
+
+	// 结束根 span 并按采样规则提交导出
+	void finish(const std::shared_ptr<Trace>& trace);
+
+	// 响应是否附带 Server-Timing 头 (调试用)
+	bool serverTiming() const { return m_server_timing; }
+
+	// 停止后台线程, 写完队列中的 trace
+	void stop();
+
+	~Tracer();
+	Tracer(const Tracer&) = delete;
+	Tracer(Tracer&&) = delete;
+	Tracer& operator=(const Tracer&) = delete;
+	Tracer& operator=(Tracer&&) = delete;
+
+private:
+	Tracer(double sample_rate, std::chrono::milliseconds slow_threshold,
+		   const std::string& export_path, size_t queue_size, bool server_timing);
+
+	void runLoop();
+
+	void write(const std::vector<std::shared_ptr<Trace>>& batch);
+
+private:
+	double m_sample_rate;
+	std::chrono::nanoseconds m_slow_threshold;
+	size_t m_queue_size;
+	bool m_server_timing;
+
+	std::ofstream m_out;
+
+	std::thread m_thread;
+	std::mutex m_mtx;
+	std::condition_variable m_cv;
+	std::deque<std::shared_ptr<Trace>> m_queue;
+	bool m_stop = false;
+
+	static std::unique_ptr<Tracer> m_instance;
+};
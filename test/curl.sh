@@ -1,39 +1,70 @@
 #!/bin/bash
-# filepath: /home/hzh/test/curl.sh
+# 逐个接口冒烟测试; 吞吐与延迟压测见 bench-http-load
+#
+# 用法:
+#   USERNAME=load0 PASSWORD=load-password ./curl.sh all    测试所有接口
+#   ./curl.sh stress <序号> [次数]                          压测指定接口
+#   ./curl.sh [次数] [序号]                                 测试指定接口若干次
+#
+# 设置 USERNAME/PASSWORD 时先登录, 之后的请求带上 Authorization; 歌单接口使用 PLAYLIST_ID
 
 # 服务器地址
-HOST="localhost"
-PORT="8080"
+HOST="${HOST:-localhost}"
+PORT="${PORT:-8080}"
+PLAYLIST_ID="${PLAYLIST_ID:-1}"
 
-# 测试接口数组
+# 测试接口数组: 方法|路径|描述|请求体 (与 setupRoutes 注册的路由一致)
 endpoints=(
-    "GET:/:首页"
-    "POST:/users/register:用户注册"
-    "POST:/users/login:用户登录"
-    "GET:/users/123:获取用户信息"
-    "PUT:/users/123:更新用户信息"
-    "PUT:/users/123/password:修改密码"
+    "GET|/|首页|"
+    "POST|/users/verify_code|获取验证码|{\"email\":\"test@example.com\",\"action\":\"register\"}"
+    "POST|/users/login|用户登录|{\"username\":\"$USERNAME\",\"password\":\"$PASSWORD\"}"
+    "GET|/users/info|获取用户信息|"
+    "GET|/users/avatar|获取用户头像|"
+    "GET|/users/avatar/raw|下载二进制头像|"
 
-    "GET:/playlists:获取歌单列表"
-    "GET:/playlists/456/songs:获取歌单歌曲"
-    "POST:/playlists/456/songs:添加歌曲到歌单"
-    "DELETE:/playlists/456/songs/789:从歌单删除歌曲"
-    "POST:/playlists:创建歌单"
-    "DELETE:/playlists/456:删除歌单"
+    "POST|/playlists|获取歌单列表|"
+    "POST|/playlists/create|创建歌单|{\"name\":\"curl\"}"
+    "GET|/playlists/info?playlist_id=$PLAYLIST_ID|获取歌单详情|"
+    "GET|/playlists/songs?playlist_id=$PLAYLIST_ID|获取歌单歌曲|"
+    "POST|/playlists/add?playlist_id=$PLAYLIST_ID|添加歌曲到歌单|{\"song\":{\"song_id\":\"curl-1\",\"where\":\"QQ\",\"name\":\"curl\"}}"
+    "POST|/playlists/erase?playlist_id=$PLAYLIST_ID|从歌单删除歌曲|{\"song_id\":\"curl-1\",\"where\":\"QQ\"}"
+    "POST|/playlists/update?playlist_id=$PLAYLIST_ID|修改歌单信息|{\"name\":\"curl-renamed\"}"
 
-    "GET:/history:获取历史记录"
-    "POST:/history:添加历史记录"
-    "DELETE:/history/123:删除历史记录"
-    "DELETE:/history:清空历史记录"
-    "GET:/history/most_played?limit=10:获取最常播放的歌曲"
-    "GET:/history/most_played?limit=10&offset=5:获取最常播放的歌曲（分页）"
+    "POST|/history|获取历史记录|{\"limit\":10,\"offset\":0}"
+    "POST|/history/add|添加历史记录|{\"song_id\":\"curl-1\",\"where\":\"QQ\",\"name\":\"curl\"}"
+    "POST|/history/erase|删除历史记录|{\"history_id\":1}"
+    "GET|/history/stats|播放统计|"
+
+    "GET|/metrics|指标|"
 )
 
+TOKEN=""
+
+# 以 USERNAME/PASSWORD 登录, 取响应头中的 token
+login() {
+    [ -z "$USERNAME" ] && return
+    TOKEN=$(curl -s -D - -o /dev/null -X POST "http://$HOST:$PORT/users/login" \
+        -H "Content-Type: application/json" \
+        -d "{\"username\":\"$USERNAME\",\"password\":\"$PASSWORD\"}" |
+        awk 'tolower($1) == "authorization:" { print $2 }' | tr -d '\r')
+    [ -z "$TOKEN" ] && echo "登录失败: $USERNAME"
+}
+
+# 发送一个请求, 额外参数传给 curl
+request() {
+    IFS='|' read -r method path description body <<<"$1"
+    shift
+    local args=(-s -X "$method" "http://$HOST:$PORT$path")
+    [ -n "$TOKEN" ] && args+=(-H "Authorization: $TOKEN")
+    [ -n "$body" ] && args+=(-H "Content-Type: application/json" -d "$body")
+    curl "${args[@]}" "$@"
+}
+
 # 单次请求测试
 test_endpoint() {
-    IFS=':' read -r method path description <<<"$1"
+    IFS='|' read -r method path description _ <<<"$1"
     echo "测试: $description ($method $path)"
-    curl -s -H "Connection: close" -i -X "$method" "http://$HOST:$PORT$path" | head -n 1
+    request "$1" -i | head -n 1
     sleep 0.1
 }
 
@@ -42,16 +73,18 @@ stress_test() {
     local repeat=$1
     local endpoint=$2
 
-    IFS=':' read -r method path description <<<"$endpoint"
+    IFS='|' read -r method path description _ <<<"$endpoint"
     echo "压力测试: $description ($method $path) - $repeat 次请求"
 
     for ((i = 1; i <= repeat; i++)); do
         echo -n "请求 $i: "
-        curl -s -H "Connection: close" -X "$method" "http://$HOST:$PORT$path" -o /dev/null -w "%{http_code}\n"
+        request "$endpoint" -o /dev/null -w "%{http_code}\n"
         sleep 0.01
     done
 }
 
+login
+
 # 使用方式判断
 if [ "$1" == "all" ]; then
     # 测试所有接口
@@ -68,8 +101,7 @@ else
 
     for ((i = 1; i <= repeat; i++)); do
         echo "第 $i 次请求:"
-        IFS=':' read -r method path description <<<"$endpoint"
-        curl -s -H "Connection: close" -i -X "$method" "http://$HOST:$PORT$path" | head -n 1
+        request "$endpoint" -i | head -n 1
         echo ""
         sleep 0.1
     done
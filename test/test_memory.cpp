@@ -0,0 +1,233 @@
+// memory 后端的处理器测试, 不依赖数据库: 唯一键, 注销用户的级联删除, 各列表的顺序
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "common/net.h"
+#include "database/PlaylistCache.h"
+#include "database/Storage.h"
+#include "handlers/PlayHistoryHandler.h"
+#include "handlers/PlaylistHandler.h"
+#include "handlers/UserHandler.h"
+
+namespace {
+
+constexpr const char* JWT_SECRET = "test-memory";
+
+int g_failures = 0;
+
+#define CHECK(cond)                                                                    \
+	do {                                                                               \
+		if (!(cond)) {                                                                 \
+			++g_failures;                                                              \
+			std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #cond "\n"; \
+		}                                                                              \
+	} while (0)
+
+HttpRequest makeRequest(http::verb verb, const std::string& target, const std::string& token,
+						const json& body = nullptr) {
+	HttpRequest req{verb, target, 11};
+	if (!token.empty()) req.set(http::field::authorization, token);
+	if (!body.is_null()) {
+		req.set(http::field::content_type, "application/json");
+		req.body() = body.dump();
+	}
+	req.prepare_payload();
+	return req;
+}
+
+json parseBody(const HttpResponse& res) { return json::parse(res.body(), nullptr, false); }
+
+json song(const std::string& song_id, const std::string& where, const std::string& singer = "") {
+	return json{{"song_id", song_id}, {"where", where}, {"name", song_id}, {"singer", singer}};
+}
+
+struct Handlers {
+	UserHandler user{JWT_SECRET};
+	PlaylistHandler playlist{JWT_SECRET};
+	HistoryHandler history{JWT_SECRET};
+};
+
+// 直接经 DAO 注册 (处理器注册需要邮件验证码), 再经处理器登录取得 token
+std::string registerAndLogin(Handlers& handlers, UserDAO& user_dao, const std::string& name) {
+	User user;
+	user.username = name;
+	user.passwd_hash = name + "-password";
+	user.email = name + "@example.com";
+	CHECK(user_dao.createUser(user) == DAOStatus::Ok);
+
+	auto res = handlers.user.handleLogin(makeRequest(
+		http::verb::post, "/user/login", "",
+		json{{"username", user.username}, {"password", user.passwd_hash}}));
+	CHECK(res.result() == http::status::ok);
+	return std::string(res[http::field::authorization]);
+}
+
+int createPlaylist(Handlers& handlers, const std::string& token, const std::string& name) {
+	auto res = handlers.playlist.handleCreatePlaylist(
+		makeRequest(http::verb::post, "/playlist/create", token, json{{"name", name}}));
+	CHECK(res.result() == http::status::ok);
+	return parseBody(res).value("playlist_id", 0);
+}
+
+http::status addSong(Handlers& handlers, const std::string& token, int playlist_id,
+					 const json& s) {
+	auto res = handlers.playlist.handleAddSongToPlaylist(
+		makeRequest(http::verb::post, "/playlist/song/add", token,
+					json{{"playlist_id", playlist_id}, {"song", s}}));
+	return res.result();
+}
+
+void play(Handlers& handlers, const std::string& token, const json& s) {
+	auto res =
+		handlers.history.handleAddHistory(makeRequest(http::verb::post, "/history/add", token, s));
+	CHECK(res.result() == http::status::ok);
+}
+
+void testUniqueKeys(Handlers& handlers, UserDAO& user_dao) {
+	const std::string token = registerAndLogin(handlers, user_dao, "alice");
+
+	User dup_name;
+	dup_name.username = "alice";
+	dup_name.passwd_hash = "x";
+	dup_name.email = "other@example.com";
+	CHECK(user_dao.createUser(dup_name) == DAOStatus::Conflict);
+
+	User dup_email;
+	dup_email.username = "alice2";
+	dup_email.passwd_hash = "x";
+	dup_email.email = "alice@example.com";
+	CHECK(user_dao.createUser(dup_email) == DAOStatus::Conflict);
+
+	// (song_id, where) 唯一: 同一歌单不能重复加入, 不同平台的同名 id 是不同歌曲
+	const int playlist_id = createPlaylist(handlers, token, "unique");
+	CHECK(addSong(handlers, token, playlist_id, song("s1", "QQ")) == http::status::ok);
+	CHECK(addSong(handlers, token, playlist_id, song("s1", "QQ")) == http::status::conflict);
+	CHECK(addSong(handlers, token, playlist_id, song("s1", "NetEase")) == http::status::ok);
+	// song_id 区分大小写
+	CHECK(addSong(handlers, token, playlist_id, song("S1", "QQ")) == http::status::ok);
+
+	auto res = handlers.playlist.handleGetSongsInPlaylist(makeRequest(
+		http::verb::get, "/playlist/songs?playlist_id=" + std::to_string(playlist_id), token));
+	CHECK(parseBody(res)["songs"].size() == 3);
+}
+
+void testOrdering(Handlers& handlers, UserDAO& user_dao) {
+	const std::string token = registerAndLogin(handlers, user_dao, "bob");
+
+	// 歌单按 id
+	std::vector<int> ids;
+	for (const char* name : {"b", "a", "c"}) ids.push_back(createPlaylist(handlers, token, name));
+	auto res = handlers.playlist.handleGetPlaylists(
+		makeRequest(http::verb::get, "/playlist/list", token));
+	json playlists = parseBody(res)["playlists"];
+	CHECK(playlists.size() == 3);
+	for (size_t i = 0; i < playlists.size() && i < ids.size(); ++i) {
+		CHECK(playlists[i]["id"] == ids[i]);
+	}
+
+	// 歌单歌曲按加入顺序
+	for (const char* id : {"o3", "o1", "o2"}) {
+		CHECK(addSong(handlers, token, ids[0], song(id, "QQ")) == http::status::ok);
+	}
+	res = handlers.playlist.handleGetSongsInPlaylist(makeRequest(
+		http::verb::get, "/playlist/songs?playlist_id=" + std::to_string(ids[0]), token));
+	json songs = parseBody(res)["songs"];
+	CHECK(songs.size() == 3);
+	if (songs.size() == 3) {
+		CHECK(songs[0]["song_id"] == "o3");
+		CHECK(songs[1]["song_id"] == "o1");
+		CHECK(songs[2]["song_id"] == "o2");
+	}
+
+	// 播放历史按时间倒序 (同一秒内按 id)
+	for (const char* id : {"h1", "h2", "h3"}) play(handlers, token, song(id, "QQ", "Singer"));
+	res = handlers.history.handleGetHistory(
+		makeRequest(http::verb::get, "/history/list?limit=10", token));
+	json history = parseBody(res)["history"];
+	CHECK(history.size() == 3);
+	if (history.size() == 3) {
+		CHECK(history[0]["song_id"] == "h3");
+		CHECK(history[2]["song_id"] == "h1");
+	}
+
+	// 统计按次数降序, 次数相同时按歌曲 (先写入的 ref 小) / 歌手名
+	const std::string stats_token = registerAndLogin(handlers, user_dao, "carol");
+	play(handlers, stats_token, song("t2", "QQ", "Zed"));
+	play(handlers, stats_token, song("t1", "QQ", "Amy"));
+	play(handlers, stats_token, song("t3", "QQ", "Mia"));
+	play(handlers, stats_token, song("t3", "QQ", "Mia"));
+	res = handlers.history.handleGetStats(
+		makeRequest(http::verb::get, "/history/stats?limit=10", stats_token));
+	json stats = parseBody(res);
+	CHECK(stats["total_plays"] == 4);
+	json top_songs = stats["top_songs"];
+	json top_artists = stats["top_artists"];
+	CHECK(top_songs.size() == 3 && top_artists.size() == 3);
+	if (top_songs.size() == 3 && top_artists.size() == 3) {
+		CHECK(top_songs[0]["song_id"] == "t3");
+		CHECK(top_songs[1]["song_id"] == "t2");
+		CHECK(top_songs[2]["song_id"] == "t1");
+		CHECK(top_artists[0]["singer"] == "Mia");
+		CHECK(top_artists[1]["singer"] == "Amy");
+		CHECK(top_artists[2]["singer"] == "Zed");
+	}
+}
+
+void testDeleteUserCascade(Handlers& handlers, UserDAO& user_dao) {
+	const std::string token = registerAndLogin(handlers, user_dao, "dave");
+	const int playlist_id = createPlaylist(handlers, token, "doomed");
+	CHECK(addSong(handlers, token, playlist_id, song("d1", "QQ")) == http::status::ok);
+	play(handlers, token, song("d1", "QQ", "Singer"));
+
+	auto user = user_dao.getUserByUsername("dave");
+	CHECK(user.has_value());
+	if (!user) return;
+	CHECK(user_dao.deleteUser(user->id).has_value());
+	CHECK(!user_dao.getUserById(user->id).has_value());
+
+	// token 仍有效, 但歌单与播放历史已随用户删除
+	auto res = handlers.playlist.handleGetPlaylists(
+		makeRequest(http::verb::get, "/playlist/list", token));
+	CHECK(parseBody(res)["playlists"].empty());
+
+	res = handlers.playlist.handleGetSongsInPlaylist(makeRequest(
+		http::verb::get, "/playlist/songs?playlist_id=" + std::to_string(playlist_id), token));
+	CHECK(res.result() == http::status::not_found);
+
+	res = handlers.history.handleGetHistory(
+		makeRequest(http::verb::get, "/history/list", token));
+	CHECK(parseBody(res)["history"].empty());
+
+	// 外键: 已删除的用户不能再创建歌单或写入历史
+	res = handlers.playlist.handleCreatePlaylist(
+		makeRequest(http::verb::post, "/playlist/create", token, json{{"name", "x"}}));
+	CHECK(res.result() == http::status::not_found);
+	res = handlers.history.handleAddHistory(
+		makeRequest(http::verb::post, "/history/add", token, song("d1", "QQ")));
+	CHECK(res.result() != http::status::ok);
+
+	// 用户名与邮箱随之释放
+	registerAndLogin(handlers, user_dao, "dave");
+}
+
+} // namespace
+
+int main() {
+	PlaylistCache::init(1024);
+	Storage::init(Storage::Backend::Memory);
+
+	Handlers handlers;
+	auto user_dao = Storage::getInstance()->createUserDAO();
+
+	testUniqueKeys(handlers, *user_dao);
+	testOrdering(handlers, *user_dao);
+	testDeleteUserCascade(handlers, *user_dao);
+
+	if (g_failures > 0) {
+		std::cerr << g_failures << " check(s) failed\n";
+		return 1;
+	}
+	std::cout << "All memory backend tests passed\n";
+	return 0;
+}
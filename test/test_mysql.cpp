@@ -10,14 +10,14 @@
 #include "utils/EmailUtil.h"
 
 void test_user_dao() {
-	UserDAO user_dao;
+	MySqlUserDAO user_dao;
 	User user{.id = 3,
 			  .username = "hzh",
 			  .passwd_hash = "123456",
 			  .email = "142344@qq.com",
 			  .qq_id = "1423443710"};
 
-	if (user_dao.createUser(user)) {
+	if (user_dao.createUser(user) == DAOStatus::Ok) {
 		std::cout << "User created successfully!\n";
 	} else {
 		std::cout << "Failed to create user!\n";
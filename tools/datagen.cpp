@@ -0,0 +1,402 @@
+/**
+ * 合成数据集生成器: 批量写入用户, 歌曲, 歌单与播放历史, 用于容量评估与 DAO 压测
+ *
+ * 歌曲热度服从 Zipf 分布 (排名随机映射到歌曲), 歌单大小为 [10, 10000] 的截断 Pareto 分布,
+ * 每个用户的播放次数为对数正态长尾, 均值为 plays_per_user, 时间均匀分布在最近 HISTORY_DAYS 天.
+ * 用户名为 load<i>, 密码均为 load-password, 与 bench-http-load 的约定一致.
+ * 统计汇总表按生成的播放历史同时写入, 结果与服务端增量维护相同.
+ *
+ * 多行 INSERT 每批一条语句 (自动提交即一个事务), 多个连接并行写入, 会话内关闭唯一键与外键检查.
+ * id 从各表当前最大值之后显式分配; 库中已有 load0 时拒绝运行.
+ *
+ * 用法: datagen <config.json> [users] [songs] [plays_per_user] [playlists] [threads] [seed]
+ */
+#include "database/DBManager.h"
+#include "database/HistoryPartitions.h"
+#include "utils/Config.h"
+#include "utils/PasswordUtil.h"
+
+#include <jdbc/cppconn/exception.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <functional>
+#include <numeric>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+constexpr size_t BATCH_ROWS = 1000;
+constexpr double ZIPF_EXPONENT = 1.0;
+constexpr double PLAYLIST_ALPHA = 1.0; // 歌单大小的 Pareto 指数
+constexpr size_t PLAYLIST_MIN = 10;
+constexpr size_t PLAYLIST_MAX = 10000;
+constexpr size_t SONGS_PER_SINGER = 20;
+constexpr uint32_t HISTORY_DAYS = 30;
+constexpr const char* SONG_PREFIX = "datagen-";
+constexpr const char* PASSWORD = "load-password";
+
+struct Options {
+	size_t users = 100000;
+	size_t songs = 50000;
+	size_t plays_per_user = 200;
+	size_t playlists = 0; // 缺省为 users / 10
+	size_t threads = 4;
+	uint64_t seed = 42;
+};
+
+// 各表已有的最大 id, 新行从其后分配
+struct Bases {
+	int user = 0;
+	int song = 0;
+	int playlist = 0;
+};
+
+/**
+ * @brief Zipf 抽样, 返回排名 [0, n), 累积分布上二分查找
+ */
+class Zipf {
+public:
+	Zipf(size_t n, double exponent) : m_cdf(n) {
+		double sum = 0;
+		for (size_t i = 0; i < n; ++i) {
+			sum += 1.0 / std::pow(static_cast<double>(i + 1), exponent);
+			m_cdf[i] = sum;
+		}
+		for (double& p : m_cdf) p /= sum;
+	}
+
+	size_t operator()(std::mt19937_64& rng) const {
+		const double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+		const auto it = std::lower_bound(m_cdf.begin(), m_cdf.end(), u);
+		return std::min(static_cast<size_t>(it - m_cdf.begin()), m_cdf.size() - 1);
+	}
+
+private:
+	std::vector<double> m_cdf;
+};
+
+/**
+ * @brief 多行 INSERT 缓冲, 满 BATCH_ROWS 行时执行一条语句
+ */
+class BatchInsert {
+public:
+	BatchInsert(const SqlConnGuard& guard, std::string head)
+		: m_stmt(guard->createStatement()), m_head(std::move(head)) {}
+
+	void add(const std::string& row) {
+		m_sql += m_rows == 0 ? m_head : ",";
+		m_sql += row;
+		if (++m_rows >= BATCH_ROWS) flush();
+	}
+
+	void flush() {
+		if (m_rows == 0) return;
+		m_stmt->executeUpdate(m_sql);
+		m_total += m_rows;
+		m_rows = 0;
+		m_sql.clear();
+	}
+
+	size_t total() const { return m_total; }
+
+private:
+	StmtPtr m_stmt;
+	std::string m_head;
+	std::string m_sql;
+	size_t m_rows = 0;
+	size_t m_total = 0;
+};
+
+std::string singerName(size_t song) { return "Singer " + std::to_string(song / SONGS_PER_SINGER); }
+
+/**
+ * @brief [0, count) 按线程切成连续区间并行执行, 每个线程一个连接
+ * @param work (guard, rng, begin, end), 返回写入的行数
+ * @return 写入的总行数, 任一线程失败时返回 -1
+ */
+int64_t runParallel(const char* phase, const Options& options, size_t count,
+					const std::function<size_t(const SqlConnGuard&, std::mt19937_64&, size_t,
+											   size_t)>& work) {
+	const auto start = Clock::now();
+	const size_t threads = std::max<size_t>(1, std::min(options.threads, count));
+	const size_t per_thread = (count + threads - 1) / threads;
+	std::atomic<size_t> rows{0};
+	std::atomic<bool> failed{false};
+
+	std::vector<std::thread> workers;
+	for (size_t t = 0; t < threads; ++t) {
+		const size_t begin = t * per_thread;
+		const size_t end = std::min(count, begin + per_thread);
+		if (begin >= end) break;
+		workers.emplace_back([&, t, begin, end]() {
+			// 每个阶段, 每个区间的随机序列固定, 同样的参数生成同样的数据
+			std::mt19937_64 rng(options.seed ^ (std::hash<std::string>()(phase) + t));
+			try {
+				SqlConnGuard guard(DBManager::getInstance()->getConnection());
+				StmtPtr stmt(guard->createStatement());
+				stmt->execute("SET SESSION unique_checks = 0, foreign_key_checks = 0");
+				rows += work(guard, rng, begin, end);
+				stmt->execute("SET SESSION unique_checks = 1, foreign_key_checks = 1");
+			} catch (const sql::SQLException& e) {
+				std::fprintf(stderr, "%s: sql error: %s (%d)\n", phase, e.what(),
+							 e.getErrorCode());
+				failed = true;
+			}
+		});
+	}
+	for (auto& worker : workers) worker.join();
+	if (failed) return -1;
+
+	const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	std::fprintf(stderr, "%-16s %12zu rows %8.1f s %10.0f rows/s\n", phase, rows.load(), seconds,
+				 seconds > 0 ? rows / seconds : 0.0);
+	return static_cast<int64_t>(rows.load());
+}
+
+int queryInt(const SqlConnGuard& guard, const std::string& sql) {
+	StmtPtr stmt(guard->createStatement());
+	ResultSetPtr result(stmt->executeQuery(sql));
+	return result->next() ? result->getInt(1) : 0;
+}
+
+bool loadBases(Bases& bases) {
+	SqlConnGuard guard(DBManager::getInstance()->getConnection());
+	if (queryInt(guard, "SELECT COUNT(*) FROM users WHERE username = 'load0'") > 0 ||
+		queryInt(guard, "SELECT COUNT(*) FROM songs WHERE song_id = '" +
+							std::string(SONG_PREFIX) + "0'") > 0) {
+		std::fprintf(stderr, "dataset already generated (load0 / %s0 exists)\n", SONG_PREFIX);
+		return false;
+	}
+	bases.user = queryInt(guard, "SELECT COALESCE(MAX(id), 0) FROM users");
+	bases.song = queryInt(guard, "SELECT COALESCE(MAX(id), 0) FROM songs");
+	bases.playlist = queryInt(guard, "SELECT COALESCE(MAX(id), 0) FROM playlists");
+	return true;
+}
+
+size_t insertSongs(const SqlConnGuard& guard, size_t begin, size_t end, const Bases& bases) {
+	BatchInsert songs(guard, "INSERT INTO songs (id, song_id, song_where, song_name, "
+							 "song_singer, song_pic) VALUES ");
+	for (size_t k = begin; k < end; ++k) {
+		const std::string n = std::to_string(k);
+		songs.add("(" + std::to_string(bases.song + 1 + k) + ",'" + SONG_PREFIX + n + "','" +
+				  (k % 2 ? "QQ" : "NetEase") + "','Song " + n + "','" + singerName(k) +
+				  "','https://y.example.com/pic/" + n + ".jpg')");
+	}
+	songs.flush();
+	return songs.total();
+}
+
+size_t insertUsers(const SqlConnGuard& guard, size_t begin, size_t end, const Bases& bases,
+				   const std::string& hash) {
+	BatchInsert users(guard, "INSERT INTO users (id, username, passwd_hash, email) VALUES ");
+	for (size_t i = begin; i < end; ++i) {
+		const std::string n = std::to_string(i);
+		users.add("(" + std::to_string(bases.user + 1 + i) + ",'load" + n + "','" + hash +
+				  "','load" + n + "@example.com')");
+	}
+	users.flush();
+	return users.total();
+}
+
+// 截断 Pareto: 逆变换抽样, 结果在 [PLAYLIST_MIN, max_size]
+size_t playlistSize(std::mt19937_64& rng, size_t max_size) {
+	const double low = static_cast<double>(PLAYLIST_MIN);
+	const double high = static_cast<double>(std::max(PLAYLIST_MIN, max_size));
+	const double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+	const double ratio = std::pow(low / high, PLAYLIST_ALPHA);
+	const double x = low / std::pow(1.0 - u * (1.0 - ratio), 1.0 / PLAYLIST_ALPHA);
+	return std::min(static_cast<size_t>(x), static_cast<size_t>(high));
+}
+
+size_t insertPlaylists(const SqlConnGuard& guard, std::mt19937_64& rng, size_t begin, size_t end,
+					   const Options& options, const Bases& bases, const Zipf& zipf,
+					   const std::vector<size_t>& rank_to_song) {
+	BatchInsert playlists(guard, "INSERT INTO playlists (id, user_id, name) VALUES ");
+	BatchInsert entries(guard, "INSERT INTO playlist_songs (playlist_id, song_ref) VALUES ");
+	std::uniform_int_distribution<size_t> any_user(0, options.users - 1);
+	std::uniform_int_distribution<size_t> any_song(0, options.songs - 1);
+	// 不超过曲库一半, 重复时改为均匀抽样, 保证很快凑齐
+	const size_t max_size = std::min(PLAYLIST_MAX, options.songs / 2);
+
+	std::unordered_set<size_t> chosen;
+	for (size_t j = begin; j < end; ++j) {
+		const std::string id = std::to_string(bases.playlist + 1 + j);
+		playlists.add("(" + id + "," + std::to_string(bases.user + 1 + any_user(rng)) +
+					  ",'Playlist " + std::to_string(j) + "')");
+
+		chosen.clear();
+		const size_t size = playlistSize(rng, max_size);
+		while (chosen.size() < size) {
+			size_t song = rank_to_song[zipf(rng)];
+			while (!chosen.insert(song).second) song = any_song(rng);
+			entries.add("(" + id + "," + std::to_string(bases.song + 1 + song) + ")");
+		}
+	}
+	playlists.flush();
+	entries.flush();
+	return playlists.total() + entries.total();
+}
+
+size_t insertHistory(const SqlConnGuard& guard, std::mt19937_64& rng, size_t begin, size_t end,
+					 const Options& options, const Bases& bases, const Zipf& zipf,
+					 const std::vector<size_t>& rank_to_song, uint32_t days) {
+	BatchInsert history(guard,
+						"INSERT INTO play_history (user_id, song_ref, played_at) VALUES ");
+	BatchInsert song_stats(guard,
+						   "INSERT INTO user_song_stats (user_id, song_ref, play_count) VALUES ");
+	BatchInsert artist_stats(
+		guard, "INSERT INTO user_artist_stats (user_id, song_singer, play_count) VALUES ");
+	BatchInsert play_stats(guard, "INSERT INTO user_play_stats (user_id, total_plays) VALUES ");
+
+	// 对数正态: 均值 exp(mu + sigma^2 / 2) = plays_per_user
+	const double sigma = 1.0;
+	const double mu = std::log(static_cast<double>(std::max<size_t>(1, options.plays_per_user))) -
+					  sigma * sigma / 2;
+	std::lognormal_distribution<double> plays_of(mu, sigma);
+	const int64_t now = static_cast<int64_t>(std::time(nullptr));
+	std::uniform_int_distribution<int64_t> age(0, static_cast<int64_t>(days) * 86400 - 1);
+
+	std::unordered_map<size_t, int> per_song;
+	std::unordered_map<size_t, int> per_singer;
+	for (size_t i = begin; i < end; ++i) {
+		const std::string user = std::to_string(bases.user + 1 + i);
+		const auto plays = static_cast<size_t>(std::llround(plays_of(rng)));
+		if (plays == 0) continue;
+
+		per_song.clear();
+		per_singer.clear();
+		for (size_t p = 0; p < plays; ++p) {
+			const size_t song = rank_to_song[zipf(rng)];
+			++per_song[song];
+			++per_singer[song / SONGS_PER_SINGER];
+			history.add("(" + user + "," + std::to_string(bases.song + 1 + song) +
+						",FROM_UNIXTIME(" + std::to_string(now - age(rng)) + "))");
+		}
+		for (const auto& [song, count] : per_song) {
+			song_stats.add("(" + user + "," + std::to_string(bases.song + 1 + song) + "," +
+						   std::to_string(count) + ")");
+		}
+		for (const auto& [singer, count] : per_singer) {
+			artist_stats.add("(" + user + ",'" + singerName(singer * SONGS_PER_SINGER) + "'," +
+							 std::to_string(count) + ")");
+		}
+		play_stats.add("(" + user + "," + std::to_string(plays) + ")");
+	}
+	history.flush();
+	song_stats.flush();
+	artist_stats.flush();
+	play_stats.flush();
+	return history.total();
+}
+
+int usage() {
+	std::fprintf(stderr, "usage: datagen <config.json> [users] [songs] [plays_per_user] "
+						 "[playlists] [threads] [seed]\n");
+	return 2;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+	if (argc < 2) return usage();
+
+	Options options;
+	size_t* const positional[] = {&options.users, &options.songs, &options.plays_per_user,
+								  &options.playlists, &options.threads};
+	for (int i = 2; i < argc && i < 7; ++i) {
+		*positional[i - 2] = static_cast<size_t>(std::strtoull(argv[i], nullptr, 10));
+	}
+	if (argc > 7) options.seed = std::strtoull(argv[7], nullptr, 10);
+	if (options.playlists == 0) options.playlists = options.users / 10;
+	if (options.users == 0 || options.songs < 2 * PLAYLIST_MIN || options.threads == 0) {
+		return usage();
+	}
+
+	Config* config = Config::getInstance();
+	if (!config->loadFromFile(argv[1])) {
+		std::fprintf(stderr, "failed to load %s\n", argv[1]);
+		return 1;
+	}
+
+	const DatabaseConfig& db = config->getDatabaseConfig();
+	DBManager::init(db.host, db.port, db.user, db.password, db.dbname, options.threads);
+
+	Bases bases;
+	try {
+		if (!loadBases(bases)) return 1;
+	} catch (const sql::SQLException& e) {
+		std::fprintf(stderr, "sql error: %s (%d)\n", e.what(), e.getErrorCode());
+		return 1;
+	}
+
+	// 播放时间只落在保留期内, 不会写入即将被汇总的分区
+	const HistoryConfig& history_config = config->getHistoryConfig();
+	const uint32_t days =
+		std::max<uint32_t>(1, std::min(HISTORY_DAYS, history_config.retention_days));
+
+	// 排名到歌曲的随机映射, 热门歌曲不集中在 id 前部
+	std::vector<size_t> rank_to_song(options.songs);
+	std::iota(rank_to_song.begin(), rank_to_song.end(), 0);
+	std::shuffle(rank_to_song.begin(), rank_to_song.end(), std::mt19937_64(options.seed));
+	const Zipf zipf(options.songs, ZIPF_EXPONENT);
+	const std::string hash = PasswordUtil::hashPassword(PASSWORD);
+
+	const auto start = Clock::now();
+	const bool ok =
+		runParallel("songs", options, options.songs,
+					[&](const SqlConnGuard& guard, std::mt19937_64&, size_t begin, size_t end) {
+						return insertSongs(guard, begin, end, bases);
+					}) >= 0 &&
+		runParallel("users", options, options.users,
+					[&](const SqlConnGuard& guard, std::mt19937_64&, size_t begin, size_t end) {
+						return insertUsers(guard, begin, end, bases, hash);
+					}) >= 0 &&
+		runParallel("playlists", options, options.playlists,
+					[&](const SqlConnGuard& guard, std::mt19937_64& rng, size_t begin,
+						size_t end) {
+						return insertPlaylists(guard, rng, begin, end, options, bases, zipf,
+											   rank_to_song);
+					}) >= 0;
+	if (!ok) return 1;
+
+	// 补齐到下月的分区; 保留期取很大的值, 不汇总任何分区, 维护间隔为 0 时后台线程随即退出
+	HistoryPartitions::init(history_config.partition_months_ahead, 36500, std::chrono::hours(0),
+							std::chrono::milliseconds(0));
+	HistoryPartitions::getInstance()->stop();
+
+	if (runParallel("history", options, options.users,
+					[&](const SqlConnGuard& guard, std::mt19937_64& rng, size_t begin,
+						size_t end) {
+						return insertHistory(guard, rng, begin, end, options, bases, zipf,
+											 rank_to_song, days);
+					}) < 0) {
+		return 1;
+	}
+
+	try {
+		SqlConnGuard guard(DBManager::getInstance()->getConnection());
+		StmtPtr stmt(guard->createStatement());
+		stmt->execute("ANALYZE TABLE users, songs, playlists, playlist_songs, play_history, "
+					  "user_song_stats, user_artist_stats, user_play_stats");
+	} catch (const sql::SQLException& e) {
+		std::fprintf(stderr, "analyze failed: %s (%d)\n", e.what(), e.getErrorCode());
+	}
+
+	std::fprintf(stderr, "done in %.1f s: users load0..load%zu (password %s), ids from %d\n",
+				 std::chrono::duration<double>(Clock::now() - start).count(), options.users - 1,
+				 PASSWORD, bases.user + 1);
+	return 0;
+}
@@ -0,0 +1,112 @@
+/**
+ * 曲库导入导出命令行工具, 格式与 /library/export, /library/import 相同
+ *
+ * 用法:
+ *   library-cli export <config.json> <user_id> [out.ndjson]   (缺省输出到 stdout)
+ *   library-cli import <config.json> <user_id> <in.ndjson>     ("-" 表示 stdin)
+ */
+#include "database/DBManager.h"
+#include "database/LibraryDAO.h"
+#include "database/PlaylistCache.h"
+#include "database/StatsEngine.h"
+#include "database/UserCache.h"
+#include "utils/Config.h"
+
+#include <jdbc/cppconn/exception.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+namespace {
+
+int usage() {
+	std::fprintf(stderr,
+				 "usage: library-cli export <config.json> <user_id> [out.ndjson]\n"
+				 "       library-cli import <config.json> <user_id> <in.ndjson|->\n");
+	return 2;
+}
+
+int runExport(int user_id, std::ostream& out) {
+	LibraryExport exporter(user_id);
+	std::string chunk;
+	bool more = true;
+	while (more) {
+		chunk.clear();
+		more = exporter.next(chunk);
+		out.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+	}
+	out.flush();
+	return out ? 0 : 1;
+}
+
+int runImport(int user_id, std::istream& in) {
+	LibraryImport importer(user_id);
+	std::string line;
+	while (std::getline(in, line)) {
+		if (line.empty() || line == "\r") continue;
+
+		json j = json::parse(line, nullptr, false);
+		importer.add(j.is_discarded() || !j.is_object() ? json::object() : j);
+	}
+	importer.finish();
+
+	const LibraryImport::Summary& summary = importer.summary();
+	std::fprintf(stderr, "playlists=%zu playlist_songs=%zu history=%zu skipped=%zu\n",
+				 summary.playlists, summary.playlist_songs, summary.history, summary.skipped);
+	return 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+	if (argc < 4) return usage();
+
+	const std::string command = argv[1];
+	const std::string config_path = argv[2];
+	const int user_id = std::atoi(argv[3]);
+	if ((command != "export" && command != "import") || user_id <= 0) return usage();
+	if (command == "import" && argc < 5) return usage();
+
+	Config* config = Config::getInstance();
+	if (!config->loadFromFile(config_path)) {
+		std::fprintf(stderr, "failed to load %s\n", config_path.c_str());
+		return 1;
+	}
+
+	const DatabaseConfig& db = config->getDatabaseConfig();
+	const CacheConfig& cache = config->getCacheConfig();
+	DBManager::init(db.host, db.port, db.user, db.password, db.dbname, 2);
+	UserCache::init(std::chrono::seconds(cache.user_ttl),
+					std::chrono::seconds(cache.user_negative_ttl), cache.user_shards);
+	PlaylistCache::init(1);
+	StatsEngine::init(1, std::chrono::hours(config->getStatsConfig().recompute_interval_hours));
+
+	int code = 0;
+	try {
+		if (command == "export") {
+			if (argc > 4) {
+				std::ofstream out(argv[4], std::ios::binary);
+				code = out ? runExport(user_id, out) : 1;
+			} else {
+				code = runExport(user_id, std::cout);
+			}
+		} else if (std::strcmp(argv[4], "-") == 0) {
+			code = runImport(user_id, std::cin);
+		} else {
+			std::ifstream in(argv[4], std::ios::binary);
+			code = in ? runImport(user_id, in) : 1;
+		}
+	} catch (const sql::SQLException& e) {
+		std::fprintf(stderr, "sql error: %s (%d)\n", e.what(), e.getErrorCode());
+		code = 1;
+	}
+
+	StatsEngine::getInstance()->stop();
+	if (code != 0) std::fprintf(stderr, "library-cli %s failed\n", command.c_str());
+	return code;
+}